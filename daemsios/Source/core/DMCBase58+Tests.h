@@ -3,3 +3,4 @@
 #import "DMCBase58.h"
 
 void DMCBase58RunAllTests();
+void DMCBase58RunAllBenchmarks();
@@ -14,6 +14,51 @@ void DMCAssertHexEncodesToBase58(NSString* hex, NSString* base58) {
     NSCAssert([data2 isEqual:data], @"should decode base58 correctly");
 }
 
+// Straightforward byte-at-a-time conversion used as a reference for the limb-based codec.
+static size_t DMCBase58ReferenceEncode(char* string, const unsigned char* data, size_t length) {
+    static const char* alphabet = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    size_t zeros = 0;
+    while (zeros < length && data[zeros] == 0) zeros++;
+
+    size_t bufLength = (length - zeros) * 138 / 100 + 1;
+    unsigned char buf[bufLength];
+    memset(buf, 0, bufLength);
+
+    for (size_t i = zeros; i < length; i++) {
+        uint32_t carry = data[i];
+        for (size_t j = bufLength; j > 0; j--) {
+            carry += (uint32_t)buf[j - 1] << 8;
+            buf[j - 1] = carry % 58;
+            carry /= 58;
+        }
+    }
+
+    size_t i = 0, n = 0;
+    while (i < bufLength && buf[i] == 0) i++;
+    while (zeros-- > 0) string[n++] = alphabet[0];
+    while (i < bufLength) string[n++] = alphabet[buf[i++]];
+    return n;
+}
+
+void DMCAssertMatchesReferenceBase58(NSData* data) {
+    char expected[DMCBase58MaxEncodedLength(data.length)];
+    char actual[DMCBase58MaxEncodedLength(data.length)];
+    unsigned char decoded[DMCBase58MaxDecodedLength(sizeof(actual))];
+    size_t expectedLength = DMCBase58ReferenceEncode(expected, data.bytes, data.length);
+    size_t actualLength = sizeof(actual);
+    size_t decodedLength = sizeof(decoded);
+
+    NSCAssert(DMCBase58Encode(actual, &actualLength, data.bytes, data.length), @"should fit into max encoded length");
+    NSCAssert(actualLength == expectedLength && memcmp(actual, expected, actualLength) == 0, @"should encode like the reference implementation");
+    NSCAssert(DMCBase58Decode(decoded, &decodedLength, actual, actualLength), @"should fit into max decoded length");
+    NSCAssert(decodedLength == data.length && memcmp(decoded, data.bytes, data.length) == 0, @"should decode back");
+
+    if (actualLength > 0) {
+        size_t shortLength = actualLength - 1;
+        NSCAssert(!DMCBase58Encode(actual, &shortLength, data.bytes, data.length), @"should not overflow the buffer");
+    }
+}
+
 void DMCAssertDetectsInvalidBase58(NSString* text) {
 	NSData *data = DMCDataFromBase58Check(text);
     
@@ -43,6 +88,39 @@ void DMCBase58RunAllTests() {
     DMCAssertHexEncodesToBase58(@"10c8511e", @"Rt5zm");
     DMCAssertHexEncodesToBase58(@"00000000000000000000", @"1111111111");
 
+    NSCAssert([DMCDataFromBase58(@"  6h8cQN \n") isEqual:DMCDataFromHex(@"deadbeef")], @"should ignore surrounding whitespace");
+    NSCAssert(DMCDataFromBase58(@"6h8 cQN") == nil, @"should not ignore whitespace inside");
+
+    // Random data of various lengths with leading zeros, including long inputs that do not fit stack limbs.
+    for (NSUInteger length = 0; length < 600; length += (length < 70 ? 1 : 37)) {
+        NSMutableData* data = [DMCRandomDataWithLength(length) mutableCopy];
+        if (length > 2 && length % 3 == 0) memset(data.mutableBytes, 0, length % 5);
+        DMCAssertMatchesReferenceBase58(data);
+    }
+
+    // Batch versions
+    {
+        NSArray* payloads = @[ DMCDataFromHex(@"00c4c5d791fcb4654a1ef5e03fe0ad3d9c598f9827"),
+                               DMCDataFromHex(@"00eb15231dfceb60925886b67d065299925915aeb1"),
+                               DMCDataFromHex(@"0000000000000000000000000000000000000000") ];
+        NSArray* strings = DMCBase58CheckStringsWithDataArray(payloads);
+        NSCAssert(strings.count == payloads.count, @"should encode every payload");
+        NSCAssert([strings[0] isEqual:@"1JwSSubhmg6iPtRjtyqhUYYH7bZg3Lfy1T"], @"should encode base58check in a batch");
+        for (NSUInteger i = 0; i < payloads.count; i++) {
+            NSCAssert([strings[i] isEqual:DMCBase58CheckStringWithData(payloads[i])], @"batch should match single encoding");
+        }
+
+        NSArray* decoded = DMCDataArrayFromBase58CheckStrings([strings arrayByAddingObjectsFromArray:@[ @"1JwSSubhmg6iPtRjtyqhUYYH7bZg3Lfy1t", @"lLoO", @"" ]]);
+        NSCAssert(decoded.count == payloads.count + 3, @"should return an object per string");
+        NSCAssert([[decoded subarrayWithRange:NSMakeRange(0, payloads.count)] isEqual:payloads], @"should decode base58check in a batch");
+        NSCAssert(decoded[payloads.count] == [NSNull null], @"should detect invalid checksum");
+        NSCAssert(decoded[payloads.count + 1] == [NSNull null], @"should detect invalid characters");
+        NSCAssert(decoded[payloads.count + 2] == [NSNull null], @"should detect too short strings");
+
+        NSArray* mixed = @[ DMCDataFromHex(@"80"), DMCDataFromHex(@"00c4c5d791fcb4654a1ef5e03fe0ad3d9c598f9827") ];
+        NSCAssert([DMCDataArrayFromBase58CheckStrings(DMCBase58CheckStringsWithDataArray(mixed)) isEqual:mixed], @"should handle payloads of different lengths");
+    }
+
     if ((0)) {
         // Search for vanity prefix
         NSString* prefix = @"s";
@@ -72,3 +150,52 @@ void DMCBase58RunAllTests() {
         }
     }
 }
+
+void DMCBase58RunAllBenchmarks() {
+    const NSUInteger n = 100000;
+    NSData* address = DMCDataFromHex(@"00c4c5d791fcb4654a1ef5e03fe0ad3d9c598f9827ffe6c4d2");
+    char string[64];
+    unsigned char data[64];
+    size_t length = 0;
+
+    CFAbsoluteTime t0 = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < n; i++) {
+        length = DMCBase58ReferenceEncode(string, address.bytes, address.length);
+    }
+    CFAbsoluteTime t1 = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < n; i++) {
+        length = sizeof(string);
+        DMCBase58Encode(string, &length, address.bytes, address.length);
+    }
+    CFAbsoluteTime t2 = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < n; i++) {
+        size_t dataLength = sizeof(data);
+        DMCBase58Decode(data, &dataLength, string, length);
+    }
+    CFAbsoluteTime t3 = CFAbsoluteTimeGetCurrent();
+
+    NSLog(@"Base58 of 25-byte address: reference encode %.0f ns, encode %.0f ns, decode %.0f ns",
+          (t1 - t0) * 1e9 / n, (t2 - t1) * 1e9 / n, (t3 - t2) * 1e9 / n);
+
+    NSMutableArray* payloads = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 10000; i++) {
+        [payloads addObject:DMCRandomDataWithLength(21)];
+    }
+
+    CFAbsoluteTime t4 = CFAbsoluteTimeGetCurrent();
+    for (NSData* payload in payloads) {
+        DMCBase58CheckStringWithData(payload);
+    }
+    CFAbsoluteTime t5 = CFAbsoluteTimeGetCurrent();
+    NSArray* strings = DMCBase58CheckStringsWithDataArray(payloads);
+    CFAbsoluteTime t6 = CFAbsoluteTimeGetCurrent();
+    for (NSString* string in strings) {
+        DMCDataFromBase58Check(string);
+    }
+    CFAbsoluteTime t7 = CFAbsoluteTimeGetCurrent();
+    DMCDataArrayFromBase58CheckStrings(strings);
+    CFAbsoluteTime t8 = CFAbsoluteTimeGetCurrent();
+
+    NSLog(@"Base58Check of %@ addresses: encode %.1f ms (batch %.1f ms), decode %.1f ms (batch %.1f ms)", @(payloads.count),
+          (t5 - t4) * 1000.0, (t6 - t5) * 1000.0, (t7 - t6) * 1000.0, (t8 - t7) * 1000.0);
+}
@@ -18,6 +18,20 @@
 
 // See NS+DMCBase58.h for easy to use categories.
 
+// Buffer sizes sufficient for encoding `length` bytes and decoding `length` characters.
+#define DMCBase58MaxEncodedLength(length) ((length) * 138 / 100 + 1)
+#define DMCBase58MaxDecodedLength(length) (length)
+
+// Low-level codec working on caller's buffers without allocations (for inputs up to a few hundred bytes).
+// `*stringLength` and `*dataLength` are capacities on input and actual lengths on output.
+// Encode does not append a terminating zero. Both return NO if the output does not fit,
+// Decode also returns NO if the string contains a non-Base58 character.
+BOOL DMCBase58Encode(char* string, size_t* stringLength, const unsigned char* data, size_t length);
+BOOL DMCBase58Decode(unsigned char* data, size_t* dataLength, const char* string, size_t length);
+
+// Returns the length of the longest prefix of the string made of Base58 characters.
+size_t DMCBase58ValidLength(const char* string, size_t length);
+
 // Returns data for a Base58 string without checksum
 // Data is mutable so you can clear sensitive information as soon as possible.
 NSMutableData* DMCDataFromBase58(NSString* string);
@@ -41,3 +55,9 @@ char* DMCBase58CheckCStringWithData(NSData* data);
 // Same as above, but returns an immutable autoreleased string. Suitable for non-sensitive data.
 NSString* DMCBase58CheckStringWithData(NSData* data);
 
+// Batch versions for address lists. Checksums of equal-length payloads are computed in parallel (see DMCSHA256Lanes.h).
+// Returns an array of NSString for an array of NSData.
+NSArray* DMCBase58CheckStringsWithDataArray(NSArray* dataArray);
+
+// Returns an array of NSData for an array of NSString with NSNull in place of invalid strings.
+NSArray* DMCDataArrayFromBase58CheckStrings(NSArray* strings);
@@ -2,10 +2,165 @@
 
 #import "DMCBase58.h"
 #import "DMCData.h"
-#import <openssl/bn.h>
+#import "DMCHashBackend.h"
+#import "DMCSHA256Lanes.h"
 
 static const char* DMCBase58Alphabet = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
 
+// Digit values of Base58 characters, -1 for other characters.
+static const int8_t DMCBase58Digits[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1, 0, 1, 2, 3, 4, 5, 6, 7, 8,-1,-1,-1,-1,-1,-1,
+    -1, 9,10,11,12,13,14,15,16,-1,17,18,19,20,21,-1, 22,23,24,25,26,27,28,29,30,31,32,-1,-1,-1,-1,-1,
+    -1,33,34,35,36,37,38,39,40,41,42,43,-1,44,45,46, 47,48,49,50,51,52,53,54,55,56,57,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1, -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+};
+
+// Numbers are kept in 32-bit limbs, least significant first: base 58^5 while encoding and base 2^32 while decoding.
+// Each step multiplies by 256^4 or 58^5 in 64-bit arithmetic, so a 25-byte address takes ~30 limb operations
+// instead of hundreds of byte operations. Limbs live on the stack unless the input is unusually long.
+#define DMCBase58LimbBase 656356768ULL // 58^5
+#define DMCBase58StackLimbs 64
+
+static const uint32_t DMCBase58Powers[6] = { 1, 58, 3364, 195112, 11316496, 656356768 };
+
+static uint32_t* DMCBase58AllocLimbs(uint32_t* stackLimbs, size_t count) {
+    return count <= DMCBase58StackLimbs ? stackLimbs : malloc(count * sizeof(uint32_t));
+}
+
+static void DMCBase58FreeLimbs(uint32_t* limbs, uint32_t* stackLimbs, size_t count) {
+    DMCSecureMemset(limbs, 0, count * sizeof(uint32_t));
+    if (limbs != stackLimbs) free(limbs);
+}
+
+BOOL DMCBase58Encode(char* string, size_t* stringLength, const unsigned char* data, size_t length) {
+    size_t zeros = 0;
+    while (zeros < length && data[zeros] == 0) zeros++;
+
+    size_t maxLimbs = (length - zeros) * 138 / 500 + 2;
+    uint32_t stackLimbs[DMCBase58StackLimbs];
+    uint32_t* limbs = DMCBase58AllocLimbs(stackLimbs, maxLimbs);
+    size_t limbCount = 0;
+
+    // Feed big-endian input 4 bytes at a time, the first chunk takes the remainder.
+    size_t i = zeros;
+    size_t chunk = (length - zeros) % 4 ? (length - zeros) % 4 : 4;
+    while (i < length) {
+        uint64_t carry = 0;
+        for (size_t k = 0; k < chunk; k++) carry = (carry << 8) | data[i + k];
+        unsigned shift = (unsigned)chunk * 8;
+
+        for (size_t j = 0; j < limbCount; j++) {
+            uint64_t t = ((uint64_t)limbs[j] << shift) + carry;
+            limbs[j] = (uint32_t)(t % DMCBase58LimbBase);
+            carry = t / DMCBase58LimbBase;
+        }
+        while (carry > 0) {
+            limbs[limbCount++] = (uint32_t)(carry % DMCBase58LimbBase);
+            carry /= DMCBase58LimbBase;
+        }
+        i += chunk;
+        chunk = 4;
+    }
+
+    // Most significant limb is written without leading zero digits, the rest as 5 digits each.
+    size_t topDigits = 0;
+    if (limbCount > 0) {
+        while (topDigits < 5 && limbs[limbCount - 1] >= DMCBase58Powers[topDigits]) topDigits++;
+    }
+    size_t total = zeros + (limbCount > 0 ? topDigits + (limbCount - 1) * 5 : 0);
+
+    if (total > *stringLength) {
+        DMCBase58FreeLimbs(limbs, stackLimbs, maxLimbs);
+        return NO;
+    }
+
+    memset(string, DMCBase58Alphabet[0], zeros);
+    char* p = string + total;
+    for (size_t j = 0; j < limbCount; j++) {
+        uint32_t limb = limbs[j];
+        size_t digits = (j + 1 < limbCount) ? 5 : topDigits;
+        for (size_t k = 0; k < digits; k++) {
+            *--p = DMCBase58Alphabet[limb % 58];
+            limb /= 58;
+        }
+    }
+
+    *stringLength = total;
+    DMCBase58FreeLimbs(limbs, stackLimbs, maxLimbs);
+    return YES;
+}
+
+BOOL DMCBase58Decode(unsigned char* data, size_t* dataLength, const char* string, size_t length) {
+    size_t ones = 0;
+    while (ones < length && string[ones] == DMCBase58Alphabet[0]) ones++;
+
+    size_t maxLimbs = (length - ones) * 733 / 4000 + 2;
+    uint32_t stackLimbs[DMCBase58StackLimbs];
+    uint32_t* limbs = DMCBase58AllocLimbs(stackLimbs, maxLimbs);
+    size_t limbCount = 0;
+
+    // Feed digits 5 at a time, the first chunk takes the remainder.
+    size_t i = ones;
+    size_t chunk = (length - ones) % 5 ? (length - ones) % 5 : 5;
+    while (i < length) {
+        uint64_t carry = 0;
+        for (size_t k = 0; k < chunk; k++) {
+            int digit = DMCBase58Digits[(unsigned char)string[i + k]];
+            if (digit < 0) {
+                DMCBase58FreeLimbs(limbs, stackLimbs, maxLimbs);
+                return NO;
+            }
+            carry = carry * 58 + (uint64_t)digit;
+        }
+        uint64_t multiplier = DMCBase58Powers[chunk];
+
+        for (size_t j = 0; j < limbCount; j++) {
+            uint64_t t = (uint64_t)limbs[j] * multiplier + carry;
+            limbs[j] = (uint32_t)t;
+            carry = t >> 32;
+        }
+        if (carry > 0) limbs[limbCount++] = (uint32_t)carry;
+        i += chunk;
+        chunk = 5;
+    }
+
+    size_t topBytes = 0;
+    if (limbCount > 0) {
+        while (topBytes < 4 && (limbs[limbCount - 1] >> (topBytes * 8)) != 0) topBytes++;
+    }
+    size_t total = ones + (limbCount > 0 ? topBytes + (limbCount - 1) * 4 : 0);
+
+    if (total > *dataLength) {
+        DMCBase58FreeLimbs(limbs, stackLimbs, maxLimbs);
+        return NO;
+    }
+
+    memset(data, 0, ones);
+    unsigned char* p = data + total;
+    for (size_t j = 0; j < limbCount; j++) {
+        uint32_t limb = limbs[j];
+        size_t bytes = (j + 1 < limbCount) ? 4 : topBytes;
+        for (size_t k = 0; k < bytes; k++) {
+            *--p = (unsigned char)limb;
+            limb >>= 8;
+        }
+    }
+
+    *dataLength = total;
+    DMCBase58FreeLimbs(limbs, stackLimbs, maxLimbs);
+    return YES;
+}
+
+size_t DMCBase58ValidLength(const char* string, size_t length) {
+    size_t i = 0;
+    while (i < length && DMCBase58Digits[(unsigned char)string[i]] >= 0) i++;
+    return i;
+}
+
 NSMutableData* DMCDataFromBase58(NSString* string) {
     return DMCDataFromBase58CString([string cStringUsingEncoding:NSASCIIStringEncoding]);
 }
@@ -16,107 +171,43 @@ NSMutableData* DMCDataFromBase58Check(NSString* string) {
 
 NSMutableData* DMCDataFromBase58CString(const char* cstring) {
     if (cstring == NULL) return nil;
-    
-    // empty string -> empty data.
-    if (cstring[0] == '\0') return [NSMutableData data];
-    
-    NSMutableData* result = nil;
-    
-    BN_CTX* pctx = BN_CTX_new();
-    __block BIGNUM bn58;   BN_init(&bn58);   BN_set_word(&bn58, 58);
-    __block BIGNUM bn;     BN_init(&bn);     BN_zero(&bn);
-    __block BIGNUM bnChar; BN_init(&bnChar);
-    
-    void(^finish)() = ^{
-        if (pctx) BN_CTX_free(pctx);
-        BN_clear_free(&bn58);
-        BN_clear_free(&bn);
-        BN_clear_free(&bnChar);
-    };
-    
+
+    // Leading and trailing whitespace is ignored.
     while (isspace(*cstring)) cstring++;
-    
-    
-    // Convert big endian string to bignum
-    for (const char* p = cstring; *p; p++) {
-        const char* p1 = strchr(DMCBase58Alphabet, *p);
-        if (p1 == NULL) {
-            while (isspace(*p))
-                p++;
-            if (*p != '\0') {
-                finish();
-                return nil;
-            }
-            break;
-        }
-        
-        BN_set_word(&bnChar, (BN_ULONG)(p1 - DMCBase58Alphabet));
-        
-        if (!BN_mul(&bn, &bn, &bn58, pctx)) {
-            finish();
-            return nil;
-        }
-        
-        if (!BN_add(&bn, &bn, &bnChar)) {
-            finish();
-            return nil;
-        }
+    size_t length = DMCBase58ValidLength(cstring, strlen(cstring));
+    for (const char* p = cstring + length; *p; p++) {
+        if (!isspace(*p)) return nil;
     }
-    
-    // Get bignum as little endian data
-    
-    NSMutableData* bndata = nil;
-    {
-        size_t bnsize = BN_bn2mpi(&bn, NULL);
-        if (bnsize <= 4) {
-            bndata = [NSMutableData data];
-        } else {
-            bndata = [NSMutableData dataWithLength:bnsize];
-            BN_bn2mpi(&bn, bndata.mutableBytes);
-            [bndata replaceBytesInRange:NSMakeRange(0, 4) withBytes:NULL length:0];
-            DMCDataReverse(bndata);
-        }
+
+    NSMutableData* result = [NSMutableData dataWithLength:DMCBase58MaxDecodedLength(length)];
+    size_t resultLength = result.length;
+    if (!DMCBase58Decode(result.mutableBytes, &resultLength, cstring, length)) {
+        DMCDataClear(result);
+        return nil;
     }
-    size_t bnsize = bndata.length;
-    
-    // Trim off sign byte if present
-    if (bnsize >= 2
-        && ((unsigned char*)bndata.bytes)[bnsize - 1] == 0
-        && ((unsigned char*)bndata.bytes)[bnsize - 2] >= 0x80) {
-        bnsize -= 1;
-        [bndata setLength:bnsize];
-    }
-    
-    // Restore leading zeros
-    int nLeadingZeros = 0;
-    for (const char* p = cstring; *p == DMCBase58Alphabet[0]; p++)
-        nLeadingZeros++;
-    
-    result = [NSMutableData dataWithLength:nLeadingZeros + bnsize];
-    
-    // Copy the bignum to the beginning of array. We'll reverse it then and zeros will become leading zeros.
-    [result replaceBytesInRange:NSMakeRange(0, bnsize) withBytes:bndata.bytes length:bnsize];
-    
-    // Convert little endian data to big endian
-    DMCDataReverse(result);
-    
-    finish();
-    
+    [result setLength:resultLength];
     return result;
 }
 
+static BOOL DMCBase58ChecksumIsValid(const unsigned char* data, size_t length) {
+    unsigned char hash[32];
+    DMCHash256Digest(hash, data, length - 4);
+    BOOL valid = memcmp(hash, data + length - 4, 4) == 0;
+    DMCSecureMemset(hash, 0, sizeof(hash));
+    return valid;
+}
+
 NSMutableData* DMCDataFromBase58CheckCString(const char* cstring) {
     if (cstring == NULL) return nil;
-    
+
     NSMutableData* result = DMCDataFromBase58CString(cstring);
     size_t length = result.length;
     if (length < 4) {
         return nil;
     }
-    NSData* hash = DMCHash256([result subdataWithRange:NSMakeRange(0, length - 4)]);
-    
+
     // Last 4 bytes should be equal first 4 bytes of the hash.
-    if (memcmp(hash.bytes, result.bytes + length - 4, 4) != 0) {
+    if (!DMCBase58ChecksumIsValid(result.bytes, length)) {
         return nil;
     }
     [result setLength:length - 4];
@@ -126,78 +217,11 @@ NSMutableData* DMCDataFromBase58CheckCString(const char* cstring) {
 
 char* DMCBase58CStringWithData(NSData* data) {
     if (!data) return NULL;
-    
-    BN_CTX* pctx = BN_CTX_new();
-    __block BIGNUM bn58; BN_init(&bn58); BN_set_word(&bn58, 58);
-    __block BIGNUM bn0;  BN_init(&bn0);  BN_zero(&bn0);
-    __block BIGNUM bn; BN_init(&bn); BN_zero(&bn);
-    __block BIGNUM dv; BN_init(&dv); BN_zero(&dv);
-    __block BIGNUM rem; BN_init(&rem); BN_zero(&rem);
-    
-    void(^finish)() = ^{
-        if (pctx) BN_CTX_free(pctx);
-        BN_clear_free(&bn58);
-        BN_clear_free(&bn0);
-        BN_clear_free(&bn);
-        BN_clear_free(&dv);
-        BN_clear_free(&rem);
-    };
-    
-    // Convert big endian data to little endian.
-    // Extra zero at the end make sure bignum will interpret as a positive number.
-    NSMutableData* tmp = DMCReversedMutableData(data);
-    tmp.length += 1;
-    
-    // Convert little endian data to bignum
-    {
-        NSUInteger size = tmp.length;
-        NSMutableData* mdata = [tmp mutableCopy];
-        
-        // Reverse to convert to OpenSSL bignum endianess
-        DMCDataReverse(mdata);
-        
-        // BIGNUM's byte stream format expects 4 bytes of
-        // big endian size data info at the front
-        [mdata replaceBytesInRange:NSMakeRange(0, 0) withBytes:"\0\0\0\0" length:4];
-        unsigned char* bytes = mdata.mutableBytes;
-        bytes[0] = (size >> 24) & 0xff;
-        bytes[1] = (size >> 16) & 0xff;
-        bytes[2] = (size >> 8) & 0xff;
-        bytes[3] = (size >> 0) & 0xff;
-        
-        BN_mpi2bn(bytes, (int)mdata.length, &bn);
-    }
-    
-    // Expected size increase from base58 conversion is approximately 137%
-    // use 138% to be safe
-    NSMutableData* stringData = [NSMutableData dataWithCapacity:data.length*138/100 + 1];
-    
-    while (BN_cmp(&bn, &bn0) > 0) {
-        if (!BN_div(&dv, &rem, &bn, &bn58, pctx)) {
-            finish();
-            return nil;
-        }
-        BN_copy(&bn, &dv);
-        unsigned long c = BN_get_word(&rem);
-        [stringData appendBytes:DMCBase58Alphabet + c length:1];
-    }
-    finish();
-    
-    // Leading zeroes encoded as base58 ones ("1")
-    const unsigned char* pbegin = data.bytes;
-    const unsigned char* pend = data.bytes + data.length;
-    for (const unsigned char* p = pbegin; p < pend && *p == 0; p++) {
-        [stringData appendBytes:DMCBase58Alphabet + 0 length:1];
-    }
-    
-    // Convert little endian std::string to big endian
-    DMCDataReverse(stringData);
-    
-    [stringData appendBytes:"" length:1];
-    
-    char* r = malloc(stringData.length);
-    memcpy(r, stringData.bytes, stringData.length);
-    DMCDataClear(stringData);
+
+    size_t length = DMCBase58MaxEncodedLength(data.length);
+    char* r = malloc(length + 1);
+    DMCBase58Encode(r, &length, data.bytes, data.length);
+    r[length] = '\0';
     return r;
 }
 
@@ -206,8 +230,9 @@ char* DMCBase58CheckCStringWithData(NSData* immutabledata) {
     if (!immutabledata) return NULL;
     // add 4-byte hash check to the end
     NSMutableData* data = [immutabledata mutableCopy];
-    NSData* checksum = DMCHash256(data);
-    [data appendBytes:checksum.bytes length:4];
+    unsigned char checksum[32];
+    DMCHash256Digest(checksum, data.bytes, data.length);
+    [data appendBytes:checksum length:4];
     char* result = DMCBase58CStringWithData(data);
     DMCDataClear(data);
     return result;
@@ -233,7 +258,80 @@ NSString* DMCBase58CheckStringWithData(NSData* data) {
 }
 
 
+NSArray* DMCBase58CheckStringsWithDataArray(NSArray* dataArray) {
+    if (!dataArray) return nil;
 
+    NSUInteger count = dataArray.count;
+    NSMutableArray* result = [NSMutableArray arrayWithCapacity:count];
+    if (count == 0) return result;
 
+    // Address lists usually have payloads of the same length: lay them out with a common stride
+    // and compute all checksums in one multi-lane pass.
+    size_t length = [dataArray[0] length];
+    BOOL sameLength = YES;
+    for (NSData* data in dataArray) {
+        if (data.length != length) {
+            sameLength = NO;
+            break;
+        }
+    }
+
+    NSMutableData* checksums = [NSMutableData dataWithLength:count * 32];
+    if (sameLength && length > 0) {
+        NSMutableData* payloads = [NSMutableData dataWithLength:count * length];
+        for (NSUInteger i = 0; i < count; i++) {
+            memcpy((unsigned char*)payloads.mutableBytes + i * length, [dataArray[i] bytes], length);
+        }
+        DMCHash256Lanes(checksums.mutableBytes, payloads.bytes, length, length, count);
+        DMCDataClear(payloads);
+    } else {
+        for (NSUInteger i = 0; i < count; i++) {
+            NSData* data = dataArray[i];
+            DMCHash256Digest((unsigned char*)checksums.mutableBytes + i * 32, data.bytes, data.length);
+        }
+    }
 
+    size_t maxLength = 0;
+    for (NSData* data in dataArray) maxLength = MAX(maxLength, data.length);
 
+    NSMutableData* payload = [NSMutableData dataWithLength:maxLength + 4];
+    NSMutableData* string = [NSMutableData dataWithLength:DMCBase58MaxEncodedLength(maxLength + 4)];
+    for (NSUInteger i = 0; i < count; i++) {
+        NSData* data = dataArray[i];
+        memcpy(payload.mutableBytes, data.bytes, data.length);
+        memcpy((unsigned char*)payload.mutableBytes + data.length, (const unsigned char*)checksums.bytes + i * 32, 4);
+
+        size_t stringLength = string.length;
+        DMCBase58Encode(string.mutableBytes, &stringLength, payload.bytes, data.length + 4);
+        [result addObject:[[NSString alloc] initWithBytes:string.bytes length:stringLength encoding:NSASCIIStringEncoding]];
+    }
+
+    DMCDataClear(payload);
+    DMCDataClear(string);
+    DMCDataClear(checksums);
+    return result;
+}
+
+NSArray* DMCDataArrayFromBase58CheckStrings(NSArray* strings) {
+    if (!strings) return nil;
+
+    NSMutableArray* result = [NSMutableArray arrayWithCapacity:strings.count];
+    NSMutableData* buffer = [NSMutableData data];
+
+    for (NSString* string in strings) {
+        const char* cstring = [string cStringUsingEncoding:NSASCIIStringEncoding];
+        size_t length = cstring ? strlen(cstring) : 0;
+        if (buffer.length < length) buffer.length = length;
+
+        size_t dataLength = length;
+        if (!cstring || !DMCBase58Decode(buffer.mutableBytes, &dataLength, cstring, length) ||
+            dataLength < 4 || !DMCBase58ChecksumIsValid(buffer.bytes, dataLength)) {
+            [result addObject:[NSNull null]];
+            continue;
+        }
+        [result addObject:[NSData dataWithBytes:buffer.bytes length:dataLength - 4]];
+    }
+
+    DMCDataClear(buffer);
+    return result;
+}
@@ -3,6 +3,7 @@
 #import <Foundation/Foundation.h>
 
 @class DMCBlockHeader;
+@class DMCByteCursor;
 @interface DMCBlock : NSObject <NSCopying>
 
 @property(nonatomic, readonly) DMCBlockHeader* header;
@@ -38,4 +39,11 @@
 // Instantiates an empty block with a given header.
 - (id) initWithHeader:(DMCBlockHeader*)header;
 
+// Parses block with its transactions from data buffer.
+- (id) initWithData:(NSData*)data;
+
+// Parses block at the cursor position and moves the cursor past it.
+// Hashes, scripts and transaction payloads reference the cursor's buffer without copying.
+- (id) initWithCursor:(DMCByteCursor*)cursor;
+
 @end
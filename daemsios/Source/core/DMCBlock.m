@@ -3,6 +3,10 @@
 #import "DMCBlock.h"
 #import "DMCBlockHeader.h"
 #import "DMCHashID.h"
+#import "DMCTransaction.h"
+#import "DMCMerkleTree.h"
+#import "DMCProtocolSerialization.h"
+#import "DMCByteCursor.h"
 
 @interface DMCBlock ()
 @property(nonatomic, readwrite) DMCBlockHeader* header;
@@ -39,16 +43,59 @@
     return self;
 }
 
+- (id) initWithCursor:(DMCByteCursor*)cursor {
+    if (self = [super init]) {
+        if (![self parseCursor:cursor]) return nil;
+    }
+    return self;
+}
+
 - (BOOL) parseData:(NSData*)data {
+    if (!data) return NO;
+    return [self parseCursor:[[DMCByteCursor alloc] initWithData:data]];
+}
 
-    // TODO
+- (BOOL) parseStream:(NSInputStream*)stream {
+    if (!stream) return NO;
+    if (stream.streamStatus == NSStreamStatusClosed) return NO;
+    if (stream.streamStatus == NSStreamStatusNotOpen) return NO;
 
-    return YES;
+    // Block length is not known upfront, so collect the stream into a buffer and parse it with a cursor.
+    NSMutableData* data = [NSMutableData data];
+    uint8_t buffer[4096];
+    NSInteger l = 0;
+    while ((l = [stream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        [data appendBytes:buffer length:l];
+    }
+    if (l < 0) return NO;
+    return [self parseData:data];
 }
 
-- (BOOL) parseStream:(NSStream*)stream {
-    // TODO
+- (BOOL) parseCursor:(DMCByteCursor*)cursor {
+    if (!cursor) return NO;
+    NSUInteger offset = cursor.offset;
+
+    DMCBlockHeader* header = [[DMCBlockHeader alloc] initWithCursor:cursor];
+    uint64_t txCount = 0;
+
+    // Each transaction takes at least 10 bytes, so a bogus count fails here instead of allocating.
+    if (!header || ![cursor readVarInt:&txCount] || txCount > cursor.remainingLength / 10) {
+        cursor.offset = offset;
+        return NO;
+    }
 
+    NSMutableArray* txs = [NSMutableArray arrayWithCapacity:(NSUInteger)txCount];
+    for (uint64_t i = 0; i < txCount; i++) {
+        DMCTransaction* tx = [[DMCTransaction alloc] initWithCursor:cursor];
+        if (!tx) {
+            cursor.offset = offset;
+            return NO;
+        }
+        [txs addObject:tx];
+    }
+
+    self.header = header;
+    self.transactions = txs;
     return YES;
 }
 
@@ -69,7 +116,10 @@
 
     [data appendData:self.header.data];
 
-    // TODO: add transactions.
+    [data appendData:[DMCProtocolSerialization dataForVarInt:self.transactions.count]];
+    for (DMCTransaction* tx in self.transactions) {
+        [data appendData:tx.data];
+    }
 
     return data;
 }
@@ -109,8 +159,7 @@
 
 // Computes merkle root hash from the current transaction array.
 - (NSData*) computeMerkleRootHash {
-    // TODO
-    return nil;
+    return [[DMCMerkleTree alloc] initWithTransactions:self.transactions].merkleRoot;
 }
 
 - (void) updateMerkleTree {
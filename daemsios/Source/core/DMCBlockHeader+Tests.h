@@ -0,0 +1,15 @@
+// 
+
+#import "DMCBlockHeader.h"
+
+@interface DMCBlockHeader (Tests)
+
+// Returns a chain of headers following the previous hash, one block per 10 minutes.
+// Nonce offset makes forks differ.
++ (NSArray* /* [DMCBlockHeader] */) chainWithCount:(NSUInteger)count previousHash:(NSData*)previousHash bits:(uint32_t)bits nonce:(uint32_t)nonce;
+
+// Same chain, but each nonce is searched from `nonce` up until the block hash meets the target.
+// Use an easy target such as 0x207fffff, where every other hash is good enough.
++ (NSArray* /* [DMCBlockHeader] */) minedChainWithCount:(NSUInteger)count previousHash:(NSData*)previousHash bits:(uint32_t)bits nonce:(uint32_t)nonce;
+
+@end
@@ -0,0 +1,42 @@
+// 
+
+#import "DMCBlockHeader+Tests.h"
+#import "DMCBigNumber.h"
+#import "DMCData.h"
+
+@implementation DMCBlockHeader (Tests)
+
++ (NSArray*) chainWithCount:(NSUInteger)count previousHash:(NSData*)previousHash bits:(uint32_t)bits nonce:(uint32_t)nonce {
+    NSMutableArray* headers = [NSMutableArray array];
+    for (NSUInteger i = 0; i < count; i++) {
+        DMCBlockHeader* header = [[DMCBlockHeader alloc] init];
+        header.previousBlockHash = previousHash;
+        header.time = 1400000000 + (uint32_t)i * 600;
+        header.difficultyTarget = bits;
+        header.nonce = nonce + (uint32_t)i;
+        [headers addObject:header];
+        previousHash = header.blockHash;
+    }
+    return headers;
+}
+
++ (NSArray*) minedChainWithCount:(NSUInteger)count previousHash:(NSData*)previousHash bits:(uint32_t)bits nonce:(uint32_t)nonce {
+    DMCBigNumber* target = [[DMCBigNumber alloc] initWithCompact:bits];
+    NSMutableArray* headers = [NSMutableArray array];
+    for (NSUInteger i = 0; i < count; i++) {
+        DMCBlockHeader* header = [[DMCBlockHeader alloc] init];
+        header.previousBlockHash = previousHash;
+        header.time = 1400000000 + (uint32_t)i * 600;
+        header.difficultyTarget = bits;
+        header.nonce = nonce;
+        while ([[[DMCBigNumber alloc] initWithUnsignedBigEndian:DMCReversedData(header.blockHash)] greater:target]) {
+            header.nonce = ++nonce;
+        }
+        nonce++;
+        [headers addObject:header];
+        previousHash = header.blockHash;
+    }
+    return headers;
+}
+
+@end
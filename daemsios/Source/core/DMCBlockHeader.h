@@ -2,12 +2,18 @@
 
 #import <Foundation/Foundation.h>
 
+@class DMCByteCursor;
+
 static const int32_t DMCBlockCurrentVersion = 2;
 
 @interface DMCBlockHeader : NSObject <NSCopying>
 
 + (NSUInteger) headerLength;
 
+// Computes block hashes of many headers at once using multi-lane SHA-256.
+// Returns an array of NSData hashes in the same order.
++ (NSArray*) blockHashesForHeaders:(NSArray* /* [DMCBlockHeader] */)headers;
+
 @property(nonatomic) int32_t version;
 @property(nonatomic) NSData* previousBlockHash;
 @property(nonatomic) NSString* previousBlockID;
@@ -46,5 +52,8 @@ static const int32_t DMCBlockCurrentVersion = 2;
 // Parses input stream
 - (id) initWithStream:(NSInputStream*)stream;
 
+// Parses header at the cursor position and moves the cursor past it.
+- (id) initWithCursor:(DMCByteCursor*)cursor;
+
 
 @end
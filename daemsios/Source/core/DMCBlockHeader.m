@@ -3,6 +3,8 @@
 #import "DMCBlockHeader.h"
 #import "DMCData.h"
 #import "DMCHashID.h"
+#import "DMCByteCursor.h"
+#import "DMCSHA256Lanes.h"
 
 @implementation DMCBlockHeader
 
@@ -10,6 +12,23 @@
     return 4 + 32 + 32 + 4 + 4 + 4;
 }
 
++ (NSArray*) blockHashesForHeaders:(NSArray*)headers {
+    NSUInteger length = [self headerLength];
+    NSMutableData* buffer = [NSMutableData dataWithCapacity:headers.count * length];
+    for (DMCBlockHeader* header in headers) {
+        [buffer appendData:header.data];
+    }
+
+    NSMutableData* digests = [NSMutableData dataWithLength:headers.count * 32];
+    DMCHash256Lanes(digests.mutableBytes, buffer.bytes, length, length, headers.count);
+
+    NSMutableArray* hashes = [NSMutableArray arrayWithCapacity:headers.count];
+    for (NSUInteger i = 0; i < headers.count; i++) {
+        [hashes addObject:[digests subdataWithRange:NSMakeRange(i * 32, 32)]];
+    }
+    return hashes;
+}
+
 - (id) init {
     if (self = [super init]) {
         // init default values
@@ -38,6 +57,13 @@
     return self;
 }
 
+- (id) initWithCursor:(DMCByteCursor*)cursor {
+    if (self = [self init]) {
+        if (![self parseCursor:cursor]) return nil;
+    }
+    return self;
+}
+
 - (NSString*) previousBlockID {
     return DMCIDFromHash(self.previousBlockHash);
 }
@@ -88,15 +114,39 @@
 }
 
 - (BOOL) parseData:(NSData*)data {
-    
-    // TODO
-    
-    return YES;
+    if (!data) return NO;
+    return [self parseCursor:[[DMCByteCursor alloc] initWithData:data]];
 }
 
-- (BOOL) parseStream:(NSStream*)stream {
-    // TODO
-    
+- (BOOL) parseStream:(NSInputStream*)stream {
+    if (!stream) return NO;
+    if (stream.streamStatus == NSStreamStatusClosed) return NO;
+    if (stream.streamStatus == NSStreamStatusNotOpen) return NO;
+
+    // Header has a fixed length, so read it at once and parse from the buffer.
+    NSUInteger length = [DMCBlockHeader headerLength];
+    NSMutableData* data = [NSMutableData dataWithLength:length];
+    NSInteger readSize = [stream read:data.mutableBytes maxLength:length];
+    if (readSize != (NSInteger)length) return NO;
+    return [self parseData:data];
+}
+
+- (BOOL) parseCursor:(DMCByteCursor*)cursor {
+    if (!cursor) return NO;
+    if (cursor.remainingLength < [DMCBlockHeader headerLength]) return NO;
+
+    uint32_t version = 0;
+    [cursor readUInt32:&version];
+    _version = (int32_t)version;
+
+    // Hashes are slices of the cursor's buffer.
+    _previousBlockHash = [cursor readDataOfLength:32];
+    _merkleRootHash = [cursor readDataOfLength:32];
+
+    [cursor readUInt32:&_time];
+    [cursor readUInt32:&_difficultyTarget];
+    [cursor readUInt32:&_nonce];
+
     return YES;
 }
 
@@ -0,0 +1,10 @@
+// 
+
+#import "DMCBloomFilter.h"
+
+@interface DMCBloomFilter (Tests)
+
++ (void) runAllTests;
++ (void) runAllBenchmarks;
+
+@end
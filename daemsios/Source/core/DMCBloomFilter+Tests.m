@@ -0,0 +1,119 @@
+// 
+
+#import "DMCBloomFilter+Tests.h"
+#import "DMCData.h"
+
+@implementation DMCBloomFilter (Tests)
+
++ (void) runAllTests {
+    [self testMurmurHash];
+    [self testSerialization];
+    [self testFillRatio];
+}
+
++ (void) runAllBenchmarks {
+    [self benchmarkInsertAndLookup];
+}
+
+// Vectors from bitcoind's hash_tests.
++ (void) testMurmurHash {
+    NSArray* vectors = @[
+        @[ @0x00000000, @0x00000000, @"" ],
+        @[ @0x6a396f08, @0xfba4c795, @"" ],
+        @[ @0x81f16f39, @0xffffffff, @"" ],
+        @[ @0x514e28b7, @0x00000000, @"00" ],
+        @[ @0xea3f0b17, @0xfba4c795, @"00" ],
+        @[ @0xfd6cf10d, @0x00000000, @"ff" ],
+        @[ @0x16c6b7ab, @0x00000000, @"0011" ],
+        @[ @0x8eb51c3d, @0x00000000, @"001122" ],
+        @[ @0xb4471bf8, @0x00000000, @"00112233" ],
+        @[ @0xe2301fa8, @0x00000000, @"0011223344" ],
+        @[ @0xfc2e4a15, @0x00000000, @"001122334455" ],
+        @[ @0xb074502c, @0x00000000, @"00112233445566" ],
+        @[ @0x8034d2a0, @0x00000000, @"0011223344556677" ],
+        @[ @0xb4698def, @0x00000000, @"001122334455667788" ],
+    ];
+
+    for (NSArray* vector in vectors) {
+        NSData* data = DMCDataFromHex(vector[2]);
+        uint32_t hash = DMCMurmurHash3([vector[1] unsignedIntValue], data.bytes, data.length);
+        NSAssert(hash == [vector[0] unsignedIntValue], @"MurmurHash3 of '%@' should be %@", vector[2], vector[0]);
+    }
+}
+
+// Vectors from bitcoind's bloom_tests.
++ (void) testSerialization {
+    NSArray* elements = @[ DMCDataFromHex(@"99108ad8ed9bb6274d3980bab5a85c048f0950c8"),
+                           DMCDataFromHex(@"b5a2c786d9ef4658287ced5914b37a1b4aa32eee"),
+                           DMCDataFromHex(@"b9300670b4c5366e95b2699e8b18bc75e5f729c5") ];
+
+    DMCBloomFilter* filter = [[DMCBloomFilter alloc] initWithElementCount:3 falsePositiveRate:0.01 tweak:0 flags:DMCBloomFilterUpdateAll];
+    [filter insertData:elements[0]];
+    NSAssert([filter containsData:elements[0]], @"Should contain the inserted element");
+    NSAssert(![filter containsData:DMCDataFromHex(@"19108ad8ed9bb6274d3980bab5a85c048f0950c8")], @"Should not contain a different element");
+    [filter insertData:elements[1]];
+    [filter insertData:elements[2]];
+    NSAssert([DMCHexFromData(filter.data) isEqual:@"03614e9b050000000000000001"], @"Serialization should match BIP37");
+
+    DMCBloomFilter* tweaked = [[DMCBloomFilter alloc] initWithElementCount:3 falsePositiveRate:0.01 tweak:2147483649 flags:DMCBloomFilterUpdateAll];
+    for (NSData* element in elements) [tweaked insertData:element];
+    NSAssert([DMCHexFromData(tweaked.data) isEqual:@"03ce4299050000000100008001"], @"Tweaked serialization should match BIP37");
+
+    DMCBloomFilter* parsed = [[DMCBloomFilter alloc] initWithData:tweaked.data];
+    NSAssert([parsed.data isEqual:tweaked.data] && parsed.tweak == 2147483649 && parsed.flags == DMCBloomFilterUpdateAll, @"Should parse serialized filter");
+    NSAssert(parsed.fillRatio == tweaked.fillRatio, @"Parsed filter should count set bits");
+    NSAssert([parsed containsData:elements[2]], @"Parsed filter should contain elements");
+
+    NSAssert(![[DMCBloomFilter alloc] initWithData:DMCDataFromHex(@"03ce429905000000010000")], @"Should reject truncated data");
+}
+
++ (void) testFillRatio {
+    DMCBloomFilter* filter = [[DMCBloomFilter alloc] initWithElementCount:1000 falsePositiveRate:0.001 tweak:12345 flags:DMCBloomFilterUpdateNone];
+    NSAssert(filter.fillRatio == 0 && filter.falsePositiveRate == 0 && !filter.needsReload, @"Empty filter has no false positives");
+
+    NSUInteger i = 0;
+    for (; i < 1000; i++) {
+        [filter insertData:DMCSHA256([NSData dataWithBytes:&i length:sizeof(i)])];
+    }
+    NSAssert(filter.elementCount == 1000, @"Should count elements");
+    NSAssert(fabs(filter.fillRatio - 0.5) < 0.05, @"Filter sized for its element count should be about half full");
+    NSAssert(filter.falsePositiveRate < filter.maxFalsePositiveRate && !filter.needsReload, @"Filter should be within its rate");
+
+    // Keep adding elements like filteradd would until the filter asks for a reload.
+    while (!filter.needsReload && i < 3000) {
+        [filter insertData:DMCSHA256([NSData dataWithBytes:&i length:sizeof(i)])];
+        i++;
+    }
+    NSAssert(filter.needsReload && i > 1050 && i < 1500, @"Filter should ask for a reload soon after its element count is exceeded");
+
+    // Measured rate should be close to the estimate.
+    NSUInteger falsePositives = 0;
+    for (NSUInteger j = 1000000; j < 1100000; j++) {
+        if ([filter containsData:DMCSHA256([NSData dataWithBytes:&j length:sizeof(j)])]) falsePositives++;
+    }
+    double rate = falsePositives / 100000.0;
+    NSAssert(rate < filter.falsePositiveRate * 2 && rate > filter.falsePositiveRate / 2, @"Measured false positive rate %f should match the estimate %f", rate, filter.falsePositiveRate);
+}
+
++ (void) benchmarkInsertAndLookup {
+    const NSUInteger count = 100000;
+    NSMutableArray* elements = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [elements addObject:[DMCSHA256([NSData dataWithBytes:&i length:sizeof(i)]) subdataWithRange:NSMakeRange(0, 20)]];
+    }
+
+    DMCBloomFilter* filter = [[DMCBloomFilter alloc] initWithElementCount:count falsePositiveRate:0.0005 tweak:0 flags:DMCBloomFilterUpdateAll];
+
+    CFAbsoluteTime t0 = CFAbsoluteTimeGetCurrent();
+    for (NSData* element in elements) [filter insertData:element];
+    CFAbsoluteTime t1 = CFAbsoluteTimeGetCurrent();
+    NSUInteger found = 0;
+    for (NSData* element in elements) found += [filter containsData:element];
+    CFAbsoluteTime t2 = CFAbsoluteTimeGetCurrent();
+
+    NSAssert(found == count, @"All inserted elements should be found");
+    NSLog(@"Bloom filter %lu bytes, %u hash functions: insert %.0f/s, lookup %.0f/s, false positive rate %f",
+          (unsigned long)filter.filterData.length, filter.hashFunctionCount, count / (t1 - t0), count / (t2 - t1), filter.falsePositiveRate);
+}
+
+@end
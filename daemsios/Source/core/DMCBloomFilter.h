@@ -0,0 +1,68 @@
+// 
+
+#import <Foundation/Foundation.h>
+
+// What a full node adds to the filter when an output matches (BIP37 nFlags).
+typedef NS_ENUM(uint8_t, DMCBloomFilterUpdate) {
+    DMCBloomFilterUpdateNone         = 0, // filter is not changed by the node
+    DMCBloomFilterUpdateAll          = 1, // outpoints of all matched outputs are added
+    DMCBloomFilterUpdateP2PubKeyOnly = 2, // outpoints are added only for pay-to-pubkey and multisig outputs
+};
+
+// MurmurHash3 (x86, 32-bit) of the data with the seed, as used by BIP37.
+uint32_t DMCMurmurHash3(uint32_t seed, const void* data, size_t length);
+
+// BIP37 bloom filter to load into peers with filterload and extend with filteradd.
+// The filter counts the bits it has set, so it knows its fill ratio and the false positive rate
+// it has now, not just the one it was sized for. When elements are added with filteradd
+// the rate grows; `needsReload` tells when it is time to build a bigger filter and send filterload.
+@interface DMCBloomFilter : NSObject <NSCopying>
+
+// Filter bytes (without serialization prefix).
+@property(nonatomic, readonly) NSData* filterData;
+
+// Number of hash functions.
+@property(nonatomic, readonly) uint32_t hashFunctionCount;
+
+// Random value that makes filters of different wallets differ (BIP37 nTweak).
+@property(nonatomic, readonly) uint32_t tweak;
+
+@property(nonatomic, readonly) DMCBloomFilterUpdate flags;
+
+// Number of elements inserted since the filter was created.
+@property(nonatomic, readonly) NSUInteger elementCount;
+
+// Share of bits that are set, from 0 to 1.
+@property(nonatomic, readonly) double fillRatio;
+
+// False positive rate the filter was sized for.
+@property(nonatomic, readonly) double targetFalsePositiveRate;
+
+// False positive rate implied by the current fill ratio: fillRatio ^ hashFunctionCount.
+@property(nonatomic, readonly) double falsePositiveRate;
+
+// Rate above which `needsReload` becomes YES. Default is twice the target rate.
+@property(nonatomic) double maxFalsePositiveRate;
+
+// YES when the filter is too full to keep adding elements with filteradd
+// and a new filter sized for the current element count should be sent with filterload.
+@property(nonatomic, readonly) BOOL needsReload;
+
+// BIP37 serialization: var_str filter, uint32 nHashFuncs, uint32 nTweak, uint8 nFlags. Payload of filterload.
+@property(nonatomic, readonly) NSData* data;
+
+// Creates a filter sized for the number of elements and the false positive rate, within BIP37 limits
+// (36000 bytes and 50 hash functions).
+- (id) initWithElementCount:(NSUInteger)elementCount falsePositiveRate:(double)falsePositiveRate tweak:(uint32_t)tweak flags:(DMCBloomFilterUpdate)flags;
+
+// Parses BIP37 serialization. Returns nil if the data is invalid or over BIP37 limits.
+// Element count is unknown in this case, so `targetFalsePositiveRate` is the current rate.
+- (id) initWithData:(NSData*)data;
+
+// Adds the element (e.g. a public key hash or a serialized outpoint).
+- (void) insertData:(NSData*)data;
+
+// Returns YES if the element may be in the filter, NO if it is definitely not.
+- (BOOL) containsData:(NSData*)data;
+
+@end
@@ -0,0 +1,178 @@
+// 
+
+#import "DMCBloomFilter.h"
+#import "DMCProtocolSerialization.h"
+
+#define DMCBloomFilterMaxLength        36000 // bytes
+#define DMCBloomFilterMaxHashFunctions 50
+#define DMCBloomFilterSeedMultiplier   0xfba4c795
+
+static inline uint32_t DMCRotateLeft32(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+uint32_t DMCMurmurHash3(uint32_t seed, const void* data, size_t length) {
+    const uint8_t* bytes = data;
+    const uint32_t c1 = 0xcc9e2d51;
+    const uint32_t c2 = 0x1b873593;
+    uint32_t h1 = seed;
+    size_t blocks = length / 4;
+
+    for (size_t i = 0; i < blocks; i++) {
+        const uint8_t* b = bytes + i * 4;
+        uint32_t k1 = b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+
+        k1 *= c1;
+        k1 = DMCRotateLeft32(k1, 15);
+        k1 *= c2;
+
+        h1 ^= k1;
+        h1 = DMCRotateLeft32(h1, 13);
+        h1 = h1 * 5 + 0xe6546b64;
+    }
+
+    const uint8_t* tail = bytes + blocks * 4;
+    uint32_t k1 = 0;
+
+    switch (length & 3) {
+        case 3: k1 ^= tail[2] << 16; // fall through
+        case 2: k1 ^= tail[1] << 8;  // fall through
+        case 1:
+            k1 ^= tail[0];
+            k1 *= c1;
+            k1 = DMCRotateLeft32(k1, 15);
+            k1 *= c2;
+            h1 ^= k1;
+    }
+
+    h1 ^= (uint32_t)length;
+    h1 ^= h1 >> 16;
+    h1 *= 0x85ebca6b;
+    h1 ^= h1 >> 13;
+    h1 *= 0xc2b2ae35;
+    h1 ^= h1 >> 16;
+    return h1;
+}
+
+
+@implementation DMCBloomFilter {
+    NSMutableData* _filter;
+    NSUInteger _setBits;
+}
+
+- (id) initWithElementCount:(NSUInteger)elementCount falsePositiveRate:(double)falsePositiveRate tweak:(uint32_t)tweak flags:(DMCBloomFilterUpdate)flags {
+    if (self = [super init]) {
+        double n = MAX(elementCount, 1);
+        double p = MIN(MAX(falsePositiveRate, 1e-10), 1.0 - 1e-10);
+
+        // Optimal size and number of hash functions from BIP37.
+        NSUInteger length = (NSUInteger)(MIN(-1.0 / (M_LN2 * M_LN2) * n * log(p), DMCBloomFilterMaxLength * 8) / 8);
+        length = MAX(length, 1);
+
+        _hashFunctionCount = (uint32_t)MAX(MIN(length * 8 / n * M_LN2, DMCBloomFilterMaxHashFunctions), 1);
+        _filter = [NSMutableData dataWithLength:length];
+        _tweak = tweak;
+        _flags = flags;
+        _targetFalsePositiveRate = p;
+        _maxFalsePositiveRate = 2 * p;
+    }
+    return self;
+}
+
+- (id) initWithData:(NSData*)data {
+    if (self = [super init]) {
+        NSUInteger offset = 0;
+        NSData* filter = [DMCProtocolSerialization readVarStringFromData:data readBytes:&offset];
+
+        if (!filter || filter.length == 0 || filter.length > DMCBloomFilterMaxLength || data.length != offset + 9) return nil;
+
+        const uint8_t* tail = (const uint8_t*)data.bytes + offset;
+        memcpy(&_hashFunctionCount, tail, 4);
+        memcpy(&_tweak, tail + 4, 4);
+        _hashFunctionCount = OSSwapLittleToHostInt32(_hashFunctionCount);
+        _tweak = OSSwapLittleToHostInt32(_tweak);
+        _flags = tail[8];
+
+        if (_hashFunctionCount == 0 || _hashFunctionCount > DMCBloomFilterMaxHashFunctions) return nil;
+
+        _filter = [filter mutableCopy];
+
+        const uint8_t* bytes = _filter.bytes;
+        for (NSUInteger i = 0; i < _filter.length; i++) {
+            _setBits += __builtin_popcount(bytes[i]);
+        }
+
+        _targetFalsePositiveRate = self.falsePositiveRate;
+        _maxFalsePositiveRate = 2 * _targetFalsePositiveRate;
+    }
+    return self;
+}
+
+- (id) copyWithZone:(NSZone*)zone {
+    DMCBloomFilter* filter = [[DMCBloomFilter alloc] init];
+    filter->_filter = [_filter mutableCopy];
+    filter->_setBits = _setBits;
+    filter->_hashFunctionCount = _hashFunctionCount;
+    filter->_tweak = _tweak;
+    filter->_flags = _flags;
+    filter->_elementCount = _elementCount;
+    filter->_targetFalsePositiveRate = _targetFalsePositiveRate;
+    filter->_maxFalsePositiveRate = _maxFalsePositiveRate;
+    return filter;
+}
+
+- (NSData*) filterData {
+    return [_filter copy];
+}
+
+- (double) fillRatio {
+    return (double)_setBits / (_filter.length * 8);
+}
+
+- (double) falsePositiveRate {
+    return pow(self.fillRatio, _hashFunctionCount);
+}
+
+- (BOOL) needsReload {
+    return self.falsePositiveRate > _maxFalsePositiveRate;
+}
+
+- (NSData*) data {
+    NSMutableData* data = [NSMutableData dataWithData:[DMCProtocolSerialization dataForVarString:_filter]];
+    uint32_t hashFunctionCount = OSSwapHostToLittleInt32(_hashFunctionCount);
+    uint32_t tweak = OSSwapHostToLittleInt32(_tweak);
+    uint8_t flags = _flags;
+    [data appendBytes:&hashFunctionCount length:4];
+    [data appendBytes:&tweak length:4];
+    [data appendBytes:&flags length:1];
+    return data;
+}
+
+- (void) insertData:(NSData*)data {
+    uint8_t* bytes = _filter.mutableBytes;
+    uint32_t bitCount = (uint32_t)(_filter.length * 8);
+
+    for (uint32_t i = 0; i < _hashFunctionCount; i++) {
+        uint32_t index = DMCMurmurHash3(i * DMCBloomFilterSeedMultiplier + _tweak, data.bytes, data.length) % bitCount;
+        uint8_t mask = 1 << (index & 7);
+
+        if (!(bytes[index >> 3] & mask)) {
+            bytes[index >> 3] |= mask;
+            _setBits++;
+        }
+    }
+    _elementCount++;
+}
+
+- (BOOL) containsData:(NSData*)data {
+    const uint8_t* bytes = _filter.bytes;
+    uint32_t bitCount = (uint32_t)(_filter.length * 8);
+
+    for (uint32_t i = 0; i < _hashFunctionCount; i++) {
+        uint32_t index = DMCMurmurHash3(i * DMCBloomFilterSeedMultiplier + _tweak, data.bytes, data.length) % bitCount;
+        if (!(bytes[index >> 3] & (1 << (index & 7)))) return NO;
+    }
+    return YES;
+}
+
+@end
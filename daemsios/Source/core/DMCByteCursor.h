@@ -0,0 +1,43 @@
+// 
+
+#import <Foundation/Foundation.h>
+
+// Byte cursor reads protocol fields directly from a data buffer.
+// Every read is bounds-checked: on failure it returns NO (or nil) and leaves the offset unchanged.
+// Data returned by the cursor is a slice that references the underlying buffer instead of copying bytes.
+// Mutable data is copied once on init, so slices stay valid if the original is modified later.
+@interface DMCByteCursor : NSObject
+
+// Buffer being read.
+@property(nonatomic, readonly) NSData* data;
+
+// Current read position. Can be set to any value within the buffer.
+@property(nonatomic) NSUInteger offset;
+
+// Number of bytes left to read.
+@property(nonatomic, readonly) NSUInteger remainingLength;
+
+- (id) initWithData:(NSData*)data;
+
+// Little-endian integers.
+- (BOOL) readUInt8:(uint8_t*)valueOut;
+- (BOOL) readUInt16:(uint16_t*)valueOut;
+- (BOOL) readUInt32:(uint32_t*)valueOut;
+- (BOOL) readUInt64:(uint64_t*)valueOut;
+
+// Variable-length integer (see DMCProtocolSerialization).
+- (BOOL) readVarInt:(uint64_t*)valueOut;
+
+// Returns a slice of the given length or nil if there are not enough bytes.
+- (NSData*) readDataOfLength:(NSUInteger)length;
+
+// Returns a slice prepended by its length in varInt format or nil on failure.
+- (NSData*) readVarData;
+
+// Moves the cursor forward without reading data.
+- (BOOL) skipLength:(NSUInteger)length;
+
+// Returns a slice of the buffer at the given range (e.g. a span of already read fields).
+- (NSData*) sliceWithRange:(NSRange)range;
+
+@end
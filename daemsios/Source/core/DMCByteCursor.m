@@ -0,0 +1,123 @@
+// 
+
+#import "DMCByteCursor.h"
+
+@implementation DMCByteCursor {
+    const uint8_t* _bytes;
+    NSUInteger _length;
+}
+
+- (id) initWithData:(NSData*)data {
+    if (!data) return nil;
+    if (self = [super init]) {
+        // Copying immutable data simply retains it.
+        _data = [data copy];
+        _bytes = _data.bytes;
+        _length = _data.length;
+        _offset = 0;
+    }
+    return self;
+}
+
+- (void) setOffset:(NSUInteger)offset {
+    _offset = MIN(offset, _length);
+}
+
+- (NSUInteger) remainingLength {
+    return _length - _offset;
+}
+
+- (BOOL) readUInt8:(uint8_t*)valueOut {
+    if (_length - _offset < 1) return NO;
+    if (valueOut) *valueOut = _bytes[_offset];
+    _offset += 1;
+    return YES;
+}
+
+- (BOOL) readUInt16:(uint16_t*)valueOut {
+    if (_length - _offset < 2) return NO;
+    if (valueOut) *valueOut = OSReadLittleInt16(_bytes, _offset);
+    _offset += 2;
+    return YES;
+}
+
+- (BOOL) readUInt32:(uint32_t*)valueOut {
+    if (_length - _offset < 4) return NO;
+    if (valueOut) *valueOut = OSReadLittleInt32(_bytes, _offset);
+    _offset += 4;
+    return YES;
+}
+
+- (BOOL) readUInt64:(uint64_t*)valueOut {
+    if (_length - _offset < 8) return NO;
+    if (valueOut) *valueOut = OSReadLittleInt64(_bytes, _offset);
+    _offset += 8;
+    return YES;
+}
+
+- (BOOL) readVarInt:(uint64_t*)valueOut {
+    NSUInteger offset = _offset;
+    uint8_t size = 0;
+    if (![self readUInt8:&size]) return NO;
+
+    uint64_t value = size;
+    BOOL result = YES;
+    if (size == 0xfd) {
+        uint16_t v16 = 0;
+        result = [self readUInt16:&v16];
+        value = v16;
+    } else if (size == 0xfe) {
+        uint32_t v32 = 0;
+        result = [self readUInt32:&v32];
+        value = v32;
+    } else if (size == 0xff) {
+        result = [self readUInt64:&value];
+    }
+
+    if (!result) {
+        _offset = offset;
+        return NO;
+    }
+    if (valueOut) *valueOut = value;
+    return YES;
+}
+
+- (NSData*) readDataOfLength:(NSUInteger)length {
+    if (_length - _offset < length) return nil;
+    NSData* slice = [self sliceWithRange:NSMakeRange(_offset, length)];
+    _offset += length;
+    return slice;
+}
+
+- (NSData*) readVarData {
+    NSUInteger offset = _offset;
+    uint64_t length = 0;
+    if (![self readVarInt:&length]) return nil;
+    if (length > _length - _offset) {
+        _offset = offset;
+        return nil;
+    }
+    return [self readDataOfLength:(NSUInteger)length];
+}
+
+- (BOOL) skipLength:(NSUInteger)length {
+    if (_length - _offset < length) return NO;
+    _offset += length;
+    return YES;
+}
+
+- (NSData*) sliceWithRange:(NSRange)range {
+    if (range.location > _length || range.length > _length - range.location) return nil;
+    if (range.length == 0) return [NSData data];
+    if (range.location == 0 && range.length == _length) return _data;
+
+    // Slice keeps the whole buffer alive instead of copying its bytes.
+    NSData* buffer = _data;
+    return [[NSData alloc] initWithBytesNoCopy:(void*)(_bytes + range.location)
+                                        length:range.length
+                                   deallocator:^(void* bytes, NSUInteger length) {
+                                       (void)buffer;
+                                   }];
+}
+
+@end
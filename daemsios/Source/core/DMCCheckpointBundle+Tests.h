@@ -0,0 +1,9 @@
+// 
+
+#import "DMCCheckpointBundle.h"
+
+@interface DMCCheckpointBundle (Tests)
+
++ (void) runAllTests;
+
+@end
@@ -0,0 +1,108 @@
+// 
+
+#import "DMCCheckpointBundle+Tests.h"
+#import "DMCBlockHeader.h"
+#import "DMCBigNumber.h"
+#import "DMCData.h"
+#import "DMCKey.h"
+#import "DMCNetwork.h"
+#import "DMCHeaderStore.h"
+#import "DMCHeaderTree.h"
+
+@implementation DMCCheckpointBundle (Tests)
+
++ (void) runAllTests {
+    [self testLoading];
+    [self testLoadTimeBudget];
+}
+
++ (DMCKey*) signingKey {
+    return [[DMCKey alloc] initWithPrivateKey:DMCHash256([@"checkpoint bundle test key" dataUsingEncoding:NSUTF8StringEncoding])];
+}
+
+// Returns a bundle with a checkpoint every `interval` blocks, one block per 10 minutes since 2014-05-13.
++ (NSData*) bundleDataWithCount:(NSUInteger)count interval:(uint32_t)interval network:(DMCNetwork*)network {
+    NSMutableArray* headers = [NSMutableArray array];
+    NSMutableArray* heights = [NSMutableArray array];
+    NSMutableArray* works = [NSMutableArray array];
+
+    for (NSUInteger i = 0; i < count; i++) {
+        uint32_t height = (uint32_t)i * interval;
+        DMCBlockHeader* header = [[DMCBlockHeader alloc] init];
+        header.time = 1400000000 + height * 600;
+        header.difficultyTarget = 0x1d00ffff;
+        header.nonce = height;
+        [headers addObject:header];
+        [heights addObject:@(height)];
+        [works addObject:[[DMCBigNumber alloc] initWithUInt64:(uint64_t)(height + 1) * 4295032833ULL]];
+    }
+
+    return [DMCCheckpointBundle bundleDataWithHeaders:headers heights:heights chainWorks:works interval:interval network:network privateKey:[self signingKey]];
+}
+
++ (DMCKey*) publicKey {
+    return [[DMCKey alloc] initWithPublicKey:[self signingKey].publicKey];
+}
+
++ (void) testLoading {
+    DMCNetwork* network = [[DMCNetwork testnet] copy];
+    network.genesisBlockHash = DMCHash256([@"genesis" dataUsingEncoding:NSUTF8StringEncoding]);
+
+    NSData* data = [self bundleDataWithCount:100 interval:2016 network:network];
+    NSError* error = nil;
+    DMCCheckpointBundle* bundle = [[DMCCheckpointBundle alloc] initWithData:data network:network publicKey:[self publicKey] error:&error];
+    NSAssert(bundle && bundle.count == 100 && bundle.interval == 2016, @"Should load the bundle");
+    NSAssert([bundle heightAtIndex:10] == 20160 && [bundle headerAtIndex:10].nonce == 20160, @"Should read the record");
+    NSAssert([[bundle chainWorkAtIndex:10] isEqual:[[DMCBigNumber alloc] initWithUInt64:20161ULL * 4295032833ULL]], @"Should read the chain work");
+
+    NSMutableData* tampered = [data mutableCopy];
+    ((uint8_t*)tampered.mutableBytes)[100] ^= 1;
+    NSAssert(![[DMCCheckpointBundle alloc] initWithData:tampered network:network publicKey:[self publicKey] error:&error] && error.code == DMCCheckpointBundleInvalidSignature, @"Should reject a modified bundle");
+
+    DMCNetwork* other = [network copy];
+    other.genesisBlockHash = DMCZero256();
+    NSAssert(![[DMCCheckpointBundle alloc] initWithData:data network:other publicKey:[self publicKey] error:&error] && error.code == DMCCheckpointBundleWrongNetwork, @"Should reject a bundle of another network");
+
+    NSAssert(![[DMCCheckpointBundle alloc] initWithData:[data subdataWithRange:NSMakeRange(0, data.length - 1)] network:network publicKey:[self publicKey] error:&error] && error.code == DMCCheckpointBundleCorrupted, @"Should reject a truncated bundle");
+
+    // Key created 30 days after checkpoint 20, checkpoints are 14 days apart: the last one a week before is 21.
+    NSTimeInterval keyTime = 1400000000 + 20 * 2016 * 600 + 30 * 24 * 3600 - NSTimeIntervalSince1970;
+    NSAssert([bundle indexOfCheckpointBeforeTime:keyTime] == 21, @"Should pick the last checkpoint a week before the key time");
+    NSAssert([bundle indexOfCheckpointBeforeTime:1400000000 - NSTimeIntervalSince1970] == NSNotFound, @"No checkpoint before the first one");
+
+    NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    DMCHeaderStore* store = [[DMCHeaderStore alloc] initWithPath:path error:&error];
+    NSAssert([bundle loadCheckpointBeforeTime:keyTime intoStore:store error:&error], @"Should load the checkpoint");
+    NSAssert(store.count == 1 && store.baseHeight == 21 * 2016, @"Store should start at the checkpoint");
+    NSAssert([store.tipHash isEqual:[bundle headerAtIndex:21].blockHash], @"Store tip should be the checkpoint");
+
+    DMCHeaderTree* tree = [bundle headerTreeWithCheckpointAtIndex:21];
+    NSAssert(tree.root.height == 21 * 2016 && [tree.root.chainWork isEqual:[bundle chainWorkAtIndex:21]], @"Tree should carry the checkpoint work");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
++ (void) testLoadTimeBudget {
+    // A checkpoint every 100 blocks up to height 1,000,000.
+    NSData* data = [self bundleDataWithCount:10000 interval:100 network:[DMCNetwork testnet]];
+    NSString* bundlePath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    NSString* storePath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    [data writeToFile:bundlePath atomically:YES];
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    NSError* error = nil;
+    DMCCheckpointBundle* bundle = [[DMCCheckpointBundle alloc] initWithContentsOfFile:bundlePath network:[DMCNetwork testnet] publicKey:[self publicKey] error:&error];
+    DMCHeaderStore* store = [[DMCHeaderStore alloc] initWithPath:storePath error:&error];
+    BOOL loaded = [bundle loadCheckpointBeforeTime:[NSDate distantFuture].timeIntervalSinceReferenceDate intoStore:store error:&error];
+
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+
+    NSAssert(loaded && store.baseHeight == 9999 * 100, @"Should load the last checkpoint");
+    NSAssert(elapsed < 0.25, @"Loading a bundle of 10000 checkpoints took %.3f sec, budget is 0.25 sec", elapsed);
+
+    [[NSFileManager defaultManager] removeItemAtPath:bundlePath error:NULL];
+    [[NSFileManager defaultManager] removeItemAtPath:storePath error:NULL];
+}
+
+@end
@@ -0,0 +1,88 @@
+// 
+
+#import <Foundation/Foundation.h>
+
+@class DMCKey;
+@class DMCNetwork;
+@class DMCBlockHeader;
+@class DMCBigNumber;
+@class DMCHeaderStore;
+@class DMCHeaderTree;
+
+extern NSString* const DMCCheckpointBundleErrorDomain;
+
+typedef NS_ENUM(NSInteger, DMCCheckpointBundleError) {
+
+    // Data is not a checkpoint bundle, has an unknown version or is damaged.
+    DMCCheckpointBundleCorrupted = 1,
+
+    // Bundle is not signed by the expected key.
+    DMCCheckpointBundleInvalidSignature = 2,
+
+    // Bundle was made for another network.
+    DMCCheckpointBundleWrongNetwork = 3,
+
+    // No checkpoint is old enough for the requested time.
+    DMCCheckpointBundleNoCheckpoint = 4,
+};
+
+// Checkpoint bundle is a signed, versioned snapshot of the header chain shipped as a resource,
+// so a fresh install starts syncing headers near the wallet's creation time instead of from genesis.
+//
+// Binary format (integers are little-endian):
+//   uint32 magic "DMCK", uint32 version, 32-byte genesis block hash, uint32 interval, uint32 count,
+//   `count` records of { uint32 height, 80-byte header, 32-byte big-endian chain work } sorted by height,
+//   65-byte compact signature of the double SHA-256 of everything before it.
+//
+// Records are read from the buffer on demand, so loading a bundle costs one hash and one signature check.
+@interface DMCCheckpointBundle : NSObject
+
+// Format version of the bundle.
+@property(nonatomic, readonly) uint32_t version;
+
+// Hash of the genesis block of the network the bundle was made for.
+@property(nonatomic, readonly) NSData* genesisBlockHash;
+
+// Number of blocks between checkpoints.
+@property(nonatomic, readonly) uint32_t interval;
+
+// Number of checkpoints.
+@property(nonatomic, readonly) NSUInteger count;
+
+// Returns the path of the bundle resource for the network ("checkpoints-<network name>.dat"), or nil if it is not shipped.
++ (NSString*) resourcePathForNetwork:(DMCNetwork*)network;
+
+// Loads and verifies the bundle. The signature must be made by the public key
+// and the genesis block hash must match the network (if the network has one).
+// A nil public key is treated as a signature mismatch: returns nil and sets DMCCheckpointBundleInvalidSignature,
+// so without the publisher key no bundle is trusted and sync starts from whatever the store holds (e.g. genesis).
+- (id) initWithData:(NSData*)data network:(DMCNetwork*)network publicKey:(DMCKey*)publicKey error:(NSError**)errorOut;
+
+// Same as initWithData:network:publicKey:error:, reading the file mapped in memory.
+- (id) initWithContentsOfFile:(NSString*)path network:(DMCNetwork*)network publicKey:(DMCKey*)publicKey error:(NSError**)errorOut;
+
+- (uint32_t) heightAtIndex:(NSUInteger)index;
+- (DMCBlockHeader*) headerAtIndex:(NSUInteger)index;
+- (DMCBigNumber*) chainWorkAtIndex:(NSUInteger)index;
+
+// Returns the index of the last checkpoint whose block time is at least a week before the time
+// (interval since reference date, like DMCPeer.earliestKeyTime), or NSNotFound.
+- (NSUInteger) indexOfCheckpointBeforeTime:(NSTimeInterval)time;
+
+// Starts an empty header store at the last checkpoint before the time, so headers are synced only from there.
+// Does nothing and returns YES if the store already has headers.
+// Returns NO and sets DMCCheckpointBundleNoCheckpoint if no checkpoint is old enough.
+- (BOOL) loadCheckpointBeforeTime:(NSTimeInterval)time intoStore:(DMCHeaderStore*)store error:(NSError**)errorOut;
+
+// Returns a header tree rooted at the checkpoint, carrying its chain work.
+- (DMCHeaderTree*) headerTreeWithCheckpointAtIndex:(NSUInteger)index;
+
+// Builds a signed bundle. Arrays are sorted by height and have equal length.
++ (NSData*) bundleDataWithHeaders:(NSArray* /* [DMCBlockHeader] */)headers
+                          heights:(NSArray* /* [NSNumber] */)heights
+                       chainWorks:(NSArray* /* [DMCBigNumber] */)chainWorks
+                         interval:(uint32_t)interval
+                          network:(DMCNetwork*)network
+                       privateKey:(DMCKey*)privateKey;
+
+@end
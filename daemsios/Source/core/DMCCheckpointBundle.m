@@ -0,0 +1,200 @@
+// 
+
+#import "DMCCheckpointBundle.h"
+#import "DMCBlockHeader.h"
+#import "DMCBigNumber.h"
+#import "DMCByteCursor.h"
+#import "DMCData.h"
+#import "DMCKey.h"
+#import "DMCNetwork.h"
+#import "DMCHeaderStore.h"
+#import "DMCHeaderTree.h"
+
+NSString* const DMCCheckpointBundleErrorDomain = @"DMCCheckpointBundleErrorDomain";
+
+#define DMCCheckpointBundleMagic      0x4b434d44 // "DMCK"
+#define DMCCheckpointBundleVersion    1
+#define DMCCheckpointBundlePrefix     (4 + 4 + 32 + 4 + 4)
+#define DMCCheckpointBundleRecord     (4 + 80 + 32)
+#define DMCCheckpointBundleSignature  65
+#define DMCCheckpointBundleTimeMargin (7*24*60*60) // same margin DMCPeer uses around earliestKeyTime
+
+@implementation DMCCheckpointBundle {
+    NSData* _data;
+    const uint8_t* _records;
+}
+
++ (NSString*) resourcePathForNetwork:(DMCNetwork*)network {
+    NSString* name = [NSString stringWithFormat:@"checkpoints-%@", network.name];
+    return [[NSBundle bundleForClass:self] pathForResource:name ofType:@"dat"];
+}
+
+- (id) initWithContentsOfFile:(NSString*)path network:(DMCNetwork*)network publicKey:(DMCKey*)publicKey error:(NSError**)errorOut {
+    NSData* data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:errorOut];
+    if (!data) return nil;
+    return [self initWithData:data network:network publicKey:publicKey error:errorOut];
+}
+
+- (id) initWithData:(NSData*)data network:(DMCNetwork*)network publicKey:(DMCKey*)publicKey error:(NSError**)errorOut {
+    if (self = [super init]) {
+        data = [data copy]; // records are read through a pointer into the buffer
+        DMCByteCursor* cursor = [[DMCByteCursor alloc] initWithData:data];
+        uint32_t magic = 0;
+        uint32_t count = 0;
+
+        if (![cursor readUInt32:&magic] || magic != DMCCheckpointBundleMagic ||
+            ![cursor readUInt32:&_version] || _version != DMCCheckpointBundleVersion ||
+            !(_genesisBlockHash = [cursor readDataOfLength:32]) ||
+            ![cursor readUInt32:&_interval] ||
+            ![cursor readUInt32:&count] ||
+            cursor.remainingLength != (NSUInteger)count * DMCCheckpointBundleRecord + DMCCheckpointBundleSignature) {
+            if (errorOut) *errorOut = [NSError errorWithDomain:DMCCheckpointBundleErrorDomain code:DMCCheckpointBundleCorrupted userInfo:nil];
+            return nil;
+        }
+
+        NSUInteger signedLength = data.length - DMCCheckpointBundleSignature;
+        NSData* hash = DMCHash256([data subdataWithRange:NSMakeRange(0, signedLength)]);
+        NSData* signature = [data subdataWithRange:NSMakeRange(signedLength, DMCCheckpointBundleSignature)];
+
+        if (!publicKey || ![publicKey isValidCompactSignature:signature forHash:hash]) {
+            if (errorOut) *errorOut = [NSError errorWithDomain:DMCCheckpointBundleErrorDomain code:DMCCheckpointBundleInvalidSignature userInfo:nil];
+            return nil;
+        }
+
+        if (network.genesisBlockHash && ![_genesisBlockHash isEqual:network.genesisBlockHash]) {
+            if (errorOut) *errorOut = [NSError errorWithDomain:DMCCheckpointBundleErrorDomain code:DMCCheckpointBundleWrongNetwork userInfo:nil];
+            return nil;
+        }
+
+        _data = data;
+        _records = (const uint8_t*)data.bytes + DMCCheckpointBundlePrefix;
+        _count = count;
+
+        // Binary search below depends on the order.
+        for (NSUInteger i = 1; i < _count; i++) {
+            if ([self heightAtIndex:i] <= [self heightAtIndex:i - 1]) {
+                if (errorOut) *errorOut = [NSError errorWithDomain:DMCCheckpointBundleErrorDomain code:DMCCheckpointBundleCorrupted userInfo:nil];
+                return nil;
+            }
+        }
+    }
+    return self;
+}
+
+
+
+#pragma mark - Records
+
+
+- (const uint8_t*) recordAtIndex:(NSUInteger)index {
+    NSAssert(index < _count, @"Checkpoint index out of bounds");
+    return _records + index * DMCCheckpointBundleRecord;
+}
+
+- (uint32_t) heightAtIndex:(NSUInteger)index {
+    uint32_t height;
+    memcpy(&height, [self recordAtIndex:index], 4);
+    return OSSwapLittleToHostInt32(height);
+}
+
+- (uint32_t) timeAtIndex:(NSUInteger)index {
+    uint32_t time;
+    memcpy(&time, [self recordAtIndex:index] + 4 + 68, 4);
+    return OSSwapLittleToHostInt32(time);
+}
+
+- (NSData*) headerDataAtIndex:(NSUInteger)index {
+    return [NSData dataWithBytes:[self recordAtIndex:index] + 4 length:80];
+}
+
+- (DMCBlockHeader*) headerAtIndex:(NSUInteger)index {
+    DMCBlockHeader* header = [[DMCBlockHeader alloc] initWithData:[self headerDataAtIndex:index]];
+    header.height = [self heightAtIndex:index];
+    return header;
+}
+
+- (DMCBigNumber*) chainWorkAtIndex:(NSUInteger)index {
+    NSData* work = [NSData dataWithBytes:[self recordAtIndex:index] + 4 + 80 length:32];
+    return [[DMCBigNumber alloc] initWithUnsignedBigEndian:work];
+}
+
+- (NSUInteger) indexOfCheckpointBeforeTime:(NSTimeInterval)time {
+    NSTimeInterval limit = time + NSTimeIntervalSince1970 - DMCCheckpointBundleTimeMargin;
+
+    // Block times are not strictly increasing, but a week of margin is far above their drift.
+    NSUInteger lo = 0, hi = _count;
+    while (lo < hi) {
+        NSUInteger mid = lo + (hi - lo) / 2;
+        if ([self timeAtIndex:mid] <= limit) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (lo == 0) ? NSNotFound : lo - 1;
+}
+
+
+
+#pragma mark - Loading
+
+
+- (BOOL) loadCheckpointBeforeTime:(NSTimeInterval)time intoStore:(DMCHeaderStore*)store error:(NSError**)errorOut {
+    if (store.count > 0) return YES;
+
+    NSUInteger index = [self indexOfCheckpointBeforeTime:time];
+    if (index == NSNotFound) {
+        if (errorOut) *errorOut = [NSError errorWithDomain:DMCCheckpointBundleErrorDomain code:DMCCheckpointBundleNoCheckpoint userInfo:nil];
+        return NO;
+    }
+
+    [store resetToBaseHeight:[self heightAtIndex:index]];
+    if (![store appendHeaders:[self recordAtIndex:index] + 4 stride:80 count:1 appended:NULL error:errorOut]) return NO;
+    [store synchronize];
+    return YES;
+}
+
+- (DMCHeaderTree*) headerTreeWithCheckpointAtIndex:(NSUInteger)index {
+    return [[DMCHeaderTree alloc] initWithRootHeader:[self headerAtIndex:index]
+                                              height:[self heightAtIndex:index]
+                                           chainWork:[self chainWorkAtIndex:index]];
+}
+
+
+
+#pragma mark - Building
+
+
++ (NSData*) bundleDataWithHeaders:(NSArray*)headers
+                          heights:(NSArray*)heights
+                       chainWorks:(NSArray*)chainWorks
+                         interval:(uint32_t)interval
+                          network:(DMCNetwork*)network
+                       privateKey:(DMCKey*)privateKey {
+    if (headers.count != heights.count || headers.count != chainWorks.count) return nil;
+
+    NSMutableData* data = [NSMutableData dataWithCapacity:DMCCheckpointBundlePrefix + headers.count * DMCCheckpointBundleRecord + DMCCheckpointBundleSignature];
+
+    uint32_t magic = OSSwapHostToLittleInt32(DMCCheckpointBundleMagic);
+    uint32_t version = OSSwapHostToLittleInt32(DMCCheckpointBundleVersion);
+    uint32_t intervalLE = OSSwapHostToLittleInt32(interval);
+    uint32_t count = OSSwapHostToLittleInt32((uint32_t)headers.count);
+
+    [data appendBytes:&magic length:4];
+    [data appendBytes:&version length:4];
+    [data appendData:network.genesisBlockHash ?: DMCZero256()];
+    [data appendBytes:&intervalLE length:4];
+    [data appendBytes:&count length:4];
+
+    for (NSUInteger i = 0; i < headers.count; i++) {
+        uint32_t height = OSSwapHostToLittleInt32([heights[i] unsignedIntValue]);
+        [data appendBytes:&height length:4];
+        [data appendData:[headers[i] data]];
+        [data appendData:[chainWorks[i] unsignedBigEndian]];
+    }
+
+    [data appendData:[privateKey compactSignatureForHash:DMCHash256(data)]];
+    return data;
+}
+
+@end
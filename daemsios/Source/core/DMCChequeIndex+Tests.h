@@ -0,0 +1,9 @@
+// 
+
+#import "DMCChequeIndex.h"
+
+@interface DMCChequeIndex (Tests)
+
++ (void) runAllTests;
+
+@end
@@ -0,0 +1,78 @@
+// 
+
+#import "DMCChequeIndex+Tests.h"
+#import "DMCOutpoint.h"
+#import "DMCTransactionOutput.h"
+#import "DMCData.h"
+
+@implementation DMCChequeIndex (Tests)
+
++ (void) runAllTests {
+    [self testDiffs];
+    [self testSelection];
+}
+
++ (DMCOutpoint*) outpoint:(const char*)name {
+    return [[DMCOutpoint alloc] initWithHash:DMCSHA256(DMCDataWithUTF8CString(name)) index:1];
+}
+
++ (void) testDiffs {
+    NSString* address = @"1JwSSubhmg6iPtRjtyqhUYYH7bZg3Lfy1T";
+    DMCOutpoint* a = [self outpoint:"a"];
+    DMCOutpoint* b = [self outpoint:"b"];
+    DMCOutpoint* c = [self outpoint:"c"];
+    DMCChequeIndex* index = [[DMCChequeIndex alloc] init];
+    NSArray* added = nil;
+    NSArray* removed = nil;
+
+    [index updateCheques:@[ a, b ] values:@[ @100, @200 ] forAddress:address added:&added removed:&removed];
+    NSAssert(added.count == 2 && removed.count == 0, @"Should add both cheques");
+    NSAssert(index.totalValue == 300 && [index totalValueForAddress:address] == 300, @"Should sum cheque values");
+
+    [index updateCheques:@[ b, c ] values:@[ @250, @50 ] forAddress:address added:&added removed:&removed];
+    NSAssert([added isEqual:@[ c ]] && [removed isEqual:@[ a ]], @"Should report only the difference");
+    NSAssert([index valueForCheque:b] == 250 && [index valueForCheque:a] == -1, @"Should apply the difference");
+    NSAssert(index.count == 2 && index.totalValue == 300, @"Should update totals incrementally");
+
+    [index disableCheques:@[ b ]];
+    NSAssert([index isChequeDisabled:b] && index.totalValue == 50, @"Disabled cheque should leave the totals right away");
+    NSAssert([index unspentOutputsForAmount:100] == nil, @"Disabled cheque should not be selected");
+
+    [index updateCheques:@[ b, c ] values:@[ @250, @50 ] forAddress:address added:NULL removed:NULL];
+    NSAssert([index isChequeDisabled:b] && index.totalValue == 50, @"Cheque should stay disabled while the node lists it");
+
+    [index updateCheques:@[ c ] values:@[ @50 ] forAddress:address added:NULL removed:&removed];
+    NSAssert([removed isEqual:@[ b ]] && index.count == 1, @"Disabled cheque should be removed once the node drops it");
+
+    [index removeAddress:address];
+    NSAssert(index.count == 0 && index.totalValue == 0 && [index totalValueForAddress:address] == 0, @"Should remove all cheques of the address");
+}
+
++ (void) testSelection {
+    DMCChequeIndex* index = [[DMCChequeIndex alloc] init];
+    NSMutableArray* outpoints = [NSMutableArray array];
+    NSMutableArray* values = [NSMutableArray array];
+
+    for (int i = 0; i < 100; i++) {
+        [outpoints addObject:[self outpoint:[NSString stringWithFormat:@"%d", i].UTF8String]];
+        [values addObject:@((i * 37) % 100 * 1000)];
+    }
+    [index updateCheques:outpoints values:values forAddress:@"1LKF45kfvHAaP7C4cF91pVb3bkAsmQ8nBr" added:NULL removed:NULL];
+
+    DMCAmount previous = INT64_MAX;
+    NSUInteger count = 0;
+    for (DMCTransactionOutput* txout in [index unspentOutputsEnumerator]) {
+        NSAssert(txout.value <= previous, @"Cheques should be enumerated largest first");
+        NSAssert(txout.transactionHash.length == 32 && txout.index == 1, @"Output should reference the cheque");
+        previous = txout.value;
+        count++;
+    }
+    NSAssert(count == 100, @"Should enumerate all cheques");
+
+    NSArray* selected = [index unspentOutputsForAmount:150000];
+    NSAssert(selected.count == 2, @"Should pick the fewest cheques");
+    NSAssert([index unspentOutputsForAmount:index.totalValue].count == 99, @"Zero value cheque is not needed");
+    NSAssert([index unspentOutputsForAmount:index.totalValue + 1] == nil, @"Should fail when cheques are not enough");
+}
+
+@end
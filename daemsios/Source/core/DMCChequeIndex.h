@@ -0,0 +1,58 @@
+// 
+
+#import <Foundation/Foundation.h>
+#import "DMCUnitsAndLimits.h"
+
+@class DMCOutpoint;
+
+// Cheque index keeps the available cheques of the wallet's addresses, keyed by address and outpoint.
+// Lists reported by a node are applied as diffs, so unchanged cheques keep their entries and totals are
+// updated incrementally. Available cheques are kept sorted by value, so picking cheques to spend does not
+// sort or scan the whole index.
+@interface DMCChequeIndex : NSObject
+
+// Total value of cheques that are not disabled.
+@property(nonatomic, readonly) DMCAmount totalValue;
+
+// Number of cheques in the index, including disabled ones.
+@property(nonatomic, readonly) NSUInteger count;
+
+// Total value of the address's cheques that are not disabled.
+- (DMCAmount) totalValueForAddress:(NSString*)address;
+
+// Outpoints of all cheques of the address, including disabled ones.
+- (NSArray* /* [DMCOutpoint] */) chequesForAddress:(NSString*)address;
+
+// Value of the cheque, or -1 if it is not in the index.
+- (DMCAmount) valueForCheque:(DMCOutpoint*)outpoint;
+
+// Returns YES if the cheque was disabled locally and is waiting for the node to drop it.
+- (BOOL) isChequeDisabled:(DMCOutpoint*)outpoint;
+
+// Replaces the address's cheques with the list reported by a node.
+// Only the difference is applied: new outpoints are added, missing ones removed, changed values updated.
+// Outpoints that were added or removed are returned via addedOut and removedOut (pass NULL to ignore).
+// Cheques disabled locally stay disabled while the node still lists them.
+- (void) updateCheques:(NSArray* /* [DMCOutpoint] */)outpoints
+                values:(NSArray* /* [NSNumber] */)values
+            forAddress:(NSString*)address
+                 added:(NSArray**)addedOut
+               removed:(NSArray**)removedOut;
+
+// Marks cheques as disabled right after sending disablecheque for them.
+// They are excluded from totals and spend selection immediately, and removed once the node stops listing them.
+- (void) disableCheques:(NSArray* /* [DMCOutpoint] */)outpoints;
+
+// Removes all cheques of the address.
+- (void) removeAddress:(NSString*)address;
+
+// Returns available cheques as unspent outputs for DMCTransactionBuilder's `unspentOutputsEnumerator`,
+// largest first, so that the fewest cheques cover the amount.
+// Each output has `transactionHash`, `index`, `value` and the address's script set.
+- (NSEnumerator* /* [DMCTransactionOutput] */) unspentOutputsEnumerator;
+
+// Returns the smallest number of available cheques (largest first) whose values add up to at least amount,
+// or nil if all available cheques are not enough.
+- (NSArray* /* [DMCTransactionOutput] */) unspentOutputsForAmount:(DMCAmount)amount;
+
+@end
@@ -0,0 +1,245 @@
+// 
+
+#import "DMCChequeIndex.h"
+#import "DMCOutpoint.h"
+#import "DMCAddress.h"
+#import "DMCScript.h"
+#import "DMCTransactionOutput.h"
+
+@interface DMCChequeEntry : NSObject
+@property(nonatomic) DMCOutpoint* outpoint;
+@property(nonatomic) NSString* address;
+@property(nonatomic) DMCAmount value;
+@property(nonatomic) BOOL disabled;
+@property(nonatomic) DMCTransactionOutput* output; // created on first use by the transaction builder
+@end
+
+@implementation DMCChequeEntry
+@end
+
+// Enumerates a snapshot of available cheques, creating their outputs only as the builder consumes them.
+@interface DMCChequeEnumerator : NSEnumerator
+- (id) initWithEntries:(NSArray*)entries index:(DMCChequeIndex*)index;
+@end
+
+@interface DMCChequeIndex ()
+- (DMCTransactionOutput*) outputForEntry:(DMCChequeEntry*)entry;
+@end
+
+@implementation DMCChequeIndex {
+    NSMutableDictionary* _entries;   // DMCOutpoint -> DMCChequeEntry
+    NSMutableDictionary* _addresses; // address -> NSMutableSet of DMCOutpoint
+    NSMutableDictionary* _totals;    // address -> total value of available cheques
+    NSMutableDictionary* _scripts;   // address -> DMCScript
+    NSMutableArray* _available;      // entries that are not disabled, largest value first
+}
+
+- (id) init {
+    if (self = [super init]) {
+        _entries = [NSMutableDictionary dictionary];
+        _addresses = [NSMutableDictionary dictionary];
+        _totals = [NSMutableDictionary dictionary];
+        _scripts = [NSMutableDictionary dictionary];
+        _available = [NSMutableArray array];
+    }
+    return self;
+}
+
+- (NSUInteger) count {
+    return _entries.count;
+}
+
+- (DMCAmount) totalValueForAddress:(NSString*)address {
+    return [_totals[address] longLongValue];
+}
+
+- (NSArray*) chequesForAddress:(NSString*)address {
+    return [_addresses[address] allObjects] ?: @[];
+}
+
+- (DMCAmount) valueForCheque:(DMCOutpoint*)outpoint {
+    DMCChequeEntry* entry = _entries[outpoint];
+    return entry ? entry.value : -1;
+}
+
+- (BOOL) isChequeDisabled:(DMCOutpoint*)outpoint {
+    return [_entries[outpoint] disabled];
+}
+
+- (void) updateCheques:(NSArray*)outpoints
+                values:(NSArray*)values
+            forAddress:(NSString*)address
+                 added:(NSArray**)addedOut
+               removed:(NSArray**)removedOut {
+    NSMutableSet* stale = [_addresses[address] mutableCopy] ?: [NSMutableSet set];
+    NSMutableArray* added = [NSMutableArray array];
+
+    for (NSUInteger i = 0; i < outpoints.count && i < values.count; i++) {
+        DMCOutpoint* outpoint = outpoints[i];
+        DMCAmount value = [values[i] longLongValue];
+        DMCChequeEntry* entry = _entries[outpoint];
+
+        [stale removeObject:outpoint];
+
+        if (!entry) {
+            entry = [[DMCChequeEntry alloc] init];
+            entry.outpoint = [outpoint copy];
+            entry.address = address;
+            entry.value = value;
+            [self addEntry:entry];
+            [added addObject:entry.outpoint];
+        } else if (entry.value != value) {
+            BOOL available = !entry.disabled;
+            if (available) [self removeAvailableEntry:entry];
+            entry.value = value;
+            entry.output = nil;
+            if (available) [self insertAvailableEntry:entry];
+        }
+    }
+
+    for (DMCOutpoint* outpoint in stale) {
+        [self removeEntry:_entries[outpoint]];
+    }
+
+    if (addedOut) *addedOut = added;
+    if (removedOut) *removedOut = stale.allObjects;
+}
+
+- (void) disableCheques:(NSArray*)outpoints {
+    for (DMCOutpoint* outpoint in outpoints) {
+        DMCChequeEntry* entry = _entries[outpoint];
+        if (!entry || entry.disabled) continue;
+        [self removeAvailableEntry:entry];
+        entry.disabled = YES;
+    }
+}
+
+- (void) removeAddress:(NSString*)address {
+    for (DMCOutpoint* outpoint in [_addresses[address] copy]) {
+        [self removeEntry:_entries[outpoint]];
+    }
+    [_scripts removeObjectForKey:address];
+}
+
+- (NSEnumerator*) unspentOutputsEnumerator {
+    return [[DMCChequeEnumerator alloc] initWithEntries:[_available copy] index:self];
+}
+
+- (NSArray*) unspentOutputsForAmount:(DMCAmount)amount {
+    NSMutableArray* outputs = [NSMutableArray array];
+    DMCAmount total = 0;
+
+    for (DMCChequeEntry* entry in _available) {
+        if (total >= amount) break;
+        total += entry.value;
+        [outputs addObject:[self outputForEntry:entry]];
+    }
+
+    return total >= amount ? outputs : nil;
+}
+
+
+
+#pragma mark - Entries
+
+
+- (void) addEntry:(DMCChequeEntry*)entry {
+    _entries[entry.outpoint] = entry;
+
+    NSMutableSet* outpoints = _addresses[entry.address];
+    if (!outpoints) {
+        outpoints = [NSMutableSet set];
+        _addresses[entry.address] = outpoints;
+    }
+    [outpoints addObject:entry.outpoint];
+
+    if (!entry.disabled) [self insertAvailableEntry:entry];
+}
+
+- (void) removeEntry:(DMCChequeEntry*)entry {
+    if (!entry) return;
+    if (!entry.disabled) [self removeAvailableEntry:entry];
+
+    [_entries removeObjectForKey:entry.outpoint];
+
+    NSMutableSet* outpoints = _addresses[entry.address];
+    [outpoints removeObject:entry.outpoint];
+    if (outpoints.count == 0) {
+        [_addresses removeObjectForKey:entry.address];
+        [_totals removeObjectForKey:entry.address];
+    }
+}
+
+static NSComparisonResult DMCChequeCompare(DMCChequeEntry* a, DMCChequeEntry* b) {
+    if (a.value > b.value) return NSOrderedAscending;
+    if (a.value < b.value) return NSOrderedDescending;
+    return NSOrderedSame;
+}
+
+- (void) insertAvailableEntry:(DMCChequeEntry*)entry {
+    NSUInteger i = [_available indexOfObject:entry
+                               inSortedRange:NSMakeRange(0, _available.count)
+                                     options:NSBinarySearchingInsertionIndex | NSBinarySearchingLastEqual
+                             usingComparator:^NSComparisonResult(id a, id b) { return DMCChequeCompare(a, b); }];
+    [_available insertObject:entry atIndex:i];
+    [self addValue:entry.value forAddress:entry.address];
+}
+
+- (void) removeAvailableEntry:(DMCChequeEntry*)entry {
+    NSUInteger i = [_available indexOfObject:entry
+                               inSortedRange:NSMakeRange(0, _available.count)
+                                     options:NSBinarySearchingFirstEqual
+                             usingComparator:^NSComparisonResult(id a, id b) { return DMCChequeCompare(a, b); }];
+
+    // Several cheques can have the same value, find this one among them.
+    while (i < _available.count && _available[i] != entry) i++;
+    if (i >= _available.count) return;
+
+    [_available removeObjectAtIndex:i];
+    [self addValue:-entry.value forAddress:entry.address];
+}
+
+- (void) addValue:(DMCAmount)value forAddress:(NSString*)address {
+    _totalValue += value;
+    _totals[address] = @([_totals[address] longLongValue] + value);
+}
+
+- (DMCTransactionOutput*) outputForEntry:(DMCChequeEntry*)entry {
+    if (!entry.output) {
+        DMCScript* script = _scripts[entry.address];
+        if (!script) {
+            script = [[DMCScript alloc] initWithAddress:[DMCAddress addressWithString:entry.address]];
+            if (script) _scripts[entry.address] = script;
+        }
+
+        DMCTransactionOutput* txout = [[DMCTransactionOutput alloc] initWithValue:entry.value script:script];
+        txout.transactionHash = entry.outpoint.txHash;
+        txout.index = entry.outpoint.index;
+        entry.output = txout;
+    }
+    return entry.output;
+}
+
+@end
+
+
+@implementation DMCChequeEnumerator {
+    NSArray* _entries;
+    NSUInteger _position;
+    DMCChequeIndex* _index;
+}
+
+- (id) initWithEntries:(NSArray*)entries index:(DMCChequeIndex*)index {
+    if (self = [super init]) {
+        _entries = entries;
+        _index = index;
+    }
+    return self;
+}
+
+- (id) nextObject {
+    if (_position >= _entries.count) return nil;
+    return [_index outputForEntry:_entries[_position++]];
+}
+
+@end
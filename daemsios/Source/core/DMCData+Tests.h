@@ -5,5 +5,6 @@
 @interface NSData (DMC_Tests)
 
 + (void) runAllTests;
++ (void) runAllBenchmarks;
 
 @end
@@ -5,9 +5,231 @@
 #import "DMCBase58.h"
 #import "NS+DMCBase58.h"
 #import "DMCData+Tests.h"
+#import "DMCSHA256Lanes.h"
+#import "DMCHashBackend.h"
+#import "DMCHashID.h"
+#import "DMCHex.h"
+#import <CommonCrypto/CommonCrypto.h>
 
 @implementation NSData (DMC_Tests)
 
++ (void) runAllBenchmarks {
+    [self benchmarkHashBackends];
+    [self benchmarkSHA256Lanes];
+    [self benchmarkHex];
+}
+
+// Cross-checks every backend available on this CPU with CommonCrypto, one-shot and fed in uneven chunks.
++ (void) testHashBackends {
+    DMCHashBackendType defaultType = DMCHashBackendCurrentType();
+    NSMutableData* message = [NSMutableData dataWithLength:300];
+    for (NSUInteger i = 0; i < message.length; i++) {
+        ((unsigned char*)message.mutableBytes)[i] = (unsigned char)(i * 13 + 5);
+    }
+
+    for (NSNumber* type in @[ @(DMCHashBackendPortable), @(DMCHashBackendSHANI), @(DMCHashBackendARMv8) ]) {
+        if (!DMCHashBackendSetType(type.integerValue)) continue;
+
+        for (size_t len = 0; len <= message.length; len++) {
+            unsigned char expected256[CC_SHA256_DIGEST_LENGTH], actual256[CC_SHA256_DIGEST_LENGTH];
+            unsigned char expected1[CC_SHA1_DIGEST_LENGTH], actual1[CC_SHA1_DIGEST_LENGTH];
+            CC_SHA256(message.bytes, (CC_LONG)len, expected256);
+            CC_SHA1(message.bytes, (CC_LONG)len, expected1);
+
+            DMCSHA256Digest(actual256, message.bytes, len);
+            DMCSHA1Digest(actual1, message.bytes, len);
+            NSAssert(memcmp(expected256, actual256, sizeof(actual256)) == 0, @"SHA256 of %@ backend should match CommonCrypto", DMCHashBackendName(type.integerValue));
+            NSAssert(memcmp(expected1, actual1, sizeof(actual1)) == 0, @"SHA1 of %@ backend should match CommonCrypto", DMCHashBackendName(type.integerValue));
+
+            DMCSHA256Context ctx;
+            DMCSHA256Init(&ctx);
+            for (size_t offset = 0; offset < len; offset += 7) {
+                DMCSHA256Update(&ctx, (const unsigned char*)message.bytes + offset, MIN(7, len - offset));
+            }
+            DMCSHA256Final(&ctx, actual256);
+            NSAssert(memcmp(expected256, actual256, sizeof(actual256)) == 0, @"Incremental SHA256 should match one-shot hash");
+        }
+    }
+
+    DMCHashBackendSetType(defaultType);
+}
+
++ (void) benchmarkHashBackends {
+    DMCHashBackendType defaultType = DMCHashBackendCurrentType();
+    NSMutableData* data = [NSMutableData dataWithLength:16 * 1024 * 1024];
+    unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+
+    for (NSNumber* type in @[ @(DMCHashBackendPortable), @(DMCHashBackendSHANI), @(DMCHashBackendARMv8) ]) {
+        if (!DMCHashBackendSetType(type.integerValue)) continue;
+
+        CFAbsoluteTime t0 = CFAbsoluteTimeGetCurrent();
+        DMCSHA256Digest(digest, data.bytes, data.length);
+        CFAbsoluteTime t1 = CFAbsoluteTimeGetCurrent();
+        DMCSHA1Digest(digest, data.bytes, data.length);
+        CFAbsoluteTime t2 = CFAbsoluteTimeGetCurrent();
+
+        NSLog(@"Hash backend %@: SHA256 %.0f MB/s, SHA1 %.0f MB/s", DMCHashBackendName(type.integerValue),
+              16.0 / (t1 - t0), 16.0 / (t2 - t1));
+    }
+
+    CFAbsoluteTime t0 = CFAbsoluteTimeGetCurrent();
+    CC_SHA256(data.bytes, (CC_LONG)data.length, digest);
+    CFAbsoluteTime t1 = CFAbsoluteTimeGetCurrent();
+    NSLog(@"CommonCrypto: SHA256 %.0f MB/s", 16.0 / (t1 - t0));
+
+    DMCHashBackendSetType(defaultType);
+}
+
+// Cross-checks multi-lane hashing with one-at-a-time hashing for all padding cases and partial batches.
++ (void) testSHA256Lanes {
+    DMCHashBackendType defaultType = DMCHashBackendCurrentType();
+
+    // Lanes run with the portable backend, hardware backends hash one message at a time.
+    for (NSNumber* type in @[ @(DMCHashBackendPortable), @(DMCHashBackendSHANI), @(DMCHashBackendARMv8) ]) {
+        if (!DMCHashBackendSetType(type.integerValue)) continue;
+        NSAssert((type.integerValue == DMCHashBackendPortable) || DMCSHA256LaneCount() == 1, @"Hardware backend should not use lanes");
+        [self testSHA256LanesWithCurrentBackend];
+    }
+
+    DMCHashBackendSetType(defaultType);
+}
+
++ (void) testSHA256LanesWithCurrentBackend {
+    NSMutableData* messages = [NSMutableData dataWithLength:20 * 200];
+    for (NSUInteger i = 0; i < messages.length; i++) {
+        ((unsigned char*)messages.mutableBytes)[i] = (unsigned char)(i * 7 + 3);
+    }
+    for (NSNumber* length in @[ @0, @1, @32, @55, @56, @63, @64, @80, @119, @120, @150 ]) {
+        size_t len = length.unsignedIntegerValue;
+        size_t stride = len + 1;
+        for (size_t count = 0; count <= 17; count++) {
+            unsigned char single[17 * 32];
+            unsigned char twice[17 * 32];
+            DMCSHA256Lanes(single, messages.bytes, len, stride, count);
+            DMCHash256Lanes(twice, messages.bytes, len, stride, count);
+            for (size_t i = 0; i < count; i++) {
+                NSData* message = [messages subdataWithRange:NSMakeRange(i * stride, len)];
+                NSAssert([[NSData dataWithBytes:single + i * 32 length:32] isEqual:DMCSHA256(message)], @"Lane hash should match SHA256");
+                NSAssert([[NSData dataWithBytes:twice + i * 32 length:32] isEqual:DMCHash256(message)], @"Lane hash should match Hash256");
+            }
+        }
+    }
+}
+
++ (void) benchmarkSHA256Lanes {
+    // 2000 block headers: the size of a "headers" message.
+    NSUInteger count = 2000;
+    NSMutableData* headers = [NSMutableData dataWithLength:count * 80];
+    NSMutableData* digests = [NSMutableData dataWithLength:count * 32];
+    DMCHashBackendType defaultType = DMCHashBackendCurrentType();
+
+    // Lane kernel only runs with the portable backend; compare it with one-at-a-time hashing on every backend.
+    DMCHashBackendSetType(DMCHashBackendPortable);
+    NSUInteger lanes = DMCSHA256LaneCount();
+    CFAbsoluteTime lanesTime = HUGE_VAL;
+    for (int round = 0; round < 3; round++) {
+        CFAbsoluteTime t0 = CFAbsoluteTimeGetCurrent();
+        DMCHash256Lanes(digests.mutableBytes, headers.bytes, 80, 80, count);
+        lanesTime = MIN(lanesTime, CFAbsoluteTimeGetCurrent() - t0);
+    }
+
+    for (NSNumber* type in @[ @(DMCHashBackendPortable), @(DMCHashBackendSHANI), @(DMCHashBackendARMv8) ]) {
+        if (!DMCHashBackendSetType(type.integerValue)) continue;
+
+        CFAbsoluteTime scalarTime = HUGE_VAL;
+        for (int round = 0; round < 3; round++) {
+            CFAbsoluteTime t0 = CFAbsoluteTimeGetCurrent();
+            for (NSUInteger i = 0; i < count; i++) {
+                DMCHash256Digest((unsigned char*)digests.mutableBytes + i * 32, (const unsigned char*)headers.bytes + i * 80, 80);
+            }
+            scalarTime = MIN(scalarTime, CFAbsoluteTimeGetCurrent() - t0);
+        }
+
+        NSLog(@"Hashing %d headers: %@ one at a time %.2f ms, %d lanes %.2f ms (%.1fx), batch uses %@",
+              (int)count, DMCHashBackendName(type.integerValue), scalarTime * 1000.0, (int)lanes, lanesTime * 1000.0,
+              scalarTime / lanesTime, DMCSHA256LaneCount() > 1 ? @"lanes" : @"one at a time");
+    }
+
+    DMCHashBackendSetType(defaultType);
+}
+
+// Cross-checks every option of the hex codec with sprintf around the 16-byte SIMD block boundaries.
++ (void) testHex {
+    NSMutableData* data = [NSMutableData dataWithLength:100];
+    for (NSUInteger i = 0; i < data.length; i++) {
+        ((unsigned char*)data.mutableBytes)[i] = (unsigned char)(i * 37 + 11);
+    }
+
+    for (size_t length = 0; length <= data.length; length++) {
+        const unsigned char* bytes = data.bytes;
+        for (DMCHexOptions options = 0; options <= (DMCHexUppercase | DMCHexReversed); options++) {
+            char expected[2 * 100 + 1], actual[2 * 100];
+            unsigned char decoded[100];
+            BOOL reversed = (options & DMCHexReversed) != 0;
+            for (size_t i = 0; i < length; i++) {
+                sprintf(expected + 2*i, (options & DMCHexUppercase) ? "%02X" : "%02x", bytes[reversed ? length - 1 - i : i]);
+            }
+
+            DMCHexEncode(actual, bytes, length, options);
+            NSAssert(memcmp(expected, actual, 2 * length) == 0, @"Hex encoding should match sprintf");
+            NSAssert(DMCHexDecode(decoded, actual, length, options) == length, @"Should decode valid hex");
+            NSAssert(memcmp(decoded, bytes, length) == 0, @"Should decode back");
+
+            // Any invalid character stops decoding at its byte.
+            if (length > 0) {
+                size_t position = (length * 7) % (2 * length);
+                for (NSNumber* c in @[ @('g'), @('G'), @('/'), @(':'), @('@'), @('`'), @(' '), @(0x80), @(0xff) ]) {
+                    actual[position] = (char)c.intValue;
+                    NSAssert(DMCHexDecode(decoded, actual, length, options) == position / 2, @"Should stop at invalid character");
+                }
+            }
+        }
+    }
+
+    NSData* hash = DMCDataFromHex(@"000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f");
+    NSAssert([DMCIDFromHash(hash) isEqual:@"1f1e1d1c1b1a191817161514131211100f0e0d0c0b0a09080706050403020100"], @"ID is a reversed hash");
+    NSAssert([DMCHashFromID(DMCIDFromHash(hash)) isEqual:hash], @"Should convert ID back to hash");
+    NSAssert(DMCHashFromID(@"1f1e1d1c1b1a191817161514131211100f0e0d0c0b0a0908070605040302010z") == nil, @"Should reject invalid ID");
+    NSAssert(DMCDataFromHex(@"dead  ") == nil, @"Should reject non-hex characters");
+}
+
++ (void) benchmarkHex {
+    NSData* hash = DMCSHA256([NSData data]);
+    NSData* transaction = DMCRandomDataWithLength(4096);
+
+    for (NSData* data in @[ hash, transaction ]) {
+        NSUInteger n = (16 * 1024 * 1024) / data.length;
+        NSMutableData* hex = [NSMutableData dataWithLength:data.length * 2 + 1];
+        NSMutableData* decoded = [NSMutableData dataWithLength:data.length];
+
+        CFAbsoluteTime t0 = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < n; i++) {
+            const unsigned char* bytes = data.bytes;
+            for (NSUInteger j = 0; j < data.length; j++) sprintf((char*)hex.mutableBytes + j*2, "%02x", bytes[j]);
+        }
+        CFAbsoluteTime t1 = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < n; i++) {
+            DMCHexEncode(hex.mutableBytes, data.bytes, data.length, DMCHexLowercase);
+        }
+        CFAbsoluteTime t2 = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < n; i++) {
+            DMCHexEncode(hex.mutableBytes, data.bytes, data.length, DMCHexReversed);
+        }
+        CFAbsoluteTime t3 = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < n; i++) {
+            DMCHexDecode(decoded.mutableBytes, hex.bytes, data.length, DMCHexLowercase);
+        }
+        CFAbsoluteTime t4 = CFAbsoluteTimeGetCurrent();
+        for (NSUInteger i = 0; i < n; i++) {
+            DMCIDFromHash(data);
+        }
+        CFAbsoluteTime t5 = CFAbsoluteTimeGetCurrent();
+
+        NSLog(@"Hex of %d bytes: sprintf %.0f MB/s, encode %.0f MB/s, reversed %.0f MB/s, decode %.0f MB/s, DMCIDFromHash %.0f ns",
+              (int)data.length, 16.0 / (t1 - t0), 16.0 / (t2 - t1), 16.0 / (t3 - t2), 16.0 / (t4 - t3), (t5 - t4) * 1e9 / n);
+    }
+}
+
 + (void) runAllTests {
     NSAssert([[[NSData alloc] init].SHA256.hex
               isEqual:@"e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"], @"Test vector");
@@ -32,6 +254,10 @@
     NSAssert([DMCDataWithUTF8CString("hello").DMCHash160.hex
               isEqual:@"b6a9c8c230722b7c748331a8b450f05566dc7d0f"], @"Test vector");
 
+    [self testHashBackends];
+    [self testSHA256Lanes];
+    [self testHex];
+
     NSAssert([DMCDataFromHex(@"deadBEEF") isEqualToData:[NSData dataWithBytes:"\xde\xad\xBE\xEF" length:4]], @"Init data with hex string");
 
     NSAssert([DMCDataFromHex(@"0xdeadBEEF") isEqualToData:[NSData dataWithBytes:"\xde\xad\xBE\xEF" length:4]], @"Init data with hex string");
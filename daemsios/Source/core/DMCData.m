@@ -1,6 +1,8 @@
 // Oleg Andreev <oleganza@gmail.com>
 
 #import "DMCData.h"
+#import "DMCHashBackend.h"
+#import "DMCHex.h"
 #import <CommonCrypto/CommonCrypto.h>
 #if DMCDataRequiresOpenSSL
 #include <openssl/ripemd.h>
@@ -128,91 +130,24 @@ NSData* DMCDataFromHex(NSString* hexString) {
 
 // Init with zero-terminated hex string (lower- or uppercase, with optional 0x prefix)
 NSData* DMCDataWithHexCString(const char* hexCString) {
-    if (hexCString == NULL) return nil;
-    
-    const unsigned char *psz = (const unsigned char*)hexCString;
-    
-    while (isspace(*psz)) psz++;
-    
-    // Skip optional 0x prefix
-    if (psz[0] == '0' && tolower(psz[1]) == 'x') psz += 2;
-        
-        while (isspace(*psz)) psz++;
-    
-    size_t len = strlen((const char*)psz);
-    
-    // If the string is not full number of bytes (each byte 2 hex characters), return nil.
-    if (len % 2 != 0) return nil;
-    
-    unsigned char* buf = (unsigned char*)malloc(len/2);
-    
-    static const signed char digits[256] = {
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-         0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
-        -1,0xa,0xb,0xc,0xd,0xe,0xf, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1,0xa,0xb,0xc,0xd,0xe,0xf, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
-    };
-    
-    unsigned char* bufpointer = buf;
-    
-    while (1) {
-        unsigned char c1 = (unsigned char)*psz++;
-        signed char n1 = digits[c1];
-        if (n1 == (signed char)-1) break; // break when null-terminator is hit
-        
-        unsigned char c2 = (unsigned char)*psz++;
-        signed char n2 = digits[c2];
-        if (n2 == (signed char)-1) break; // break when null-terminator is hit
-        
-        *bufpointer = (unsigned char)((n1 << 4) | n2);
-        bufpointer++;
-    }
-    
-    return [[NSData alloc] initWithBytesNoCopy:buf length:len/2];
+    return DMCDataWithHexCStringOptions(hexCString, DMCHexLowercase);
 }
 
 
-NSString* DMCHexFromDataWithFormat(NSData* data, const char* format) {
-    if (!data) return nil;
-    
-    NSUInteger length = data.length;
-    if (length == 0) return @"";
-    
-    NSMutableData* resultdata = [NSMutableData dataWithLength:length * 2];
-    char *dest = resultdata.mutableBytes;
-    unsigned const char *src = data.bytes;
-    for (int i = 0; i < length; ++i) {
-        sprintf(dest + i*2, format, (unsigned int)(src[i]));
-    }
-    return [[NSString alloc] initWithData:resultdata encoding:NSASCIIStringEncoding];
-}
-
 NSString* DMCHexStringFromData(NSData* data) { // deprecated
-    return DMCHexFromDataWithFormat(data, "%02x");
+    return DMCHexFromDataWithOptions(data, DMCHexLowercase);
 }
 
 NSString* DMCUppercaseHexStringFromData(NSData* data) { // deprecated
-    return DMCHexFromDataWithFormat(data, "%02X");
+    return DMCHexFromDataWithOptions(data, DMCHexUppercase);
 }
 
 NSString* DMCHexFromData(NSData* data) {
-    return DMCHexFromDataWithFormat(data, "%02x");
+    return DMCHexFromDataWithOptions(data, DMCHexLowercase);
 }
 
 NSString* DMCUppercaseHexFromData(NSData* data) {
-    return DMCHexFromDataWithFormat(data, "%02X");
+    return DMCHexFromDataWithOptions(data, DMCHexUppercase);
 }
 
 
@@ -269,12 +204,12 @@ NSMutableData* DMCSHA1(NSData* data) {
     if (!data) return nil;
     unsigned char digest[CC_SHA1_DIGEST_LENGTH];
 
-    __block CC_SHA1_CTX ctx;
-    CC_SHA1_Init(&ctx);
+    __block DMCSHA1Context ctx;
+    DMCSHA1Init(&ctx);
     [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
-        CC_SHA1_Update(&ctx, bytes, (CC_LONG)byteRange.length);
+        DMCSHA1Update(&ctx, bytes, byteRange.length);
     }];
-    CC_SHA1_Final(digest, &ctx);
+    DMCSHA1Final(&ctx, digest);
 
     NSMutableData* result = [NSMutableData dataWithBytes:digest length:CC_SHA1_DIGEST_LENGTH];
     DMCSecureMemset(digest, 0, CC_SHA1_DIGEST_LENGTH);
@@ -285,12 +220,12 @@ NSMutableData* DMCSHA256(NSData* data) {
     if (!data) return nil;
     unsigned char digest[CC_SHA256_DIGEST_LENGTH];
 
-    __block CC_SHA256_CTX ctx;
-    CC_SHA256_Init(&ctx);
+    __block DMCSHA256Context ctx;
+    DMCSHA256Init(&ctx);
     [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
-        CC_SHA256_Update(&ctx, bytes, (CC_LONG)byteRange.length);
+        DMCSHA256Update(&ctx, bytes, byteRange.length);
     }];
-    CC_SHA256_Final(digest, &ctx);
+    DMCSHA256Final(&ctx, digest);
 
     NSMutableData* result = [NSMutableData dataWithBytes:digest length:CC_SHA256_DIGEST_LENGTH];
     DMCSecureMemset(digest, 0, CC_SHA256_DIGEST_LENGTH);
@@ -317,15 +252,15 @@ NSMutableData* DMCSHA256Concat(NSData* data1, NSData* data2) {
     if (!data1 || !data2) return nil;
     unsigned char digest[CC_SHA256_DIGEST_LENGTH];
     
-    __block CC_SHA256_CTX ctx;
-    CC_SHA256_Init(&ctx);
+    __block DMCSHA256Context ctx;
+    DMCSHA256Init(&ctx);
     [data1 enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
-        CC_SHA256_Update(&ctx, bytes, (CC_LONG)byteRange.length);
+        DMCSHA256Update(&ctx, bytes, byteRange.length);
     }];
     [data2 enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
-        CC_SHA256_Update(&ctx, bytes, (CC_LONG)byteRange.length);
+        DMCSHA256Update(&ctx, bytes, byteRange.length);
     }];
-    CC_SHA256_Final(digest, &ctx);
+    DMCSHA256Final(&ctx, digest);
     
     NSMutableData* result = [NSMutableData dataWithBytes:digest length:CC_SHA256_DIGEST_LENGTH];
     DMCSecureMemset(digest, 0, CC_SHA256_DIGEST_LENGTH);
@@ -336,13 +271,13 @@ NSMutableData* DMCHash256(NSData* data) {
     if (!data) return nil;
     unsigned char digest1[CC_SHA256_DIGEST_LENGTH];
     unsigned char digest2[CC_SHA256_DIGEST_LENGTH];
-    __block CC_SHA256_CTX ctx;
-    CC_SHA256_Init(&ctx);
+    __block DMCSHA256Context ctx;
+    DMCSHA256Init(&ctx);
     [data enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
-        CC_SHA256_Update(&ctx, bytes, (CC_LONG)byteRange.length);
+        DMCSHA256Update(&ctx, bytes, byteRange.length);
     }];
-    CC_SHA256_Final(digest1, &ctx);
-    CC_SHA256(digest1, CC_SHA256_DIGEST_LENGTH, digest2);
+    DMCSHA256Final(&ctx, digest1);
+    DMCSHA256Digest(digest2, digest1, CC_SHA256_DIGEST_LENGTH);
     NSMutableData* result = [NSMutableData dataWithBytes:digest2 length:CC_SHA256_DIGEST_LENGTH];
     DMCSecureMemset(digest1, 0, CC_SHA256_DIGEST_LENGTH);
     DMCSecureMemset(digest2, 0, CC_SHA256_DIGEST_LENGTH);
@@ -355,16 +290,16 @@ NSMutableData* DMCHash256Concat(NSData* data1, NSData* data2) {
     unsigned char digest1[CC_SHA256_DIGEST_LENGTH];
     unsigned char digest2[CC_SHA256_DIGEST_LENGTH];
     
-    __block CC_SHA256_CTX ctx;
-    CC_SHA256_Init(&ctx);
+    __block DMCSHA256Context ctx;
+    DMCSHA256Init(&ctx);
     [data1 enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
-        CC_SHA256_Update(&ctx, bytes, (CC_LONG)byteRange.length);
+        DMCSHA256Update(&ctx, bytes, byteRange.length);
     }];
     [data2 enumerateByteRangesUsingBlock:^(const void *bytes, NSRange byteRange, BOOL *stop) {
-        CC_SHA256_Update(&ctx, bytes, (CC_LONG)byteRange.length);
+        DMCSHA256Update(&ctx, bytes, byteRange.length);
     }];
-    CC_SHA256_Final(digest1, &ctx);
-    CC_SHA256(digest1, CC_SHA256_DIGEST_LENGTH, digest2);
+    DMCSHA256Final(&ctx, digest1);
+    DMCSHA256Digest(digest2, digest1, CC_SHA256_DIGEST_LENGTH);
     
     NSMutableData* result = [NSMutableData dataWithBytes:digest2 length:CC_SHA256_DIGEST_LENGTH];
     DMCSecureMemset(digest1, 0, CC_SHA256_DIGEST_LENGTH);
@@ -0,0 +1,56 @@
+// 
+
+#import <Foundation/Foundation.h>
+
+// Hash backend provides SHA-256 and SHA-1 block functions picked once per process for this CPU:
+// SHA extensions on x86-64 (SHA-NI), cryptography extensions on ARMv8, or portable C code otherwise.
+// DMCData hash functions and SHA256()/SHA1() from NSData+DaemsCoin are built on top of it.
+
+typedef NS_ENUM(NSInteger, DMCHashBackendType) {
+    DMCHashBackendPortable = 0,
+    DMCHashBackendSHANI    = 1, // Intel SHA extensions (sha256rnds2, sha1rnds4)
+    DMCHashBackendARMv8    = 2, // ARMv8 cryptography extensions (sha256h, sha1c)
+};
+
+// Backend currently in use.
+DMCHashBackendType DMCHashBackendCurrentType(void);
+
+// Returns YES if the backend can run on this CPU. Portable backend is always available.
+BOOL DMCHashBackendIsAvailable(DMCHashBackendType type);
+
+// Switches to another backend (used by tests and benchmarks). Returns NO if it is not available on this CPU.
+// Should not be called while other threads are hashing.
+BOOL DMCHashBackendSetType(DMCHashBackendType type);
+
+// Short name of the backend for logs: "portable", "sha-ni" or "armv8".
+NSString* DMCHashBackendName(DMCHashBackendType type);
+
+// Compress `count` consecutive 64-byte blocks into the state.
+void DMCSHA256Compress(uint32_t state[8], const unsigned char* blocks, size_t count);
+void DMCSHA1Compress(uint32_t state[5], const unsigned char* blocks, size_t count);
+
+// Incremental hashing. Final writes the digest and clears the context.
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;
+    unsigned char buffer[64];
+} DMCSHA256Context;
+
+typedef struct {
+    uint32_t state[5];
+    uint64_t length;
+    unsigned char buffer[64];
+} DMCSHA1Context;
+
+void DMCSHA256Init(DMCSHA256Context* ctx);
+void DMCSHA256Update(DMCSHA256Context* ctx, const void* data, size_t length);
+void DMCSHA256Final(DMCSHA256Context* ctx, unsigned char digest[32]);
+
+void DMCSHA1Init(DMCSHA1Context* ctx);
+void DMCSHA1Update(DMCSHA1Context* ctx, const void* data, size_t length);
+void DMCSHA1Final(DMCSHA1Context* ctx, unsigned char digest[20]);
+
+// One-shot digests. DMCHash256Digest is SHA256(SHA256(data)).
+void DMCSHA256Digest(unsigned char digest[32], const void* data, size_t length);
+void DMCHash256Digest(unsigned char digest[32], const void* data, size_t length);
+void DMCSHA1Digest(unsigned char digest[20], const void* data, size_t length);
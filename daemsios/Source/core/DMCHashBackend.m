@@ -0,0 +1,470 @@
+// 
+
+#import "DMCHashBackend.h"
+#import "DMCData.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define DMC_HASH_BACKEND_SHANI 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+// Apple arm64 CPUs all implement the cryptography extensions and the compiler advertises them.
+#if (defined(__arm64__) || defined(__aarch64__)) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2))
+#define DMC_HASH_BACKEND_ARMV8 1
+#include <arm_neon.h>
+#endif
+
+typedef void (*DMCHashCompressFunction)(uint32_t* state, const unsigned char* blocks, size_t count);
+
+static const uint32_t DMCSHA256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t DMCSHA256IV[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint32_t DMCSHA1IV[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+
+static inline uint32_t DMCHashReadBig32(const unsigned char* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+
+#pragma mark - Portable
+
+
+#define DMCHashRol(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define DMCHashRor(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void DMCSHA256CompressPortable(uint32_t* r, const unsigned char* blocks, size_t count) {
+    for (; count > 0; count--, blocks += 64) {
+        uint32_t a = r[0], b = r[1], c = r[2], d = r[3], e = r[4], f = r[5], g = r[6], h = r[7], t1, t2, w[64];
+        int i = 0;
+
+        for (; i < 16; i++) w[i] = DMCHashReadBig32(blocks + i*4);
+        for (; i < 64; i++) {
+            uint32_t s0 = DMCHashRor(w[i - 15], 7) ^ DMCHashRor(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = DMCHashRor(w[i - 2], 17) ^ DMCHashRor(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = s1 + w[i - 7] + s0 + w[i - 16];
+        }
+
+        for (i = 0; i < 64; i++) {
+            t1 = h + (DMCHashRor(e, 6) ^ DMCHashRor(e, 11) ^ DMCHashRor(e, 25)) + ((e & f) ^ (~e & g)) + DMCSHA256K[i] + w[i];
+            t2 = (DMCHashRor(a, 2) ^ DMCHashRor(a, 13) ^ DMCHashRor(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;
+        }
+
+        r[0] += a; r[1] += b; r[2] += c; r[3] += d; r[4] += e; r[5] += f; r[6] += g; r[7] += h;
+    }
+}
+
+#define DMCSHA1Round(f, k) (t = DMCHashRol(a, 5) + (f) + e + (k) + x[i], e = d, d = c, c = DMCHashRol(b, 30), b = a, a = t)
+
+static void DMCSHA1CompressPortable(uint32_t* r, const unsigned char* blocks, size_t count) {
+    for (; count > 0; count--, blocks += 64) {
+        uint32_t a = r[0], b = r[1], c = r[2], d = r[3], e = r[4], t, x[80];
+        int i = 0;
+
+        for (; i < 16; i++) x[i] = DMCHashReadBig32(blocks + i*4);
+        for (; i < 80; i++) x[i] = DMCHashRol(x[i - 3] ^ x[i - 8] ^ x[i - 14] ^ x[i - 16], 1);
+
+        for (i = 0; i < 20; i++) DMCSHA1Round((b & c) | (~b & d), 0x5a827999);
+        for (; i < 40; i++) DMCSHA1Round(b ^ c ^ d, 0x6ed9eba1);
+        for (; i < 60; i++) DMCSHA1Round((b & c) | (b & d) | (c & d), 0x8f1bbcdc);
+        for (; i < 80; i++) DMCSHA1Round(b ^ c ^ d, 0xca62c1d6);
+
+        r[0] += a; r[1] += b; r[2] += c; r[3] += d; r[4] += e;
+    }
+}
+
+
+#pragma mark - SHA-NI
+
+
+#if DMC_HASH_BACKEND_SHANI
+
+#define DMCSHANITarget __attribute__((target("sha,sse4.1,ssse3")))
+
+// Four SHA-256 rounds of group g (0...15). Message words m[] rotate through four registers:
+// the first four groups load them, later groups extend the schedule two groups ahead.
+#define DMCSHANI256Group(g) do {                                                                    \
+    if (g < 4) m[g & 3] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks + 16*g)), mask); \
+    msg = _mm_add_epi32(m[g & 3], _mm_loadu_si128((const __m128i*)&DMCSHA256K[4*g]));                \
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);                                            \
+    if (g >= 3 && g <= 14) {                                                                        \
+        tmp = _mm_alignr_epi8(m[g & 3], m[(g + 3) & 3], 4);                                         \
+        m[(g + 1) & 3] = _mm_sha256msg2_epu32(_mm_add_epi32(m[(g + 1) & 3], tmp), m[g & 3]);         \
+    }                                                                                               \
+    msg = _mm_shuffle_epi32(msg, 0x0E);                                                             \
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);                                            \
+    if (g >= 1 && g <= 12) m[(g + 3) & 3] = _mm_sha256msg1_epu32(m[(g + 3) & 3], m[g & 3]);         \
+} while (0)
+
+static DMCSHANITarget void DMCSHA256CompressSHANI(uint32_t* r, const unsigned char* blocks, size_t count) {
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, saved0, saved1, msg, tmp, m[4];
+
+    // Instructions keep the state as ABEF and CDGH.
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&r[0]), 0xB1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&r[4]), 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; count > 0; count--, blocks += 64) {
+        saved0 = state0;
+        saved1 = state1;
+
+        DMCSHANI256Group(0);  DMCSHANI256Group(1);  DMCSHANI256Group(2);  DMCSHANI256Group(3);
+        DMCSHANI256Group(4);  DMCSHANI256Group(5);  DMCSHANI256Group(6);  DMCSHANI256Group(7);
+        DMCSHANI256Group(8);  DMCSHANI256Group(9);  DMCSHANI256Group(10); DMCSHANI256Group(11);
+        DMCSHANI256Group(12); DMCSHANI256Group(13); DMCSHANI256Group(14); DMCSHANI256Group(15);
+
+        state0 = _mm_add_epi32(state0, saved0);
+        state1 = _mm_add_epi32(state1, saved1);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    _mm_storeu_si128((__m128i*)&r[0], _mm_blend_epi16(tmp, state1, 0xF0));
+    _mm_storeu_si128((__m128i*)&r[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+// Four SHA-1 rounds of group g (0...19). `e` alternates between two registers from group to group.
+#define DMCSHANI1Group(g) do {                                                                      \
+    if (g < 4) m[g & 3] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks + 16*g)), mask); \
+    if (g == 0) e[0] = _mm_add_epi32(e[0], m[0]);                                                   \
+    else e[g & 1] = _mm_sha1nexte_epu32(e[g & 1], m[g & 3]);                                        \
+    e[(g + 1) & 1] = abcd;                                                                          \
+    if (g >= 3 && g <= 18) m[(g + 1) & 3] = _mm_sha1msg2_epu32(m[(g + 1) & 3], m[g & 3]);           \
+    abcd = _mm_sha1rnds4_epu32(abcd, e[g & 1], g / 5);                                              \
+    if (g >= 1 && g <= 16) m[(g + 3) & 3] = _mm_sha1msg1_epu32(m[(g + 3) & 3], m[g & 3]);           \
+    if (g >= 2 && g <= 17) m[(g + 2) & 3] = _mm_xor_si128(m[(g + 2) & 3], m[g & 3]);                \
+} while (0)
+
+static DMCSHANITarget void DMCSHA1CompressSHANI(uint32_t* r, const unsigned char* blocks, size_t count) {
+    const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+    __m128i abcd, savedABCD, savedE, e[2], m[4];
+
+    abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)r), 0x1B);
+    e[0] = _mm_set_epi32((int)r[4], 0, 0, 0);
+
+    for (; count > 0; count--, blocks += 64) {
+        savedABCD = abcd;
+        savedE = e[0];
+
+        DMCSHANI1Group(0);  DMCSHANI1Group(1);  DMCSHANI1Group(2);  DMCSHANI1Group(3);  DMCSHANI1Group(4);
+        DMCSHANI1Group(5);  DMCSHANI1Group(6);  DMCSHANI1Group(7);  DMCSHANI1Group(8);  DMCSHANI1Group(9);
+        DMCSHANI1Group(10); DMCSHANI1Group(11); DMCSHANI1Group(12); DMCSHANI1Group(13); DMCSHANI1Group(14);
+        DMCSHANI1Group(15); DMCSHANI1Group(16); DMCSHANI1Group(17); DMCSHANI1Group(18); DMCSHANI1Group(19);
+
+        e[0] = _mm_sha1nexte_epu32(e[0], savedE);
+        abcd = _mm_add_epi32(abcd, savedABCD);
+    }
+
+    _mm_storeu_si128((__m128i*)r, _mm_shuffle_epi32(abcd, 0x1B));
+    r[4] = (uint32_t)_mm_extract_epi32(e[0], 3);
+}
+
+static BOOL DMCHashBackendHasSHANI(void) {
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return NO;
+    if (!(ecx & bit_SSSE3) || !(ecx & bit_SSE4_1)) return NO;
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return NO;
+    return (ebx & (1u << 29)) != 0;
+}
+
+#endif
+
+
+#pragma mark - ARMv8
+
+
+#if DMC_HASH_BACKEND_ARMV8
+
+// Four SHA-256 rounds of group g (0...15). `k[g & 1]` holds message words plus constants of the current group,
+// the other one is prepared for the next group while the schedule is extended four groups ahead.
+#define DMCARMv8256Group(g) do {                                                                    \
+    if (g < 12) m[g & 3] = vsha256su0q_u32(m[g & 3], m[(g + 1) & 3]);                               \
+    tmp = state0;                                                                                   \
+    if (g < 15) k[(g + 1) & 1] = vaddq_u32(m[(g + 1) & 3], vld1q_u32(&DMCSHA256K[4*((g + 1) & 15)])); \
+    state0 = vsha256hq_u32(state0, state1, k[g & 1]);                                               \
+    state1 = vsha256h2q_u32(state1, tmp, k[g & 1]);                                                 \
+    if (g < 12) m[g & 3] = vsha256su1q_u32(m[g & 3], m[(g + 2) & 3], m[(g + 3) & 3]);               \
+} while (0)
+
+static void DMCSHA256CompressARMv8(uint32_t* r, const unsigned char* blocks, size_t count) {
+    uint32x4_t state0 = vld1q_u32(&r[0]);
+    uint32x4_t state1 = vld1q_u32(&r[4]);
+    uint32x4_t saved0, saved1, tmp, k[2], m[4];
+
+    for (; count > 0; count--, blocks += 64) {
+        saved0 = state0;
+        saved1 = state1;
+
+        for (int i = 0; i < 4; i++) m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16*i)));
+        k[0] = vaddq_u32(m[0], vld1q_u32(&DMCSHA256K[0]));
+
+        DMCARMv8256Group(0);  DMCARMv8256Group(1);  DMCARMv8256Group(2);  DMCARMv8256Group(3);
+        DMCARMv8256Group(4);  DMCARMv8256Group(5);  DMCARMv8256Group(6);  DMCARMv8256Group(7);
+        DMCARMv8256Group(8);  DMCARMv8256Group(9);  DMCARMv8256Group(10); DMCARMv8256Group(11);
+        DMCARMv8256Group(12); DMCARMv8256Group(13); DMCARMv8256Group(14); DMCARMv8256Group(15);
+
+        state0 = vaddq_u32(state0, saved0);
+        state1 = vaddq_u32(state1, saved1);
+    }
+
+    vst1q_u32(&r[0], state0);
+    vst1q_u32(&r[4], state1);
+}
+
+static const uint32_t DMCSHA1K[4] = { 0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6 };
+
+// Four SHA-1 rounds of group g (0...19) using choose, parity and majority functions by 20 rounds.
+#define DMCARMv81Group(g, function) do {                                                            \
+    e[(g + 1) & 1] = vsha1h_u32(vgetq_lane_u32(abcd, 0));                                           \
+    abcd = function(abcd, e[g & 1], k[g & 1]);                                                      \
+    if (g < 18) k[g & 1] = vaddq_u32(m[(g + 2) & 3], vdupq_n_u32(DMCSHA1K[((g + 2) / 5) & 3]));     \
+    if (g >= 1 && g <= 16) m[(g + 3) & 3] = vsha1su1q_u32(m[(g + 3) & 3], m[(g + 2) & 3]);          \
+    if (g <= 15) m[g & 3] = vsha1su0q_u32(m[g & 3], m[(g + 1) & 3], m[(g + 2) & 3]);                \
+} while (0)
+
+static void DMCSHA1CompressARMv8(uint32_t* r, const unsigned char* blocks, size_t count) {
+    uint32x4_t abcd = vld1q_u32(r);
+    uint32x4_t savedABCD, k[2], m[4];
+    uint32_t e[2], savedE;
+    e[0] = r[4];
+
+    for (; count > 0; count--, blocks += 64) {
+        savedABCD = abcd;
+        savedE = e[0];
+
+        for (int i = 0; i < 4; i++) m[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16*i)));
+        k[0] = vaddq_u32(m[0], vdupq_n_u32(DMCSHA1K[0]));
+        k[1] = vaddq_u32(m[1], vdupq_n_u32(DMCSHA1K[0]));
+
+        DMCARMv81Group(0, vsha1cq_u32);  DMCARMv81Group(1, vsha1cq_u32);  DMCARMv81Group(2, vsha1cq_u32);
+        DMCARMv81Group(3, vsha1cq_u32);  DMCARMv81Group(4, vsha1cq_u32);  DMCARMv81Group(5, vsha1pq_u32);
+        DMCARMv81Group(6, vsha1pq_u32);  DMCARMv81Group(7, vsha1pq_u32);  DMCARMv81Group(8, vsha1pq_u32);
+        DMCARMv81Group(9, vsha1pq_u32);  DMCARMv81Group(10, vsha1mq_u32); DMCARMv81Group(11, vsha1mq_u32);
+        DMCARMv81Group(12, vsha1mq_u32); DMCARMv81Group(13, vsha1mq_u32); DMCARMv81Group(14, vsha1mq_u32);
+        DMCARMv81Group(15, vsha1pq_u32); DMCARMv81Group(16, vsha1pq_u32); DMCARMv81Group(17, vsha1pq_u32);
+        DMCARMv81Group(18, vsha1pq_u32); DMCARMv81Group(19, vsha1pq_u32);
+
+        abcd = vaddq_u32(abcd, savedABCD);
+        e[0] += savedE;
+    }
+
+    vst1q_u32(r, abcd);
+    r[4] = e[0];
+}
+
+#endif
+
+
+#pragma mark - Dispatch
+
+
+static DMCHashBackendType DMCHashBackendType_ = DMCHashBackendPortable;
+static DMCHashCompressFunction DMCSHA256CompressFunction = DMCSHA256CompressPortable;
+static DMCHashCompressFunction DMCSHA1CompressFunction = DMCSHA1CompressPortable;
+
+BOOL DMCHashBackendIsAvailable(DMCHashBackendType type) {
+    switch (type) {
+        case DMCHashBackendPortable:
+            return YES;
+#if DMC_HASH_BACKEND_SHANI
+        case DMCHashBackendSHANI: {
+            static BOOL available = NO;
+            static dispatch_once_t onceToken;
+            dispatch_once(&onceToken, ^{
+                available = DMCHashBackendHasSHANI();
+            });
+            return available;
+        }
+#endif
+#if DMC_HASH_BACKEND_ARMV8
+        case DMCHashBackendARMv8:
+            return YES;
+#endif
+        default:
+            return NO;
+    }
+}
+
+static void DMCHashBackendSelect(DMCHashBackendType type) {
+    DMCHashBackendType_ = type;
+    switch (type) {
+#if DMC_HASH_BACKEND_SHANI
+        case DMCHashBackendSHANI:
+            DMCSHA256CompressFunction = DMCSHA256CompressSHANI;
+            DMCSHA1CompressFunction = DMCSHA1CompressSHANI;
+            break;
+#endif
+#if DMC_HASH_BACKEND_ARMV8
+        case DMCHashBackendARMv8:
+            DMCSHA256CompressFunction = DMCSHA256CompressARMv8;
+            DMCSHA1CompressFunction = DMCSHA1CompressARMv8;
+            break;
+#endif
+        default:
+            DMCHashBackendType_ = DMCHashBackendPortable;
+            DMCSHA256CompressFunction = DMCSHA256CompressPortable;
+            DMCSHA1CompressFunction = DMCSHA1CompressPortable;
+            break;
+    }
+}
+
+static inline void DMCHashBackendPrepare(void) {
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        if (DMCHashBackendIsAvailable(DMCHashBackendSHANI)) DMCHashBackendSelect(DMCHashBackendSHANI);
+        else if (DMCHashBackendIsAvailable(DMCHashBackendARMv8)) DMCHashBackendSelect(DMCHashBackendARMv8);
+    });
+}
+
+DMCHashBackendType DMCHashBackendCurrentType(void) {
+    DMCHashBackendPrepare();
+    return DMCHashBackendType_;
+}
+
+BOOL DMCHashBackendSetType(DMCHashBackendType type) {
+    DMCHashBackendPrepare();
+    if (!DMCHashBackendIsAvailable(type)) return NO;
+    DMCHashBackendSelect(type);
+    return YES;
+}
+
+NSString* DMCHashBackendName(DMCHashBackendType type) {
+    switch (type) {
+        case DMCHashBackendSHANI: return @"sha-ni";
+        case DMCHashBackendARMv8: return @"armv8";
+        default: return @"portable";
+    }
+}
+
+void DMCSHA256Compress(uint32_t state[8], const unsigned char* blocks, size_t count) {
+    DMCHashBackendPrepare();
+    DMCSHA256CompressFunction(state, blocks, count);
+}
+
+void DMCSHA1Compress(uint32_t state[5], const unsigned char* blocks, size_t count) {
+    DMCHashBackendPrepare();
+    DMCSHA1CompressFunction(state, blocks, count);
+}
+
+
+#pragma mark - Contexts
+
+
+// Buffers partial blocks and passes whole blocks straight from the input to the compression function.
+static void DMCHashUpdate(uint32_t* state, uint64_t* totalLength, unsigned char* buffer,
+                          const unsigned char* data, size_t length, DMCHashCompressFunction compress) {
+    size_t used = (size_t)(*totalLength & 63);
+    *totalLength += length;
+
+    if (used > 0) {
+        size_t fill = MIN(64 - used, length);
+        memcpy(buffer + used, data, fill);
+        data += fill;
+        length -= fill;
+        if (used + fill < 64) return;
+        compress(state, buffer, 1);
+    }
+
+    if (length >= 64) {
+        compress(state, data, length / 64);
+        data += length & ~(size_t)63;
+        length &= 63;
+    }
+
+    if (length > 0) memcpy(buffer, data, length);
+}
+
+// Appends padding and bit length in big-endian order.
+static void DMCHashPad(uint32_t* state, uint64_t totalLength, unsigned char* buffer, DMCHashCompressFunction compress) {
+    size_t used = (size_t)(totalLength & 63);
+    buffer[used++] = 0x80;
+    if (used > 56) {
+        memset(buffer + used, 0, 64 - used);
+        compress(state, buffer, 1);
+        used = 0;
+    }
+    memset(buffer + used, 0, 56 - used);
+    uint64_t bits = totalLength * 8;
+    for (int i = 0; i < 8; i++) buffer[56 + i] = (unsigned char)(bits >> (56 - 8*i));
+    compress(state, buffer, 1);
+}
+
+static inline void DMCHashWriteState(unsigned char* digest, const uint32_t* state, int words) {
+    for (int i = 0; i < words; i++) {
+        digest[i*4 + 0] = (unsigned char)(state[i] >> 24);
+        digest[i*4 + 1] = (unsigned char)(state[i] >> 16);
+        digest[i*4 + 2] = (unsigned char)(state[i] >> 8);
+        digest[i*4 + 3] = (unsigned char)state[i];
+    }
+}
+
+void DMCSHA256Init(DMCSHA256Context* ctx) {
+    DMCHashBackendPrepare();
+    memcpy(ctx->state, DMCSHA256IV, sizeof(DMCSHA256IV));
+    ctx->length = 0;
+}
+
+void DMCSHA256Update(DMCSHA256Context* ctx, const void* data, size_t length) {
+    DMCHashUpdate(ctx->state, &ctx->length, ctx->buffer, data, length, DMCSHA256CompressFunction);
+}
+
+void DMCSHA256Final(DMCSHA256Context* ctx, unsigned char digest[32]) {
+    DMCHashPad(ctx->state, ctx->length, ctx->buffer, DMCSHA256CompressFunction);
+    DMCHashWriteState(digest, ctx->state, 8);
+    DMCSecureMemset(ctx, 0, sizeof(*ctx));
+}
+
+void DMCSHA1Init(DMCSHA1Context* ctx) {
+    DMCHashBackendPrepare();
+    memcpy(ctx->state, DMCSHA1IV, sizeof(DMCSHA1IV));
+    ctx->length = 0;
+}
+
+void DMCSHA1Update(DMCSHA1Context* ctx, const void* data, size_t length) {
+    DMCHashUpdate(ctx->state, &ctx->length, ctx->buffer, data, length, DMCSHA1CompressFunction);
+}
+
+void DMCSHA1Final(DMCSHA1Context* ctx, unsigned char digest[20]) {
+    DMCHashPad(ctx->state, ctx->length, ctx->buffer, DMCSHA1CompressFunction);
+    DMCHashWriteState(digest, ctx->state, 5);
+    DMCSecureMemset(ctx, 0, sizeof(*ctx));
+}
+
+void DMCSHA256Digest(unsigned char digest[32], const void* data, size_t length) {
+    DMCSHA256Context ctx;
+    DMCSHA256Init(&ctx);
+    DMCSHA256Update(&ctx, data, length);
+    DMCSHA256Final(&ctx, digest);
+}
+
+void DMCHash256Digest(unsigned char digest[32], const void* data, size_t length) {
+    DMCSHA256Context ctx;
+    DMCSHA256Init(&ctx);
+    DMCSHA256Update(&ctx, data, length);
+    DMCSHA256Final(&ctx, digest);
+    DMCSHA256Init(&ctx);
+    DMCSHA256Update(&ctx, digest, 32);
+    DMCSHA256Final(&ctx, digest);
+}
+
+void DMCSHA1Digest(unsigned char digest[20], const void* data, size_t length) {
+    DMCSHA1Context ctx;
+    DMCSHA1Init(&ctx);
+    DMCSHA1Update(&ctx, data, length);
+    DMCSHA1Final(&ctx, digest);
+}
@@ -1,12 +1,12 @@
 // 
 
 #import "DMCHashID.h"
-#import "DMCData.h"
+#import "DMCHex.h"
 
 NSData* DMCHashFromID(NSString* identifier) {
-    return DMCReversedData(DMCDataFromHex(identifier));
+    return DMCDataWithHexCStringOptions([identifier cStringUsingEncoding:NSASCIIStringEncoding], DMCHexReversed);
 }
 
 NSString* DMCIDFromHash(NSData* hash) {
-    return DMCHexFromData(DMCReversedData(hash));
+    return DMCHexFromDataWithOptions(hash, DMCHexReversed);
 }
@@ -0,0 +1,9 @@
+// 
+
+#import "DMCHeaderStore.h"
+
+@interface DMCHeaderStore (Tests)
+
++ (void) runAllTests;
+
+@end
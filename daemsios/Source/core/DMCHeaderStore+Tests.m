@@ -0,0 +1,87 @@
+// 
+
+#import "DMCHeaderStore+Tests.h"
+#import "DMCBlockHeader+Tests.h"
+#import "DMCData.h"
+
+@implementation DMCHeaderStore (Tests)
+
++ (void) runAllTests {
+    [self testAppendAndReopen];
+    [self testDisconnectedHeaders];
+}
+
++ (NSData*) dataWithHeaders:(NSArray*)headers {
+    NSMutableData* data = [NSMutableData data];
+    for (DMCBlockHeader* header in headers) {
+        [data appendData:header.data];
+    }
+    return data;
+}
+
++ (NSString*) temporaryPath {
+    NSString* path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    return path;
+}
+
++ (void) testAppendAndReopen {
+    NSString* path = [self temporaryPath];
+    NSError* error = nil;
+    DMCHeaderStore* store = [[DMCHeaderStore alloc] initWithPath:path error:&error];
+    NSAssert(store && store.count == 0 && !store.tipHash, @"Should create an empty store");
+
+    NSArray* headers = [DMCBlockHeader chainWithCount:3000 previousHash:DMCZero256() bits:0x1d00ffff nonce:0];
+    NSData* data = [self dataWithHeaders:headers];
+
+    NSUInteger appended = 0;
+    NSAssert([store appendHeaders:data.bytes stride:80 count:2000 appended:&appended error:&error] && appended == 2000, @"Should append the first batch");
+    NSAssert([store appendHeaders:(const uint8_t*)data.bytes + 2000 * 80 stride:80 count:1000 appended:&appended error:&error], @"Should append the second batch");
+    NSAssert(store.count == 3000 && store.tipHeight == 2999, @"Should store all headers");
+    NSAssert([store.tipHash isEqual:[headers.lastObject blockHash]], @"Tip hash should match");
+    NSAssert([[store blockHashAtHeight:1234] isEqual:[headers[1234] blockHash]], @"Stored hash should match");
+    NSAssert([[store headerAtHeight:2999].data isEqual:[headers.lastObject data]], @"Stored header should match");
+    NSAssert([store heightForBlockHash:[headers[10] blockHash]] == 10, @"Should find the header height");
+    NSAssert([store heightForBlockHash:DMCZero256()] == -1, @"Should not find unknown hash");
+
+    NSArray* locator = [store blockLocatorHashes];
+    NSAssert([locator.firstObject isEqual:store.tipHash] && [locator.lastObject isEqual:[headers[0] blockHash]], @"Locator should start at the tip and end at the first header");
+    NSAssert(locator.count < 30, @"Locator should be sparse");
+
+    // Reopening only maps the file.
+    store = nil;
+    store = [[DMCHeaderStore alloc] initWithPath:path error:&error];
+    NSAssert(store.count == 3000 && [store.tipHash isEqual:[headers.lastObject blockHash]], @"Should reopen with the same tip");
+
+    [store truncateToHeight:1999];
+    NSAssert(store.count == 2000 && [store.tipHash isEqual:[headers[1999] blockHash]], @"Should truncate to the height");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
++ (void) testDisconnectedHeaders {
+    NSString* path = [self temporaryPath];
+    NSError* error = nil;
+    DMCHeaderStore* store = [[DMCHeaderStore alloc] initWithPath:path error:&error];
+    [store resetToBaseHeight:100000];
+
+    NSMutableArray* headers = [[DMCBlockHeader chainWithCount:10 previousHash:DMCZero256() bits:0x1d00ffff nonce:0] mutableCopy];
+    DMCBlockHeader* broken = [headers[6] copy];
+    broken.previousBlockHash = DMCZero256();
+    headers[6] = broken;
+
+    // Headers message layout: header followed by a zero transaction count.
+    NSMutableData* message = [NSMutableData data];
+    for (DMCBlockHeader* header in headers) {
+        [message appendData:header.data];
+        [message appendBytes:"\0" length:1];
+    }
+
+    NSUInteger appended = 0;
+    NSAssert(![store appendHeaders:message.bytes stride:81 count:10 appended:&appended error:&error], @"Should fail on a broken link");
+    NSAssert(appended == 6 && error.code == DMCHeaderStoreDisconnectedHeader, @"Should append headers before the broken link");
+    NSAssert(store.baseHeight == 100000 && store.tipHeight == 100005, @"Should count heights from the base");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+@end
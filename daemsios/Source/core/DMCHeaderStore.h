@@ -0,0 +1,75 @@
+// 
+
+#import <Foundation/Foundation.h>
+
+@class DMCBlockHeader;
+
+extern NSString* const DMCHeaderStoreErrorDomain;
+
+typedef NS_ENUM(NSInteger, DMCHeaderStoreError) {
+
+    // File could not be opened, grown or mapped. Underlying POSIX error is in NSUnderlyingErrorKey.
+    DMCHeaderStoreFileError = 1,
+
+    // File exists but is not a header store or is damaged.
+    DMCHeaderStoreCorrupted = 2,
+
+    // Header does not link to the previous header (its previousBlockHash is different).
+    DMCHeaderStoreDisconnectedHeader = 3,
+};
+
+// Header store keeps a chain of block headers in a memory-mapped file of fixed 80-byte records,
+// so the header at any height is found by offset and opening the store costs one mmap.
+// The file starts with a small metadata block (first height, number of headers, tip hash).
+// Block hashes are not stored: the hash of a header is the previousBlockHash of the next one,
+// and the hash of the tip is kept in the metadata.
+@interface DMCHeaderStore : NSObject
+
+// Opens the store at the path, creating an empty one if the file does not exist.
+- (id) initWithPath:(NSString*)path error:(NSError**)errorOut;
+
+// Height of the first stored header (0 unless the store was started from a checkpoint).
+@property(nonatomic, readonly) uint32_t baseHeight;
+
+// Height of the last stored header. Only valid if count > 0.
+@property(nonatomic, readonly) uint32_t tipHeight;
+
+// Number of stored headers.
+@property(nonatomic, readonly) NSUInteger count;
+
+// Hash of the last stored header, or nil if the store is empty.
+@property(nonatomic, readonly) NSData* tipHash;
+
+// Returns 80 bytes of the header at the height, or nil if it is not stored.
+- (NSData*) headerDataAtHeight:(uint32_t)height;
+
+// Returns the parsed header at the height, with `height` set, or nil if it is not stored.
+- (DMCBlockHeader*) headerAtHeight:(uint32_t)height;
+
+// Returns the hash of the header at the height without hashing it, or nil if it is not stored.
+- (NSData*) blockHashAtHeight:(uint32_t)height;
+
+// Returns the height of the stored header with the hash, or -1 if it is not stored. Scans from the tip down.
+- (int64_t) heightForBlockHash:(NSData*)hash;
+
+// Returns hashes for a getheaders block locator: the last 10 headers, then exponentially sparser ones,
+// then the first stored header.
+- (NSArray* /* [NSData] */) blockLocatorHashes;
+
+// Appends `count` headers of 80 bytes starting at `bytes + i*stride` (e.g. stride 81 for a headers message).
+// All headers are hashed in one batch, and each must link to the previous one, the first to the tip.
+// An empty store accepts any first header at baseHeight.
+// Headers before the first one that does not link are appended; if countOut is not NULL it receives their number.
+// Returns NO and sets DMCHeaderStoreDisconnectedHeader if not all headers were appended.
+- (BOOL) appendHeaders:(const void*)bytes stride:(size_t)stride count:(NSUInteger)count appended:(NSUInteger*)countOut error:(NSError**)errorOut;
+
+// Drops headers above the height, e.g. before appending headers of a better fork.
+- (void) truncateToHeight:(uint32_t)height;
+
+// Drops all headers and makes the next appended header start at the height.
+- (void) resetToBaseHeight:(uint32_t)height;
+
+// Flushes the mapped file to disk.
+- (void) synchronize;
+
+@end
@@ -0,0 +1,259 @@
+// 
+
+#import "DMCHeaderStore.h"
+#import "DMCBlockHeader.h"
+#import "DMCSHA256Lanes.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+NSString* const DMCHeaderStoreErrorDomain = @"DMCHeaderStoreErrorDomain";
+
+#define DMCHeaderStoreMagic       0x48434d44 // "DMCH"
+#define DMCHeaderStoreVersion     1
+#define DMCHeaderStoreRecord      80
+#define DMCHeaderStoreGrowRecords 20160 // ten retarget periods per resize
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t baseHeight;
+    uint32_t count;
+    uint8_t tipHash[32];
+    uint8_t reserved[16];
+} DMCHeaderStoreMeta;
+
+@implementation DMCHeaderStore {
+    int _fd;
+    uint8_t* _map;
+    size_t _mapLength;
+    NSUInteger _capacity; // records that fit in the mapped file
+}
+
+- (id) initWithPath:(NSString*)path error:(NSError**)errorOut {
+    if (self = [super init]) {
+        _fd = open(path.fileSystemRepresentation, O_RDWR | O_CREAT, 0644);
+        if (_fd < 0) {
+            if (errorOut) *errorOut = [self fileError];
+            return nil;
+        }
+
+        struct stat st;
+        if (fstat(_fd, &st) < 0) {
+            if (errorOut) *errorOut = [self fileError];
+            return nil;
+        }
+
+        if (st.st_size == 0) {
+            if (![self mapRecords:DMCHeaderStoreGrowRecords error:errorOut]) return nil;
+            DMCHeaderStoreMeta* meta = [self meta];
+            meta->magic = DMCHeaderStoreMagic;
+            meta->version = DMCHeaderStoreVersion;
+        } else {
+            if (st.st_size < sizeof(DMCHeaderStoreMeta)) {
+                if (errorOut) *errorOut = [NSError errorWithDomain:DMCHeaderStoreErrorDomain code:DMCHeaderStoreCorrupted userInfo:nil];
+                return nil;
+            }
+            if (![self mapRecords:(st.st_size - sizeof(DMCHeaderStoreMeta)) / DMCHeaderStoreRecord error:errorOut]) return nil;
+
+            DMCHeaderStoreMeta* meta = [self meta];
+            if (meta->magic != DMCHeaderStoreMagic || meta->version != DMCHeaderStoreVersion || meta->count > _capacity) {
+                if (errorOut) *errorOut = [NSError errorWithDomain:DMCHeaderStoreErrorDomain code:DMCHeaderStoreCorrupted userInfo:nil];
+                return nil;
+            }
+        }
+    }
+    return self;
+}
+
+- (void) dealloc {
+    if (_map) munmap(_map, _mapLength);
+    if (_fd >= 0) close(_fd);
+}
+
+- (NSError*) fileError {
+    NSError* posixError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+    return [NSError errorWithDomain:DMCHeaderStoreErrorDomain code:DMCHeaderStoreFileError userInfo:@{NSUnderlyingErrorKey: posixError}];
+}
+
+// Resizes the file to hold the number of records and maps it again.
+// The old mapping is released only once the new one exists, so a failed grow (e.g. a full disk) leaves the store usable.
+- (BOOL) mapRecords:(NSUInteger)records error:(NSError**)errorOut {
+    size_t length = sizeof(DMCHeaderStoreMeta) + records * DMCHeaderStoreRecord;
+
+    if (ftruncate(_fd, length) < 0) {
+        if (errorOut) *errorOut = [self fileError];
+        return NO;
+    }
+
+    void* map = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (map == MAP_FAILED) {
+        if (errorOut) *errorOut = [self fileError];
+        return NO;
+    }
+
+    if (_map) munmap(_map, _mapLength);
+    _map = map;
+    _mapLength = length;
+    _capacity = records;
+    return YES;
+}
+
+- (DMCHeaderStoreMeta*) meta {
+    return (DMCHeaderStoreMeta*)_map;
+}
+
+- (uint8_t*) recordAtIndex:(NSUInteger)i {
+    return _map + sizeof(DMCHeaderStoreMeta) + i * DMCHeaderStoreRecord;
+}
+
+
+
+#pragma mark - Properties
+
+
+- (uint32_t) baseHeight {
+    return [self meta]->baseHeight;
+}
+
+- (uint32_t) tipHeight {
+    return [self meta]->baseHeight + [self meta]->count - 1;
+}
+
+- (NSUInteger) count {
+    return [self meta]->count;
+}
+
+- (NSData*) tipHash {
+    if ([self meta]->count == 0) return nil;
+    return [NSData dataWithBytes:[self meta]->tipHash length:32];
+}
+
+- (BOOL) containsHeight:(uint32_t)height {
+    DMCHeaderStoreMeta* meta = [self meta];
+    return height >= meta->baseHeight && height - meta->baseHeight < meta->count;
+}
+
+- (NSData*) headerDataAtHeight:(uint32_t)height {
+    if (![self containsHeight:height]) return nil;
+    return [NSData dataWithBytes:[self recordAtIndex:height - self.baseHeight] length:DMCHeaderStoreRecord];
+}
+
+- (DMCBlockHeader*) headerAtHeight:(uint32_t)height {
+    NSData* data = [self headerDataAtHeight:height];
+    if (!data) return nil;
+
+    DMCBlockHeader* header = [[DMCBlockHeader alloc] initWithData:data];
+    header.height = height;
+    return header;
+}
+
+- (NSData*) blockHashAtHeight:(uint32_t)height {
+    if (![self containsHeight:height]) return nil;
+    if (height == self.tipHeight) return self.tipHash;
+
+    // The next header commits to this one's hash.
+    return [NSData dataWithBytes:[self recordAtIndex:height - self.baseHeight + 1] + 4 length:32];
+}
+
+- (int64_t) heightForBlockHash:(NSData*)hash {
+    DMCHeaderStoreMeta* meta = [self meta];
+    if (meta->count == 0 || hash.length != 32) return -1;
+    if (memcmp(meta->tipHash, hash.bytes, 32) == 0) return self.tipHeight;
+
+    for (NSUInteger i = meta->count - 1; i > 0; i--) {
+        if (memcmp([self recordAtIndex:i] + 4, hash.bytes, 32) == 0) return (int64_t)meta->baseHeight + i - 1;
+    }
+    return -1;
+}
+
+- (NSArray*) blockLocatorHashes {
+    NSMutableArray* hashes = [NSMutableArray array];
+    if (self.count == 0) return hashes;
+
+    int64_t height = self.tipHeight;
+    int64_t step = 1;
+
+    while (height > self.baseHeight) {
+        [hashes addObject:[self blockHashAtHeight:(uint32_t)height]];
+        if (hashes.count >= 10) step *= 2;
+        height -= step;
+    }
+    [hashes addObject:[self blockHashAtHeight:self.baseHeight]];
+    return hashes;
+}
+
+
+
+#pragma mark - Updates
+
+
+- (BOOL) appendHeaders:(const void*)bytes stride:(size_t)stride count:(NSUInteger)count appended:(NSUInteger*)countOut error:(NSError**)errorOut {
+    if (countOut) *countOut = 0;
+    if (count == 0) return YES;
+
+    NSMutableData* digests = [NSMutableData dataWithLength:count * 32];
+    DMCHash256Lanes(digests.mutableBytes, bytes, DMCHeaderStoreRecord, stride, count);
+
+    // Find how many headers link to each other and to the tip.
+    const uint8_t* prev = ([self meta]->count > 0) ? [self meta]->tipHash : NULL;
+    NSUInteger linked = 0;
+    for (; linked < count; linked++) {
+        const uint8_t* header = (const uint8_t*)bytes + linked * stride;
+        if (prev && memcmp(header + 4, prev, 32) != 0) break;
+        prev = (const uint8_t*)digests.bytes + linked * 32;
+    }
+
+    if (linked > 0) {
+        NSUInteger needed = [self meta]->count + linked;
+        if (needed > _capacity && ![self mapRecords:MAX(needed, _capacity + DMCHeaderStoreGrowRecords) error:errorOut]) return NO;
+
+        DMCHeaderStoreMeta* meta = [self meta];
+        for (NSUInteger i = 0; i < linked; i++) {
+            memcpy([self recordAtIndex:meta->count + i], (const uint8_t*)bytes + i * stride, DMCHeaderStoreRecord);
+        }
+
+        // Records are in place before the count covers them.
+        memcpy(meta->tipHash, (const uint8_t*)digests.bytes + (linked - 1) * 32, 32);
+        meta->count += linked;
+    }
+
+    if (countOut) *countOut = linked;
+
+    if (linked < count) {
+        if (errorOut) *errorOut = [NSError errorWithDomain:DMCHeaderStoreErrorDomain code:DMCHeaderStoreDisconnectedHeader userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Header %lu of %lu does not link to the previous header", (unsigned long)linked, (unsigned long)count]}];
+        return NO;
+    }
+    return YES;
+}
+
+- (void) truncateToHeight:(uint32_t)height {
+    DMCHeaderStoreMeta* meta = [self meta];
+    if (meta->count == 0 || height >= self.tipHeight) return;
+
+    if (height < meta->baseHeight) {
+        meta->count = 0;
+        memset(meta->tipHash, 0, 32);
+        return;
+    }
+
+    NSUInteger count = height - meta->baseHeight + 1;
+
+    // The first dropped header commits to the new tip's hash.
+    memcpy(meta->tipHash, [self recordAtIndex:count] + 4, 32);
+    meta->count = (uint32_t)count;
+}
+
+- (void) resetToBaseHeight:(uint32_t)height {
+    DMCHeaderStoreMeta* meta = [self meta];
+    meta->count = 0;
+    meta->baseHeight = height;
+    memset(meta->tipHash, 0, 32);
+}
+
+- (void) synchronize {
+    msync(_map, _mapLength, MS_ASYNC);
+}
+
+@end
@@ -0,0 +1,9 @@
+// 
+
+#import "DMCHeaderTree.h"
+
+@interface DMCHeaderTree (Tests)
+
++ (void) runAllTests;
+
+@end
@@ -0,0 +1,111 @@
+// 
+
+#import "DMCHeaderTree+Tests.h"
+#import "DMCBlockHeader+Tests.h"
+#import "DMCBigNumber.h"
+#import "DMCData.h"
+
+@implementation DMCHeaderTree (Tests)
+
++ (void) runAllTests {
+    [self testWork];
+    [self testAncestors];
+    [self testReorganization];
+    [self testProofOfWork];
+}
+
++ (void) testWork {
+    NSAssert([[DMCHeaderTree workForDifficultyTarget:0x1d00ffff].decimalString isEqual:@"4295032833"], @"Work of the lowest difficulty should be 0x100010001");
+    NSAssert([DMCHeaderTree workForDifficultyTarget:0] == nil, @"Zero target is invalid");
+    NSAssert([DMCHeaderTree workForDifficultyTarget:0x1d80ffff] == nil, @"Negative target is invalid");
+
+    NSArray* headers = [DMCBlockHeader minedChainWithCount:10 previousHash:DMCZero256() bits:0x207fffff nonce:0];
+    DMCBigNumber* rootWork = [[DMCBigNumber alloc] initWithDecimalString:@"18446744073709551615"]; // 2^64 - 1, so the sum crosses a word boundary
+    DMCHeaderTree* tree = [[DMCHeaderTree alloc] initWithRootHeader:headers[0] height:0 chainWork:rootWork];
+
+    NSError* error = nil;
+    NSAssert([tree addHeaders:[headers subarrayWithRange:NSMakeRange(1, 9)] disconnected:NULL connected:NULL error:&error], @"Should add the chain");
+
+    NSAssert([[DMCHeaderTree workForDifficultyTarget:0x207fffff].decimalString isEqual:@"2"], @"Work of the regtest target should be 2");
+    DMCMutableBigNumber* expected = [rootWork mutableCopy];
+    [expected add:[[DMCBigNumber alloc] initWithUInt32:2 * 9]];
+    NSAssert([tree.tip.chainWork isEqual:expected], @"Chain work should be the sum of header work");
+}
+
++ (void) testAncestors {
+    NSArray* headers = [DMCBlockHeader minedChainWithCount:1000 previousHash:DMCZero256() bits:0x207fffff nonce:0];
+    DMCHeaderTree* tree = [[DMCHeaderTree alloc] initWithRootHeader:headers[0] height:500000 chainWork:nil];
+    NSAssert([tree addHeaders:[headers subarrayWithRange:NSMakeRange(1, 999)] disconnected:NULL connected:NULL error:NULL], @"Should add the chain");
+    NSAssert(tree.count == 1000 && tree.tip.height == 500999, @"Tip should be the last header");
+
+    for (uint32_t h = 500000; h < 501000; h += 37) {
+        DMCHeaderTreeNode* ancestor = [tree.tip ancestorAtHeight:h];
+        NSAssert(ancestor.height == h && [ancestor.blockHash isEqual:[headers[h - 500000] blockHash]], @"Should find the ancestor");
+    }
+    NSAssert([tree.tip ancestorAtHeight:499999] == nil, @"Nothing below the root");
+    NSAssert([tree.root ancestorAtHeight:500001] == nil, @"Nothing above the node");
+
+    NSError* error = nil;
+    DMCBlockHeader* orphan = [DMCBlockHeader minedChainWithCount:1 previousHash:DMCHash256([@"unknown" dataUsingEncoding:NSUTF8StringEncoding]) bits:0x207fffff nonce:0][0];
+    NSAssert(![tree addHeader:orphan error:&error] && error.code == DMCHeaderTreeUnknownParent, @"Should reject header with unknown parent");
+}
+
++ (void) testReorganization {
+    NSArray* main = [DMCBlockHeader minedChainWithCount:100 previousHash:DMCZero256() bits:0x207fffff nonce:0];
+    DMCHeaderTree* tree = [[DMCHeaderTree alloc] initWithRootHeader:main[0] height:0 chainWork:nil];
+
+    NSArray* disconnected = nil;
+    NSArray* connected = nil;
+    NSAssert([tree addHeaders:[main subarrayWithRange:NSMakeRange(1, 99)] disconnected:&disconnected connected:&connected error:NULL], @"Should add the main chain");
+    NSAssert(disconnected.count == 0 && connected.count == 99, @"Should connect the main chain");
+
+    // Fork after height 90 with equal work is not enough to switch.
+    NSArray* fork = [DMCBlockHeader minedChainWithCount:9 previousHash:[main[90] blockHash] bits:0x207fffff nonce:1000];
+    NSAssert([tree addHeaders:fork disconnected:&disconnected connected:&connected error:NULL], @"Should add the fork");
+    NSAssert(tree.tip.height == 99 && [tree.tip.blockHash isEqual:[main.lastObject blockHash]], @"First seen chain stays with equal work");
+    NSAssert(disconnected.count == 0 && connected.count == 0, @"Tip should not move");
+
+    DMCHeaderTreeNode* forkTip = [tree nodeForBlockHash:[fork.lastObject blockHash]];
+    NSAssert([tree commonAncestorOfNode:tree.tip andNode:forkTip].height == 90, @"Fork should split after 90");
+
+    // Two more headers make the fork better.
+    NSArray* more = [DMCBlockHeader minedChainWithCount:2 previousHash:[fork.lastObject blockHash] bits:0x207fffff nonce:2000];
+    NSAssert([tree addHeaders:more disconnected:&disconnected connected:&connected error:NULL], @"Should extend the fork");
+    NSAssert(tree.tip.height == 101, @"Fork should become the best chain");
+
+    NSAssert(disconnected.count == 9, @"Should disconnect main chain above 90");
+    NSAssert([[disconnected.firstObject blockHash] isEqual:[main[99] blockHash]] && [disconnected.lastObject height] == 91, @"Disconnected blocks go from the old tip down");
+
+    NSAssert(connected.count == 11, @"Should connect the whole fork");
+    NSAssert([[connected.firstObject blockHash] isEqual:[fork[0] blockHash]] && [connected.lastObject height] == 101, @"Connected blocks go from the ancestor up");
+
+    NSArray* back = nil;
+    NSArray* forward = nil;
+    [tree pathFromNode:tree.tip toNode:[tree nodeForBlockHash:[main[95] blockHash]] disconnected:&back connected:&forward];
+    NSAssert(back.count == 11 && forward.count == 5, @"Path should go through the common ancestor");
+}
+
++ (void) testProofOfWork {
+    NSArray* main = [DMCBlockHeader minedChainWithCount:10 previousHash:DMCZero256() bits:0x207fffff nonce:0];
+    DMCHeaderTree* tree = [[DMCHeaderTree alloc] initWithRootHeader:main[0] height:0 chainWork:nil];
+    NSAssert([tree addHeaders:[main subarrayWithRange:NSMakeRange(1, 9)] disconnected:NULL connected:NULL error:NULL], @"Should add the mined chain");
+
+    // A header claiming a hard target it was never mined for would outweigh the whole chain.
+    DMCBlockHeader* fake = [DMCBlockHeader chainWithCount:1 previousHash:[main[5] blockHash] bits:0x03000001 nonce:0][0];
+    NSError* error = nil;
+    NSAssert(![tree addHeader:fake error:&error] && error.code == DMCHeaderTreeInsufficientProofOfWork, @"Should reject a header whose hash is above its target");
+    NSAssert(tree.tip.height == 9 && tree.count == 10, @"Rejected header should not move the tip");
+
+    // Hash above the easy target: find a nonce that fails it.
+    DMCBlockHeader* unmined = [DMCBlockHeader chainWithCount:1 previousHash:[main.lastObject blockHash] bits:0x207fffff nonce:0][0];
+    DMCBigNumber* target = [[DMCBigNumber alloc] initWithCompact:0x207fffff];
+    while ([[[DMCBigNumber alloc] initWithUnsignedBigEndian:DMCReversedData(unmined.blockHash)] lessOrEqual:target]) unmined.nonce++;
+    NSAssert(![tree addHeader:unmined error:&error] && error.code == DMCHeaderTreeInsufficientProofOfWork, @"Should reject an unmined header");
+
+    // Targets above the network limit are rejected even when the hash meets them.
+    DMCHeaderTree* limited = [[DMCHeaderTree alloc] initWithRootHeader:main[0] height:0 chainWork:nil];
+    limited.proofOfWorkLimit = [[DMCBigNumber alloc] initWithCompact:0x1d00ffff];
+    NSAssert(![limited addHeader:main[1] error:&error] && error.code == DMCHeaderTreeInvalidTarget, @"Should reject a target above the limit");
+}
+
+@end
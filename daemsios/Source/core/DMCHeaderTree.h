@@ -0,0 +1,96 @@
+// 
+
+#import <Foundation/Foundation.h>
+
+@class DMCBlockHeader;
+@class DMCBigNumber;
+
+extern NSString* const DMCHeaderTreeErrorDomain;
+
+typedef NS_ENUM(NSInteger, DMCHeaderTreeError) {
+
+    // Header's previousBlockHash is not in the tree.
+    DMCHeaderTreeUnknownParent = 1,
+
+    // Header's difficulty target is zero, negative, overflows 256 bits or is above the proof of work limit.
+    DMCHeaderTreeInvalidTarget = 2,
+
+    // Header's block hash is above its difficulty target.
+    DMCHeaderTreeInsufficientProofOfWork = 3,
+};
+
+// A header stored in the tree with its position and the total work of the chain ending with it.
+@interface DMCHeaderTreeNode : NSObject
+
+@property(nonatomic, readonly) DMCBlockHeader* header;
+@property(nonatomic, readonly) NSData* blockHash;
+@property(nonatomic, readonly) uint32_t height;
+
+// Previous node, or nil for the root of the tree.
+@property(nonatomic, readonly) DMCHeaderTreeNode* parent;
+
+// Sum of the work of this header and all its ancestors (including work before the root if it was given).
+@property(nonatomic, readonly) DMCBigNumber* chainWork;
+
+// Returns the ancestor at the height (or self), or nil if the height is above this node or below the root.
+// Follows skip pointers, so it takes O(log n) steps.
+- (DMCHeaderTreeNode*) ancestorAtHeight:(uint32_t)height;
+
+// Returns YES if the chain of this node has more work than the chain of the other node.
+- (BOOL) hasMoreWorkThan:(DMCHeaderTreeNode*)node;
+
+@end
+
+
+// Header tree keeps block headers on all known forks, keyed by hash, and follows the chain with the most work.
+// Each node keeps its cumulative work in fixed-width 256-bit words, so comparing forks does not allocate,
+// and a skip pointer to a far ancestor, so ancestors and common ancestors are found in O(log n).
+// When the best chain changes, the tree returns the exact list of blocks to disconnect and connect,
+// so wallet state can be rolled back incrementally instead of rescanning.
+@interface DMCHeaderTree : NSObject
+
+// Root of the tree: genesis block or a checkpoint header.
+@property(nonatomic, readonly) DMCHeaderTreeNode* root;
+
+// Last node of the chain with the most work. If forks have equal work, the first seen one stays the best.
+@property(nonatomic, readonly) DMCHeaderTreeNode* tip;
+
+// Number of headers in the tree, including the root.
+@property(nonatomic, readonly) NSUInteger count;
+
+// Highest target a header may have (DMCNetwork.proofOfWorkLimit). Default is nil: any valid target is accepted.
+@property(nonatomic) DMCBigNumber* proofOfWorkLimit;
+
+// Creates a tree starting with the header at the height.
+// `chainWork` is the total work of the chain up to and including the header, or nil to count only the header's own work.
+- (id) initWithRootHeader:(DMCBlockHeader*)header height:(uint32_t)height chainWork:(DMCBigNumber*)chainWork;
+
+// Returns the node with the block hash, or nil if it is not in the tree.
+- (DMCHeaderTreeNode*) nodeForBlockHash:(NSData*)hash;
+
+// Adds a header whose parent is in the tree and moves the tip if the new chain has more work.
+// The block hash must meet the header's target, otherwise anyone could claim the work of any target for free.
+// The root is trusted as given and is not checked.
+// Returns the existing node if the header is already in the tree.
+// Returns nil and sets DMCHeaderTreeUnknownParent, DMCHeaderTreeInvalidTarget or DMCHeaderTreeInsufficientProofOfWork
+// if the header can not be added.
+- (DMCHeaderTreeNode*) addHeader:(DMCBlockHeader*)header error:(NSError**)errorOut;
+
+// Adds headers in order, hashing them in one batch. Stops at the first header that can not be added.
+// If the tip has moved, `disconnectedOut` receives nodes to disconnect from the old tip down
+// and `connectedOut` receives nodes to connect from the common ancestor up (both empty if the tip has not moved).
+// Returns NO and sets the error if not all headers were added; the lists still describe the tip change that happened.
+- (BOOL) addHeaders:(NSArray* /* [DMCBlockHeader] */)headers disconnected:(NSArray**)disconnectedOut connected:(NSArray**)connectedOut error:(NSError**)errorOut;
+
+// Returns the last node that is an ancestor of both nodes (or one of the nodes).
+- (DMCHeaderTreeNode*) commonAncestorOfNode:(DMCHeaderTreeNode*)node1 andNode:(DMCHeaderTreeNode*)node2;
+
+// Lists the nodes to go from one chain to another: `disconnectedOut` from `fromNode` down to the common ancestor (excluded),
+// `connectedOut` from the common ancestor (excluded) up to `toNode`.
+- (void) pathFromNode:(DMCHeaderTreeNode*)fromNode toNode:(DMCHeaderTreeNode*)toNode disconnected:(NSArray**)disconnectedOut connected:(NSArray**)connectedOut;
+
+// Returns the total work a header with this difficulty target adds to the chain: 2^256 / (target + 1).
+// Returns nil if the target is invalid.
++ (DMCBigNumber*) workForDifficultyTarget:(uint32_t)bits;
+
+@end
@@ -0,0 +1,312 @@
+// 
+
+#import "DMCHeaderTree.h"
+#import "DMCBlockHeader.h"
+#import "DMCBigNumber.h"
+#import "DMCData.h"
+
+NSString* const DMCHeaderTreeErrorDomain = @"DMCHeaderTreeErrorDomain";
+
+// 256-bit unsigned integer, least significant word first.
+typedef struct {
+    uint64_t words[4];
+} DMCChainWork;
+
+static DMCChainWork DMCChainWorkAdd(DMCChainWork a, DMCChainWork b) {
+    DMCChainWork sum;
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; i++) {
+        uint64_t s = a.words[i] + carry;
+        carry = (s < carry);
+        sum.words[i] = s + b.words[i];
+        carry += (sum.words[i] < s);
+    }
+    return sum;
+}
+
+static NSComparisonResult DMCChainWorkCompare(DMCChainWork a, DMCChainWork b) {
+    for (int i = 3; i >= 0; i--) {
+        if (a.words[i] < b.words[i]) return NSOrderedAscending;
+        if (a.words[i] > b.words[i]) return NSOrderedDescending;
+    }
+    return NSOrderedSame;
+}
+
+static DMCChainWork DMCChainWorkFromBigNumber(DMCBigNumber* bn) {
+    DMCChainWork work = {{0, 0, 0, 0}};
+    const uint8_t* bytes = bn.unsignedBigEndian.bytes; // 32 bytes, zero-padded
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 8; j++) {
+            work.words[3 - i] = (work.words[3 - i] << 8) | bytes[i * 8 + j];
+        }
+    }
+    return work;
+}
+
+// Block hash is a little-endian 256-bit number.
+static DMCChainWork DMCChainWorkFromHash(NSData* hash) {
+    DMCChainWork number = {{0, 0, 0, 0}};
+    const uint8_t* bytes = hash.bytes;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 7; j >= 0; j--) {
+            number.words[i] = (number.words[i] << 8) | bytes[i * 8 + j];
+        }
+    }
+    return number;
+}
+
+static DMCBigNumber* DMCBigNumberFromChainWork(DMCChainWork work) {
+    uint8_t bytes[32];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 8; j++) {
+            bytes[i * 8 + j] = (uint8_t)(work.words[3 - i] >> (56 - 8 * j));
+        }
+    }
+    return [[DMCBigNumber alloc] initWithUnsignedBigEndian:[NSData dataWithBytes:bytes length:32]];
+}
+
+// Height of the skip pointer target, as in bitcoind: the lowest bits are cleared
+// so that any ancestor is reachable in O(log n) jumps.
+static uint32_t DMCSkipHeight(uint32_t height) {
+    if (height < 2) return 0;
+    uint32_t h = (height & 1) ? height - 1 : height;
+    h &= h - 1;
+    if (height & 1) {
+        h &= h - 1;
+        h += 1;
+    }
+    return h;
+}
+
+
+@interface DMCHeaderTreeNode () {
+@public
+    DMCChainWork _work;
+    DMCHeaderTreeNode* _skip;
+}
+@property(nonatomic, readwrite) DMCBlockHeader* header;
+@property(nonatomic, readwrite) NSData* blockHash;
+@property(nonatomic, readwrite) uint32_t height;
+@property(nonatomic, readwrite) DMCHeaderTreeNode* parent;
+@end
+
+@implementation DMCHeaderTreeNode
+
+- (DMCBigNumber*) chainWork {
+    return DMCBigNumberFromChainWork(_work);
+}
+
+- (DMCHeaderTreeNode*) ancestorAtHeight:(uint32_t)height {
+    if (height > _height) return nil;
+
+    DMCHeaderTreeNode* walk = self;
+    while (walk && walk->_height > height) {
+        DMCHeaderTreeNode* skip = walk->_skip;
+        DMCHeaderTreeNode* parentSkip = walk->_parent ? walk->_parent->_skip : nil;
+
+        // Jump unless the parent's skip gets closer to the height without passing it.
+        if (skip && (skip->_height == height ||
+                     (skip->_height > height && !(parentSkip && parentSkip->_height + 2 < skip->_height && parentSkip->_height >= height)))) {
+            walk = skip;
+        } else {
+            walk = walk->_parent;
+        }
+    }
+    return walk;
+}
+
+- (BOOL) hasMoreWorkThan:(DMCHeaderTreeNode*)node {
+    return DMCChainWorkCompare(_work, node->_work) == NSOrderedDescending;
+}
+
+- (NSString*) description {
+    return [NSString stringWithFormat:@"<%@:0x%p %u %@>", [self class], self, _height, _header.blockID];
+}
+
+@end
+
+
+@implementation DMCHeaderTree {
+    NSMutableDictionary* _nodes; // block hash -> DMCHeaderTreeNode
+    NSMutableDictionary* _workByTarget; // bits -> DMCChainWork target and work; targets change once per retarget period
+}
+
+- (id) initWithRootHeader:(DMCBlockHeader*)header height:(uint32_t)height chainWork:(DMCBigNumber*)chainWork {
+    if (!header) return nil;
+
+    if (self = [super init]) {
+        _nodes = [NSMutableDictionary dictionary];
+        _workByTarget = [NSMutableDictionary dictionary];
+
+        DMCHeaderTreeNode* root = [[DMCHeaderTreeNode alloc] init];
+        root.header = header;
+        root.blockHash = header.blockHash;
+        root.height = height;
+
+        if (chainWork) {
+            root->_work = DMCChainWorkFromBigNumber(chainWork);
+        } else if (![self work:&root->_work target:NULL forDifficultyTarget:header.difficultyTarget]) {
+            return nil;
+        }
+
+        _root = root;
+        _tip = root;
+        _nodes[root.blockHash] = root;
+    }
+    return self;
+}
+
+- (NSUInteger) count {
+    return _nodes.count;
+}
+
+- (void) setProofOfWorkLimit:(DMCBigNumber*)proofOfWorkLimit {
+    _proofOfWorkLimit = proofOfWorkLimit;
+    [_workByTarget removeAllObjects]; // cached targets were checked against the old limit
+}
+
+- (DMCHeaderTreeNode*) nodeForBlockHash:(NSData*)hash {
+    if (!hash) return nil;
+    return _nodes[hash];
+}
+
++ (DMCBigNumber*) workForDifficultyTarget:(uint32_t)bits {
+    DMCBigNumber* target = [[DMCBigNumber alloc] initWithCompact:bits];
+    if ([target lessOrEqual:[DMCBigNumber zero]] || BN_num_bits(target.BIGNUM) > 256) return nil;
+
+    DMCMutableBigNumber* work = [[DMCMutableBigNumber one] lshift:256];
+    [work divide:[[target mutableCopy] add:[DMCBigNumber one]]];
+    return [work copy];
+}
+
+- (BOOL) work:(DMCChainWork*)workOut target:(DMCChainWork*)targetOut forDifficultyTarget:(uint32_t)bits {
+    NSNumber* key = @(bits);
+    NSData* cached = _workByTarget[key];
+
+    if (!cached) {
+        DMCBigNumber* work = [DMCHeaderTree workForDifficultyTarget:bits];
+        if (!work) return NO;
+
+        DMCBigNumber* target = [[DMCBigNumber alloc] initWithCompact:bits];
+        if (_proofOfWorkLimit && [target greater:_proofOfWorkLimit]) return NO;
+
+        DMCChainWork pair[2] = { DMCChainWorkFromBigNumber(target), DMCChainWorkFromBigNumber(work) };
+        cached = [NSData dataWithBytes:pair length:sizeof(pair)];
+        _workByTarget[key] = cached;
+    }
+
+    const DMCChainWork* pair = cached.bytes;
+    if (targetOut) *targetOut = pair[0];
+    if (workOut) *workOut = pair[1];
+    return YES;
+}
+
+
+
+#pragma mark - Adding Headers
+
+
+- (DMCHeaderTreeNode*) addHeader:(DMCBlockHeader*)header error:(NSError**)errorOut {
+    return [self addHeader:header blockHash:header.blockHash error:errorOut];
+}
+
+- (DMCHeaderTreeNode*) addHeader:(DMCBlockHeader*)header blockHash:(NSData*)hash error:(NSError**)errorOut {
+    DMCHeaderTreeNode* existing = _nodes[hash];
+    if (existing) return existing;
+
+    DMCHeaderTreeNode* parent = _nodes[header.previousBlockHash];
+    if (!parent) {
+        if (errorOut) *errorOut = [NSError errorWithDomain:DMCHeaderTreeErrorDomain code:DMCHeaderTreeUnknownParent userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Previous block %@ is not in the header tree", header.previousBlockID]}];
+        return nil;
+    }
+
+    DMCChainWork work;
+    DMCChainWork target;
+    if (![self work:&work target:&target forDifficultyTarget:header.difficultyTarget]) {
+        if (errorOut) *errorOut = [NSError errorWithDomain:DMCHeaderTreeErrorDomain code:DMCHeaderTreeInvalidTarget userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Invalid difficulty target 0x%08x", header.difficultyTarget]}];
+        return nil;
+    }
+
+    if (DMCChainWorkCompare(DMCChainWorkFromHash(hash), target) == NSOrderedDescending) {
+        if (errorOut) *errorOut = [NSError errorWithDomain:DMCHeaderTreeErrorDomain code:DMCHeaderTreeInsufficientProofOfWork userInfo:@{NSLocalizedDescriptionKey: [NSString stringWithFormat:@"Block hash %@ is above its difficulty target 0x%08x", header.blockID, header.difficultyTarget]}];
+        return nil;
+    }
+
+    DMCHeaderTreeNode* node = [[DMCHeaderTreeNode alloc] init];
+    node.header = header;
+    node.blockHash = hash;
+    node.height = parent.height + 1;
+    node.parent = parent;
+    node->_work = DMCChainWorkAdd(parent->_work, work);
+    node->_skip = [parent ancestorAtHeight:MAX(DMCSkipHeight(node.height), _root.height)];
+
+    _nodes[hash] = node;
+
+    if ([node hasMoreWorkThan:_tip]) _tip = node;
+
+    return node;
+}
+
+- (BOOL) addHeaders:(NSArray*)headers disconnected:(NSArray**)disconnectedOut connected:(NSArray**)connectedOut error:(NSError**)errorOut {
+    DMCHeaderTreeNode* oldTip = _tip;
+    NSArray* hashes = [DMCBlockHeader blockHashesForHeaders:headers];
+    BOOL result = YES;
+
+    for (NSUInteger i = 0; i < headers.count; i++) {
+        if (![self addHeader:headers[i] blockHash:hashes[i] error:errorOut]) {
+            result = NO;
+            break;
+        }
+    }
+
+    [self pathFromNode:oldTip toNode:_tip disconnected:disconnectedOut connected:connectedOut];
+    return result;
+}
+
+
+
+#pragma mark - Forks
+
+
+- (DMCHeaderTreeNode*) commonAncestorOfNode:(DMCHeaderTreeNode*)node1 andNode:(DMCHeaderTreeNode*)node2 {
+    if (node1.height > node2.height) {
+        node1 = [node1 ancestorAtHeight:node2.height];
+    } else {
+        node2 = [node2 ancestorAtHeight:node1.height];
+    }
+
+    while (node1 && node2 && node1 != node2) {
+        // Nodes at equal heights have skip pointers at equal heights.
+        // Different skip targets mean the chains split below them.
+        if (node1->_skip && node1->_skip != node2->_skip) {
+            node1 = node1->_skip;
+            node2 = node2->_skip;
+        } else {
+            node1 = node1->_parent;
+            node2 = node2->_parent;
+        }
+    }
+    return node1;
+}
+
+- (void) pathFromNode:(DMCHeaderTreeNode*)fromNode toNode:(DMCHeaderTreeNode*)toNode disconnected:(NSArray**)disconnectedOut connected:(NSArray**)connectedOut {
+    DMCHeaderTreeNode* ancestor = [self commonAncestorOfNode:fromNode andNode:toNode];
+
+    if (disconnectedOut) {
+        NSMutableArray* disconnected = [NSMutableArray array];
+        for (DMCHeaderTreeNode* node = fromNode; node != ancestor; node = node->_parent) {
+            [disconnected addObject:node];
+        }
+        *disconnectedOut = disconnected;
+    }
+
+    if (connectedOut) {
+        NSMutableArray* connected = [NSMutableArray array];
+        for (DMCHeaderTreeNode* node = toNode; node != ancestor; node = node->_parent) {
+            [connected addObject:node];
+        }
+        *connectedOut = [[connected reverseObjectEnumerator] allObjects];
+    }
+}
+
+@end
@@ -0,0 +1,27 @@
+// 
+
+#import <Foundation/Foundation.h>
+
+// Hex codec used by DMCHexFromData, DMCDataFromHex, DMCIDFromHash and the like.
+// Processes 16 bytes per step with SSSE3 on x86-64 or NEON on ARM64, and uses lookup tables for the rest.
+
+typedef NS_OPTIONS(NSUInteger, DMCHexOptions) {
+    DMCHexLowercase = 0,
+    DMCHexUppercase = 1 << 0, // Encode with A-F (decoding accepts both cases).
+    DMCHexReversed  = 1 << 1, // Byte order is reversed between data and hex, as in transaction and block IDs.
+};
+
+// Writes 2*length hex characters into `hex` (no terminating zero).
+void DMCHexEncode(char* hex, const unsigned char* data, size_t length, DMCHexOptions options);
+
+// Decodes 2*length hex characters into `length` bytes of `data`.
+// Returns the number of bytes decoded before the first non-hex character, which is `length` if the whole string is valid.
+// With DMCHexReversed only a complete result is meaningful.
+size_t DMCHexDecode(unsigned char* data, const char* hex, size_t length, DMCHexOptions options);
+
+// Hex string for data, nil if data is nil.
+NSString* DMCHexFromDataWithOptions(NSData* data, DMCHexOptions options);
+
+// Data for a zero-terminated hex string (lower- or uppercase, with optional 0x prefix).
+// Returns nil if the string has odd length or contains non-hex characters.
+NSData* DMCDataWithHexCStringOptions(const char* hexCString, DMCHexOptions options);
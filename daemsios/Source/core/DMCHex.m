@@ -0,0 +1,238 @@
+// 
+
+#import "DMCHex.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define DMC_HEX_SSSE3 1
+#include <tmmintrin.h>
+#elif (defined(__arm64__) || defined(__aarch64__)) && defined(__ARM_NEON)
+#define DMC_HEX_NEON 1
+#include <arm_neon.h>
+#endif
+
+static const char* DMCHexLowercaseDigits = "0123456789abcdef";
+static const char* DMCHexUppercaseDigits = "0123456789ABCDEF";
+
+// Values of hex digits, -1 for other characters.
+static const int8_t DMCHexValues[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+    -1,0xa,0xb,0xc,0xd,0xe,0xf, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1,0xa,0xb,0xc,0xd,0xe,0xf, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+// Scalar code handles bytes [from, length). Byte i of the hex string is byte i of data, or length-1-i when reversed.
+
+static void DMCHexEncodeTail(char* hex, const unsigned char* data, size_t from, size_t length, const char* digits, BOOL reversed) {
+    for (size_t i = from; i < length; i++) {
+        unsigned char b = reversed ? data[length - 1 - i] : data[i];
+        hex[2*i] = digits[b >> 4];
+        hex[2*i + 1] = digits[b & 0x0f];
+    }
+}
+
+static size_t DMCHexDecodeTail(unsigned char* data, const char* hex, size_t from, size_t length, BOOL reversed) {
+    for (size_t i = from; i < length; i++) {
+        int hi = DMCHexValues[(unsigned char)hex[2*i]];
+        int lo = DMCHexValues[(unsigned char)hex[2*i + 1]];
+        if ((hi | lo) < 0) return i;
+        data[reversed ? length - 1 - i : i] = (unsigned char)((hi << 4) | lo);
+    }
+    return length;
+}
+
+#pragma mark - SSSE3
+
+#if DMC_HEX_SSSE3
+
+#define DMCHexSSSE3 __attribute__((target("ssse3")))
+
+static DMCHexSSSE3 size_t DMCHexEncodeSSSE3(char* hex, const unsigned char* data, size_t length, const char* digits, BOOL reversed) {
+    const __m128i table = _mm_loadu_si128((const __m128i*)digits);
+    const __m128i mask = _mm_set1_epi8(0x0f);
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i v;
+        if (reversed) {
+            v = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + length - 16 - i)), reverse);
+        } else {
+            v = _mm_loadu_si128((const __m128i*)(data + i));
+        }
+        __m128i hi = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(v, mask));
+        _mm_storeu_si128((__m128i*)(hex + 2*i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i*)(hex + 2*i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+    return i;
+}
+
+// Converts 16 characters to their values and clears bits of `valid` for non-hex characters.
+static inline DMCHexSSSE3 __m128i DMCHexValuesSSSE3(__m128i c, __m128i* valid) {
+    __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+    *valid = _mm_and_si128(*valid, _mm_or_si128(isDigit, isLetter));
+    return _mm_or_si128(_mm_and_si128(isDigit, digit),
+                        _mm_and_si128(isLetter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+
+static DMCHexSSSE3 size_t DMCHexDecodeSSSE3(unsigned char* data, const char* hex, size_t length, BOOL reversed) {
+    const __m128i weights = _mm_set1_epi16(0x0110); // high digit * 16 + low digit
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i valid = _mm_set1_epi8(-1);
+        __m128i a = DMCHexValuesSSSE3(_mm_loadu_si128((const __m128i*)(hex + 2*i)), &valid);
+        __m128i b = DMCHexValuesSSSE3(_mm_loadu_si128((const __m128i*)(hex + 2*i + 16)), &valid);
+        if (_mm_movemask_epi8(valid) != 0xffff) break;
+
+        __m128i v = _mm_packus_epi16(_mm_maddubs_epi16(a, weights), _mm_maddubs_epi16(b, weights));
+        if (reversed) {
+            _mm_storeu_si128((__m128i*)(data + length - 16 - i), _mm_shuffle_epi8(v, reverse));
+        } else {
+            _mm_storeu_si128((__m128i*)(data + i), v);
+        }
+    }
+    return i;
+}
+
+#endif
+
+#pragma mark - NEON
+
+#if DMC_HEX_NEON
+
+static inline uint8x16_t DMCHexReverseNEON(uint8x16_t v) {
+    v = vrev64q_u8(v);
+    return vextq_u8(v, v, 8);
+}
+
+static size_t DMCHexEncodeNEON(char* hex, const unsigned char* data, size_t length, const char* digits, BOOL reversed) {
+    const uint8x16_t table = vld1q_u8((const uint8_t*)digits);
+    const uint8x16_t mask = vdupq_n_u8(0x0f);
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t v = reversed ? DMCHexReverseNEON(vld1q_u8(data + length - 16 - i)) : vld1q_u8(data + i);
+        uint8x16x2_t chars;
+        chars.val[0] = vqtbl1q_u8(table, vshrq_n_u8(v, 4));
+        chars.val[1] = vqtbl1q_u8(table, vandq_u8(v, mask));
+        vst2q_u8((uint8_t*)hex + 2*i, chars);
+    }
+    return i;
+}
+
+// Converts 16 characters to their values and clears bits of `valid` for non-hex characters.
+static inline uint8x16_t DMCHexValuesNEON(uint8x16_t c, uint8x16_t* valid) {
+    uint8x16_t digit = vsubq_u8(c, vdupq_n_u8('0'));
+    uint8x16_t letter = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t isDigit = vcleq_u8(digit, vdupq_n_u8(9));
+    uint8x16_t isLetter = vcleq_u8(letter, vdupq_n_u8(5));
+    *valid = vandq_u8(*valid, vorrq_u8(isDigit, isLetter));
+    return vbslq_u8(isDigit, digit, vaddq_u8(letter, vdupq_n_u8(10)));
+}
+
+static size_t DMCHexDecodeNEON(unsigned char* data, const char* hex, size_t length, BOOL reversed) {
+    size_t i = 0;
+
+    for (; i + 16 <= length; i += 16) {
+        uint8x16x2_t chars = vld2q_u8((const uint8_t*)hex + 2*i); // even and odd characters
+        uint8x16_t valid = vdupq_n_u8(0xff);
+        uint8x16_t hi = DMCHexValuesNEON(chars.val[0], &valid);
+        uint8x16_t lo = DMCHexValuesNEON(chars.val[1], &valid);
+        if (vminvq_u8(valid) != 0xff) break;
+
+        uint8x16_t v = vorrq_u8(vshlq_n_u8(hi, 4), lo);
+        if (reversed) {
+            vst1q_u8(data + length - 16 - i, DMCHexReverseNEON(v));
+        } else {
+            vst1q_u8(data + i, v);
+        }
+    }
+    return i;
+}
+
+#endif
+
+#pragma mark - Entry Points
+
+void DMCHexEncode(char* hex, const unsigned char* data, size_t length, DMCHexOptions options) {
+    const char* digits = (options & DMCHexUppercase) ? DMCHexUppercaseDigits : DMCHexLowercaseDigits;
+    BOOL reversed = (options & DMCHexReversed) != 0;
+    size_t i = 0;
+
+#if DMC_HEX_SSSE3
+    if (length >= 16 && __builtin_cpu_supports("ssse3")) i = DMCHexEncodeSSSE3(hex, data, length, digits, reversed);
+#elif DMC_HEX_NEON
+    if (length >= 16) i = DMCHexEncodeNEON(hex, data, length, digits, reversed);
+#endif
+
+    DMCHexEncodeTail(hex, data, i, length, digits, reversed);
+}
+
+size_t DMCHexDecode(unsigned char* data, const char* hex, size_t length, DMCHexOptions options) {
+    BOOL reversed = (options & DMCHexReversed) != 0;
+    size_t i = 0;
+
+#if DMC_HEX_SSSE3
+    if (length >= 16 && __builtin_cpu_supports("ssse3")) i = DMCHexDecodeSSSE3(data, hex, length, reversed);
+#elif DMC_HEX_NEON
+    if (length >= 16) i = DMCHexDecodeNEON(data, hex, length, reversed);
+#endif
+
+    return DMCHexDecodeTail(data, hex, i, length, reversed);
+}
+
+NSString* DMCHexFromDataWithOptions(NSData* data, DMCHexOptions options) {
+    if (!data) return nil;
+
+    NSUInteger length = data.length;
+    if (length == 0) return @"";
+
+    char* hex = malloc(length * 2);
+    DMCHexEncode(hex, data.bytes, length, options);
+    return [[NSString alloc] initWithBytesNoCopy:hex length:length * 2 encoding:NSASCIIStringEncoding freeWhenDone:YES];
+}
+
+NSData* DMCDataWithHexCStringOptions(const char* hexCString, DMCHexOptions options) {
+    if (hexCString == NULL) return nil;
+
+    const unsigned char *psz = (const unsigned char*)hexCString;
+
+    while (isspace(*psz)) psz++;
+
+    // Skip optional 0x prefix
+    if (psz[0] == '0' && tolower(psz[1]) == 'x') psz += 2;
+
+    while (isspace(*psz)) psz++;
+
+    size_t len = strlen((const char*)psz);
+
+    // If the string is not full number of bytes (each byte 2 hex characters), return nil.
+    if (len % 2 != 0) return nil;
+
+    unsigned char* buf = (unsigned char*)malloc(len/2);
+
+    if (DMCHexDecode(buf, (const char*)psz, len/2, options) != len/2) {
+        free(buf);
+        return nil;
+    }
+
+    return [[NSData alloc] initWithBytesNoCopy:buf length:len/2];
+}
@@ -0,0 +1,9 @@
+// 
+
+#import "DMCMerkleBlock.h"
+
+@interface DMCMerkleBlock (Tests)
+
++ (void) runAllTests;
+
+@end
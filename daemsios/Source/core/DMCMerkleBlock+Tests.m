@@ -0,0 +1,173 @@
+// 
+
+#import "DMCMerkleBlock+Tests.h"
+#import "DMCMerkleTree.h"
+#import "DMCBlockHeader.h"
+#import "DMCTransaction.h"
+#import "DMCProtocolSerialization.h"
+#import "DMCData.h"
+
+@implementation DMCMerkleBlock (Tests)
+
++ (void) runAllTests {
+    [self testPartialTrees];
+    [self testTransactionCollection];
+    [self testMalformedTrees];
+    [self testTailDuplicates];
+}
+
++ (uint32_t) widthAtHeight:(int)height total:(NSUInteger)total {
+    return (uint32_t)((total + (1 << height) - 1) >> height);
+}
+
++ (NSData*) hashAtHeight:(int)height position:(uint32_t)position leaves:(NSArray*)leaves {
+    if (height == 0) return leaves[position];
+    NSData* left = [self hashAtHeight:height - 1 position:position * 2 leaves:leaves];
+    NSData* right = left;
+    if (position * 2 + 1 < [self widthAtHeight:height - 1 total:leaves.count]) {
+        right = [self hashAtHeight:height - 1 position:position * 2 + 1 leaves:leaves];
+    }
+    return DMCHash256Concat(left, right);
+}
+
+// Builds the partial tree like a full node does (CPartialMerkleTree::TraverseAndBuild).
++ (void) buildAtHeight:(int)height position:(uint32_t)position leaves:(NSArray*)leaves matches:(NSIndexSet*)matches hashes:(NSMutableData*)hashes bits:(NSMutableArray*)bits {
+    NSRange range = NSMakeRange(position << height, MIN((NSUInteger)(position + 1) << height, leaves.count) - (position << height));
+    BOOL parentOfMatch = [matches intersectsIndexesInRange:range];
+    [bits addObject:@(parentOfMatch)];
+
+    if (height == 0 || !parentOfMatch) {
+        [hashes appendData:[self hashAtHeight:height position:position leaves:leaves]];
+    } else {
+        [self buildAtHeight:height - 1 position:position * 2 leaves:leaves matches:matches hashes:hashes bits:bits];
+        if (position * 2 + 1 < [self widthAtHeight:height - 1 total:leaves.count]) {
+            [self buildAtHeight:height - 1 position:position * 2 + 1 leaves:leaves matches:matches hashes:hashes bits:bits];
+        }
+    }
+}
+
+// Returns a merkleblock message payload for the leaves with the matched indexes.
++ (NSData*) messageWithLeaves:(NSArray*)leaves matches:(NSIndexSet*)matches merkleRoot:(NSData*)merkleRoot {
+    int height = 0;
+    while ([self widthAtHeight:height total:leaves.count] > 1) height++;
+
+    NSMutableData* hashes = [NSMutableData data];
+    NSMutableArray* bits = [NSMutableArray array];
+    [self buildAtHeight:height position:0 leaves:leaves matches:matches hashes:hashes bits:bits];
+
+    NSMutableData* flags = [NSMutableData dataWithLength:(bits.count + 7) / 8];
+    for (NSUInteger i = 0; i < bits.count; i++) {
+        if ([bits[i] boolValue]) ((uint8_t*)flags.mutableBytes)[i >> 3] |= 1 << (i & 7);
+    }
+
+    DMCBlockHeader* header = [[DMCBlockHeader alloc] init];
+    header.merkleRootHash = merkleRoot ?: [[DMCMerkleTree alloc] initWithHashes:leaves].merkleRoot;
+    header.time = 1400000000;
+    header.difficultyTarget = 0x1d00ffff;
+
+    uint32_t total = OSSwapHostToLittleInt32((uint32_t)leaves.count);
+    NSMutableData* message = [header.data mutableCopy];
+    [message appendBytes:&total length:4];
+    [message appendData:[DMCProtocolSerialization dataForVarInt:hashes.length / 32]];
+    [message appendData:hashes];
+    [message appendData:[DMCProtocolSerialization dataForVarString:flags]];
+    return message;
+}
+
++ (NSArray*) transactionsWithCount:(NSUInteger)count {
+    NSMutableArray* transactions = [NSMutableArray array];
+    for (NSUInteger i = 0; i < count; i++) {
+        DMCTransaction* tx = [[DMCTransaction alloc] init];
+        tx.lockTime = (uint32_t)i;
+        [transactions addObject:tx];
+    }
+    return transactions;
+}
+
++ (void) testPartialTrees {
+    for (NSNumber* total in @[ @1, @2, @3, @7, @16, @17, @100, @1001 ]) {
+        NSMutableArray* leaves = [NSMutableArray array];
+        for (NSUInteger i = 0; i < total.unsignedIntegerValue; i++) {
+            [leaves addObject:DMCHash256([NSData dataWithBytes:&i length:sizeof(i)])];
+        }
+
+        for (NSNumber* step in @[ @0, @1, @3, @50 ]) {
+            NSMutableIndexSet* matches = [NSMutableIndexSet indexSet];
+            if (step.unsignedIntegerValue > 0) {
+                for (NSUInteger i = 0; i < leaves.count; i += step.unsignedIntegerValue) [matches addIndex:i];
+            }
+
+            DMCMerkleBlock* block = [[DMCMerkleBlock alloc] initWithData:[self messageWithLeaves:leaves matches:matches merkleRoot:nil]];
+            NSAssert(block.isValid && !block.hasTailDuplicates, @"Partial tree of %@ transactions should be valid", total);
+            NSAssert([block.merkleRoot isEqual:block.header.merkleRootHash], @"Root should match the header");
+            NSAssert([block.matchedTransactionHashes isEqual:[leaves objectsAtIndexes:matches]], @"Should return the matched hashes in block order");
+        }
+    }
+
+    NSArray* leaves = @[ DMCHash256([@"a" dataUsingEncoding:NSUTF8StringEncoding]), DMCHash256([@"b" dataUsingEncoding:NSUTF8StringEncoding]) ];
+    DMCMerkleBlock* block = [[DMCMerkleBlock alloc] initWithData:[self messageWithLeaves:leaves matches:[NSIndexSet indexSetWithIndex:1] merkleRoot:DMCZero256()]];
+    NSAssert(block && !block.isValid, @"Root not matching the header makes the block invalid");
+}
+
++ (void) testTransactionCollection {
+    NSArray* transactions = [self transactionsWithCount:10];
+    NSArray* leaves = [transactions valueForKey:@"transactionHash"];
+    NSMutableIndexSet* matches = [NSMutableIndexSet indexSet];
+    [matches addIndex:2];
+    [matches addIndex:5];
+    [matches addIndex:9];
+
+    DMCMerkleBlock* block = [[DMCMerkleBlock alloc] initWithData:[self messageWithLeaves:leaves matches:matches merkleRoot:nil]];
+    NSAssert(block.isValid && block.missingTransactionCount == 3, @"Should expect three transactions");
+
+    NSAssert([block skipTransactionHash:[transactions[5] transactionHash]], @"Should skip a known transaction");
+    NSAssert(![block addTransaction:transactions[3]], @"Should not add a transaction that is not matched");
+    NSAssert([block addTransaction:transactions[9]], @"Should add a matched transaction");
+    NSAssert(![block addTransaction:transactions[9]], @"Should not add a transaction twice");
+    NSAssert(block.missingTransactionCount == 1, @"One transaction should be missing");
+    NSAssert([block addTransaction:transactions[2]] && block.missingTransactionCount == 0, @"All transactions should be received");
+    NSAssert([block.transactions isEqual:@[ transactions[9], transactions[2] ]], @"Should keep added transactions");
+}
+
++ (void) testMalformedTrees {
+    NSMutableArray* leaves = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 20; i++) {
+        [leaves addObject:DMCHash256([NSData dataWithBytes:&i length:sizeof(i)])];
+    }
+    NSData* message = [self messageWithLeaves:leaves matches:[NSIndexSet indexSetWithIndex:7] merkleRoot:nil];
+    NSAssert([[DMCMerkleBlock alloc] initWithData:message].isValid, @"Original block should be valid");
+
+    NSAssert(![[DMCMerkleBlock alloc] initWithData:[message subdataWithRange:NSMakeRange(0, message.length - 1)]], @"Truncated message should fail to parse");
+
+    // Extra flag byte: the tree does not use all flags.
+    NSMutableData* extraFlags = [[message subdataWithRange:NSMakeRange(0, message.length - 1 - 2)] mutableCopy];
+    NSData* flags = [message subdataWithRange:NSMakeRange(message.length - 2, 2)];
+    NSMutableData* longerFlags = [flags mutableCopy];
+    [longerFlags appendBytes:"\0" length:1];
+    [extraFlags appendData:[DMCProtocolSerialization dataForVarString:longerFlags]];
+    DMCMerkleBlock* block = [[DMCMerkleBlock alloc] initWithData:extraFlags];
+    NSAssert(block && !block.isValid, @"Unused flag bytes make the block invalid");
+
+    // Total transactions larger than the tree.
+    NSMutableData* wrongTotal = [message mutableCopy];
+    ((uint8_t*)wrongTotal.mutableBytes)[80] = 40;
+    block = [[DMCMerkleBlock alloc] initWithData:wrongTotal];
+    NSAssert(block && !block.isValid, @"Wrong transaction count makes the block invalid");
+}
+
++ (void) testTailDuplicates {
+    NSData* a = DMCHash256([@"a" dataUsingEncoding:NSUTF8StringEncoding]);
+    NSData* b = DMCHash256([@"b" dataUsingEncoding:NSUTF8StringEncoding]);
+    NSData* c = DMCHash256([@"c" dataUsingEncoding:NSUTF8StringEncoding]);
+
+    // [a, b, c, c] has the same root as [a, b, c].
+    NSArray* duplicated = @[ a, b, c, c ];
+    NSAssert([[DMCMerkleTree alloc] initWithHashes:duplicated].hasTailDuplicates, @"Merkle tree should detect the duplicates");
+
+    NSMutableIndexSet* all = [NSMutableIndexSet indexSetWithIndexesInRange:NSMakeRange(0, 4)];
+    DMCMerkleBlock* block = [[DMCMerkleBlock alloc] initWithData:[self messageWithLeaves:duplicated matches:all merkleRoot:nil]];
+    NSAssert([block.merkleRoot isEqual:[[DMCMerkleTree alloc] initWithHashes:@[ a, b, c ]].merkleRoot], @"Roots should collide");
+    NSAssert(block.hasTailDuplicates && !block.isValid, @"Merkle block should detect the duplicates");
+}
+
+@end
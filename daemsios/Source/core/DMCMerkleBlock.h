@@ -0,0 +1,59 @@
+// 
+
+#import <Foundation/Foundation.h>
+
+@class DMCBlockHeader;
+@class DMCTransaction;
+
+// Merkle block (BIP37) is a block header with a partial merkle tree proving that
+// the transactions matched by a bloom filter are included in the block.
+// The tree is walked once to find its shape, then inner hashes are computed level by level,
+// all pairs of a level in one batch of multi-lane double SHA-256.
+//
+// After a merkleblock message the node sends tx messages for the matched transactions;
+// the block collects them until none is missing.
+@interface DMCMerkleBlock : NSObject
+
+@property(nonatomic, readonly) DMCBlockHeader* header;
+@property(nonatomic, readonly) NSData* blockHash;
+
+// Number of transactions in the full block.
+@property(nonatomic, readonly) uint32_t totalTransactions;
+
+// Hashes of the partial merkle tree in depth-first order.
+@property(nonatomic, readonly) NSArray* /* [NSData] */ hashes;
+
+// Flag bits of the partial merkle tree, least significant bit first.
+@property(nonatomic, readonly) NSData* flags;
+
+// Root computed from the partial merkle tree, or nil if the tree could not be walked.
+@property(nonatomic, readonly) NSData* merkleRoot;
+
+// Hashes of the transactions matched by the filter, in block order.
+@property(nonatomic, readonly) NSArray* /* [NSData] */ matchedTransactionHashes;
+
+// YES if two identical hashes are paired in the tree, the condition of CVE-2012-2459
+// (see DMCMerkleTree.hasTailDuplicates). Such block must be treated as invalid.
+@property(nonatomic, readonly) BOOL hasTailDuplicates;
+
+// YES if the tree uses all hashes and flag bits, has no tail duplicates and its root matches the header.
+@property(nonatomic, readonly) BOOL isValid;
+
+// Transactions collected with addTransaction:, in the order they were added.
+@property(nonatomic, readonly) NSArray* /* [DMCTransaction] */ transactions;
+
+// Number of matched transactions neither added nor skipped yet.
+@property(nonatomic, readonly) NSUInteger missingTransactionCount;
+
+// Parses a merkleblock message payload. Returns nil if it is malformed.
+// The tree is checked during parsing; see `isValid`.
+- (id) initWithData:(NSData*)data;
+
+// Adds a matched transaction. Returns NO if the transaction is not matched by this block or was already added.
+- (BOOL) addTransaction:(DMCTransaction*)transaction;
+
+// Marks a matched transaction as received without keeping it, e.g. when the peer has relayed it before the block
+// and will not send it again. Returns NO if the hash is not matched by this block or was already received.
+- (BOOL) skipTransactionHash:(NSData*)hash;
+
+@end
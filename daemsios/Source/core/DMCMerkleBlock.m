@@ -0,0 +1,234 @@
+// 
+
+#import "DMCMerkleBlock.h"
+#import "DMCBlockHeader.h"
+#import "DMCByteCursor.h"
+#import "DMCTransaction.h"
+#import "DMCSHA256Lanes.h"
+#import "DMCUnitsAndLimits.h"
+
+#define DMCMerkleBlockMaxTransactions (DMC_MAX_BLOCK_SIZE / 60) // block size limit over the smallest transaction size
+#define DMCMerkleBlockMaxHeight       32
+
+// Node of the partial tree visited by the depth-first walk.
+typedef struct {
+    uint32_t position;  // index within its level
+    int32_t hashIndex;  // index in `hashes`, or -1 for a node computed from its children
+} DMCMerkleBlockNode;
+
+// State of the depth-first walk.
+typedef struct {
+    const uint8_t* flags;
+    NSUInteger flagBitCount;
+    NSUInteger bitIndex;
+    NSUInteger hashCount;
+    NSUInteger hashIndex;
+    uint32_t totalTransactions;
+    __unsafe_unretained NSMutableData* levels[DMCMerkleBlockMaxHeight + 1];
+    __unsafe_unretained NSMutableData* matched; // int32 hash indexes
+} DMCMerkleBlockWalk;
+
+static uint32_t DMCMerkleBlockWidth(uint32_t total, int height) {
+    return (uint32_t)(((uint64_t)total + (1ULL << height) - 1) >> height);
+}
+
+// Records the shape of the tree in `levels` without hashing anything.
+static BOOL DMCMerkleBlockTraverse(DMCMerkleBlockWalk* walk, int height, uint32_t position) {
+    if (walk->bitIndex >= walk->flagBitCount) return NO;
+
+    BOOL parentOfMatch = (walk->flags[walk->bitIndex >> 3] >> (walk->bitIndex & 7)) & 1;
+    walk->bitIndex++;
+
+    DMCMerkleBlockNode node = { position, -1 };
+
+    if (height == 0 || !parentOfMatch) {
+        if (walk->hashIndex >= walk->hashCount) return NO;
+        node.hashIndex = (int32_t)walk->hashIndex++;
+        [walk->levels[height] appendBytes:&node length:sizeof(node)];
+
+        if (height == 0 && parentOfMatch) {
+            [walk->matched appendBytes:&node.hashIndex length:sizeof(node.hashIndex)];
+        }
+        return YES;
+    }
+
+    [walk->levels[height] appendBytes:&node length:sizeof(node)];
+
+    if (!DMCMerkleBlockTraverse(walk, height - 1, position * 2)) return NO;
+    if (position * 2 + 1 < DMCMerkleBlockWidth(walk->totalTransactions, height - 1)) {
+        if (!DMCMerkleBlockTraverse(walk, height - 1, position * 2 + 1)) return NO;
+    }
+    return YES;
+}
+
+
+@implementation DMCMerkleBlock {
+    NSData* _hashBytes; // hashes back to back
+    NSDictionary* _matchedIndexes; // tx hash -> index in matchedTransactionHashes
+    NSMutableIndexSet* _received;
+    NSMutableArray* _transactions;
+}
+
+- (id) initWithData:(NSData*)data {
+    if (self = [super init]) {
+        DMCByteCursor* cursor = [[DMCByteCursor alloc] initWithData:data];
+        uint64_t hashCount = 0;
+
+        _header = [[DMCBlockHeader alloc] initWithCursor:cursor];
+        if (!_header) return nil;
+        if (![cursor readUInt32:&_totalTransactions]) return nil;
+        if (![cursor readVarInt:&hashCount] || hashCount > cursor.remainingLength / 32) return nil;
+        if (!(_hashBytes = [cursor readDataOfLength:(NSUInteger)hashCount * 32])) return nil;
+        if (!(_flags = [cursor readVarData])) return nil;
+
+        NSMutableArray* hashes = [NSMutableArray arrayWithCapacity:(NSUInteger)hashCount];
+        for (NSUInteger i = 0; i < hashCount; i++) {
+            [hashes addObject:[_hashBytes subdataWithRange:NSMakeRange(i * 32, 32)]];
+        }
+        _hashes = hashes;
+        _blockHash = _header.blockHash;
+        _transactions = [NSMutableArray array];
+        _received = [NSMutableIndexSet indexSet];
+
+        [self computeMerkleRoot];
+    }
+    return self;
+}
+
+- (void) computeMerkleRoot {
+    _matchedTransactionHashes = @[];
+
+    if (_totalTransactions == 0 || _totalTransactions > DMCMerkleBlockMaxTransactions) return;
+    if (_hashes.count > _totalTransactions || _flags.length * 8 < _hashes.count) return;
+
+    int treeHeight = 0;
+    while (DMCMerkleBlockWidth(_totalTransactions, treeHeight) > 1) treeHeight++;
+
+    NSMutableArray* levels = [NSMutableArray array]; // keeps the buffers the walk points to
+    NSMutableData* matched = [NSMutableData data];
+
+    DMCMerkleBlockWalk walk = {0};
+    walk.flags = _flags.bytes;
+    walk.flagBitCount = _flags.length * 8;
+    walk.hashCount = _hashes.count;
+    walk.totalTransactions = _totalTransactions;
+    walk.matched = matched;
+    for (int h = 0; h <= treeHeight; h++) {
+        [levels addObject:[NSMutableData data]];
+        walk.levels[h] = levels[h];
+    }
+
+    if (!DMCMerkleBlockTraverse(&walk, treeHeight, 0)) return;
+
+    // All hashes must be used, and flag bits only padded to a whole byte.
+    if (walk.hashIndex != walk.hashCount || (walk.bitIndex + 7) / 8 != _flags.length) return;
+
+    // Compute inner nodes bottom up. Children of the inner nodes of a level are consecutive
+    // in the level below, because the walk visits each level left to right.
+    const uint8_t* hashBytes = _hashBytes.bytes;
+    NSMutableData* below = nil; // hashes of the level below, in visit order
+
+    for (int h = 0; h <= treeHeight; h++) {
+        NSData* level = levels[h];
+        const DMCMerkleBlockNode* nodes = level.bytes;
+        NSUInteger count = level.length / sizeof(DMCMerkleBlockNode);
+        NSMutableData* current = [NSMutableData dataWithLength:count * 32];
+        uint8_t* out = current.mutableBytes;
+
+        NSMutableData* pairs = [NSMutableData data];
+        NSMutableData* targets = [NSMutableData data]; // index in `current` for each pair
+        NSUInteger child = 0;
+        NSUInteger belowCount = below.length / 32;
+        uint32_t belowWidth = (h > 0) ? DMCMerkleBlockWidth(_totalTransactions, h - 1) : 0;
+
+        for (NSUInteger i = 0; i < count; i++) {
+            if (nodes[i].hashIndex >= 0) {
+                memcpy(out + i * 32, hashBytes + nodes[i].hashIndex * 32, 32);
+                continue;
+            }
+
+            if (child >= belowCount) return;
+            const uint8_t* left = (const uint8_t*)below.bytes + child++ * 32;
+            const uint8_t* right = left;
+
+            if (nodes[i].position * 2 + 1 < belowWidth) {
+                if (child >= belowCount) return;
+                right = (const uint8_t*)below.bytes + child++ * 32;
+
+                // Identical left and right branches are the CVE-2012-2459 duplication.
+                if (memcmp(left, right, 32) == 0) _hasTailDuplicates = YES;
+            }
+
+            [pairs appendBytes:left length:32];
+            [pairs appendBytes:right length:32];
+            [targets appendBytes:&i length:sizeof(i)];
+        }
+
+        NSUInteger pairCount = targets.length / sizeof(NSUInteger);
+        if (pairCount > 0) {
+            NSMutableData* digests = [NSMutableData dataWithLength:pairCount * 32];
+            DMCHash256Lanes(digests.mutableBytes, pairs.bytes, 64, 64, pairCount);
+
+            const NSUInteger* indexes = targets.bytes;
+            for (NSUInteger j = 0; j < pairCount; j++) {
+                memcpy(out + indexes[j] * 32, (const uint8_t*)digests.bytes + j * 32, 32);
+            }
+        }
+
+        below = current;
+    }
+
+    if (below.length != 32) return;
+    _merkleRoot = [below copy];
+
+    const int32_t* matchedIndexes = matched.bytes;
+    NSUInteger matchedCount = matched.length / sizeof(int32_t);
+    NSMutableArray* matchedHashes = [NSMutableArray arrayWithCapacity:matchedCount];
+    NSMutableDictionary* indexByHash = [NSMutableDictionary dictionaryWithCapacity:matchedCount];
+
+    for (NSUInteger i = 0; i < matchedCount; i++) {
+        NSData* hash = _hashes[matchedIndexes[i]];
+        [matchedHashes addObject:hash];
+        indexByHash[hash] = @(i);
+    }
+    _matchedTransactionHashes = matchedHashes;
+    _matchedIndexes = indexByHash;
+}
+
+- (BOOL) isValid {
+    return _merkleRoot && !_hasTailDuplicates && [_merkleRoot isEqual:_header.merkleRootHash];
+}
+
+
+
+#pragma mark - Transactions
+
+
+- (NSArray*) transactions {
+    return [_transactions copy];
+}
+
+- (NSUInteger) missingTransactionCount {
+    return _matchedTransactionHashes.count - _received.count;
+}
+
+- (BOOL) receiveTransactionHash:(NSData*)hash {
+    NSNumber* index = hash ? _matchedIndexes[hash] : nil;
+    if (!index || [_received containsIndex:index.unsignedIntegerValue]) return NO;
+
+    [_received addIndex:index.unsignedIntegerValue];
+    return YES;
+}
+
+- (BOOL) addTransaction:(DMCTransaction*)transaction {
+    if (![self receiveTransactionHash:transaction.transactionHash]) return NO;
+
+    [_transactions addObject:transaction];
+    return YES;
+}
+
+- (BOOL) skipTransactionHash:(NSData*)hash {
+    return [self receiveTransactionHash:hash];
+}
+
+@end
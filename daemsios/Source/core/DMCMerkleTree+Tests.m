@@ -40,6 +40,36 @@
         NSAssert([tree.merkleRoot isEqual:r], @"Root(a,b,c) == Hash(Hash(a+b)+Hash(c+c))");
     }
 
+    // Batched hashing should match pairwise hashing for all tree shapes.
+    for (NSUInteger count = 1; count <= 40; count++) {
+        NSMutableArray* hashes = [NSMutableArray array];
+        for (NSUInteger i = 0; i < count; i++) {
+            [hashes addObject:DMCHash256([NSData dataWithBytes:&i length:sizeof(i)])];
+        }
+        NSArray* level = hashes;
+        while (level.count > 1) {
+            NSMutableArray* next = [NSMutableArray array];
+            for (NSUInteger i = 0; i < level.count; i += 2) {
+                [next addObject:DMCHash256Concat(level[i], level[MIN(i + 1, level.count - 1)])];
+            }
+            level = next;
+        }
+        DMCMerkleTree* tree = [[DMCMerkleTree alloc] initWithHashes:hashes];
+        NSAssert([tree.merkleRoot isEqual:level[0]], @"Root should match pairwise hashing");
+        NSAssert(!tree.hasTailDuplicates, @"Distinct hashes have no tail duplicates");
+    }
+
+    {
+        NSData* a = DMCDataFromHex(@"9c2e4d8fe97d881430de4e754b4205b9c27ce96715231cffc4337340cb110280");
+        NSData* b = DMCDataFromHex(@"0c08173828583fc6ecd6ecdbcca7b6939c49c242ad5107e39deb7b0a5996b903");
+        NSData* c = DMCDataFromHex(@"80903da4e6bbdf96e8ff6fc3966b0cfd355c7e860bdd1caa8e4722d9230e40ac");
+        DMCMerkleTree* tree1 = [[DMCMerkleTree alloc] initWithHashes:@[a, b, c]];
+        DMCMerkleTree* tree2 = [[DMCMerkleTree alloc] initWithHashes:@[a, b, c, c]];
+        NSAssert([tree1.merkleRoot isEqual:tree2.merkleRoot], @"CVE-2012-2459: both trees have the same root");
+        NSAssert(!tree1.hasTailDuplicates, @"Original list has no duplicates");
+        NSAssert(tree2.hasTailDuplicates, @"Duplicated tail should be detected");
+    }
+
 }
 
 @end
@@ -2,6 +2,7 @@
 
 #import "DMCMerkleTree.h"
 #import "DMCData.h"
+#import "DMCSHA256Lanes.h"
 
 @interface DMCMerkleTree ()
 @property(nonatomic, readwrite) NSData* merkleRoot;
@@ -84,6 +85,38 @@
        known ways of changing the transactions without affecting the merkle
        root.
     */
+    _hasTailDuplicates = NO;
+
+    // Each level is kept in a contiguous buffer, so pairs of hashes are hashed in batches.
+    NSUInteger size = self.hashes.count;
+    NSMutableData* level = [NSMutableData dataWithCapacity:(size + 1) * 32];
+    for (NSData* hash in self.hashes) {
+        if (hash.length != 32) return [self computeMerkleRootOfArbitraryHashes];
+        [level appendData:hash];
+    }
+    level.length = (size + 1) * 32; // room for pairing the odd hash
+    while (size > 1) {
+        unsigned char* bytes = level.mutableBytes;
+        if (size % 2 == 0) {
+            if (0 == memcmp(bytes + (size - 2) * 32, bytes + (size - 1) * 32, 32)) {
+                // Two identical hashes at the end of the list at a particular level.
+                _hasTailDuplicates = YES;
+            }
+        } else {
+            // Odd hash is paired with itself.
+            memcpy(bytes + size * 32, bytes + (size - 1) * 32, 32);
+            size++;
+        }
+        NSMutableData* nextLevel = [NSMutableData dataWithLength:(size / 2 + 1) * 32];
+        DMCHash256Lanes(nextLevel.mutableBytes, bytes, 64, 64, size / 2);
+        size /= 2;
+        level = nextLevel;
+    }
+    return [level subdataWithRange:NSMakeRange(0, 32)];
+}
+
+// Same algorithm for hashes of any length, one pair at a time.
+- (NSData*) computeMerkleRootOfArbitraryHashes {
     NSMutableArray* tree = [self.hashes mutableCopy];
     _hasTailDuplicates = NO;
     NSInteger j = 0;
@@ -5,5 +5,6 @@
 @interface DMCMnemonic (Tests)
 
 + (void) runAllTests;
++ (void) runAllBenchmarks;
 
 @end
@@ -1,12 +1,20 @@
 #import "DMCMnemonic+Tests.h"
 #import "DMCData.h"
 #import "NSData+DMCData.h"
+#import "DMCPBKDF2.h"
+#import <CommonCrypto/CommonKeyDerivation.h>
 
 @implementation DMCMnemonic (Tests)
 
 + (void) runAllTests {
     [self testStandardTestVectors];
     [self testMnemonicsWithoutPassword];
+    [self testPBKDF2];
+    [self testSeedsForPasswords];
+}
+
++ (void) runAllBenchmarks {
+    [self benchmarkSeedDerivation];
 }
 
 + (void) testStandardTestVectors {
@@ -162,6 +170,97 @@
     NSAssert([mnemonic.seed isEqual:seed], @"Should generate a correct seed.");
 }
 
+// Cross-checks single and multi-lane PBKDF2 with CommonCrypto for keys longer than one block,
+// passwords longer than a SHA-512 block and lane counts that do not fill the last group.
++ (void) testPBKDF2 {
+    NSMutableData* bytes = [NSMutableData dataWithLength:300];
+    for (NSUInteger i = 0; i < bytes.length; i++) {
+        ((unsigned char*)bytes.mutableBytes)[i] = (unsigned char)(i * 29 + 7);
+    }
+
+    for (size_t count = 1; count <= 9; count++) {
+        size_t keyLength = 1 + (count * 37) % 150;
+        unsigned rounds = 1 + (unsigned)count * 3;
+        const void* passwords[9];
+        const void* salts[9];
+        size_t passwordLengths[9], saltLengths[9];
+
+        for (size_t i = 0; i < count; i++) {
+            passwords[i] = (const unsigned char*)bytes.bytes + i;
+            passwordLengths[i] = (count * 13 + i * 71) % 200;
+            salts[i] = (const unsigned char*)bytes.bytes + 50 + i;
+            saltLengths[i] = (count * 7 + i * 29) % 150;
+        }
+
+        NSMutableData* keys = [NSMutableData dataWithLength:count * keyLength];
+        DMCPBKDF2HMACSHA512Lanes(keys.mutableBytes, keyLength, passwords, passwordLengths, salts, saltLengths, count, rounds);
+
+        for (size_t i = 0; i < count; i++) {
+            unsigned char expected[150], actual[150];
+            CCKeyDerivationPBKDF(kCCPBKDF2, passwords[i], passwordLengths[i], salts[i], saltLengths[i],
+                                 kCCPRFHmacAlgSHA512, rounds, expected, keyLength);
+            DMCPBKDF2HMACSHA512(actual, keyLength, passwords[i], passwordLengths[i], salts[i], saltLengths[i], rounds);
+
+            NSAssert(memcmp(expected, actual, keyLength) == 0, @"PBKDF2 should match CommonCrypto");
+            NSAssert(memcmp(expected, (const unsigned char*)keys.bytes + i * keyLength, keyLength) == 0, @"PBKDF2 lane %@ of %@ should match CommonCrypto", @(i), @(count));
+        }
+    }
+}
+
++ (void) testSeedsForPasswords {
+    NSArray* words = [@"legal winner thank year wave sausage worth useful legal winner thank yellow" componentsSeparatedByString:@" "];
+    NSArray* passwords = @[ @"", @"TREZOR", @"correct horse", @"battery staple", @"TREZOR" ];
+
+    NSArray* seeds = [DMCMnemonic seedsForWords:words passwords:passwords];
+
+    NSAssert(seeds.count == passwords.count, @"Should return a seed per password");
+    NSAssert([seeds[1] isEqual:DMCDataFromHex(@"2e8905819b8723fe2c1d161860e5ee1830318dbf49a83bd451cfb8440c28bd6fa457fe1296106559a3c80937a1c1069be3a3a5bd381ee6260e8d9739fce1f607")], @"Should generate a correct seed.");
+    NSAssert([seeds[4] isEqual:seeds[1]], @"Same password should give the same seed");
+
+    for (NSUInteger i = 0; i < passwords.count; i++) {
+        DMCMnemonic* mnemonic = [[DMCMnemonic alloc] initWithWords:words password:passwords[i] wordListType:DMCMnemonicWordListTypeEnglish];
+        NSAssert([mnemonic.seed isEqual:seeds[i]], @"Batch seed should match a seed of a single mnemonic");
+    }
+
+    NSAssert([DMCMnemonic seedsForWords:words passwords:@[]].count == 0, @"Should return no seeds for no passwords");
+    NSAssert([[DMCMnemonic seedsForWords:words passwords:@[ @"TREZOR" ]] isEqual:@[ seeds[1] ]], @"Single password should give the same seed");
+}
+
++ (void) benchmarkSeedDerivation {
+    NSData* mnemonic = [@"abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon abandon about" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData* salt = [@"mnemonicTREZOR" dataUsingEncoding:NSUTF8StringEncoding];
+    const NSUInteger n = 64;
+    unsigned char seed[64];
+
+    CFAbsoluteTime t0 = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < n; i++) {
+        CCKeyDerivationPBKDF(kCCPBKDF2, mnemonic.bytes, mnemonic.length, salt.bytes, salt.length,
+                             kCCPRFHmacAlgSHA512, 2048, seed, sizeof(seed));
+    }
+    CFAbsoluteTime t1 = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < n; i++) {
+        DMCPBKDF2HMACSHA512(seed, sizeof(seed), mnemonic.bytes, mnemonic.length, salt.bytes, salt.length, 2048);
+    }
+    CFAbsoluteTime t2 = CFAbsoluteTimeGetCurrent();
+
+    const void* passwords[n];
+    const void* salts[n];
+    size_t passwordLengths[n], saltLengths[n];
+    for (NSUInteger i = 0; i < n; i++) {
+        passwords[i] = mnemonic.bytes;
+        passwordLengths[i] = mnemonic.length;
+        salts[i] = salt.bytes;
+        saltLengths[i] = salt.length;
+    }
+    NSMutableData* seeds = [NSMutableData dataWithLength:n * sizeof(seed)];
+    CFAbsoluteTime t3 = CFAbsoluteTimeGetCurrent();
+    DMCPBKDF2HMACSHA512Lanes(seeds.mutableBytes, sizeof(seed), passwords, passwordLengths, salts, saltLengths, n, 2048);
+    CFAbsoluteTime t4 = CFAbsoluteTimeGetCurrent();
+
+    NSLog(@"BIP39 seed: CommonCrypto %.2f ms, saved pad states %.2f ms, %@ lanes %.2f ms per seed",
+          (t1 - t0) * 1000.0 / n, (t2 - t1) * 1000.0 / n, @(DMCPBKDF2HMACSHA512LaneCount()), (t4 - t3) * 1000.0 / n);
+}
+
 + (void) testInvalidWords {
     {
         NSArray* phrases = @[
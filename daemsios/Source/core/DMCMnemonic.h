@@ -59,6 +59,11 @@ typedef NS_ENUM(int8_t, DMCMnemonicWordListType) {
 // If the data was produced by `-dataWithSeed` method, seed will not be recomputed.
 - (id) initWithData:(NSData*)data;
 
+// Computes seeds for the same words with several candidate passwords (e.g. to find a forgotten one).
+// Candidates are derived in parallel using SIMD lanes. Returns an array of NSData seeds in the order of `passwords`,
+// or nil if memory could not be allocated.
++ (NSArray*) seedsForWords:(NSArray*)words passwords:(NSArray*)passwords;
+
 // Clears all sensitive information from memory.
 - (void) clear;
 
@@ -4,6 +4,7 @@
 #import "DMCData.h"
 #import "DMCKeychain.h"
 #import "DMCProtocolSerialization.h"
+#import "DMCPBKDF2.h"
 #include <CommonCrypto/CommonKeyDerivation.h>
 
 @interface DMCMnemonic ()
@@ -182,7 +183,7 @@ static inline NSUInteger DMCMnemonicIntegerFrom11Bits(uint8_t* buf, int bitIndex
 // Lazily-computed seed for BIP32
 - (NSData*) seed {
     if (!_seed) {
-        _seed = [self seedForWords:self.words password:self.password];
+        _seed = [[self class] seedForWords:self.words password:self.password];
     }
     return _seed;
 }
@@ -239,6 +240,53 @@ static inline NSUInteger DMCMnemonicIntegerFrom11Bits(uint8_t* buf, int bitIndex
     return [self.seed isEqual:other.seed];
 }
 
++ (NSArray*) seedsForWords:(NSArray*)words passwords:(NSArray*)passwords {
+    NSData* mnemonic = [[words componentsJoinedByString:@" "] dataUsingEncoding:NSUTF8StringEncoding];
+    NSUInteger count = passwords.count;
+
+    if (count == 0) return @[];
+
+    // CommonCrypto derives a single seed faster than one lane.
+    if (count == 1) return @[ [self seedForWords:words password:passwords[0]] ];
+
+    const NSUInteger seedLength = 64;
+    NSMutableArray* salts = [NSMutableArray arrayWithCapacity:count];
+    const void** mnemonics = malloc(count * sizeof(void*));
+    size_t* mnemonicLengths = malloc(count * sizeof(size_t));
+    const void** saltBytes = malloc(count * sizeof(void*));
+    size_t* saltLengths = malloc(count * sizeof(size_t));
+    NSMutableData* seeds = [NSMutableData dataWithLength:count * seedLength];
+    NSMutableArray* result = nil;
+
+    if (!mnemonics || !mnemonicLengths || !saltBytes || !saltLengths) goto done;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        NSData* salt = [[@"mnemonic" stringByAppendingString:passwords[i]] dataUsingEncoding:NSUTF8StringEncoding];
+        [salts addObject:salt];
+        mnemonics[i] = mnemonic.bytes;
+        mnemonicLengths[i] = mnemonic.length;
+        saltBytes[i] = salt.bytes;
+        saltLengths[i] = salt.length;
+    }
+
+    if (!DMCPBKDF2HMACSHA512Lanes(seeds.mutableBytes, seedLength, mnemonics, mnemonicLengths, saltBytes, saltLengths, count, 2048)) goto done;
+
+    result = [NSMutableArray arrayWithCapacity:count];
+    for (NSUInteger i = 0; i < count; i++) {
+        [result addObject:[seeds subdataWithRange:NSMakeRange(i * seedLength, seedLength)]];
+    }
+
+done:
+    DMCDataClear(seeds);
+    for (NSData* salt in salts) DMCDataClear(salt);
+    free(mnemonics);
+    free(mnemonicLengths);
+    free(saltBytes);
+    free(saltLengths);
+
+    return result;
+}
+
 - (void) dealloc {
     [self clear];
 }
@@ -257,7 +305,7 @@ static inline NSUInteger DMCMnemonicIntegerFrom11Bits(uint8_t* buf, int bitIndex
 #pragma mark - Private Helpers
 
 
-- (NSData*) seedForWords:(NSArray*)words password:(NSString*)password {
++ (NSData*) seedForWords:(NSArray*)words password:(NSString*)password {
     password = password ?: @"";
 
     NSData* mnemonic = [[words componentsJoinedByString:@" "] dataUsingEncoding:NSUTF8StringEncoding];
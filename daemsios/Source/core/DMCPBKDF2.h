@@ -0,0 +1,26 @@
+// 
+
+#import <Foundation/Foundation.h>
+
+// PBKDF2 with HMAC-SHA512 (as used by BIP39 to turn a mnemonic into a seed).
+// Key pads are hashed once per password and every round resumes from the saved states,
+// so a round costs two SHA-512 compressions instead of four.
+
+// Derives `keyLength` bytes of key from the password and salt.
+// Returns NO and zeroes the key if memory could not be allocated.
+// CCKeyDerivationPBKDF is faster for one key; use this one where CommonCrypto is not available.
+BOOL DMCPBKDF2HMACSHA512(unsigned char* key, size_t keyLength,
+                         const void* password, size_t passwordLength,
+                         const void* salt, size_t saltLength,
+                         unsigned rounds);
+
+// Number of passwords derived in parallel on this CPU (one per SIMD lane). Returns 1 if there is no SIMD support.
+NSUInteger DMCPBKDF2HMACSHA512LaneCount(void);
+
+// Derives keys for `count` password and salt pairs at once, several per SIMD lane group.
+// Writes `count` keys of `keyLength` bytes back to back into `keys`.
+// Returns NO and zeroes the keys if memory could not be allocated.
+BOOL DMCPBKDF2HMACSHA512Lanes(unsigned char* keys, size_t keyLength,
+                              const void* const* passwords, const size_t* passwordLengths,
+                              const void* const* salts, const size_t* saltLengths,
+                              size_t count, unsigned rounds);
@@ -0,0 +1,269 @@
+// 
+
+#import "DMCPBKDF2.h"
+#import "DMCData.h"
+#import "DMCSHA512.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__arm64__) || defined(__aarch64__) || defined(__ARM_NEON__))
+#define DMC_PBKDF2_LANES_SIMD 1
+#endif
+
+// Length in bits of an HMAC-SHA512 message that follows the key pad: 128-byte pad and 64-byte digest.
+#define DMCPBKDF2DigestMessageBits ((128 + 64) * 8)
+
+// One SHA-512 compression of `r` with the 16-word block `w` (overwritten by the schedule).
+// V is either uint64_t or a vector of words, one per lane.
+#define DMCPBKDF2Compress(V, r, w) do {                                                                 \
+    V a = r[0], b = r[1], c = r[2], d = r[3], e = r[4], f = r[5], g = r[6], h = r[7], t1, t2;          \
+    for (int i = 0; i < 80; i++) {                                                                      \
+        if (i >= 16) {                                                                                  \
+            w[i & 15] += DMCSHA512S3(w[(i - 2) & 15]) + w[(i - 7) & 15] + DMCSHA512S2(w[(i - 15) & 15]); \
+        }                                                                                               \
+        t1 = h + DMCSHA512S1(e) + DMCSHA512Ch(e, f, g) + DMCSHA512K[i] + w[i & 15];                    \
+        t2 = DMCSHA512S0(a) + DMCSHA512Maj(a, b, c);                                                    \
+        h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;                              \
+    }                                                                                                   \
+    r[0] += a; r[1] += b; r[2] += c; r[3] += d; r[4] += e; r[5] += f; r[6] += g; r[7] += h;            \
+} while (0)
+
+static inline uint64_t DMCPBKDF2ReadBig64(const unsigned char* p) {
+    uint64_t x = 0;
+    for (int i = 0; i < 8; i++) x = (x << 8) | p[i];
+    return x;
+}
+
+static inline void DMCPBKDF2WriteBig64(unsigned char* p, uint64_t x) {
+    for (int i = 7; i >= 0; i--, x >>= 8) p[i] = (unsigned char)x;
+}
+
+static void DMCPBKDF2CompressBytes(uint64_t r[8], const unsigned char* block) {
+    uint64_t w[16];
+    for (int i = 0; i < 16; i++) w[i] = DMCPBKDF2ReadBig64(block + i*8);
+    DMCPBKDF2Compress(uint64_t, r, w);
+    DMCSecureMemset(w, 0, sizeof(w));
+}
+
+// Hashes the rest of a message into `r` that already absorbed `prefixLength` bytes and adds the padding.
+static void DMCPBKDF2Finish(uint64_t r[8], uint64_t prefixLength, const unsigned char* data, size_t length) {
+    uint64_t bits = (prefixLength + length) * 8;
+    unsigned char tail[256];
+
+    for (; length >= 128; data += 128, length -= 128) DMCPBKDF2CompressBytes(r, data);
+
+    size_t tailLength = (length + 17 <= 128) ? 128 : 256;
+    memset(tail, 0, tailLength);
+    memcpy(tail, data, length);
+    tail[length] = 0x80;
+    DMCPBKDF2WriteBig64(tail + tailLength - 8, bits);
+
+    for (size_t i = 0; i < tailLength; i += 128) DMCPBKDF2CompressBytes(r, tail + i);
+    DMCSecureMemset(tail, 0, sizeof(tail));
+}
+
+// Hashes the key pads of HMAC into the inner and outer states.
+static void DMCPBKDF2PrepareKey(uint64_t inner[8], uint64_t outer[8], const unsigned char* password, size_t passwordLength) {
+    unsigned char key[128] = {0};
+    unsigned char pad[128];
+
+    if (passwordLength > 128) {
+        uint64_t r[8];
+        memcpy(r, DMCSHA512IV, sizeof(r));
+        DMCPBKDF2Finish(r, 0, password, passwordLength);
+        for (int i = 0; i < 8; i++) DMCPBKDF2WriteBig64(key + i*8, r[i]);
+        DMCSecureMemset(r, 0, sizeof(r));
+    } else {
+        memcpy(key, password, passwordLength);
+    }
+
+    for (int i = 0; i < 128; i++) pad[i] = key[i] ^ 0x36;
+    memcpy(inner, DMCSHA512IV, sizeof(DMCSHA512IV));
+    DMCPBKDF2CompressBytes(inner, pad);
+
+    for (int i = 0; i < 128; i++) pad[i] = key[i] ^ 0x5c;
+    memcpy(outer, DMCSHA512IV, sizeof(DMCSHA512IV));
+    DMCPBKDF2CompressBytes(outer, pad);
+
+    DMCSecureMemset(key, 0, sizeof(key));
+    DMCSecureMemset(pad, 0, sizeof(pad));
+}
+
+// Fills the block with a 64-byte digest and the padding of an HMAC-SHA512 message.
+#define DMCPBKDF2DigestBlock(w, digest, zero) do {                                                      \
+    for (int j = 0; j < 8; j++) w[j] = digest[j];                                                       \
+    w[8] = zero + 0x8000000000000000ULL;                                                                \
+    for (int j = 9; j < 15; j++) w[j] = zero;                                                           \
+    w[15] = zero + DMCPBKDF2DigestMessageBits;                                                          \
+} while (0)
+
+// U1 = HMAC(password, salt || INT32_BE(blockIndex)). Returns NO if there is no memory for the message.
+static BOOL DMCPBKDF2FirstBlock(uint64_t u[8], const uint64_t inner[8], const uint64_t outer[8],
+                                const unsigned char* salt, size_t saltLength, uint32_t blockIndex) {
+    unsigned char* message = malloc(saltLength + 4);
+    uint64_t r[8], w[16];
+
+    if (!message) return NO;
+
+    if (saltLength > 0) memcpy(message, salt, saltLength);
+    message[saltLength + 0] = (unsigned char)(blockIndex >> 24);
+    message[saltLength + 1] = (unsigned char)(blockIndex >> 16);
+    message[saltLength + 2] = (unsigned char)(blockIndex >> 8);
+    message[saltLength + 3] = (unsigned char)blockIndex;
+
+    memcpy(r, inner, sizeof(r));
+    DMCPBKDF2Finish(r, 128, message, saltLength + 4);
+    DMCPBKDF2DigestBlock(w, r, (uint64_t)0);
+    memcpy(u, outer, sizeof(r));
+    DMCPBKDF2Compress(uint64_t, u, w);
+
+    DMCSecureMemset(message, 0, saltLength + 4);
+    DMCSecureMemset(r, 0, sizeof(r));
+    DMCSecureMemset(w, 0, sizeof(w));
+    free(message);
+    return YES;
+}
+
+// Defines a kernel running rounds 2...n of N passwords at once: each lane of vector type V holds a word of one password.
+// Arguments hold 8 words per lane back to back. On return `t` contains U1 xor U2 xor ... xor Un.
+#define DMCDefinePBKDF2Kernel(name, V, N, attributes)                                                  \
+static attributes void name(uint64_t* t, const uint64_t* inner, const uint64_t* outer, const uint64_t* u1, unsigned rounds) { \
+    V is[8], os[8], u[8], acc[8], s[8], w[16], zero;                                                    \
+    for (int l = 0; l < N; l++) zero[l] = 0;                                                            \
+    for (int j = 0; j < 8; j++) for (int l = 0; l < N; l++) {                                           \
+        is[j][l] = inner[l*8 + j];                                                                      \
+        os[j][l] = outer[l*8 + j];                                                                      \
+        u[j][l] = u1[l*8 + j];                                                                          \
+    }                                                                                                   \
+    for (int j = 0; j < 8; j++) acc[j] = u[j];                                                          \
+    for (unsigned round = 1; round < rounds; round++) {                                                 \
+        DMCPBKDF2DigestBlock(w, u, zero);                                                               \
+        for (int j = 0; j < 8; j++) s[j] = is[j];                                                       \
+        DMCPBKDF2Compress(V, s, w);                                                                     \
+        DMCPBKDF2DigestBlock(w, s, zero);                                                               \
+        for (int j = 0; j < 8; j++) u[j] = os[j];                                                       \
+        DMCPBKDF2Compress(V, u, w);                                                                     \
+        for (int j = 0; j < 8; j++) acc[j] ^= u[j];                                                     \
+    }                                                                                                   \
+    for (int j = 0; j < 8; j++) for (int l = 0; l < N; l++) t[l*8 + j] = acc[j][l];                     \
+    DMCSecureMemset(is, 0, sizeof(is)); DMCSecureMemset(os, 0, sizeof(os));                             \
+    DMCSecureMemset(u, 0, sizeof(u)); DMCSecureMemset(acc, 0, sizeof(acc));                             \
+    DMCSecureMemset(s, 0, sizeof(s)); DMCSecureMemset(w, 0, sizeof(w));                                 \
+}
+
+typedef void (*DMCPBKDF2Kernel)(uint64_t*, const uint64_t*, const uint64_t*, const uint64_t*, unsigned);
+
+typedef uint64_t DMCPBKDF2Lanes1 __attribute__((vector_size(8)));
+DMCDefinePBKDF2Kernel(DMCPBKDF2Kernel1, DMCPBKDF2Lanes1, 1, )
+
+#if DMC_PBKDF2_LANES_SIMD
+typedef uint64_t DMCPBKDF2Lanes2 __attribute__((vector_size(16)));
+DMCDefinePBKDF2Kernel(DMCPBKDF2Kernel2, DMCPBKDF2Lanes2, 2, )
+
+#if defined(__x86_64__)
+typedef uint64_t DMCPBKDF2Lanes4 __attribute__((vector_size(32)));
+DMCDefinePBKDF2Kernel(DMCPBKDF2Kernel4, DMCPBKDF2Lanes4, 4, __attribute__((target("avx2"))))
+#endif
+#endif
+
+static NSUInteger DMCPBKDF2Select(DMCPBKDF2Kernel* kernelOut) {
+#if DMC_PBKDF2_LANES_SIMD
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+        if (kernelOut) *kernelOut = DMCPBKDF2Kernel4;
+        return 4;
+    }
+#endif
+    if (kernelOut) *kernelOut = DMCPBKDF2Kernel2;
+    return 2;
+#else
+    if (kernelOut) *kernelOut = DMCPBKDF2Kernel1;
+    return 1;
+#endif
+}
+
+NSUInteger DMCPBKDF2HMACSHA512LaneCount(void) {
+    return DMCPBKDF2Select(NULL);
+}
+
+static BOOL DMCPBKDF2Derive(unsigned char* keys, size_t keyLength,
+                            const void* const* passwords, const size_t* passwordLengths,
+                            const void* const* salts, const size_t* saltLengths,
+                            size_t count, unsigned rounds, BOOL lanes) {
+    if (count == 0 || keyLength == 0) return YES;
+    if (rounds < 1) rounds = 1;
+
+    DMCPBKDF2Kernel kernel = DMCPBKDF2Kernel1;
+    size_t laneCount = lanes ? DMCPBKDF2Select(&kernel) : 1;
+    size_t wordsLength = count * 8 * sizeof(uint64_t);
+    uint64_t* inner = malloc(wordsLength);
+    uint64_t* outer = malloc(wordsLength);
+    uint64_t* u = malloc(wordsLength);
+    uint64_t* t = malloc(wordsLength);
+    BOOL result = (inner && outer && u && t);
+
+    for (size_t i = 0; result && i < count; i++) {
+        DMCPBKDF2PrepareKey(inner + i*8, outer + i*8, passwords[i], passwordLengths[i]);
+    }
+
+    for (uint32_t block = 0; result && block * 64 < keyLength; block++) {
+        for (size_t i = 0; result && i < count; i++) {
+            result = DMCPBKDF2FirstBlock(u + i*8, inner + i*8, outer + i*8, salts[i], saltLengths[i], block + 1);
+        }
+        if (!result) break;
+
+        size_t i = 0;
+        for (; i + laneCount <= count; i += laneCount) {
+            kernel(t + i*8, inner + i*8, outer + i*8, u + i*8, rounds);
+        }
+
+        // Fill unused lanes with the last password and keep only needed results.
+        if (i < count) {
+            uint64_t tailInner[4*8], tailOuter[4*8], tailU[4*8], tailT[4*8];
+            for (size_t l = 0; l < laneCount; l++) {
+                size_t k = MIN(i + l, count - 1);
+                memcpy(tailInner + l*8, inner + k*8, 64);
+                memcpy(tailOuter + l*8, outer + k*8, 64);
+                memcpy(tailU + l*8, u + k*8, 64);
+            }
+            kernel(tailT, tailInner, tailOuter, tailU, rounds);
+            memcpy(t + i*8, tailT, (count - i)*64);
+            DMCSecureMemset(tailInner, 0, sizeof(tailInner));
+            DMCSecureMemset(tailOuter, 0, sizeof(tailOuter));
+            DMCSecureMemset(tailU, 0, sizeof(tailU));
+            DMCSecureMemset(tailT, 0, sizeof(tailT));
+        }
+
+        size_t length = MIN(64, keyLength - block*64);
+        for (size_t i = 0; i < count; i++) {
+            unsigned char digest[64];
+            for (int j = 0; j < 8; j++) DMCPBKDF2WriteBig64(digest + j*8, t[i*8 + j]);
+            memcpy(keys + i*keyLength + block*64, digest, length);
+            DMCSecureMemset(digest, 0, sizeof(digest));
+        }
+    }
+
+    if (inner) DMCSecureMemset(inner, 0, wordsLength);
+    if (outer) DMCSecureMemset(outer, 0, wordsLength);
+    if (u) DMCSecureMemset(u, 0, wordsLength);
+    if (t) DMCSecureMemset(t, 0, wordsLength);
+    free(inner);
+    free(outer);
+    free(u);
+    free(t);
+
+    if (!result) DMCSecureMemset(keys, 0, count * keyLength);
+    return result;
+}
+
+BOOL DMCPBKDF2HMACSHA512(unsigned char* key, size_t keyLength,
+                         const void* password, size_t passwordLength,
+                         const void* salt, size_t saltLength,
+                         unsigned rounds) {
+    return DMCPBKDF2Derive(key, keyLength, &password, &passwordLength, &salt, &saltLength, 1, rounds, NO);
+}
+
+BOOL DMCPBKDF2HMACSHA512Lanes(unsigned char* keys, size_t keyLength,
+                              const void* const* passwords, const size_t* passwordLengths,
+                              const void* const* salts, const size_t* saltLengths,
+                              size_t count, unsigned rounds) {
+    return DMCPBKDF2Derive(keys, keyLength, passwords, passwordLengths, salts, saltLengths, count, rounds, YES);
+}
@@ -2,6 +2,7 @@
 
 #import "DMCProtocolSerialization+Tests.h"
 #import "DMCData.h"
+#import "DMCByteCursor.h"
 
 @implementation DMCProtocolSerialization (Tests)
 
@@ -15,6 +16,7 @@
     NSUInteger len = [DMCProtocolSerialization readVarInt:&value fromData:data];
     NSAssert(len == requiredLength, @"Should read correct number of bytes");
     NSAssert(value == number, @"Should read original value");
+    NSAssert(DMCVarIntLength(number) == requiredLength, @"Should compute correct length");
     
     NSInputStream* stream = [NSInputStream inputStreamWithData:data];
     [stream open];
@@ -22,6 +24,16 @@
     [stream close];
     NSAssert(len == requiredLength, @"Should read 1 byte");
     NSAssert(value == number, @"Should read original value");
+
+    DMCByteCursor* cursor = [[DMCByteCursor alloc] initWithData:data];
+    value = 0;
+    NSAssert([cursor readVarInt:&value], @"Cursor should read varint");
+    NSAssert(cursor.offset == requiredLength, @"Cursor should move past varint");
+    NSAssert(value == number, @"Cursor should read original value");
+
+    cursor = [[DMCByteCursor alloc] initWithData:[data subdataWithRange:NSMakeRange(0, requiredLength - 1)]];
+    NSAssert(![cursor readVarInt:&value], @"Cursor should not read truncated varint");
+    NSAssert(cursor.offset == 0, @"Cursor should not move after failed read");
 }
 
 + (void) runAllTests {
@@ -2,6 +2,13 @@
 
 #import <Foundation/Foundation.h>
 
+// Returns number of bytes needed to encode the value in varInt format (1, 3, 5 or 9).
+NSUInteger DMCVarIntLength(uint64_t value);
+
+// Writes value in varInt format into a buffer having at least DMCVarIntLength(value) bytes.
+// Returns pointer to the byte following the written value.
+uint8_t* DMCWriteVarInt(uint8_t* bytes, uint64_t value);
+
 // A collection of routines dealing with parsing and writing various protocol messages.
 @interface DMCProtocolSerialization : NSObject
 
@@ -2,6 +2,32 @@
 
 #import "DMCProtocolSerialization.h"
 
+NSUInteger DMCVarIntLength(uint64_t value) {
+    if (value < 0xfd) return 1;
+    if (value <= 0xffff) return 3;
+    if (value <= 0xffffffffUL) return 5;
+    return 9;
+}
+
+uint8_t* DMCWriteVarInt(uint8_t* bytes, uint64_t value) {
+    if (value < 0xfd) {
+        bytes[0] = (uint8_t)value;
+        return bytes + 1;
+    } else if (value <= 0xffff) {
+        bytes[0] = 0xfd;
+        OSWriteLittleInt16(bytes, 1, (uint16_t)value);
+        return bytes + 3;
+    } else if (value <= 0xffffffffUL) {
+        bytes[0] = 0xfe;
+        OSWriteLittleInt32(bytes, 1, (uint32_t)value);
+        return bytes + 5;
+    } else {
+        bytes[0] = 0xff;
+        OSWriteLittleInt64(bytes, 1, value);
+        return bytes + 9;
+    }
+}
+
 @implementation DMCProtocolSerialization
 
 
@@ -106,31 +132,8 @@
 
 + (NSData*) dataForVarInt:(uint64_t)value
 {
-    if (value < 0xfd) {
-        unsigned char size = value;
-        return [NSData dataWithBytes:&size length:sizeof(size)];
-    } else if (value <= 0xffff) {
-        unsigned char size = 0xfd;
-        uint16_t compactValue = CFSwapInt16HostToLittle((uint16_t)value);
-        NSMutableData* data = [NSMutableData dataWithLength:1 + sizeof(compactValue)];
-        [data replaceBytesInRange:NSMakeRange(0, 1) withBytes:&size];
-        [data replaceBytesInRange:NSMakeRange(1, sizeof(compactValue)) withBytes:&compactValue];
-        return data;
-    } else if (value <= 0xffffffffUL) {
-        unsigned char size = 0xfe;
-        uint32_t compactValue = CFSwapInt32HostToLittle((uint32_t)value);
-        NSMutableData* data = [NSMutableData dataWithLength:1 + sizeof(compactValue)];
-        [data replaceBytesInRange:NSMakeRange(0, 1) withBytes:&size];
-        [data replaceBytesInRange:NSMakeRange(1, sizeof(compactValue)) withBytes:&compactValue];
-        return data;
-    } else {
-        unsigned char size = 0xff;
-        uint64_t compactValue = CFSwapInt64HostToLittle(value);
-        NSMutableData* data = [NSMutableData dataWithLength:1 + sizeof(compactValue)];
-        [data replaceBytesInRange:NSMakeRange(0, 1) withBytes:&size];
-        [data replaceBytesInRange:NSMakeRange(1, sizeof(compactValue)) withBytes:&compactValue];
-        return data;
-    }
+    uint8_t bytes[9];
+    return [NSData dataWithBytes:bytes length:DMCWriteVarInt(bytes, value) - bytes];
 }
 
 // Prepends binary string with its length in varInt format.
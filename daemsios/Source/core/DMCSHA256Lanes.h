@@ -0,0 +1,20 @@
+// 
+
+#import <Foundation/Foundation.h>
+
+// Multi-lane SHA-256 hashes several messages of equal length at once,
+// one message per SIMD lane (NEON on ARM, SSE2 or AVX2 on x86-64).
+// Falls back to one-at-a-time hashing where vector registers are not available,
+// and when a hardware hash backend is in use (see DMCHashBackend), which is faster than the lanes.
+// Use it when many short messages are hashed together: block headers, merkle tree levels.
+
+// Number of messages hashed in parallel on this CPU.
+// Returns 1 if there is no SIMD support or a hardware hash backend is in use.
+NSUInteger DMCSHA256LaneCount(void);
+
+// Computes SHA-256 of `count` messages of `length` bytes. Message i starts at `messages + i*stride`.
+// Writes `count` 32-byte digests back to back into `digests`.
+void DMCSHA256Lanes(unsigned char* digests, const unsigned char* messages, size_t length, size_t stride, size_t count);
+
+// Same as DMCSHA256Lanes, but computes double SHA-256 (see DMCHash256).
+void DMCHash256Lanes(unsigned char* digests, const unsigned char* messages, size_t length, size_t stride, size_t count);
@@ -0,0 +1,178 @@
+// 
+
+#import "DMCSHA256Lanes.h"
+#import "DMCHashBackend.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__arm64__) || defined(__aarch64__) || defined(__ARM_NEON__))
+#define DMC_SHA256_LANES_SIMD 1
+#endif
+
+static const uint32_t DMCSHA256LanesK[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t DMCSHA256LanesIV[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static void DMCSHA256LanesScalar(unsigned char* digests, const unsigned char* messages, size_t length, size_t stride, size_t count, BOOL twice) {
+    for (size_t i = 0; i < count; i++) {
+        if (twice) DMCHash256Digest(digests + i*32, messages + i*stride, length);
+        else DMCSHA256Digest(digests + i*32, messages + i*stride, length);
+    }
+}
+
+#if DMC_SHA256_LANES_SIMD
+
+// Returns big-endian word of the padded message at the byte offset.
+static inline uint32_t DMCSHA256LanesWord(const unsigned char* m, size_t length, size_t blocks, size_t offset) {
+    if (offset + 4 <= length) {
+        return ((uint32_t)m[offset] << 24) | ((uint32_t)m[offset + 1] << 16) | ((uint32_t)m[offset + 2] << 8) | m[offset + 3];
+    }
+    size_t total = blocks * 64;
+    uint64_t bits = (uint64_t)length * 8;
+    uint32_t word = 0;
+    for (size_t k = offset; k < offset + 4; k++) {
+        uint8_t byte = 0;
+        if (k < length) byte = m[k];
+        else if (k == length) byte = 0x80;
+        else if (k >= total - 8) byte = (uint8_t)(bits >> (8 * (total - 1 - k)));
+        word = (word << 8) | byte;
+    }
+    return word;
+}
+
+#define DMCLaneRor(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define DMCLaneCh(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
+#define DMCLaneMaj(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define DMCLaneS0(x) (DMCLaneRor((x), 2) ^ DMCLaneRor((x), 13) ^ DMCLaneRor((x), 22))
+#define DMCLaneS1(x) (DMCLaneRor((x), 6) ^ DMCLaneRor((x), 11) ^ DMCLaneRor((x), 25))
+#define DMCLaneS2(x) (DMCLaneRor((x), 7) ^ DMCLaneRor((x), 18) ^ ((x) >> 3))
+#define DMCLaneS3(x) (DMCLaneRor((x), 17) ^ DMCLaneRor((x), 19) ^ ((x) >> 10))
+
+// One compression of all lanes: `r` is the state, `w` is the 16-word block (overwritten by the schedule).
+#define DMCLaneCompress(V, r, w) do {                                                                   \
+    V a = r[0], b = r[1], c = r[2], d = r[3], e = r[4], f = r[5], g = r[6], h = r[7], t1, t2;          \
+    for (int i = 0; i < 64; i++) {                                                                      \
+        if (i >= 16) {                                                                                  \
+            w[i & 15] += DMCLaneS3(w[(i - 2) & 15]) + w[(i - 7) & 15] + DMCLaneS2(w[(i - 15) & 15]);    \
+        }                                                                                               \
+        t1 = h + DMCLaneS1(e) + DMCLaneCh(e, f, g) + DMCSHA256LanesK[i] + w[i & 15];                   \
+        t2 = DMCLaneS0(a) + DMCLaneMaj(a, b, c);                                                        \
+        h = g; g = f; f = e; e = d + t1; d = c; c = b; b = a; a = t1 + t2;                              \
+    }                                                                                                   \
+    r[0] += a; r[1] += b; r[2] += c; r[3] += d; r[4] += e; r[5] += f; r[6] += g; r[7] += h;            \
+} while (0)
+
+// Defines a kernel hashing N messages at once, each lane of vector type V holds a word of one message.
+// The second hash of a double SHA-256 takes the first digest straight from the registers.
+#define DMCDefineLaneKernel(name, V, N, attributes)                                                     \
+static attributes void name(unsigned char* digests, const unsigned char* const* messages, size_t length, BOOL twice) { \
+    V r[8], w[16];                                                                                      \
+    size_t blocks = (length + 8) / 64 + 1;                                                              \
+    for (int j = 0; j < 8; j++) for (int l = 0; l < N; l++) r[j][l] = DMCSHA256LanesIV[j];             \
+    for (size_t block = 0; block < blocks; block++) {                                                   \
+        for (int j = 0; j < 16; j++) for (int l = 0; l < N; l++) {                                      \
+            w[j][l] = DMCSHA256LanesWord(messages[l], length, blocks, block * 64 + j * 4);              \
+        }                                                                                               \
+        DMCLaneCompress(V, r, w);                                                                       \
+    }                                                                                                   \
+    if (twice) {                                                                                        \
+        for (int j = 0; j < 8; j++) w[j] = r[j];                                                        \
+        for (int j = 8; j < 16; j++) for (int l = 0; l < N; l++) w[j][l] = 0;                           \
+        for (int l = 0; l < N; l++) { w[8][l] = 0x80000000; w[15][l] = 256; }                           \
+        for (int j = 0; j < 8; j++) for (int l = 0; l < N; l++) r[j][l] = DMCSHA256LanesIV[j];         \
+        DMCLaneCompress(V, r, w);                                                                       \
+    }                                                                                                   \
+    for (int l = 0; l < N; l++) for (int j = 0; j < 8; j++) {                                           \
+        uint32_t x = r[j][l];                                                                           \
+        unsigned char* p = digests + l * 32 + j * 4;                                                    \
+        p[0] = (unsigned char)(x >> 24); p[1] = (unsigned char)(x >> 16);                               \
+        p[2] = (unsigned char)(x >> 8); p[3] = (unsigned char)x;                                        \
+    }                                                                                                   \
+}
+
+typedef uint32_t DMCLanes4 __attribute__((vector_size(16)));
+DMCDefineLaneKernel(DMCSHA256Kernel4, DMCLanes4, 4, )
+
+#if defined(__x86_64__)
+typedef uint32_t DMCLanes8 __attribute__((vector_size(32)));
+DMCDefineLaneKernel(DMCSHA256Kernel8, DMCLanes8, 8, __attribute__((target("avx2"))))
+#endif
+
+typedef void (*DMCSHA256Kernel)(unsigned char*, const unsigned char* const*, size_t, BOOL);
+
+static NSUInteger DMCSHA256LanesSelect(DMCSHA256Kernel* kernelOut) {
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+        if (kernelOut) *kernelOut = DMCSHA256Kernel8;
+        return 8;
+    }
+#endif
+    if (kernelOut) *kernelOut = DMCSHA256Kernel4;
+    return 4;
+}
+
+#endif
+
+// SHA-NI and ARMv8 instructions hash one message faster than the vector lanes hash several
+// (2000 headers: about 0.5 ms one at a time with SHA-NI, 0.7-0.8 ms in 8 lanes),
+// so the lanes are only used with the portable backend.
+static BOOL DMCSHA256LanesEnabled(void) {
+    return DMCHashBackendCurrentType() == DMCHashBackendPortable;
+}
+
+NSUInteger DMCSHA256LaneCount(void) {
+#if DMC_SHA256_LANES_SIMD
+    if (!DMCSHA256LanesEnabled()) return 1;
+    return DMCSHA256LanesSelect(NULL);
+#else
+    return 1;
+#endif
+}
+
+static void DMCSHA256LanesHash(unsigned char* digests, const unsigned char* messages, size_t length, size_t stride, size_t count, BOOL twice) {
+#if DMC_SHA256_LANES_SIMD
+    if (!DMCSHA256LanesEnabled()) {
+        DMCSHA256LanesScalar(digests, messages, length, stride, count, twice);
+        return;
+    }
+
+    DMCSHA256Kernel kernel = NULL;
+    size_t lanes = DMCSHA256LanesSelect(&kernel);
+    const unsigned char* pointers[8];
+    size_t i = 0;
+
+    for (; i + lanes <= count; i += lanes) {
+        for (size_t l = 0; l < lanes; l++) pointers[l] = messages + (i + l)*stride;
+        kernel(digests + i*32, pointers, length, twice);
+    }
+
+    // Fill unused lanes with the last message and keep only needed digests.
+    if (count - i > 1) {
+        unsigned char tail[8 * 32];
+        for (size_t l = 0; l < lanes; l++) pointers[l] = messages + MIN(i + l, count - 1)*stride;
+        kernel(tail, pointers, length, twice);
+        memcpy(digests + i*32, tail, (count - i)*32);
+        i = count;
+    }
+    DMCSHA256LanesScalar(digests + i*32, messages + i*stride, length, stride, count - i, twice);
+#else
+    DMCSHA256LanesScalar(digests, messages, length, stride, count, twice);
+#endif
+}
+
+void DMCSHA256Lanes(unsigned char* digests, const unsigned char* messages, size_t length, size_t stride, size_t count) {
+    DMCSHA256LanesHash(digests, messages, length, stride, count, NO);
+}
+
+void DMCHash256Lanes(unsigned char* digests, const unsigned char* messages, size_t length, size_t stride, size_t count) {
+    DMCSHA256LanesHash(digests, messages, length, stride, count, YES);
+}
@@ -0,0 +1,21 @@
+// 
+
+#import <Foundation/Foundation.h>
+
+// SHA-512 constants and round functions shared by SHA512Compress in NSData+DaemsCoin
+// and the multi-lane compression of DMCPBKDF2. Private, not imported by DaemsCoin.h.
+// Round functions are macros, so they work both on words and on vectors of words.
+
+// Round constants.
+extern const uint64_t DMCSHA512K[80];
+
+// Initial hash value.
+extern const uint64_t DMCSHA512IV[8];
+
+#define DMCSHA512Ror(x, n) (((x) >> (n)) | ((x) << (64 - (n))))
+#define DMCSHA512Ch(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
+#define DMCSHA512Maj(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define DMCSHA512S0(x) (DMCSHA512Ror((x), 28) ^ DMCSHA512Ror((x), 34) ^ DMCSHA512Ror((x), 39))
+#define DMCSHA512S1(x) (DMCSHA512Ror((x), 14) ^ DMCSHA512Ror((x), 18) ^ DMCSHA512Ror((x), 41))
+#define DMCSHA512S2(x) (DMCSHA512Ror((x), 1) ^ DMCSHA512Ror((x), 8) ^ ((x) >> 7))
+#define DMCSHA512S3(x) (DMCSHA512Ror((x), 19) ^ DMCSHA512Ror((x), 61) ^ ((x) >> 6))
@@ -63,6 +63,11 @@ typedef NS_ENUM(NSInteger, DMCScriptSimulationOptions) {
 // Binary representation
 @property(nonatomic, readonly) NSData* data;
 
+// Number of in-place edits made to this script (the modification methods below).
+// Scripts can be shared, so they don't know their owners; an owner caching serialized scripts
+// compares this number to skip checking the script when it wasn't edited since.
+@property(nonatomic, readonly) uint64_t editCount;
+
 // Hex representation
 @property(nonatomic, readonly) NSString* hex;
 
@@ -709,6 +709,7 @@
 
 
 - (void) invalidateSerialization {
+    _editCount++;
     _data = nil;
     _string = nil;
     _multisigSignaturesRequired = 0;
@@ -782,28 +783,44 @@
     if (data.length == 0) return self;
     
     NSMutableData* md = [NSMutableData data];
+    BOOL deleted = NO;
     
     for (DMCScriptChunk* chunk in _chunks) {
         if (![chunk.pushdata isEqual:data]) {
             [md appendData:chunk.chunkData];
+        } else {
+            deleted = YES;
         }
     }
     
+    // Keep the original data (and caches depending on it) if nothing was deleted.
+    if (!deleted) return self;
+    
     _chunks = [self parseData:md];
+    [self invalidateSerialization];
+    _data = md;
 
     return self;
 }
 
 - (DMCScript*) deleteOccurrencesOfOpcode:(DMCOpcode)opcode {
     NSMutableData* md = [NSMutableData data];
+    BOOL deleted = NO;
     
     for (DMCScriptChunk* chunk in _chunks) {
         if (chunk.opcode != opcode) {
             [md appendData:chunk.chunkData];
+        } else {
+            deleted = YES;
         }
     }
     
+    // Keep the original data (and caches depending on it) if nothing was deleted.
+    if (!deleted) return self;
+    
     _chunks = [self parseData:md];
+    [self invalidateSerialization];
+    _data = md;
 
     return self;
 }
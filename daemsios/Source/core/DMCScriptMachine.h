@@ -9,6 +9,7 @@ typedef NS_ENUM(NSUInteger, DMCScriptVerification) {
 
 @class DMCScript;
 @class DMCTransaction;
+@class DMCSignatureHasher;
 
 // ScriptMachine is a stack machine (like Forth) that evaluates a predicate
 // returning a bool indicating valid or not. There are no loops.
@@ -23,6 +24,11 @@ typedef NS_ENUM(NSUInteger, DMCScriptVerification) {
 // Required parameter.
 @property(nonatomic) uint32_t inputIndex;
 
+// Signature hasher used by signature checks. Optional parameter.
+// Set the same hasher on machines verifying different inputs of one transaction to serialize it only once.
+// If nil or made for another transaction, a new one is created on the first signature check.
+@property(nonatomic) DMCSignatureHasher* signatureHasher;
+
 // Overrides inputScript from transaction.inputs[inputIndex].
 // Useful for testing, but useless if you need to test CHECKSIG operations. In latter case you still need a full transaction.
 @property(nonatomic) DMCScript* inputScript;
@@ -11,6 +11,7 @@
 #import "DMCErrors.h"
 #import "DMCUnitsAndLimits.h"
 #import "DMCData.h"
+#import "DMCSignatureHasher.h"
 
 @interface DMCScriptMachine ()
 
@@ -102,6 +103,7 @@
     DMCScriptMachine* sm = [[DMCScriptMachine alloc] init];
     sm.transaction = self.transaction;
     sm.inputIndex = self.inputIndex;
+    sm.signatureHasher = self.signatureHasher;
     sm.blockTimestamp = self.blockTimestamp;
     sm.verificationFlags = self.verificationFlags;
     sm->_stack = [_stack mutableCopy];
@@ -1094,7 +1096,16 @@
     // Strip that last byte to have a pure signature.
     signature = [signature subdataWithRange:NSMakeRange(0, signature.length - 1)];
     
-    NSData* sighash = [_transaction signatureHashForScript:subscript inputIndex:_inputIndex hashType:hashType error:errorOut];
+    if (!_signatureHasher || _signatureHasher.transaction != _transaction) {
+        _signatureHasher = [[DMCSignatureHasher alloc] initWithTransaction:_transaction];
+    }
+    
+    if (!_signatureHasher) {
+        if (errorOut) *errorOut = [self scriptError:NSLocalizedString(@"Transaction and valid input index must be provided for signature verification.", @"")];
+        return NO;
+    }
+    
+    NSData* sighash = [_signatureHasher signatureHashForScript:subscript inputIndex:_inputIndex hashType:hashType error:errorOut];
     
     //NSLog(@"DMCScriptMachine: Hash for input %d [%d]: %@", _inputIndex, hashType, DMCHexFromData(sighash));
     
@@ -0,0 +1,29 @@
+// 
+
+#import <Foundation/Foundation.h>
+#import "DMCSignatureHashType.h"
+
+@class DMCScript;
+@class DMCTransaction;
+
+// Signature hasher computes hashes for signing transaction inputs without copying and re-serializing
+// the whole transaction for every input.
+// Parts of the transaction that do not depend on the input being signed (version, blanked inputs,
+// outputs and lock time) are serialized once per hasher and hash type. For each input only
+// its substituted script is streamed into SHA-256 between these segments.
+//
+// Hasher takes a snapshot of the transaction on the first use. Signature scripts of the inputs
+// do not affect the hash (they are blanked), so you may sign inputs one by one using the same hasher.
+// If you change version, lock time, outpoints, sequences or outputs, create a new hasher.
+@interface DMCSignatureHasher : NSObject
+
+// Transaction being hashed.
+@property(nonatomic, readonly) DMCTransaction* transaction;
+
+- (id) initWithTransaction:(DMCTransaction*)tx;
+
+// Hash for signing a transaction input.
+// Same as -[DMCTransaction signatureHashForScript:inputIndex:hashType:error:].
+- (NSData*) signatureHashForScript:(DMCScript*)subscript inputIndex:(uint32_t)inputIndex hashType:(DMCSignatureHashType)hashType error:(NSError**)errorOut;
+
+@end
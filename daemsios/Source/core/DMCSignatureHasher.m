@@ -0,0 +1,229 @@
+// 
+
+#import "DMCSignatureHasher.h"
+#import "DMCTransaction.h"
+#import "DMCTransactionInput.h"
+#import "DMCTransactionOutput.h"
+#import "DMCScript.h"
+#import "DMCErrors.h"
+#import "DMCProtocolSerialization.h"
+#import "DMCHashBackend.h"
+#import <CommonCrypto/CommonCrypto.h>
+
+// Blank input is serialized as: previous hash, previous index, empty script (varint 0), sequence.
+// Blank output is value -1 and empty script (see -[DMCTransactionOutput init]).
+static const unsigned char DMCSignatureHasherBlankOutput[9] = {0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff,0x00};
+
+static inline void DMCSignatureHasherUpdateVarInt(DMCSHA256Context* ctx, uint64_t value) {
+    uint8_t buf[9];
+    DMCSHA256Update(ctx, buf, DMCWriteVarInt(buf, value) - buf);
+}
+
+static inline void DMCSignatureHasherUpdateUInt32(DMCSHA256Context* ctx, uint32_t value) {
+    uint32_t le = OSSwapHostToLittleInt32(value);
+    DMCSHA256Update(ctx, &le, sizeof(le));
+}
+
+@implementation DMCSignatureHasher {
+    BOOL _prepared;
+
+    uint32_t _version;
+    uint32_t _lockTime;
+
+    // Blank inputs serialized back to back and offsets of each one (inputsCount + 1 entries).
+    NSUInteger _inputsCount;
+    NSMutableData* _blankInputs;
+    NSUInteger* _inputOffsets;
+
+    // Same as _blankInputs, but with zero sequences (for SIGHASH_NONE and SIGHASH_SINGLE). Built lazily.
+    NSMutableData* _blankInputsZeroSequence;
+
+    // Coinbase inputs are serialized with their (uncopied) coinbase data instead of a script.
+    NSIndexSet* _coinbaseIndexes;
+
+    // Serialized outputs and offsets of each one (outputsCount + 1 entries).
+    NSUInteger _outputsCount;
+    NSMutableData* _outputs;
+    NSUInteger* _outputOffsets;
+}
+
+- (id) initWithTransaction:(DMCTransaction*)tx {
+    if (!tx) return nil;
+    if (self = [super init]) {
+        _transaction = tx;
+    }
+    return self;
+}
+
+- (void) dealloc {
+    free(_inputOffsets);
+    free(_outputOffsets);
+}
+
+// Serializes segments of the transaction that are shared between all inputs.
+- (void) prepare {
+    if (_prepared) return;
+    _prepared = YES;
+
+    _version = _transaction.version;
+    _lockTime = _transaction.lockTime;
+
+    NSArray* inputs = _transaction.inputs;
+    _inputsCount = inputs.count;
+    _inputOffsets = calloc(_inputsCount + 1, sizeof(NSUInteger));
+    _blankInputs = [NSMutableData dataWithCapacity:_inputsCount * 41];
+    NSMutableIndexSet* coinbaseIndexes = [NSMutableIndexSet indexSet];
+
+    NSUInteger i = 0;
+    for (DMCTransactionInput* txin in inputs) {
+        _inputOffsets[i] = _blankInputs.length;
+        uint32_t prevIndex = OSSwapHostToLittleInt32(txin.previousIndex);
+        uint8_t emptyScript = 0;
+        uint32_t sequence = OSSwapHostToLittleInt32(txin.sequence);
+        [_blankInputs appendData:txin.previousHash];
+        [_blankInputs appendBytes:&prevIndex length:sizeof(prevIndex)];
+        [_blankInputs appendBytes:&emptyScript length:sizeof(emptyScript)];
+        [_blankInputs appendBytes:&sequence length:sizeof(sequence)];
+        if (txin.isCoinbase) [coinbaseIndexes addIndex:i];
+        i++;
+    }
+    _inputOffsets[_inputsCount] = _blankInputs.length;
+    _coinbaseIndexes = coinbaseIndexes;
+
+    NSArray* outputs = _transaction.outputs;
+    _outputsCount = outputs.count;
+    _outputOffsets = calloc(_outputsCount + 1, sizeof(NSUInteger));
+    _outputs = [NSMutableData data];
+
+    i = 0;
+    for (DMCTransactionOutput* txout in outputs) {
+        _outputOffsets[i] = _outputs.length;
+        [_outputs appendData:txout.data];
+        i++;
+    }
+    _outputOffsets[_outputsCount] = _outputs.length;
+}
+
+- (NSData*) blankInputsZeroSequence {
+    if (!_blankInputsZeroSequence) {
+        _blankInputsZeroSequence = [_blankInputs mutableCopy];
+        unsigned char* bytes = _blankInputsZeroSequence.mutableBytes;
+        for (NSUInteger i = 0; i < _inputsCount; i++) {
+            memset(bytes + _inputOffsets[i + 1] - 4, 0, 4);
+        }
+    }
+    return _blankInputsZeroSequence;
+}
+
+- (NSError*) scriptError:(NSString*)localizedString {
+    return [NSError errorWithDomain:DMCErrorDomain
+                               code:DMCErrorScriptError
+                           userInfo:@{NSLocalizedDescriptionKey: localizedString}];
+}
+
+// Hashes input at the index with its script substituted by a subscript.
+// Outpoint and sequence are always taken from the original input.
+- (void) updateContext:(DMCSHA256Context*)ctx withInputAtIndex:(NSUInteger)index scriptData:(NSData*)scriptData {
+    const unsigned char* record = (const unsigned char*)_blankInputs.bytes + _inputOffsets[index];
+    NSUInteger recordLength = _inputOffsets[index + 1] - _inputOffsets[index];
+
+    // Outpoint (everything up to the empty script and sequence).
+    DMCSHA256Update(ctx, record, recordLength - 5);
+
+    // Coinbase inputs are serialized with coinbase data that is not carried over by -[DMCTransactionInput copy].
+    if ([_coinbaseIndexes containsIndex:index]) scriptData = nil;
+
+    DMCSignatureHasherUpdateVarInt(ctx, scriptData.length);
+    if (scriptData.length > 0) DMCSHA256Update(ctx, scriptData.bytes, scriptData.length);
+
+    // Original sequence.
+    DMCSHA256Update(ctx, record + recordLength - 4, 4);
+}
+
+- (NSData*) signatureHashForScript:(DMCScript*)subscript inputIndex:(uint32_t)inputIndex hashType:(DMCSignatureHashType)hashType error:(NSError**)errorOut {
+    // We may have a scriptmachine instantiated without a transaction (for testing),
+    // but it should not use signature checks then.
+    if (inputIndex == 0xFFFFFFFF) {
+        if (errorOut) *errorOut = [self scriptError:NSLocalizedString(@"Transaction and valid input index must be provided for signature verification.", @"")];
+        return nil;
+    }
+
+    [self prepare];
+
+    // Note: BitcoinQT returns a 256-bit little-endian number 1 in such case, but it does not matter
+    // because it would crash before that in CScriptCheck::operator()(). We normally won't enter this condition
+    // if script machine is instantiated with initWithTransaction:inputIndex:, but if it was just -init-ed, it's better to check.
+    if (inputIndex >= _inputsCount) {
+        if (errorOut) *errorOut = [self scriptError:[NSString stringWithFormat:
+                                                     NSLocalizedString(@"Input index is out of bounds for transaction: %d >= %d.", @""),
+                                                     (int)inputIndex, (int)_inputsCount]];
+        return nil;
+    }
+
+    // In case concatenating two scripts ends up with two codeseparators,
+    // or an extra one at the end, this prevents all those possible incompatibilities.
+    // Also: we modify the same subscript which is used several times for multisig check, but that's what BitcoinQT does as well.
+    [subscript deleteOccurrencesOfOpcode:OP_CODESEPARATOR];
+
+    DMCSignatureHashType outputMode = (hashType & SIGHASH_OUTPUT_MASK);
+
+    // If outputIndex is out of bounds, BitcoinQT is returning a 256-bit little-endian 0x01 instead of failing with error.
+    // We should do the same to stay compatible.
+    if (outputMode == SIGHASH_SINGLE && inputIndex >= _outputsCount) {
+        static unsigned char littleEndianOne[32] = {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+        return [NSData dataWithBytes:littleEndianOne length:32];
+    }
+
+    NSData* scriptData = subscript.data;
+
+    DMCSHA256Context ctx;
+    DMCSHA256Init(&ctx);
+
+    DMCSignatureHasherUpdateUInt32(&ctx, _version);
+
+    if (hashType & SIGHASH_ANYONECANPAY) {
+        // Other inputs are removed completely.
+        DMCSignatureHasherUpdateVarInt(&ctx, 1);
+        [self updateContext:&ctx withInputAtIndex:inputIndex scriptData:scriptData];
+    } else {
+        // Others' sequence numbers are blanked out in NONE and SINGLE modes to let others update transaction at will.
+        NSData* blankInputs = (outputMode == SIGHASH_NONE || outputMode == SIGHASH_SINGLE) ? [self blankInputsZeroSequence] : _blankInputs;
+        const unsigned char* bytes = blankInputs.bytes;
+
+        DMCSignatureHasherUpdateVarInt(&ctx, _inputsCount);
+        DMCSHA256Update(&ctx, bytes, _inputOffsets[inputIndex]);
+        [self updateContext:&ctx withInputAtIndex:inputIndex scriptData:scriptData];
+        DMCSHA256Update(&ctx, bytes + _inputOffsets[inputIndex + 1], _inputOffsets[_inputsCount] - _inputOffsets[inputIndex + 1]);
+    }
+
+    if (outputMode == SIGHASH_NONE) {
+        // Wildcard payee - we can pay anywhere.
+        DMCSignatureHasherUpdateVarInt(&ctx, 0);
+    } else if (outputMode == SIGHASH_SINGLE) {
+        // Outputs before the one we need are blanked out. All outputs after are simply removed.
+        DMCSignatureHasherUpdateVarInt(&ctx, inputIndex + 1);
+        for (uint32_t i = 0; i < inputIndex; i++) {
+            DMCSHA256Update(&ctx, DMCSignatureHasherBlankOutput, sizeof(DMCSignatureHasherBlankOutput));
+        }
+        DMCSHA256Update(&ctx, (const unsigned char*)_outputs.bytes + _outputOffsets[inputIndex],
+                        _outputOffsets[inputIndex + 1] - _outputOffsets[inputIndex]);
+    } else {
+        // Default is SIGHASH_ALL - all inputs and outputs are signed.
+        DMCSignatureHasherUpdateVarInt(&ctx, _outputsCount);
+        DMCSHA256Update(&ctx, _outputs.bytes, _outputs.length);
+    }
+
+    DMCSignatureHasherUpdateUInt32(&ctx, _lockTime);
+
+    // Important: we have to hash transaction together with its hash type.
+    // Hash type is appended as little endian uint32 unlike 1-byte suffix of the signature.
+    DMCSignatureHasherUpdateUInt32(&ctx, (uint32_t)hashType);
+
+    unsigned char digest1[CC_SHA256_DIGEST_LENGTH];
+    unsigned char digest2[CC_SHA256_DIGEST_LENGTH];
+    DMCSHA256Final(&ctx, digest1);
+    DMCSHA256Digest(digest2, digest1, CC_SHA256_DIGEST_LENGTH);
+    return [NSData dataWithBytes:digest2 length:CC_SHA256_DIGEST_LENGTH];
+}
+
+@end
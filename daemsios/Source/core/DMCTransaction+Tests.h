@@ -13,5 +13,6 @@
 @interface DMCTransaction (Tests)
 
 + (void) runAllTests;
++ (void) runAllBenchmarks;
 
 @end
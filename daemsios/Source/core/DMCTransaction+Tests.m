@@ -16,6 +16,11 @@
 #import "DMCScriptMachine.h"
 #import "DMCAddress.h"
 #import "DMCChainCom.h"
+#import "DMCSignatureHasher.h"
+#import "DMCByteCursor.h"
+#import "DMCBlock.h"
+#import "DMCBlockHeader.h"
+#import "DMCProtocolSerialization.h"
 
 typedef enum : NSUInteger {
     DMCAPIChain,
@@ -27,11 +32,432 @@ typedef enum : NSUInteger {
 + (void) runAllTests {
     [self testSerialization];
     [self testFees];
+    [self testSerializationCache];
+    [self testCursorParsing];
+    [self testKnownHash];
+    [self testLazyParsing];
+    [self testSignatureHasher];
     [self testSpendCoins:DMCAPIChain];
     [self testSpendCoins:DMCAPIBlockchain];
 }
 
 
++ (void) runAllBenchmarks {
+    [self benchmarkSignatureHash];
+    [self benchmarkParsing];
+    [self benchmarkLazyParsing];
+}
+
+
++ (void) testSerializationCache {
+    NSData* txdata = DMCDataFromHex(@"010000000150869eb405cdd81ac4a1ccfa74f256a176f3139dece7e36e038c8b38cdfee6a4020000001976a914f1ca8440982d7bd086f64b3bf6dbb1244f5dbc4c88acffffffff03a0860100000000001976a9149c7bce1f45e6743fa1fde9e507f768cb3de3fbd988aca0860100000000001976a91424b70bbd9f4c75e9a6f7f30abf183d15d3bab87188acf035a601000000001976a914f1ca8440982d7bd086f64b3bf6dbb1244f5dbc4c88ac00000000");
+    DMCTransaction* tx = [[DMCTransaction alloc] initWithData:txdata];
+
+    NSAssert([tx.data isEqual:txdata], @"Should serialize back to the same bytes");
+    NSAssert(tx.data == tx.data, @"Payload should be cached");
+    NSAssert(tx.transactionID == tx.transactionID, @"Transaction ID should be cached");
+
+    NSData* cached = tx.data;
+    [[[DMCScript alloc] init] appendOpcode:OP_NOP];
+    NSAssert(tx.data == cached, @"Editing another script should keep the payload");
+
+    DMCTransactionInput* txin = tx.inputs[0];
+    DMCTransactionOutput* txout = tx.outputs[0];
+    NSAssert(txin.data.length == txin.dataLength, @"Input length should match its data");
+    NSAssert(txout.data.length == txout.dataLength, @"Output length should match its data");
+
+    NSString* txid = tx.transactionID;
+
+    txin.sequence = 0;
+    NSAssert(![tx.transactionID isEqual:txid], @"Changing input sequence should change txid");
+    txin.sequence = 0xFFFFFFFF;
+    NSAssert([tx.transactionID isEqual:txid], @"Restoring input sequence should restore txid");
+
+    [txout.script appendOpcode:OP_NOP];
+    NSAssert(![tx.transactionID isEqual:txid], @"Editing output script in place should change txid");
+    NSAssert(txout.data.length == txout.dataLength, @"Output data should be updated after script edit");
+    txout.script = [[DMCScript alloc] initWithData:[txout.script.data subdataWithRange:NSMakeRange(0, txout.script.data.length - 1)]];
+    NSAssert([tx.transactionID isEqual:txid], @"Restoring output script should restore txid");
+
+    txout.value += 1;
+    NSAssert(![tx.transactionID isEqual:txid], @"Changing output value should change txid");
+    txout.value -= 1;
+
+    [tx addOutput:[[DMCTransactionOutput alloc] initWithValue:1]];
+    NSAssert(![tx.transactionID isEqual:txid], @"Adding an output should change txid");
+    tx.outputs = [tx.outputs subarrayWithRange:NSMakeRange(0, 3)];
+    NSAssert([tx.transactionID isEqual:txid], @"Replacing outputs should restore txid");
+
+    tx.inputs = @[];
+    NSAssert(![tx.transactionID isEqual:txid], @"Replacing inputs should change txid");
+    tx.inputs = @[ txin ];
+    NSAssert([tx.transactionID isEqual:txid], @"Restoring inputs should restore txid");
+
+    tx.lockTime = 1;
+    NSAssert(![tx.data isEqual:txdata], @"Changing lock time should change payload");
+
+    DMCTransaction* tx2 = [tx copy];
+    ((DMCTransactionInput*)tx2.inputs[0]).previousIndex = 0;
+    NSAssert(![tx2.transactionHash isEqual:tx.transactionHash], @"Copy should track changes of its own inputs");
+}
+
++ (void) testCursorParsing {
+    NSData* txdata = DMCDataFromHex(@"010000000150869eb405cdd81ac4a1ccfa74f256a176f3139dece7e36e038c8b38cdfee6a4020000001976a914f1ca8440982d7bd086f64b3bf6dbb1244f5dbc4c88acffffffff03a0860100000000001976a9149c7bce1f45e6743fa1fde9e507f768cb3de3fbd988aca0860100000000001976a91424b70bbd9f4c75e9a6f7f30abf183d15d3bab87188acf035a601000000001976a914f1ca8440982d7bd086f64b3bf6dbb1244f5dbc4c88ac00000000");
+
+    // Two transactions back to back followed by a truncated one.
+    NSMutableData* batch = [NSMutableData data];
+    [batch appendData:txdata];
+    [batch appendData:txdata];
+    [batch appendData:[txdata subdataWithRange:NSMakeRange(0, txdata.length - 1)]];
+
+    DMCByteCursor* cursor = [[DMCByteCursor alloc] initWithData:batch];
+    DMCTransaction* tx1 = [[DMCTransaction alloc] initWithCursor:cursor];
+    NSAssert(cursor.offset == txdata.length, @"Cursor should move past the first transaction");
+    DMCTransaction* tx2 = [[DMCTransaction alloc] initWithCursor:cursor];
+    NSAssert(cursor.offset == 2 * txdata.length, @"Cursor should move past the second transaction");
+    NSAssert([tx1.data isEqual:txdata] && [tx2.data isEqual:txdata], @"Should parse both transactions");
+    NSAssert([tx1.transactionID isEqual:[[DMCTransaction alloc] initWithData:txdata].transactionID], @"Should have the same txid");
+
+    NSAssert(![[DMCTransaction alloc] initWithCursor:cursor], @"Should not parse truncated transaction");
+    NSAssert(cursor.offset == 2 * txdata.length, @"Cursor should stay in place after a failure");
+
+    // Parsed fields are slices of the batch buffer.
+    const uint8_t* begin = cursor.data.bytes;
+    const uint8_t* end = begin + cursor.data.length;
+    DMCTransactionInput* txin = tx2.inputs[0];
+    DMCTransactionOutput* txout = tx2.outputs[2];
+    NSAssert((const uint8_t*)txin.previousHash.bytes >= begin && (const uint8_t*)txin.previousHash.bytes < end, @"Hash should not be copied");
+    NSAssert((const uint8_t*)txout.script.data.bytes >= begin && (const uint8_t*)txout.script.data.bytes < end, @"Script should not be copied");
+    NSAssert((const uint8_t*)tx2.data.bytes == begin + txdata.length, @"Payload should not be copied");
+
+    // Slices stay valid when the original mutable buffer changes.
+    NSData* hash = txin.previousHash;
+    NSData* hashCopy = [hash copy];
+    memset(batch.mutableBytes, 0, batch.length);
+    NSAssert([txin.previousHash isEqual:hashCopy] && [tx2.data isEqual:txdata], @"Slices should not depend on the mutable source");
+
+    // Editing a parsed transaction drops the parsed payload.
+    txout.value += 1;
+    NSAssert(![tx2.data isEqual:txdata], @"Payload should be recomputed after a change");
+
+    // Block with a header and transactions.
+    DMCBlock* block = [[DMCBlock alloc] init];
+    block.header.previousBlockHash = DMCSHA256(DMCDataWithUTF8CString("previous block"));
+    block.header.time = 1400000000;
+    block.header.difficultyTarget = 0x1d00ffff;
+    block.header.nonce = 42;
+    block.transactions = @[ [[DMCTransaction alloc] initWithData:txdata], [self transactionWithInputsCount:3 outputsCount:2] ];
+    [block updateMerkleTree];
+
+    NSData* blockData = block.data;
+    DMCBlock* block2 = [[DMCBlock alloc] initWithData:blockData];
+    NSAssert(block2.transactions.count == 2, @"Should parse all transactions");
+    NSAssert([block2.blockHash isEqual:block.blockHash], @"Should parse the same header");
+    NSAssert(block2.header.nonce == 42 && block2.header.time == 1400000000, @"Should parse header fields");
+    NSAssert([block2.data isEqual:blockData], @"Should serialize back to the same bytes");
+    NSAssert([[block2 computeMerkleRootHash] isEqual:block2.header.merkleRootHash], @"Merkle root should match parsed transactions");
+
+    NSAssert(![[DMCBlock alloc] initWithData:[blockData subdataWithRange:NSMakeRange(0, blockData.length - 1)]], @"Should not parse truncated block");
+    NSAssert(![[DMCBlockHeader alloc] initWithData:[blockData subdataWithRange:NSMakeRange(0, 79)]], @"Should not parse truncated header");
+
+    DMCBlockHeader* header2 = [block2.header copy];
+    header2.nonce = 43;
+    NSArray* hashes = [DMCBlockHeader blockHashesForHeaders:@[ block.header, header2, block2.header ]];
+    NSAssert([hashes[0] isEqual:block.blockHash] && [hashes[1] isEqual:header2.blockHash] && [hashes[2] isEqual:block2.blockHash], @"Batched header hashes should match");
+}
+
++ (void) testKnownHash {
+    NSData* txdata = DMCDataFromHex(@"010000000150869eb405cdd81ac4a1ccfa74f256a176f3139dece7e36e038c8b38cdfee6a4020000001976a914f1ca8440982d7bd086f64b3bf6dbb1244f5dbc4c88acffffffff03a0860100000000001976a9149c7bce1f45e6743fa1fde9e507f768cb3de3fbd988aca0860100000000001976a91424b70bbd9f4c75e9a6f7f30abf183d15d3bab87188acf035a601000000001976a914f1ca8440982d7bd086f64b3bf6dbb1244f5dbc4c88ac00000000");
+    NSData* hash = DMCHash256(txdata);
+    DMCTransaction* tx = [[DMCTransaction alloc] initWithData:txdata transactionHash:hash];
+
+    NSAssert([tx.transactionHash isEqual:hash], @"Should use the known hash");
+    NSAssert([tx.transactionID isEqual:[[DMCTransaction alloc] initWithData:txdata].transactionID], @"Should have the same txid");
+
+    tx.lockTime = 1;
+    NSAssert(![tx.transactionHash isEqual:hash], @"Changing the transaction should drop the known hash");
+
+    // Hash of a buffer with trailing bytes is not the txid.
+    NSMutableData* padded = [txdata mutableCopy];
+    [padded appendBytes:"\x00\x01" length:2];
+    DMCTransaction* tx2 = [[DMCTransaction alloc] initWithData:padded transactionHash:DMCHash256(padded)];
+    NSAssert(tx2, @"Should parse the transaction before trailing bytes");
+    NSAssert([tx2.transactionHash isEqual:hash], @"Should hash only the transaction bytes");
+    NSAssert([tx2.data isEqual:txdata], @"Payload should not include trailing bytes");
+}
+
++ (void) testLazyParsing {
+    DMCTransaction* reference = [self transactionWithInputsCount:3 outputsCount:2];
+    NSData* txdata = reference.data;
+
+    DMCTransaction* tx = [[DMCTransaction alloc] initLazilyWithData:txdata];
+    NSAssert(tx.isLazy, @"Should not decode inputs and outputs");
+    NSAssert(tx.inputsCount == 3 && tx.outputsCount == 2, @"Should count inputs and outputs");
+    NSAssert([tx.transactionID isEqual:reference.transactionID], @"Should compute txid from the original bytes");
+    NSAssert(tx.version == reference.version && tx.lockTime == reference.lockTime, @"Should read version and lock time");
+    NSAssert(!tx.isCoinbase, @"Should not be coinbase");
+
+    for (NSUInteger i = 0; i < 3; i++) {
+        uint8_t hash[32];
+        uint32_t index = 0;
+        [tx getPreviousHash:hash index:&index ofInputAtIndex:i];
+        DMCTransactionInput* txin = reference.inputs[i];
+        NSAssert([[NSData dataWithBytes:hash length:32] isEqual:txin.previousHash], @"Should read previous hash");
+        NSAssert(index == txin.previousIndex, @"Should read previous index");
+    }
+    for (NSUInteger i = 0; i < 2; i++) {
+        NSUInteger length = 0;
+        const uint8_t* bytes = [tx scriptBytesOfOutputAtIndex:i length:&length];
+        DMCTransactionOutput* txout = reference.outputs[i];
+        NSAssert([[NSData dataWithBytes:bytes length:length] isEqual:txout.script.data], @"Should read output script");
+        NSAssert([tx valueOfOutputAtIndex:i] == txout.value, @"Should read output value");
+    }
+    NSAssert(tx.isLazy, @"Accessors should not decode inputs and outputs");
+
+    NSAssert(tx.inputs.count == 3 && tx.outputs.count == 2, @"Should decode inputs and outputs on access");
+    NSAssert(!tx.isLazy, @"Should not be lazy after decoding");
+    NSAssert([tx.data isEqual:txdata] && [tx.transactionID isEqual:reference.transactionID], @"Decoding should not change the payload");
+
+    // Any change decodes the transaction first.
+    DMCTransaction* tx2 = [[DMCTransaction alloc] initLazilyWithData:txdata];
+    tx2.lockTime = 0;
+    NSAssert(!tx2.isLazy && tx2.inputs.count == 3, @"Changing lazy tx should decode it");
+    tx2.lockTime = reference.lockTime;
+    NSAssert([tx2.data isEqual:txdata], @"Should serialize decoded objects back to the same bytes");
+
+    NSAssert(![[DMCTransaction alloc] initLazilyWithData:[txdata subdataWithRange:NSMakeRange(0, txdata.length - 1)]], @"Should not parse truncated transaction");
+    NSAssert(![[DMCTransaction alloc] initLazilyWithData:[NSData data]], @"Should not parse empty data");
+
+    DMCTransactionInput* coinbaseInput = [[DMCTransactionInput alloc] init];
+    coinbaseInput.coinbaseData = DMCDataWithUTF8CString("coinbase");
+    DMCTransaction* coinbase = [[DMCTransaction alloc] init];
+    [coinbase addInput:coinbaseInput];
+    [coinbase addOutput:[[DMCTransactionOutput alloc] initWithValue:50]];
+    NSAssert([[DMCTransaction alloc] initLazilyWithData:coinbase.data].isCoinbase, @"Should detect coinbase");
+}
+
+// Parses `data` the way it was done before DMCByteCursor: through NSInputStream.
++ (NSArray*) streamParsedTransactionsFromData:(NSData*)data count:(NSUInteger)count {
+    NSMutableArray* txs = [NSMutableArray arrayWithCapacity:count];
+    NSInputStream* stream = [NSInputStream inputStreamWithData:data];
+    [stream open];
+    for (NSUInteger i = 0; i < count; i++) {
+        DMCTransaction* tx = [[DMCTransaction alloc] initWithStream:stream];
+        if (!tx) break;
+        [txs addObject:tx];
+    }
+    [stream close];
+    return txs;
+}
+
++ (void) benchmarkParsing {
+    // Typical payment transactions (1-3 inputs, 2 outputs), as in blocks and tx4lightnode batches.
+    NSMutableArray* txs = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 2000; i++) {
+        [txs addObject:[self transactionWithInputsCount:1 + i % 3 outputsCount:2]];
+    }
+    DMCBlock* block = [[DMCBlock alloc] init];
+    block.transactions = txs;
+    NSData* blockData = block.data;
+
+    NSMutableData* batch = [NSMutableData data];
+    for (DMCTransaction* tx in [txs subarrayWithRange:NSMakeRange(0, 200)]) {
+        [batch appendData:tx.data];
+    }
+
+    NSUInteger headerLength = [DMCBlockHeader headerLength] + DMCVarIntLength(txs.count);
+    NSData* blockTxsData = [blockData subdataWithRange:NSMakeRange(headerLength, blockData.length - headerLength)];
+
+    for (int round = 0; round < 3; round++) {
+        CFAbsoluteTime t0 = CFAbsoluteTimeGetCurrent();
+        NSArray* streamTxs = [self streamParsedTransactionsFromData:blockTxsData count:txs.count];
+        CFAbsoluteTime t1 = CFAbsoluteTimeGetCurrent();
+        DMCBlock* parsedBlock = [[DMCBlock alloc] initWithData:blockData];
+        CFAbsoluteTime t2 = CFAbsoluteTimeGetCurrent();
+        NSAssert(streamTxs.count == txs.count && parsedBlock.transactions.count == txs.count, @"Should parse all transactions");
+
+        NSLog(@"Parsing block with %d txs (%d bytes): stream %.1f ms, cursor %.1f ms (%.1fx)",
+              (int)txs.count, (int)blockData.length, (t1 - t0) * 1000.0, (t2 - t1) * 1000.0, (t1 - t0) / (t2 - t1));
+
+        t0 = CFAbsoluteTimeGetCurrent();
+        for (int i = 0; i < 10; i++) {
+            [self streamParsedTransactionsFromData:batch count:200];
+        }
+        t1 = CFAbsoluteTimeGetCurrent();
+        for (int i = 0; i < 10; i++) {
+            DMCByteCursor* cursor = [[DMCByteCursor alloc] initWithData:batch];
+            while (cursor.remainingLength > 0) {
+                if (![[DMCTransaction alloc] initWithCursor:cursor]) break;
+            }
+        }
+        t2 = CFAbsoluteTimeGetCurrent();
+
+        NSLog(@"Parsing 10 batches of 200 txs: stream %.1f ms, cursor %.1f ms (%.1fx)",
+              (t1 - t0) * 1000.0, (t2 - t1) * 1000.0, (t1 - t0) / (t2 - t1));
+    }
+}
+
+// Builds a transaction spending `inputsCount` P2PKH outputs to two outputs.
++ (DMCTransaction*) transactionWithInputsCount:(NSUInteger)inputsCount outputsCount:(NSUInteger)outputsCount {
+    DMCTransaction* tx = [DMCTransaction new];
+    for (NSUInteger i = 0; i < inputsCount; i++) {
+        DMCTransactionInput* txin = [DMCTransactionInput new];
+        txin.previousHash = DMCSHA256([[NSString stringWithFormat:@"tx%d", (int)i] dataUsingEncoding:NSUTF8StringEncoding]);
+        txin.previousIndex = (uint32_t)(i % 3);
+        txin.sequence = 0xFFFFFFFF - (uint32_t)i;
+        txin.signatureScript = [[[DMCScript new] appendData:[DMCScript simulatedSignatureWithHashType:SIGHASH_ALL]] appendData:[DMCScript simulatedCompressedPubkey]];
+        [tx addInput:txin];
+    }
+    for (NSUInteger i = 0; i < outputsCount; i++) {
+        DMCScript* script = [[DMCScript alloc] initWithAddress:[DMCPublicKeyAddress addressWithData:DMCHash160([NSData dataWithBytes:&i length:sizeof(i)])]];
+        [tx addOutput:[[DMCTransactionOutput alloc] initWithValue:(DMCAmount)(10000 + i) script:script]];
+    }
+    tx.lockTime = 12345;
+    return tx;
+}
+
+// Straightforward implementation of the signature hash which copies and modifies the whole transaction.
+// Used to cross-check DMCSignatureHasher.
++ (NSData*) referenceSignatureHashForTransaction:(DMCTransaction*)original script:(DMCScript*)subscript inputIndex:(uint32_t)inputIndex hashType:(DMCSignatureHashType)hashType {
+    DMCTransaction* tx = [original copy];
+    if (inputIndex >= tx.inputs.count) return nil;
+
+    [subscript deleteOccurrencesOfOpcode:OP_CODESEPARATOR];
+
+    for (DMCTransactionInput* txin in tx.inputs) {
+        txin.signatureScript = [[DMCScript alloc] init];
+    }
+    ((DMCTransactionInput*)tx.inputs[inputIndex]).signatureScript = subscript;
+
+    if ((hashType & SIGHASH_OUTPUT_MASK) == SIGHASH_NONE) {
+        [tx removeAllOutputs];
+        for (NSUInteger i = 0; i < tx.inputs.count; i++) {
+            if (i != inputIndex) ((DMCTransactionInput*)tx.inputs[i]).sequence = 0;
+        }
+    } else if ((hashType & SIGHASH_OUTPUT_MASK) == SIGHASH_SINGLE) {
+        uint32_t outputIndex = inputIndex;
+        if (outputIndex >= tx.outputs.count) {
+            static unsigned char littleEndianOne[32] = {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+            return [NSData dataWithBytes:littleEndianOne length:32];
+        }
+        DMCTransactionOutput* myOutput = tx.outputs[outputIndex];
+        [tx removeAllOutputs];
+        for (int i = 0; i < outputIndex; i++) {
+            [tx addOutput:[[DMCTransactionOutput alloc] init]];
+        }
+        [tx addOutput:myOutput];
+        for (NSUInteger i = 0; i < tx.inputs.count; i++) {
+            if (i != inputIndex) ((DMCTransactionInput*)tx.inputs[i]).sequence = 0;
+        }
+    }
+
+    if (hashType & SIGHASH_ANYONECANPAY) {
+        DMCTransactionInput* input = tx.inputs[inputIndex];
+        [tx removeAllInputs];
+        [tx addInput:input];
+    }
+
+    NSMutableData* fulldata = [tx.data mutableCopy];
+    uint32_t hashType32 = OSSwapHostToLittleInt32((uint32_t)hashType);
+    [fulldata appendBytes:&hashType32 length:sizeof(hashType32)];
+    return DMCHash256(fulldata);
+}
+
++ (void) testSignatureHasher {
+    DMCTransaction* tx = [self transactionWithInputsCount:5 outputsCount:3];
+    DMCScript* subscript = [[DMCScript alloc] initWithAddress:[DMCPublicKeyAddress addressWithData:DMCHash160(DMCDataWithUTF8CString("key"))]];
+    DMCSignatureHasher* hasher = [[DMCSignatureHasher alloc] initWithTransaction:tx];
+
+    NSData* d1 = tx.data;
+    DMCSignatureHashType hashTypes[] = {
+        SIGHASH_ALL, SIGHASH_NONE, SIGHASH_SINGLE,
+        SIGHASH_ALL | SIGHASH_ANYONECANPAY, SIGHASH_NONE | SIGHASH_ANYONECANPAY, SIGHASH_SINGLE | SIGHASH_ANYONECANPAY,
+    };
+    for (int t = 0; t < sizeof(hashTypes) / sizeof(hashTypes[0]); t++) {
+        for (uint32_t i = 0; i < tx.inputs.count; i++) {
+            NSData* h1 = [self referenceSignatureHashForTransaction:tx script:[subscript copy] inputIndex:i hashType:hashTypes[t]];
+            NSData* h2 = [hasher signatureHashForScript:[subscript copy] inputIndex:i hashType:hashTypes[t] error:NULL];
+            NSData* h3 = [tx signatureHashForScript:[subscript copy] inputIndex:i hashType:hashTypes[t] error:NULL];
+            NSAssert([h1 isEqual:h2], @"Hasher must produce the same hash as a modified copy of the transaction");
+            NSAssert([h1 isEqual:h3], @"Transaction must produce the same hash as a modified copy of the transaction");
+        }
+    }
+    NSAssert([d1 isEqual:tx.data], @"Transaction must not change within signature hashing");
+
+    // Signing inputs one by one must not affect hashes of other inputs.
+    NSData* before = [hasher signatureHashForScript:[subscript copy] inputIndex:4 hashType:SIGHASH_ALL error:NULL];
+    ((DMCTransactionInput*)tx.inputs[0]).signatureScript = [[DMCScript new] appendData:DMCDataWithUTF8CString("signature")];
+    NSAssert([before isEqual:[self referenceSignatureHashForTransaction:tx script:[subscript copy] inputIndex:4 hashType:SIGHASH_ALL]], @"Signature scripts must be blanked");
+
+    NSError* error = nil;
+    NSAssert([hasher signatureHashForScript:subscript inputIndex:5 hashType:SIGHASH_ALL error:&error] == nil, @"Out of bounds index should fail");
+    NSAssert(error != nil, @"Out of bounds index should set an error");
+}
+
++ (void) benchmarkSignatureHash {
+    DMCScript* subscript = [[DMCScript alloc] initWithAddress:[DMCPublicKeyAddress addressWithData:DMCHash160(DMCDataWithUTF8CString("key"))]];
+
+    for (NSNumber* count in @[ @10, @100, @300, @1000 ]) {
+        DMCTransaction* tx = [self transactionWithInputsCount:count.unsignedIntegerValue outputsCount:2];
+
+        CFAbsoluteTime t0 = CFAbsoluteTimeGetCurrent();
+        for (uint32_t i = 0; i < tx.inputs.count; i++) {
+            [self referenceSignatureHashForTransaction:tx script:[subscript copy] inputIndex:i hashType:SIGHASH_ALL];
+        }
+        CFAbsoluteTime t1 = CFAbsoluteTimeGetCurrent();
+        DMCSignatureHasher* hasher = [[DMCSignatureHasher alloc] initWithTransaction:tx];
+        for (uint32_t i = 0; i < tx.inputs.count; i++) {
+            [hasher signatureHashForScript:[subscript copy] inputIndex:i hashType:SIGHASH_ALL error:NULL];
+        }
+        CFAbsoluteTime t2 = CFAbsoluteTimeGetCurrent();
+
+        NSLog(@"Signature hashes for %@ inputs: copying %.1f ms (%.1f us/input), hasher %.1f ms (%.1f us/input)",
+              count, (t1 - t0) * 1000.0, (t1 - t0) * 1e6 / count.doubleValue,
+              (t2 - t1) * 1000.0, (t2 - t1) * 1e6 / count.doubleValue);
+    }
+}
+
+
++ (void) benchmarkLazyParsing {
+    NSMutableData* batch = [NSMutableData data];
+    for (NSUInteger i = 0; i < 2000; i++) {
+        [batch appendData:[self transactionWithInputsCount:1 + i % 3 outputsCount:2].data];
+    }
+
+    // Typical work for a relayed transaction: compute txid, look at outpoints and output scripts.
+    for (int round = 0; round < 3; round++) {
+        NSUInteger eagerScriptBytes = 0;
+        CFAbsoluteTime t0 = CFAbsoluteTimeGetCurrent();
+        DMCByteCursor* cursor = [[DMCByteCursor alloc] initWithData:batch];
+        while (cursor.remainingLength > 0) {
+            DMCTransaction* tx = [[DMCTransaction alloc] initWithCursor:cursor];
+            if (!tx) break;
+            (void)tx.transactionHash;
+            for (DMCTransactionOutput* txout in tx.outputs) {
+                eagerScriptBytes += txout.script.data.length;
+            }
+        }
+        CFAbsoluteTime t1 = CFAbsoluteTimeGetCurrent();
+        NSUInteger lazyScriptBytes = 0;
+        cursor = [[DMCByteCursor alloc] initWithData:batch];
+        while (cursor.remainingLength > 0) {
+            DMCTransaction* tx = [[DMCTransaction alloc] initLazilyWithCursor:cursor];
+            if (!tx) break;
+            (void)tx.transactionHash;
+            for (NSUInteger i = 0; i < tx.outputsCount; i++) {
+                NSUInteger length = 0;
+                [tx scriptBytesOfOutputAtIndex:i length:&length];
+                lazyScriptBytes += length;
+            }
+        }
+        CFAbsoluteTime t2 = CFAbsoluteTimeGetCurrent();
+        NSAssert(eagerScriptBytes == lazyScriptBytes, @"Should see the same scripts");
+
+        NSLog(@"Hashing and scanning 2000 txs: eager %.1f ms, lazy %.1f ms (%.1fx)",
+              (t1 - t0) * 1000.0, (t2 - t1) * 1000.0, (t1 - t0) / (t2 - t1));
+    }
+}
+
 + (void) testFees {
     NSAssert([[DMCTransaction new] estimatedFee] == DMCTransactionDefaultFeeRate, @"smallest tx must have a fee == default fee rate");
     NSAssert([[DMCTransaction new] estimatedFeeWithRate:12345] == 12345, @"smallest tx must have a fee == fee rate");
@@ -11,6 +11,7 @@ static const DMCAmount DMCTransactionDefaultFeeRate = 10000; // 10K satoshis per
 @class DMCScript;
 @class DMCTransactionInput;
 @class DMCTransactionOutput;
+@class DMCByteCursor;
 
 /*!
  * Converts string transaction ID (reversed tx hash in hex format) to transaction hash.
@@ -57,6 +58,8 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) DEPRECATED_ATTRIBUTE;
 @property(nonatomic) uint32_t lockTime; // aka "lock_time"
 
 // Binary representation on tx ready to be sent over the wire (aka "payload")
+// Payload, transactionHash and transactionID are cached until the transaction,
+// any of its inputs or outputs, or their scripts change.
 @property(nonatomic, readonly) NSData* data;
 
 // Binary representiation in hex.
@@ -115,15 +118,56 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) DEPRECATED_ATTRIBUTE;
 // Parses tx from data buffer.
 - (id) initWithData:(NSData*)data;
 
+// Parses tx from data buffer whose hash is already known (e.g. computed while the data was received),
+// so transactionHash does not hash the data again. The hash is ignored if the data has bytes after the transaction.
+- (id) initWithData:(NSData*)data transactionHash:(NSData*)hash;
+
 // Parses tx from hex string.
 - (id) initWithHex:(NSString*)hex;
 
 // Parses input stream (useful when parsing many transactions from a single source, e.g. a block).
 - (id) initWithStream:(NSInputStream*)stream;
 
+// Parses tx at the cursor position and moves the cursor past it.
+// Faster than streams when parsing many transactions from a single buffer (e.g. a block):
+// hashes, scripts and the cached payload reference the cursor's buffer without copying.
+- (id) initWithCursor:(DMCByteCursor*)cursor;
+
 // Constructs transaction from its dictionary representation
 - (id) initWithDictionary:(NSDictionary*)dictionary;
 
+// Lazy parsing
+// ------------
+// Lazily parsed transaction validates its layout and records offsets of inputs and outputs in a single pass.
+// Data, txid, outpoints and output scripts are then read from the original buffer without creating objects.
+// Input and output objects are decoded on first access to `inputs` or `outputs` or on any change to the transaction.
+
+// Parses tx lazily from data buffer.
+- (id) initLazilyWithData:(NSData*)data;
+
+// Parses tx lazily at the cursor position and moves the cursor past it.
+- (id) initLazilyWithCursor:(DMCByteCursor*)cursor;
+
+// Returns YES if inputs and outputs are not decoded into objects yet.
+@property(nonatomic, readonly) BOOL isLazy;
+
+// Number of inputs and outputs. Do not decode a lazy transaction.
+@property(nonatomic, readonly) NSUInteger inputsCount;
+@property(nonatomic, readonly) NSUInteger outputsCount;
+
+// Copies 32-byte hash and index of the outpoint spent by the input.
+// Throws NSRangeException if index is out of bounds.
+- (void) getPreviousHash:(uint8_t*)hashOut index:(uint32_t*)indexOut ofInputAtIndex:(NSUInteger)index;
+
+// Amount of the output.
+// Throws NSRangeException if index is out of bounds.
+- (DMCAmount) valueOfOutputAtIndex:(NSUInteger)index;
+
+// Returns pointer to the output script bytes and stores their length in lengthOut.
+// Pointer is valid while the transaction is alive and not modified.
+// Throws NSRangeException if index is out of bounds.
+- (const uint8_t*) scriptBytesOfOutputAtIndex:(NSUInteger)index length:(NSUInteger*)lengthOut;
+
 // Hash for signing a transaction.
 // You should supply the output script of the previous transaction, desired hash type and input index in this transaction.
 - (NSData*) signatureHashForScript:(DMCScript*)subscript inputIndex:(uint32_t)inputIndex hashType:(DMCSignatureHashType)hashType error:(NSError**)errorOut;
@@ -140,6 +184,10 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) DEPRECATED_ATTRIBUTE;
 // Replaces outputs with an empty array.
 - (void) removeAllOutputs;
 
+// Drops cached payload and hash. Inputs and outputs call this when their fields change.
+// You only need to call it yourself after mutating NSMutableData assigned to some input or output.
+- (void) invalidatePayload;
+
 // Returns YES if this txin generates new coins.
 @property(nonatomic, readonly) BOOL isCoinbase;
 
@@ -8,6 +8,8 @@
 #import "DMCScript.h"
 #import "DMCErrors.h"
 #import "DMCHashID.h"
+#import "DMCSignatureHasher.h"
+#import "DMCByteCursor.h"
 
 NSData* DMCTransactionHashFromID(NSString* txid) {
     return DMCHashFromID(txid);
@@ -17,10 +19,34 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
     return DMCIDFromHash(txhash);
 }
 
+// Location of an input or output within the payload of a lazily parsed transaction.
+typedef struct {
+    NSUInteger offset;
+    NSUInteger scriptOffset;
+    NSUInteger scriptLength;
+} DMCTransactionFieldRange;
+
 @interface DMCTransaction ()
 @end
 
-@implementation DMCTransaction
+@implementation DMCTransaction {
+    // Cached payload, its hash and txid. Reset by -invalidatePayload.
+    NSData* _payload;
+    NSData* _payloadHash;
+    NSString* _payloadID;
+
+    // Script data of each input and output when the payload was cached.
+    // Scripts are mutable, so we compare them to detect in-place edits.
+    // Comparison is skipped while the scripts' edit counts add up to the same sum as when they were taken.
+    NSArray* _payloadScripts;
+    uint64_t _payloadScriptEdits;
+
+    // Offsets of inputs followed by outputs in the cached payload while the transaction is lazy.
+    // Freed when inputs and outputs are decoded into objects.
+    DMCTransactionFieldRange* _lazyRanges;
+    NSUInteger _lazyInputsCount;
+    NSUInteger _lazyOutputsCount;
+}
 
 - (id) init {
     if (self = [super init]) {
@@ -46,6 +72,15 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
     return self;
 }
 
+// Parses tx from data buffer whose hash is already known.
+- (id) initWithData:(NSData*)data transactionHash:(NSData*)hash {
+    if (self = [self initWithData:data]) {
+        // The hash covers the whole buffer, so it is the txid only if the tx takes all of it.
+        if (_payload.length == data.length) _payloadHash = [hash copy];
+    }
+    return self;
+}
+
 // Parses tx from hex string.
 - (id) initWithHex:(NSString*)hex {
     return [self initWithData:DMCDataFromHex(hex)];
@@ -59,6 +94,32 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
     return self;
 }
 
+// Parses tx at the cursor position and moves the cursor past it.
+- (id) initWithCursor:(DMCByteCursor*)cursor {
+    if (self = [self init]) {
+        if (![self parseCursor:cursor]) return nil;
+    }
+    return self;
+}
+
+// Records layout of the tx without decoding inputs and outputs.
+- (id) initLazilyWithData:(NSData*)data {
+    if (!data) return nil;
+    return [self initLazilyWithCursor:[[DMCByteCursor alloc] initWithData:data]];
+}
+
+// Records layout of the tx at the cursor position and moves the cursor past it.
+- (id) initLazilyWithCursor:(DMCByteCursor*)cursor {
+    if (self = [self init]) {
+        if (![self parseLazilyWithCursor:cursor]) return nil;
+    }
+    return self;
+}
+
+- (void) dealloc {
+    free(_lazyRanges);
+}
+
 // Constructs transaction from dictionary representation
 - (id) initWithDictionary:(NSDictionary*)dictionary {
     if (self = [self init]) {
@@ -90,6 +151,7 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
 }
 
 - (NSDictionary*) dictionary {
+    [self decodeLazyFields];
     return @{
       @"hash":      self.transactionID,
       @"ver":       @(_version),
@@ -125,11 +187,12 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
     DMCTransaction* tx = [[DMCTransaction alloc] init];
     tx->_inputs = [[NSArray alloc] initWithArray:self.inputs copyItems:YES]; // so each element is copied individually
     tx->_outputs = [[NSArray alloc] initWithArray:self.outputs copyItems:YES]; // so each element is copied individually
+    // Link copies to the new transaction so their changes invalidate its cached payload.
     for (DMCTransactionInput* txin in tx.inputs) {
-        txin.transaction = self;
+        txin.transaction = tx;
     }
     for (DMCTransactionOutput* txout in tx.outputs) {
-        txout.transaction = self;
+        txout.transaction = tx;
     }
     tx.version = self.version;
     tx.lockTime = self.lockTime;
@@ -150,7 +213,11 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
 
 
 - (NSData*) transactionHash {
-    return DMCHash256(self.data);
+    NSData* payload = self.data;
+    if (!_payloadHash) {
+        _payloadHash = [DMCHash256(payload) copy];
+    }
+    return _payloadHash;
 }
 
 - (NSString*) displayTransactionHash { // deprecated
@@ -158,7 +225,11 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
 }
 
 - (NSString*) transactionID {
-    return DMCIDFromHash(self.transactionHash);
+    NSData* hash = self.transactionHash;
+    if (!_payloadID) {
+        _payloadID = DMCIDFromHash(hash);
+    }
+    return _payloadID;
 }
 
 - (NSString*) blockID {
@@ -170,41 +241,126 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
 }
 
 - (NSData*) data {
-    return [self computePayload];
+    // Lazy payload is immutable until inputs and outputs are decoded.
+    if (_lazyRanges) return _payload;
+
+    // Inputs and outputs drop the payload when they change, so only in-place script edits need checking.
+    uint64_t edits = [self currentScriptEdits];
+    if (_payload && edits == _payloadScriptEdits) return _payload;
+
+    if (!_payload || ![self payloadScriptsAreCurrent]) {
+        [self invalidatePayload];
+        _payloadScripts = [self currentPayloadScripts];
+        _payload = [self computePayload];
+    }
+    _payloadScriptEdits = edits;
+    return _payload;
 }
 
 - (NSString*) hex {
     return DMCHexFromData(self.data);
 }
 
+// Computes exact length first and writes everything into a single buffer.
 - (NSData*) computePayload {
-    NSMutableData* payload = [NSMutableData data];
-    
+    NSUInteger length = 4 + DMCVarIntLength(_inputs.count) + DMCVarIntLength(_outputs.count) + 4;
+    for (DMCTransactionInput* input in _inputs) {
+        length += input.dataLength;
+    }
+    for (DMCTransactionOutput* output in _outputs) {
+        length += output.dataLength;
+    }
+
+    uint8_t* bytes = malloc(length);
+    uint8_t* p = bytes;
+
     // 4-byte version
-    uint32_t ver = _version;
-    [payload appendBytes:&ver length:4];
-    
-    // varint with number of inputs
-    [payload appendData:[DMCProtocolSerialization dataForVarInt:_inputs.count]];
-    
-    // input payloads
+    OSWriteLittleInt32(p, 0, _version);
+    p += 4;
+
+    // varint with number of inputs and input payloads
+    p = DMCWriteVarInt(p, _inputs.count);
     for (DMCTransactionInput* input in _inputs) {
-        [payload appendData:input.data];
+        p = [input writeDataToBytes:p];
     }
-    
-    // varint with number of outputs
-    [payload appendData:[DMCProtocolSerialization dataForVarInt:_outputs.count]];
-    
-    // output payloads
+
+    // varint with number of outputs and output payloads
+    p = DMCWriteVarInt(p, _outputs.count);
     for (DMCTransactionOutput* output in _outputs) {
-        [payload appendData:output.data];
+        p = [output writeDataToBytes:p];
     }
-    
+
     // 4-byte lock_time
-    uint32_t lt = _lockTime;
-    [payload appendBytes:&lt length:4];
-    
-    return payload;
+    OSWriteLittleInt32(p, 0, _lockTime);
+    p += 4;
+
+    NSAssert(p == bytes + length, @"Must write exactly the computed length");
+
+    return [[NSData alloc] initWithBytesNoCopy:bytes length:length freeWhenDone:YES];
+}
+
+- (NSArray*) currentPayloadScripts {
+    NSMutableArray* scripts = [NSMutableArray arrayWithCapacity:_inputs.count + _outputs.count];
+    for (DMCTransactionInput* input in _inputs) {
+        [scripts addObject:input.signatureScript.data ?: [NSNull null]];
+    }
+    for (DMCTransactionOutput* output in _outputs) {
+        [scripts addObject:output.script.data ?: [NSNull null]];
+    }
+    return scripts;
+}
+
+// Edit counts only grow and replaced scripts drop the payload, so the sum changes exactly when one of the scripts was edited.
+- (uint64_t) currentScriptEdits {
+    uint64_t edits = 0;
+    for (DMCTransactionInput* input in _inputs) {
+        edits += input.signatureScript.editCount;
+    }
+    for (DMCTransactionOutput* output in _outputs) {
+        edits += output.script.editCount;
+    }
+    return edits;
+}
+
+- (BOOL) payloadScriptsAreCurrent {
+    if (_payloadScripts.count != _inputs.count + _outputs.count) return NO;
+    NSUInteger i = 0;
+    for (DMCTransactionInput* input in _inputs) {
+        if ((input.signatureScript.data ?: [NSNull null]) != _payloadScripts[i++]) return NO;
+    }
+    for (DMCTransactionOutput* output in _outputs) {
+        if ((output.script.data ?: [NSNull null]) != _payloadScripts[i++]) return NO;
+    }
+    return YES;
+}
+
+- (void) invalidatePayload {
+    // Objects must be decoded before the payload they are decoded from is dropped.
+    [self decodeLazyFields];
+    _payload = nil;
+    _payloadHash = nil;
+    _payloadID = nil;
+    _payloadScripts = nil;
+}
+
+- (NSArray*) inputs {
+    [self decodeLazyFields];
+    return _inputs;
+}
+
+- (NSArray*) outputs {
+    [self decodeLazyFields];
+    return _outputs;
+}
+
+- (void) setVersion:(uint32_t)version {
+    _version = version;
+    [self invalidatePayload];
+}
+
+- (void) setLockTime:(uint32_t)lockTime {
+    _lockTime = lockTime;
+    [self invalidatePayload];
 }
 
 
@@ -214,8 +370,10 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
 // Adds input script
 - (void) addInput:(DMCTransactionInput*)input {
     if (!input) return;
+    [self decodeLazyFields];
     [self linkInput:input];
     _inputs = [_inputs arrayByAddingObject:input];
+    [self invalidatePayload];
 }
 
 - (void) linkInput:(DMCTransactionInput*)input {
@@ -229,8 +387,10 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
 // Adds output script
 - (void) addOutput:(DMCTransactionOutput*)output {
     if (!output) return;
+    [self decodeLazyFields];
     [self linkOutput:output];
     _outputs = [_outputs arrayByAddingObject:output];
+    [self invalidatePayload];
 }
 
 - (void) linkOutput:(DMCTransactionOutput*)output {
@@ -258,20 +418,31 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
 }
 
 - (void) removeAllInputs {
+    [self decodeLazyFields];
     for (DMCTransactionInput* txin in _inputs) {
         txin.transaction = nil;
     }
     _inputs = @[];
+    [self invalidatePayload];
 }
 
 - (void) removeAllOutputs {
+    [self decodeLazyFields];
     for (DMCTransactionOutput* txout in _outputs) {
         txout.transaction = nil;
     }
     _outputs = @[];
+    [self invalidatePayload];
 }
 
 - (BOOL) isCoinbase {
+    if (_lazyRanges) {
+        if (_lazyInputsCount != 1) return NO;
+        uint8_t hash[32];
+        uint32_t index = 0;
+        [self getPreviousHash:hash index:&index ofInputAtIndex:0];
+        return index == 0xFFFFFFFF && 0 == memcmp(hash, DMCZeroString256(), sizeof(hash));
+    }
     // Coinbase transaction has one input and it must be coinbase.
     return (_inputs.count == 1 && [(DMCTransactionInput*)_inputs[0] isCoinbase]);
 }
@@ -283,11 +454,7 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
 
 - (BOOL) parseData:(NSData*)data {
     if (!data) return NO;
-    NSInputStream* stream = [NSInputStream inputStreamWithData:data];
-    [stream open];
-    BOOL result = [self parseStream:stream];
-    [stream close];
-    return result;
+    return [self parseCursor:[[DMCByteCursor alloc] initWithData:data]];
 }
 
 - (BOOL) parseStream:(NSInputStream*)stream {
@@ -333,115 +500,214 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
 }
 
 
-#pragma mark - Signing a transaction
+- (BOOL) parseCursor:(DMCByteCursor*)cursor {
+    if (!cursor) return NO;
+    NSUInteger offset = cursor.offset;
+    if (![self parseFieldsWithCursor:cursor]) {
+        cursor.offset = offset;
+        return NO;
+    }
 
+    // Parsed bytes are exactly the serialized transaction, so keep them as the cached payload.
+    _payload = [cursor sliceWithRange:NSMakeRange(offset, cursor.offset - offset)];
+    _payloadScriptEdits = [self currentScriptEdits];
+    _payloadScripts = [self currentPayloadScripts];
 
+    return YES;
+}
 
-// Hash for signing a transaction.
-// You should supply the output script of the previous transaction, desired hash type and input index in this transaction.
-- (NSData*) signatureHashForScript:(DMCScript*)subscript inputIndex:(uint32_t)inputIndex hashType:(DMCSignatureHashType)hashType error:(NSError**)errorOut {
-    // Create a temporary copy of the transaction to apply modifications to it.
-    DMCTransaction* tx = [self copy];
-    
-    // We may have a scriptmachine instantiated without a transaction (for testing),
-    // but it should not use signature checks then.
-    if (!tx || inputIndex == 0xFFFFFFFF) {
-        if (errorOut) *errorOut = [NSError errorWithDomain:DMCErrorDomain
-                                                      code:DMCErrorScriptError
-                                                  userInfo:@{NSLocalizedDescriptionKey: NSLocalizedString(@"Transaction and valid input index must be provided for signature verification.", @"")}];
-        return nil;
+- (BOOL) parseFieldsWithCursor:(DMCByteCursor*)cursor {
+    uint32_t version = 0;
+    if (![cursor readUInt32:&version]) return NO;
+    _version = version;
+
+    if (![self parseInputsAndOutputsWithCursor:cursor]) return NO;
+
+    uint32_t lockTime = 0;
+    if (![cursor readUInt32:&lockTime]) return NO;
+    _lockTime = lockTime;
+
+    return YES;
+}
+
+- (BOOL) parseInputsAndOutputsWithCursor:(DMCByteCursor*)cursor {
+    {
+        uint64_t inputsCount = 0;
+        if (![cursor readVarInt:&inputsCount]) return NO;
+
+        // Each input takes at least 41 bytes, so a bogus count fails here instead of allocating.
+        if (inputsCount > cursor.remainingLength / 41) return NO;
+
+        NSMutableArray* ins = [NSMutableArray arrayWithCapacity:(NSUInteger)inputsCount];
+        for (uint64_t i = 0; i < inputsCount; i++)
+        {
+            DMCTransactionInput* input = [[DMCTransactionInput alloc] initWithCursor:cursor];
+            if (!input) return NO;
+            [self linkInput:input];
+            [ins addObject:input];
+        }
+        _inputs = ins;
     }
-    
-    // Note: BitcoinQT returns a 256-bit little-endian number 1 in such case, but it does not matter
-    // because it would crash before that in CScriptCheck::operator()(). We normally won't enter this condition
-    // if script machine is instantiated with initWithTransaction:inputIndex:, but if it was just -init-ed, it's better to check.
-    if (inputIndex >= tx.inputs.count) {
-        if (errorOut) *errorOut = [NSError errorWithDomain:DMCErrorDomain
-                                                      code:DMCErrorScriptError
-                                                  userInfo:@{NSLocalizedDescriptionKey:[NSString stringWithFormat:
-                                                     NSLocalizedString(@"Input index is out of bounds for transaction: %d >= %d.", @""),
-                                                                                        (int)inputIndex, (int)tx.inputs.count]}];
-        return nil;
+
+    {
+        uint64_t outputsCount = 0;
+        if (![cursor readVarInt:&outputsCount]) return NO;
+
+        // Each output takes at least 9 bytes.
+        if (outputsCount > cursor.remainingLength / 9) return NO;
+
+        NSMutableArray* outs = [NSMutableArray arrayWithCapacity:(NSUInteger)outputsCount];
+        for (uint64_t i = 0; i < outputsCount; i++)
+        {
+            DMCTransactionOutput* output = [[DMCTransactionOutput alloc] initWithCursor:cursor];
+            if (!output) return NO;
+            [self linkOutput:output];
+            [outs addObject:output];
+        }
+        _outputs = outs;
     }
-    
-    // In case concatenating two scripts ends up with two codeseparators,
-    // or an extra one at the end, this prevents all those possible incompatibilities.
-    // Note: this normally never happens because there is no use for OP_CODESEPARATOR.
-    // But we have to do that cleanup anyway to not break on rare transaction that use that for lulz.
-    // Also: we modify the same subscript which is used several times for multisig check, but that's what BitcoinQT does as well.
-    [subscript deleteOccurrencesOfOpcode:OP_CODESEPARATOR];
-    
-    // Blank out other inputs' signature scripts
-    // and replace our input script with a subscript (which is typically a full output script from the previous transaction).
-    for (DMCTransactionInput* txin in tx.inputs) {
-        txin.signatureScript = [[DMCScript alloc] init];
+
+    return YES;
+}
+
+// Checks the layout in a single pass and records where inputs and outputs are,
+// so that txid, outpoints and output scripts are available without creating objects.
+- (BOOL) parseLazilyWithCursor:(DMCByteCursor*)cursor {
+    if (!cursor) return NO;
+    NSUInteger offset = cursor.offset;
+    DMCTransactionFieldRange* ranges = NULL;
+    uint64_t inputsCount = 0;
+    uint64_t outputsCount = 0;
+    uint32_t version = 0;
+    uint32_t lockTime = 0;
+
+    if (![cursor readUInt32:&version] ||
+        ![cursor readVarInt:&inputsCount] ||
+        inputsCount > cursor.remainingLength / 41) goto fail;
+
+    // Ranges of inputs come first; the array grows once the number of outputs is known.
+    ranges = malloc(sizeof(DMCTransactionFieldRange) * (size_t)MAX(inputsCount, 1));
+    if (!ranges) goto fail;
+    for (uint64_t i = 0; i < inputsCount; i++) {
+        ranges[i].offset = cursor.offset - offset;
+        uint64_t scriptLength = 0;
+        if (![cursor skipLength:32 + 4] || ![cursor readVarInt:&scriptLength]) goto fail;
+        ranges[i].scriptOffset = cursor.offset - offset;
+        if (scriptLength > cursor.remainingLength || ![cursor skipLength:(NSUInteger)scriptLength + 4]) goto fail;
+        ranges[i].scriptLength = (NSUInteger)scriptLength;
+    }
+
+    if (![cursor readVarInt:&outputsCount] || outputsCount > cursor.remainingLength / 9) goto fail;
+
+    ranges = reallocf(ranges, sizeof(DMCTransactionFieldRange) * (size_t)MAX(inputsCount + outputsCount, 1));
+    if (!ranges) goto fail;
+    for (uint64_t i = inputsCount; i < inputsCount + outputsCount; i++) {
+        ranges[i].offset = cursor.offset - offset;
+        uint64_t scriptLength = 0;
+        if (![cursor skipLength:8] || ![cursor readVarInt:&scriptLength]) goto fail;
+        ranges[i].scriptOffset = cursor.offset - offset;
+        if (scriptLength > cursor.remainingLength || ![cursor skipLength:(NSUInteger)scriptLength]) goto fail;
+        ranges[i].scriptLength = (NSUInteger)scriptLength;
+    }
+
+    if (![cursor readUInt32:&lockTime]) goto fail;
+
+    _version = version;
+    _lockTime = lockTime;
+    _payload = [cursor sliceWithRange:NSMakeRange(offset, cursor.offset - offset)];
+    _lazyRanges = ranges;
+    _lazyInputsCount = (NSUInteger)inputsCount;
+    _lazyOutputsCount = (NSUInteger)outputsCount;
+    return YES;
+
+fail:
+    free(ranges);
+    cursor.offset = offset;
+    return NO;
+}
+
+// Builds input and output objects from the payload of a lazily parsed transaction.
+- (void) decodeLazyFields {
+    if (!_lazyRanges) return;
+
+    free(_lazyRanges);
+    _lazyRanges = NULL;
+    _lazyInputsCount = 0;
+    _lazyOutputsCount = 0;
+
+    DMCByteCursor* cursor = [[DMCByteCursor alloc] initWithData:_payload];
+    cursor.offset = 4;
+    BOOL result = [self parseInputsAndOutputsWithCursor:cursor];
+    NSAssert(result, @"Payload was validated by the lazy parser");
+    (void)result;
+
+    // Payload stays cached: scripts are now slices of it.
+    _payloadScriptEdits = [self currentScriptEdits];
+    _payloadScripts = [self currentPayloadScripts];
+}
+
+- (BOOL) isLazy {
+    return _lazyRanges != NULL;
+}
+
+- (NSUInteger) inputsCount {
+    return _lazyRanges ? _lazyInputsCount : _inputs.count;
+}
+
+- (NSUInteger) outputsCount {
+    return _lazyRanges ? _lazyOutputsCount : _outputs.count;
+}
+
+- (void) getPreviousHash:(uint8_t*)hashOut index:(uint32_t*)indexOut ofInputAtIndex:(NSUInteger)index {
+    if (index >= self.inputsCount) {
+        @throw [NSException exceptionWithName:NSRangeException reason:@"Input index is out of bounds" userInfo:nil];
     }
-    ((DMCTransactionInput*)tx.inputs[inputIndex]).signatureScript = subscript;
-    
-    // Blank out some of the outputs depending on DMCSignatureHashType
-    // Default is SIGHASH_ALL - all inputs and outputs are signed.
-    if ((hashType & SIGHASH_OUTPUT_MASK) == SIGHASH_NONE) {
-        // Wildcard payee - we can pay anywhere.
-        [tx removeAllOutputs];
-        
-        // Blank out others' input sequence numbers to let others update transaction at will.
-        for (NSUInteger i = 0; i < tx.inputs.count; i++) {
-            if (i != inputIndex) {
-                ((DMCTransactionInput*)tx.inputs[i]).sequence = 0;
-            }
-        }
-    } else if ((hashType & SIGHASH_OUTPUT_MASK) == SIGHASH_SINGLE) {
-        // Single mode assumes we sign an output at the same index as an input.
-        // Outputs before the one we need are blanked out. All outputs after are simply removed.
-        // Only lock-in the txout payee at same index as txin.
-        uint32_t outputIndex = inputIndex;
-        
-        // If outputIndex is out of bounds, BitcoinQT is returning a 256-bit little-endian 0x01 instead of failing with error.
-        // We should do the same to stay compatible.
-        if (outputIndex >= tx.outputs.count) {
-            static unsigned char littleEndianOne[32] = {1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-            return [NSData dataWithBytes:littleEndianOne length:32];
-        }
-        
-        // All outputs before the one we need are blanked out. All outputs after are simply removed.
-        // This is equivalent to replacing outputs with (i-1) empty outputs and a i-th original one.
-        DMCTransactionOutput* myOutput = tx.outputs[outputIndex];
-        [tx removeAllOutputs];
-        for (int i = 0; i < outputIndex; i++) {
-            [tx addOutput:[[DMCTransactionOutput alloc] init]];
-        }
-        [tx addOutput:myOutput];
-        
-        // Blank out others' input sequence numbers to let others update transaction at will.
-        for (NSUInteger i = 0; i < tx.inputs.count; i++) {
-            if (i != inputIndex) {
-                ((DMCTransactionInput*)tx.inputs[i]).sequence = 0;
-            }
-        }
+    if (_lazyRanges) {
+        const uint8_t* bytes = (const uint8_t*)_payload.bytes + _lazyRanges[index].offset;
+        if (hashOut) memcpy(hashOut, bytes, 32);
+        if (indexOut) *indexOut = OSReadLittleInt32(bytes, 32);
+    } else {
+        DMCTransactionInput* txin = _inputs[index];
+        if (hashOut) memcpy(hashOut, txin.previousHash.bytes, MIN(txin.previousHash.length, 32));
+        if (indexOut) *indexOut = txin.previousIndex;
     }
-    
-    // Blank out other inputs completely. This is not recommended for open transactions.
-    if (hashType & SIGHASH_ANYONECANPAY) {
-        DMCTransactionInput* input = tx.inputs[inputIndex];
-        [tx removeAllInputs];
-        [tx addInput:input];
+}
+
+- (DMCAmount) valueOfOutputAtIndex:(NSUInteger)index {
+    if (index >= self.outputsCount) {
+        @throw [NSException exceptionWithName:NSRangeException reason:@"Output index is out of bounds" userInfo:nil];
     }
-    
-    // Important: we have to hash transaction together with its hash type.
-    // Hash type is appended as little endian uint32 unlike 1-byte suffix of the signature.
-    NSMutableData* fulldata = [tx.data mutableCopy];
-    uint32_t hashType32 = OSSwapHostToLittleInt32((uint32_t)hashType);
-    [fulldata appendBytes:&hashType32 length:sizeof(hashType32)];
-    
-    NSData* hash = DMCHash256(fulldata);
-    
-//    NSLog(@"\n----------------------\n");
-//    NSLog(@"TX: %@", DMCHexFromData(fulldata));
-//    NSLog(@"TX SUBSCRIPT: %@ (%@)", DMCHexFromData(subscript.data), subscript);
-//    NSLog(@"TX HASH: %@", DMCHexFromData(hash));
-//    NSLog(@"TX PLIST: %@", tx.dictionary);
-    
-    return hash;
+    if (_lazyRanges) {
+        return (DMCAmount)OSReadLittleInt64(_payload.bytes, _lazyRanges[_lazyInputsCount + index].offset);
+    }
+    return ((DMCTransactionOutput*)_outputs[index]).value;
+}
+
+- (const uint8_t*) scriptBytesOfOutputAtIndex:(NSUInteger)index length:(NSUInteger*)lengthOut {
+    if (index >= self.outputsCount) {
+        @throw [NSException exceptionWithName:NSRangeException reason:@"Output index is out of bounds" userInfo:nil];
+    }
+    if (_lazyRanges) {
+        DMCTransactionFieldRange range = _lazyRanges[_lazyInputsCount + index];
+        if (lengthOut) *lengthOut = range.scriptLength;
+        return (const uint8_t*)_payload.bytes + range.scriptOffset;
+    }
+    NSData* scriptData = ((DMCTransactionOutput*)_outputs[index]).script.data;
+    if (lengthOut) *lengthOut = scriptData.length;
+    return scriptData.bytes;
+}
+
+
+#pragma mark - Signing a transaction
+
+
+
+// Hash for signing a transaction.
+// You should supply the output script of the previous transaction, desired hash type and input index in this transaction.
+// To sign or verify many inputs of the same transaction, use a single DMCSignatureHasher instead.
+- (NSData*) signatureHashForScript:(DMCScript*)subscript inputIndex:(uint32_t)inputIndex hashType:(DMCSignatureHashType)hashType error:(NSError**)errorOut {
+    DMCSignatureHasher* hasher = [[DMCSignatureHasher alloc] initWithTransaction:self];
+    return [hasher signatureHashForScript:subscript inputIndex:inputIndex hashType:hashType error:errorOut];
 }
 
 
@@ -611,7 +877,7 @@ NSString* DMCTransactionIDFromHash(NSData* txhash) {
     
     // To limit dust spam, require base fee if any output is less than 0.01
     if (minFee < baseFee) {
-        for (DMCTransactionOutput* txout in _outputs) {
+        for (DMCTransactionOutput* txout in self.outputs) {
             if (txout.value < DMCCent) {
                 minFee = baseFee;
                 break;
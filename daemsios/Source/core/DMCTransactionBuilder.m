@@ -6,6 +6,7 @@
 #import "DMCScript.h"
 #import "DMCKey.h"
 #import "DMCData.h"
+#import "DMCSignatureHasher.h"
 
 NSString* const DMCTransactionBuilderErrorDomain = @"com.oleganza.DaemsCoin.TransactionBuilder";
 
@@ -197,12 +198,13 @@ NSString* const DMCTransactionBuilderErrorDomain = @"com.oleganza.DaemsCoin.Tran
 - (DMCAmount) computeFeeForTransaction:(DMCTransaction*)tx {
     // Compute fees for this tx by composing a tx with properly sized dummy signatures.
     DMCTransaction* simtx = [tx copy];
+    DMCSignatureHasher* hasher = [[DMCSignatureHasher alloc] initWithTransaction:simtx];
     uint32_t i = 0;
     for (DMCTransactionInput* txin in simtx.inputs) {
         NSAssert(!!txin.transactionOutput, @"must have transactionOutput");
         DMCScript* txoutScript = txin.transactionOutput.script;
 
-        if (![self attemptToSignTransactionInput:txin tx:simtx inputIndex:i error:NULL]) {
+        if (![self attemptToSignTransactionInput:txin tx:simtx inputIndex:i hasher:hasher error:NULL]) {
             // TODO: if cannot match the simulated signature, use data source to provide one. (If signing API available, then use it.)
             txin.signatureScript = [txoutScript simulatedSignatureScriptWithOptions:DMCScriptSimulationMultisigP2SH];
         }
@@ -252,13 +254,16 @@ NSString* const DMCTransactionBuilderErrorDomain = @"com.oleganza.DaemsCoin.Tran
         }
     }
 
+    // Inputs and outputs are final now, so the shared parts of the transaction can be serialized once for all inputs.
+    DMCSignatureHasher* hasher = [[DMCSignatureHasher alloc] initWithTransaction:tx];
+
     // Try to sign each input.
     for (uint32_t i = 0; i < tx.inputs.count; i++) {
         // We support two kinds of scripts: p2pkh (modern style) and p2pk (old style)
         // For each of these we support compressed and uncompressed pubkeys.
         DMCTransactionInput* txin = tx.inputs[i];
 
-        if ([self attemptToSignTransactionInput:txin tx:tx inputIndex:i error:errorOut]) {
+        if ([self attemptToSignTransactionInput:txin tx:tx inputIndex:i hasher:hasher error:errorOut]) {
             [unsignedIndexes removeIndex:i];
         }
     } // each input
@@ -282,7 +287,7 @@ NSString* const DMCTransactionBuilderErrorDomain = @"com.oleganza.DaemsCoin.Tran
     }];
 }
 
-- (BOOL) attemptToSignTransactionInput:(DMCTransactionInput*)txin tx:(DMCTransaction*)tx inputIndex:(uint32_t)i error:(NSError**)errorOut {
+- (BOOL) attemptToSignTransactionInput:(DMCTransactionInput*)txin tx:(DMCTransaction*)tx inputIndex:(uint32_t)i hasher:(DMCSignatureHasher*)hasher error:(NSError**)errorOut {
     if (!_shouldSign) return NO;
 
     // We stored output script here earlier.
@@ -299,7 +304,7 @@ NSString* const DMCTransactionBuilderErrorDomain = @"com.oleganza.DaemsCoin.Tran
 
         DMCSignatureHashType hashtype = SIGHASH_ALL;
 
-        NSData* sighash = [tx signatureHashForScript:[outputScript copy] inputIndex:i hashType:hashtype error:errorOut];
+        NSData* sighash = [hasher signatureHashForScript:[outputScript copy] inputIndex:i hashType:hashtype error:errorOut];
         if (!sighash) {
             return NO;
         }
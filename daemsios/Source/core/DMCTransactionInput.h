@@ -6,6 +6,7 @@
 @class DMCOutpoint;
 @class DMCTransaction;
 @class DMCTransactionOutput;
+@class DMCByteCursor;
 
 // Transaction input (aka "txin") represents a reference to another transaction's output.
 // Reference is defined by tx hash + tx output index.
@@ -39,8 +40,16 @@
 @property(nonatomic) uint32_t sequence;
 
 // Serialized binary representation of the txin.
+// Cached until any of the serialized fields or the signature script changes.
 @property(nonatomic, readonly) NSData* data;
 
+// Length of the serialized binary representation computed without building it.
+@property(nonatomic, readonly) NSUInteger dataLength;
+
+// Writes serialized binary representation into a buffer having at least `dataLength` bytes.
+// Returns pointer to the byte following the written data.
+- (uint8_t*) writeDataToBytes:(uint8_t*)bytes;
+
 
 // Informational properties
 // ------------------------
@@ -69,6 +78,10 @@
 // Read tx input from the stream.
 - (id) initWithStream:(NSInputStream*)stream;
 
+// Reads tx input at the cursor position and moves the cursor past it.
+// Hash and script reference the cursor's buffer without copying.
+- (id) initWithCursor:(DMCByteCursor*)cursor;
+
 // Constructs transaction input from a dictionary representation
 - (id) initWithDictionary:(NSDictionary*)dictionary;
 
@@ -8,6 +8,7 @@
 #import "DMCData.h"
 #import "DMCHashID.h"
 #import "DMCOutpoint.h"
+#import "DMCByteCursor.h"
 
 @interface DMCTransactionInput ()
 @end
@@ -16,7 +17,12 @@ static const uint32_t DMCInvalidIndex = 0xFFFFFFFF; // aka "(unsigned int) -1" i
 static const uint32_t DMCMaxSequence = 0xFFFFFFFF;
 
 
-@implementation DMCTransactionInput
+@implementation DMCTransactionInput {
+    // Cached serialized representation and the script data it was made from
+    // (scripts are mutable, so we compare it to detect in-place edits).
+    NSData* _payload;
+    NSData* _payloadScriptData;
+}
 
 - (id) init {
     if (self = [super init]) {
@@ -45,6 +51,14 @@ static const uint32_t DMCMaxSequence = 0xFFFFFFFF;
     return self;
 }
 
+// Reads tx input at the cursor position and moves the cursor past it.
+- (id) initWithCursor:(DMCByteCursor*)cursor {
+    if (self = [self init]) {
+        if (![self parseCursor:cursor]) return nil;
+    }
+    return self;
+}
+
 // Constructs transaction input from a dictionary representation
 - (id) initWithDictionary:(NSDictionary*)dictionary {
     if (self = [self init]) {
@@ -96,27 +110,77 @@ static const uint32_t DMCMaxSequence = 0xFFFFFFFF;
 }
 
 - (NSData*) data {
-    return [self computePayload];
+    NSData* scriptData = _signatureScript.data;
+    if (!_payload || _payloadScriptData != scriptData) {
+        _payload = [self computePayload];
+        _payloadScriptData = scriptData;
+    }
+    return _payload;
 }
 
 - (NSData*) computePayload {
-    NSMutableData* payload = [NSMutableData data];
-    
-    [payload appendData:_previousHash];
-    [payload appendBytes:&_previousIndex length:4];
+    NSUInteger length = self.dataLength;
+    uint8_t* bytes = malloc(length);
+    uint8_t* end = [self writeDataToBytes:bytes];
+    NSAssert(end == bytes + length, @"Must write exactly dataLength bytes");
+    return [[NSData alloc] initWithBytesNoCopy:bytes length:length freeWhenDone:YES];
+}
 
-    if (self.isCoinbase) {
-        [payload appendData:[DMCProtocolSerialization dataForVarInt:self.coinbaseData.length]];
-        [payload appendData:self.coinbaseData];
-    } else {
-        NSData* scriptData = _signatureScript.data;
-        [payload appendData:[DMCProtocolSerialization dataForVarInt:scriptData.length]];
-        [payload appendData:scriptData];
-    }
-    
-    [payload appendBytes:&_sequence length:4];
-    
-    return payload;
+- (NSData*) serializedScriptData {
+    return self.isCoinbase ? _coinbaseData : _signatureScript.data;
+}
+
+- (NSUInteger) dataLength {
+    NSUInteger scriptLength = [self serializedScriptData].length;
+    return _previousHash.length + 4 + DMCVarIntLength(scriptLength) + scriptLength + 4;
+}
+
+- (uint8_t*) writeDataToBytes:(uint8_t*)bytes {
+    memcpy(bytes, _previousHash.bytes, _previousHash.length);
+    bytes += _previousHash.length;
+
+    OSWriteLittleInt32(bytes, 0, _previousIndex);
+    bytes += 4;
+
+    NSData* scriptData = [self serializedScriptData];
+    bytes = DMCWriteVarInt(bytes, scriptData.length);
+    if (scriptData.length > 0) memcpy(bytes, scriptData.bytes, scriptData.length);
+    bytes += scriptData.length;
+
+    OSWriteLittleInt32(bytes, 0, _sequence);
+    return bytes + 4;
+}
+
+// Drops cached serialization here and in the owning transaction.
+- (void) invalidatePayload {
+    _payload = nil;
+    _payloadScriptData = nil;
+    [_transaction invalidatePayload];
+}
+
+- (void) setPreviousHash:(NSData *)previousHash {
+    _previousHash = previousHash;
+    [self invalidatePayload];
+}
+
+- (void) setPreviousIndex:(uint32_t)previousIndex {
+    _previousIndex = previousIndex;
+    [self invalidatePayload];
+}
+
+- (void) setSignatureScript:(DMCScript *)signatureScript {
+    _signatureScript = signatureScript;
+    [self invalidatePayload];
+}
+
+- (void) setCoinbaseData:(NSData *)coinbaseData {
+    _coinbaseData = coinbaseData;
+    [self invalidatePayload];
+}
+
+- (void) setSequence:(uint32_t)sequence {
+    _sequence = sequence;
+    [self invalidatePayload];
 }
 
 - (DMCOutpoint*) outpoint {
@@ -176,11 +240,7 @@ static const uint32_t DMCMaxSequence = 0xFFFFFFFF;
 
 - (BOOL) parseData:(NSData*)data {
     if (!data) return NO;
-    NSInputStream* stream = [NSInputStream inputStreamWithData:data];
-    [stream open];
-    BOOL result = [self parseStream:stream];
-    [stream close];
-    return result;
+    return [self parseCursor:[[DMCByteCursor alloc] initWithData:data]];
 }
 
 - (BOOL) parseStream:(NSInputStream*)stream {
@@ -212,6 +272,37 @@ static const uint32_t DMCMaxSequence = 0xFFFFFFFF;
     return YES;
 }
 
+- (BOOL) parseCursor:(DMCByteCursor*)cursor {
+    if (!cursor) return NO;
+    NSUInteger offset = cursor.offset;
+
+    // Previous hash, signature script and coinbase data are slices of the cursor's buffer.
+    NSData* previousHash = [cursor readDataOfLength:32];
+    uint32_t previousIndex = 0;
+    NSData* scriptData = nil;
+    uint32_t sequence = 0;
+
+    if (!previousHash ||
+        ![cursor readUInt32:&previousIndex] ||
+        !(scriptData = [cursor readVarData]) ||
+        ![cursor readUInt32:&sequence]) {
+        cursor.offset = offset;
+        return NO;
+    }
+
+    _previousHash = previousHash;
+    _previousIndex = previousIndex;
+    _sequence = sequence;
+
+    if ([self isCoinbase]) {
+        _coinbaseData = scriptData;
+    } else {
+        _signatureScript = [[DMCScript alloc] initWithData:scriptData];
+    }
+
+    return YES;
+}
+
 
 - (BOOL) isCoinbase {
     return (_previousIndex == DMCInvalidIndex) &&
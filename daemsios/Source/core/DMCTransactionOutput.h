@@ -6,6 +6,7 @@
 @class DMCScript;
 @class DMCAddress;
 @class DMCTransaction;
+@class DMCByteCursor;
 
 static uint32_t const DMCTransactionOutputIndexUnknown = 0xffffffff;
 
@@ -15,8 +16,16 @@ static uint32_t const DMCTransactionOutputIndexUnknown = 0xffffffff;
 @interface DMCTransactionOutput : NSObject<NSCopying>
 
 // Serialized binary form of the output (payload)
+// Cached until value or script changes.
 @property(nonatomic, readonly) NSData* data;
 
+// Length of the serialized binary form computed without building it.
+@property(nonatomic, readonly) NSUInteger dataLength;
+
+// Writes serialized binary form into a buffer having at least `dataLength` bytes.
+// Returns pointer to the byte following the written data.
+- (uint8_t*) writeDataToBytes:(uint8_t*)bytes;
+
 // Value of output in satoshis.
 @property(nonatomic) DMCAmount value;
 
@@ -86,6 +95,10 @@ static uint32_t const DMCTransactionOutputIndexUnknown = 0xffffffff;
 // Reads tx output from the stream.
 - (id) initWithStream:(NSInputStream*)stream;
 
+// Reads tx output at the cursor position and moves the cursor past it.
+// Script references the cursor's buffer without copying.
+- (id) initWithCursor:(DMCByteCursor*)cursor;
+
 // Makes tx output from a dictionary representation
 - (id) initWithDictionary:(NSDictionary*)dictionary;
 
@@ -7,11 +7,17 @@
 #import "DMCData.h"
 #import "DMCHashID.h"
 #import "DMCProtocolSerialization.h"
+#import "DMCByteCursor.h"
 
 @interface DMCTransactionOutput ()
 @end
 
-@implementation DMCTransactionOutput
+@implementation DMCTransactionOutput {
+    // Cached serialized representation and the script data it was made from
+    // (scripts are mutable, so we compare it to detect in-place edits).
+    NSData* _payload;
+    NSData* _payloadScriptData;
+}
 
 - (id) init {
     return [self initWithValue:-1 script:[[DMCScript alloc] init]];
@@ -54,6 +60,14 @@
     return self;
 }
 
+// Reads tx output at the cursor position and moves the cursor past it.
+- (id) initWithCursor:(DMCByteCursor*)cursor {
+    if (self = [self init]) {
+        if (![self parseCursor:cursor]) return nil;
+    }
+    return self;
+}
+
 // Constructs transaction input from a dictionary representation
 - (id) initWithDictionary:(NSDictionary*)dictionary {
     if (self = [self init]) {
@@ -93,19 +107,52 @@
 }
 
 - (NSData*) data {
-    return [self computePayload];
+    NSData* scriptData = _script.data;
+    if (!_payload || _payloadScriptData != scriptData) {
+        _payload = [self computePayload];
+        _payloadScriptData = scriptData;
+    }
+    return _payload;
 }
 
 - (NSData*) computePayload {
-    NSMutableData* payload = [NSMutableData data];
-    
-    [payload appendBytes:&_value length:sizeof(_value)];
-    
-    NSData* scriptData = _script.data ?: [NSData data];
-    [payload appendData:[DMCProtocolSerialization dataForVarInt:scriptData.length]];
-    [payload appendData:scriptData];
-    
-    return payload;
+    NSUInteger length = self.dataLength;
+    uint8_t* bytes = malloc(length);
+    uint8_t* end = [self writeDataToBytes:bytes];
+    NSAssert(end == bytes + length, @"Must write exactly dataLength bytes");
+    return [[NSData alloc] initWithBytesNoCopy:bytes length:length freeWhenDone:YES];
+}
+
+- (NSUInteger) dataLength {
+    NSUInteger scriptLength = _script.data.length;
+    return sizeof(_value) + DMCVarIntLength(scriptLength) + scriptLength;
+}
+
+- (uint8_t*) writeDataToBytes:(uint8_t*)bytes {
+    OSWriteLittleInt64(bytes, 0, (uint64_t)_value);
+    bytes += sizeof(_value);
+
+    NSData* scriptData = _script.data;
+    bytes = DMCWriteVarInt(bytes, scriptData.length);
+    if (scriptData.length > 0) memcpy(bytes, scriptData.bytes, scriptData.length);
+    return bytes + scriptData.length;
+}
+
+// Drops cached serialization here and in the owning transaction.
+- (void) invalidatePayload {
+    _payload = nil;
+    _payloadScriptData = nil;
+    [_transaction invalidatePayload];
+}
+
+- (void) setValue:(DMCAmount)value {
+    _value = value;
+    [self invalidatePayload];
+}
+
+- (void) setScript:(DMCScript *)script {
+    _script = script;
+    [self invalidatePayload];
 }
 
 - (NSString*) description {
@@ -169,11 +216,7 @@
 
 - (BOOL) parseData:(NSData*)data {
     if (!data) return NO;
-    NSInputStream* stream = [NSInputStream inputStreamWithData:data];
-    [stream open];
-    BOOL result = [self parseStream:stream];
-    [stream close];
-    return result;
+    return [self parseCursor:[[DMCByteCursor alloc] initWithData:data]];
 }
 
 - (BOOL) parseStream:(NSInputStream*)stream {
@@ -192,6 +235,24 @@
     return YES;
 }
 
+- (BOOL) parseCursor:(DMCByteCursor*)cursor {
+    if (!cursor) return NO;
+    NSUInteger offset = cursor.offset;
+
+    // Script is parsed from a slice of the cursor's buffer.
+    uint64_t value = 0;
+    NSData* scriptData = nil;
+    if (![cursor readUInt64:&value] || !(scriptData = [cursor readVarData])) {
+        cursor.offset = offset;
+        return NO;
+    }
+
+    _value = (DMCAmount)value;
+    _script = [[DMCScript alloc] initWithData:scriptData];
+
+    return YES;
+}
+
 
 
 
@@ -13,7 +13,11 @@
 #import <DaemsCoin/DMCBlock.h>
 #import <DaemsCoin/DMCBlockchainInfo.h>
 #import <DaemsCoin/DMCBlockHeader.h>
+#import <DaemsCoin/DMCBloomFilter.h>
+#import <DaemsCoin/DMCByteCursor.h>
 #import <DaemsCoin/DMCChainCom.h>
+#import <DaemsCoin/DMCCheckpointBundle.h>
+#import <DaemsCoin/DMCChequeIndex.h>
 #import <DaemsCoin/DMCCurrencyConverter.h>
 #import <DaemsCoin/DMCCurvePoint.h>
 #import <DaemsCoin/DMCData.h>
@@ -21,15 +25,21 @@
 #import <DaemsCoin/DMCEncryptedMessage.h>
 #import <DaemsCoin/DMCErrors.h>
 #import <DaemsCoin/DMCFancyEncryptedMessage.h>
+#import <DaemsCoin/DMCHashBackend.h>
 #import <DaemsCoin/DMCHashID.h>
+#import <DaemsCoin/DMCHeaderStore.h>
+#import <DaemsCoin/DMCHeaderTree.h>
+#import <DaemsCoin/DMCHex.h>
 #import <DaemsCoin/DMCKey.h>
 #import <DaemsCoin/DMCKeychain.h>
+#import <DaemsCoin/DMCMerkleBlock.h>
 #import <DaemsCoin/DMCMerkleTree.h>
 #import <DaemsCoin/DMCMnemonic.h>
 #import <DaemsCoin/DMCNetwork.h>
 #import <DaemsCoin/DMCNumberFormatter.h>
 #import <DaemsCoin/DMCOpcode.h>
 #import <DaemsCoin/DMCOutpoint.h>
+#import <DaemsCoin/DMCPBKDF2.h>
 #import <DaemsCoin/DMCPaymentMethod.h>
 #import <DaemsCoin/DMCPaymentMethodDetails.h>
 #import <DaemsCoin/DMCPaymentMethodRequest.h>
@@ -43,7 +53,9 @@
 #import <DaemsCoin/DMCScript.h>
 #import <DaemsCoin/DMCScriptMachine.h>
 #import <DaemsCoin/DMCSecretSharing.h>
+#import <DaemsCoin/DMCSHA256Lanes.h>
 #import <DaemsCoin/DMCSignatureHashType.h>
+#import <DaemsCoin/DMCSignatureHasher.h>
 #import <DaemsCoin/DMCTransaction.h>
 #import <DaemsCoin/DMCTransactionBuilder.h>
 #import <DaemsCoin/DMCTransactionInput.h>
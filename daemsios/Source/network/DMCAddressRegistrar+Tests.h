@@ -0,0 +1,10 @@
+//
+//  DMCAddressRegistrar+Tests.h
+
+#import "DMCAddressRegistrar.h"
+
+@interface DMCAddressRegistrar (Tests)
+
++ (void)runAllTests;
+
+@end
@@ -0,0 +1,122 @@
+//
+//  DMCAddressRegistrar+Tests.m
+
+#import "DMCAddressRegistrar+Tests.h"
+#import "DMCStubPeer.h"
+#import "DMCKeychain.h"
+#import "DMCKey.h"
+#import "DMCAddress.h"
+#import "DMCData.h"
+
+@implementation DMCAddressRegistrar (Tests)
+
++ (void)runAllTests
+{
+    [self testBatching];
+    [self testNodes];
+    [self testPersistence];
+    [self testKeychain];
+}
+
++ (NSString *)temporaryPath
+{
+    return [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+}
+
++ (void)testBatching
+{
+    DMCAddressRegistrar *registrar = [[DMCAddressRegistrar alloc] initWithPath:nil];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+
+    [registrar registerAddresses:@[@"a", @"b", @"c"] withPeer:peer];
+    NSAssert(peer.registrations.count == 1, @"Should register all addresses with one call");
+    NSAssert([peer.registrations[0] isEqual:(@[@"a", @"b", @"c"])], @"Should send every address");
+
+    [registrar registerAddresses:@[@"b", @"d"] withPeer:peer];
+    NSAssert([peer.registrations.lastObject isEqual:@[@"d"]], @"Should not send addresses waiting for a reply");
+
+    [registrar peer:peer registeredAddresses:@[@"a", @"c", @"x"]];
+    NSAssert([registrar isAddress:@"a" registeredWithPeer:peer], @"Should count confirmed addresses as registered");
+    NSAssert(! [registrar isAddress:@"x" registeredWithPeer:peer], @"Should ignore addresses that aren't ours");
+    NSAssert([[registrar pendingAddressesForPeer:peer] isEqual:(@[@"b", @"d"])], @"Unconfirmed addresses should be pending");
+
+    [registrar peer:peer disconnectedWithError:nil];
+    [registrar registerAddresses:@[] withPeer:peer];
+    NSAssert([peer.registrations.lastObject isEqual:(@[@"b", @"d"])], @"Should send unconfirmed addresses again after a disconnect");
+}
+
++ (void)testNodes
+{
+    DMCAddressRegistrar *registrar = [[DMCAddressRegistrar alloc] initWithPath:nil];
+    DMCStubPeer *peer1 = [DMCStubPeer stubPeerWithPort:1], *peer2 = [DMCStubPeer stubPeerWithPort:2];
+
+    [registrar registerAddresses:@[@"a", @"b"] withPeer:peer1];
+    [registrar peer:peer1 registeredAddresses:@[@"a", @"b"]];
+
+    // the wallet reconnects to another node
+    [registrar peer:peer1 disconnectedWithError:nil];
+    [registrar registerAddresses:@[] withPeer:peer2];
+    NSAssert([peer2.registrations.lastObject isEqual:(@[@"a", @"b"])], @"Should register with a node that hasn't confirmed");
+    NSAssert(! [registrar isAddress:@"a" registeredWithPeer:peer2], @"Confirmation of one node should not count for another");
+
+    [registrar peer:peer2 registeredAddresses:@[@"a"]];
+    NSAssert([registrar isAddress:@"a" registeredWithPeer:peer2], @"Should count the other node's confirmation");
+    NSAssert([[registrar pendingAddressesForPeer:peer2] isEqual:@[@"b"]], @"Should track pending addresses per node");
+
+    // a new connection to the first node sends nothing
+    DMCStubPeer *peer1again = [DMCStubPeer stubPeerWithPort:1];
+    [registrar registerAddresses:@[] withPeer:peer1again];
+    NSAssert(peer1again.registrations.count == 0, @"Should not register again with a node that has confirmed");
+}
+
++ (void)testPersistence
+{
+    NSString *path = [self temporaryPath];
+    DMCStubPeer *peer1 = [DMCStubPeer stubPeerWithPort:1], *peer2 = [DMCStubPeer stubPeerWithPort:2];
+    DMCAddressRegistrar *registrar = [[DMCAddressRegistrar alloc] initWithPath:path];
+
+    [registrar registerAddresses:@[@"a", @"b", @"c"] withPeer:peer1];
+    [registrar peer:peer1 registeredAddresses:@[@"a", @"b"]];
+
+    // relaunch
+    registrar = [[DMCAddressRegistrar alloc] initWithPath:path];
+    NSAssert([registrar.addresses isEqual:(@[@"a", @"b", @"c"])], @"Should load the addresses in order");
+    NSAssert([registrar isAddress:@"b" registeredWithPeer:peer1], @"Should load the confirmations");
+
+    [registrar registerAddresses:@[] withPeer:peer1];
+    NSAssert([peer1.registrations.lastObject isEqual:@[@"c"]], @"Should send only what the node hasn't confirmed");
+    [registrar registerAddresses:@[] withPeer:peer2];
+    NSAssert([peer2.registrations.lastObject isEqual:(@[@"a", @"b", @"c"])], @"Should send everything to another node");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
++ (void)testKeychain
+{
+    NSString *path = [self temporaryPath];
+    DMCKeychain *keychain = [[DMCKeychain alloc] initWithSeed:DMCDataFromHex(@"000102030405060708090a0b0c0d0e0f")];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    DMCAddressRegistrar *registrar = [[DMCAddressRegistrar alloc] initWithPath:path];
+
+    registrar.lookahead = 5;
+    [registrar registerKeychain:keychain usedCount:0 withPeer:peer];
+    NSAssert(peer.registrations.count == 1 && [peer.registrations[0] count] == 5, @"Should register the lookahead window in one call");
+    NSAssert([registrar.addresses[0] isEqual:[keychain keyAtIndex:0].address.string], @"Should derive from the first index");
+
+    [registrar registerKeychain:keychain usedCount:0 withPeer:peer];
+    NSAssert(peer.registrations.count == 1, @"Should not derive or send the window again");
+
+    [registrar peer:peer registeredAddresses:registrar.addresses];
+
+    // relaunch after two addresses were used
+    registrar = [[DMCAddressRegistrar alloc] initWithPath:path];
+    registrar.lookahead = 5;
+    [registrar registerKeychain:keychain usedCount:2 withPeer:peer];
+    NSAssert(registrar.addresses.count == 7, @"Should derive only the new indexes");
+    NSAssert([peer.registrations.lastObject isEqual:[registrar.addresses subarrayWithRange:NSMakeRange(5, 2)]],
+             @"Should send only the new addresses");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+@end
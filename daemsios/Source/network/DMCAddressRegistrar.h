@@ -0,0 +1,77 @@
+//
+//  DMCAddressRegistrar.h
+
+#import <Foundation/Foundation.h>
+
+@class DMCPeer, DMCKeychain;
+
+/**
+ 地址注册
+
+ Registers wallet addresses with nodes in batches: addresses are packed many per registeraddr message, and an address
+ counts as registered with a node once that node lists it in a registered reply. Each node (host:port) keeps its own
+ registrations, so connecting to another node registers the addresses there too. The addresses, the nodes that have
+ confirmed them, and how far each keychain has been derived are saved, so a relaunch neither derives an address twice
+ nor registers it again with a node that has confirmed it.
+
+ Not thread safe, use it from the peer delegate queue and forward peer:registeredAddresses: and disconnects to it.
+ */
+@interface DMCAddressRegistrar : NSObject
+
+/**
+ Unused addresses registered past the last used one of each keychain (the gap window), 20 by default.
+ */
+@property (nonatomic, assign) uint32_t lookahead;
+
+/**
+ All addresses to register, in the order they were added or derived.
+ */
+@property (nonatomic, readonly) NSArray *addresses;
+
+/**
+ 以保存注册状态的文件初始化
+
+ @param path file the registration state is saved to, and loaded from if it exists
+ */
+- (instancetype)initWithPath:(NSString *)path;
+
+/**
+ Addresses the peer's node hasn't confirmed yet, including those sent and waiting for a reply.
+ */
+- (NSArray *)pendingAddressesForPeer:(DMCPeer *)peer;
+
+/**
+ Returns YES if the peer's node has confirmed the address.
+ */
+- (BOOL)isAddress:(NSString *)address registeredWithPeer:(DMCPeer *)peer;
+
+/**
+ 注册地址
+
+ Sends the addresses the peer's node hasn't confirmed and that aren't waiting for its reply already.
+
+ @param addresses 地址
+ @param peer connected peer to register with
+ */
+- (void)registerAddresses:(NSArray *)addresses withPeer:(DMCPeer *)peer;
+
+/**
+ 注册keychain的地址窗口
+
+ Derives the keychain's addresses up to usedCount + lookahead, skipping indexes derived on earlier calls, and
+ registers them along with every address the peer's node hasn't confirmed.
+
+ @param keychain BIP32 keychain the addresses are derived from, e.g. an account's external chain
+ @param usedCount number of addresses of the keychain that have been used
+ @param peer connected peer to register with
+ */
+- (void)registerKeychain:(DMCKeychain *)keychain usedCount:(uint32_t)usedCount withPeer:(DMCPeer *)peer;
+
+- (void)peer:(DMCPeer *)peer registeredAddresses:(NSArray *)addresses;
+
+/**
+ Unsent confirmations are lost with the connection, so the addresses waiting on the peer's node will be sent again.
+ */
+- (void)peer:(DMCPeer *)peer disconnectedWithError:(NSError *)error;
+
+@end
@@ -0,0 +1,166 @@
+//
+//  DMCAddressRegistrar.m
+
+#import "DMCAddressRegistrar.h"
+#import "DMCPeer.h"
+#import "DMCKeychain.h"
+#import "DMCNetwork.h"
+#import "DMCKey.h"
+#import "DMCAddress.h"
+#import "DMCData.h"
+
+#if ! PEER_LOGGING
+#define NSLog(...)
+#endif
+
+#define REGISTER_LOOKAHEAD 20
+
+// keys of the saved state
+#define ADDRESSES_KEY  @"addresses"
+#define REGISTERED_KEY @"registeredByNode"
+#define DERIVED_KEY    @"derived"
+
+@implementation DMCAddressRegistrar {
+    NSString *_path;
+    NSMutableOrderedSet *_addresses; // all addresses to register, in the order they were derived
+    NSMutableDictionary *_registered; // node (host:port) -> NSMutableSet of addresses it confirmed
+    NSMutableDictionary *_derived; // keychain identifier (hex) -> number of addresses derived
+    NSMutableDictionary *_sent; // node (host:port) -> NSMutableSet of addresses sent to it, waiting for a reply
+}
+
+- (instancetype)initWithPath:(NSString *)path
+{
+    if (! (self = [super init])) return nil;
+
+    NSDictionary *state = [NSDictionary dictionaryWithContentsOfFile:path];
+
+    _path = path;
+    _lookahead = REGISTER_LOOKAHEAD;
+    _addresses = [NSMutableOrderedSet orderedSetWithArray:state[ADDRESSES_KEY] ?: @[]];
+    _registered = [NSMutableDictionary dictionary];
+    _derived = [state[DERIVED_KEY] mutableCopy] ?: [NSMutableDictionary dictionary];
+    _sent = [NSMutableDictionary dictionary];
+
+    [state[REGISTERED_KEY] enumerateKeysAndObjectsUsingBlock:^(NSString *node, NSArray *addresses, BOOL *stop) {
+        _registered[node] = [NSMutableSet setWithArray:addresses];
+    }];
+
+    return self;
+}
+
+- (NSArray *)addresses
+{
+    return _addresses.array;
+}
+
+// addresses are registered with each node separately, so a reconnect to another node registers them there too
+- (NSString *)nodeForPeer:(DMCPeer *)peer
+{
+    return [NSString stringWithFormat:@"%@:%u", peer.host, peer.port];
+}
+
+- (NSArray *)pendingAddressesForPeer:(DMCPeer *)peer
+{
+    NSSet *registered = _registered[[self nodeForPeer:peer]];
+    NSMutableArray *pending = [NSMutableArray array];
+
+    for (NSString *address in _addresses) {
+        if (! [registered containsObject:address]) [pending addObject:address];
+    }
+
+    return pending;
+}
+
+- (BOOL)isAddress:(NSString *)address registeredWithPeer:(DMCPeer *)peer
+{
+    return [_registered[[self nodeForPeer:peer]] containsObject:address];
+}
+
+- (void)registerAddresses:(NSArray *)addresses withPeer:(DMCPeer *)peer
+{
+    NSUInteger count = _addresses.count;
+
+    [_addresses addObjectsFromArray:addresses];
+    if (_addresses.count != count) [self save];
+    [self sendPendingWithPeer:peer];
+}
+
+- (void)registerKeychain:(DMCKeychain *)keychain usedCount:(uint32_t)usedCount withPeer:(DMCPeer *)peer
+{
+    NSString *identifier = DMCHexFromData(keychain.identifier);
+    uint32_t derived = [_derived[identifier] unsignedIntValue], end = usedCount + self.lookahead;
+
+    if (derived < end) {
+        for (uint32_t i = derived; i < end; i++) {
+            DMCKey *key = [keychain keyAtIndex:i];
+            DMCAddress *address = (keychain.network.isTestnet) ? key.addressTestnet : key.address;
+
+            [_addresses addObject:address.string];
+        }
+
+        NSLog(@"derived addresses %u-%u of keychain %@ for registration", derived, end - 1, identifier);
+        _derived[identifier] = @(end);
+        [self save];
+    }
+
+    [self sendPendingWithPeer:peer];
+}
+
+// sends the addresses the peer's node hasn't confirmed and that aren't waiting for a reply from it
+- (void)sendPendingWithPeer:(DMCPeer *)peer
+{
+    NSString *node = [self nodeForPeer:peer];
+    NSSet *registered = _registered[node];
+    NSMutableSet *sent = _sent[node] ?: (_sent[node] = [NSMutableSet set]);
+    NSMutableArray *addresses = [NSMutableArray array];
+
+    for (NSString *address in _addresses) {
+        if ([registered containsObject:address] || [sent containsObject:address]) continue;
+        [sent addObject:address];
+        [addresses addObject:address];
+    }
+
+    if (addresses.count == 0) return;
+    [peer sendRegisteraddrMessageWithAddresses:addresses];
+}
+
+- (void)save
+{
+    NSMutableDictionary *registered = [NSMutableDictionary dictionaryWithCapacity:_registered.count];
+
+    [_registered enumerateKeysAndObjectsUsingBlock:^(NSString *node, NSSet *addresses, BOOL *stop) {
+        registered[node] = addresses.allObjects;
+    }];
+
+    NSDictionary *state = @{ADDRESSES_KEY:_addresses.array, REGISTERED_KEY:registered, DERIVED_KEY:_derived};
+
+    if (_path && ! [state writeToFile:_path atomically:YES]) {
+        NSLog(@"failed to save address registration to %@", _path);
+    }
+}
+
+// MARK: - replies
+
+- (void)peer:(DMCPeer *)peer registeredAddresses:(NSArray *)addresses
+{
+    NSString *node = [self nodeForPeer:peer];
+    NSMutableSet *registered = _registered[node] ?: [NSMutableSet set];
+    NSUInteger count = registered.count;
+
+    for (NSString *address in addresses) {
+        if (! [_addresses containsObject:address]) continue; // not ours
+        [_sent[node] removeObject:address];
+        [registered addObject:address];
+    }
+
+    if (registered.count == count) return; // nothing new, or confirmed twice
+    _registered[node] = registered;
+    [self save];
+}
+
+- (void)peer:(DMCPeer *)peer disconnectedWithError:(NSError *)error
+{
+    [_sent removeObjectForKey:[self nodeForPeer:peer]];
+}
+
+@end
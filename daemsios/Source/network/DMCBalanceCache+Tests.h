@@ -0,0 +1,10 @@
+//
+//  DMCBalanceCache+Tests.h
+
+#import "DMCBalanceCache.h"
+
+@interface DMCBalanceCache (Tests)
+
++ (void)runAllTests;
+
+@end
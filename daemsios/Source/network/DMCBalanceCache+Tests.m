@@ -0,0 +1,135 @@
+//
+//  DMCBalanceCache+Tests.m
+
+#import "DMCBalanceCache+Tests.h"
+#import "DMCStubPeer.h"
+
+@implementation DMCBalanceCache (Tests)
+
++ (void)runAllTests
+{
+    [self testBatching];
+    [self testReplies];
+    [self testFreshness];
+    [self testDisconnect];
+    [self testTimeout];
+}
+
++ (void)testBatching
+{
+    DMCBalanceCache *cache = [DMCBalanceCache new];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+
+    [cache refreshAddresses:@[@"a", @"b", @"c"] withPeer:peer completion:nil];
+    NSAssert(peer.balanceQueries.count == 1, @"Should query all addresses with one call");
+    NSAssert([peer.balanceQueries[0] isEqual:(@[@"a", @"b", @"c"])], @"Should query every stale address");
+
+    [cache refreshAddresses:@[@"b", @"c", @"d"] withPeer:peer completion:nil];
+    NSAssert(peer.balanceQueries.count == 2, @"Should query the new address");
+    NSAssert([peer.balanceQueries[1] isEqual:@[@"d"]], @"Should not query addresses already being queried");
+
+    [cache refreshAddresses:@[@"a", @"d"] withPeer:peer completion:nil];
+    NSAssert(peer.balanceQueries.count == 2, @"Should not send anything when every address is being queried");
+}
+
++ (void)testReplies
+{
+    DMCBalanceCache *cache = [DMCBalanceCache new];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    __block NSDictionary *first = nil, *second = nil;
+    __block NSUInteger calls = 0;
+
+    [cache refreshAddresses:@[@"a", @"b"] withPeer:peer completion:^(NSDictionary *balances, NSError *error) {
+        NSAssert(! error, @"Should not fail");
+        first = balances;
+        calls++;
+    }];
+    [cache refreshAddresses:@[@"b", @"c"] withPeer:peer completion:^(NSDictionary *balances, NSError *error) {
+        NSAssert(! error, @"Should not fail");
+        second = balances;
+        calls++;
+    }];
+
+    // replies come in any order, split over several messages
+    [cache peer:peer relayedBalances:@{@"c":@3}];
+    NSAssert(calls == 0, @"Should wait for all addresses of a refresh");
+    [cache peer:peer relayedBalances:@{@"b":@2, @"x":@9}];
+    NSAssert(calls == 1 && [second isEqual:(@{@"b":@2, @"c":@3})], @"Should complete the refresh whose addresses all arrived");
+    [cache peer:peer relayedBalances:@{@"a":@1}];
+    NSAssert(calls == 2 && [first isEqual:(@{@"a":@1, @"b":@2})], @"Should complete the other refresh");
+
+    [cache peer:peer relayedBalances:@{@"a":@1}];
+    NSAssert(calls == 2, @"Should complete each refresh once");
+    NSAssert([[cache balanceForAddress:@"a"] isEqual:@1], @"Should cache the balance");
+    NSAssert(! [cache balanceForAddress:@"d"], @"Should have no balance for an address never queried");
+}
+
++ (void)testFreshness
+{
+    DMCBalanceCache *cache = [DMCBalanceCache new];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    __block NSDictionary *result = nil;
+
+    [cache refreshAddresses:@[@"a", @"b"] withPeer:peer completion:nil];
+    [cache peer:peer relayedBalances:@{@"a":@1, @"b":@2}];
+    NSAssert([cache staleAddresses:(@[@"a", @"b", @"c"])].count == 1, @"Only the unknown address should be stale");
+
+    [cache refreshAddresses:@[@"a", @"b"] withPeer:peer completion:^(NSDictionary *balances, NSError *error) {
+        result = balances;
+    }];
+    NSAssert(peer.balanceQueries.count == 1, @"Should not query fresh balances");
+    NSAssert([result isEqual:(@{@"a":@1, @"b":@2})], @"Should complete right away from the cache");
+
+    [cache invalidateAddresses:@[@"b"]];
+    [cache refreshAddresses:@[@"a", @"b"] withPeer:peer completion:nil];
+    NSAssert([peer.balanceQueries.lastObject isEqual:@[@"b"]], @"Should query the invalidated address only");
+    NSAssert([[cache balanceForAddress:@"b"] isEqual:@2], @"Should keep the old balance until a new one arrives");
+
+    cache.maxAge = 0;
+    NSAssert([cache staleAddresses:@[@"a"]].count == 1, @"Should be stale past maxAge");
+}
+
++ (void)testDisconnect
+{
+    DMCBalanceCache *cache = [DMCBalanceCache new];
+    DMCStubPeer *peer1 = [DMCStubPeer stubPeerWithPort:1], *peer2 = [DMCStubPeer stubPeerWithPort:2];
+    __block NSError *error1 = nil, *error2 = nil;
+
+    [cache refreshAddresses:@[@"a"] withPeer:peer1 completion:^(NSDictionary *balances, NSError *error) {
+        error1 = error;
+    }];
+    [cache refreshAddresses:@[@"b"] withPeer:peer2 completion:^(NSDictionary *balances, NSError *error) {
+        error2 = error;
+    }];
+
+    [cache peer:peer1 disconnectedWithError:nil];
+    NSAssert(error1, @"Should fail the refresh waiting on the disconnected peer");
+    NSAssert(! error2, @"Should not fail refreshes waiting on another peer");
+
+    [cache refreshAddresses:@[@"a", @"b"] withPeer:peer2 completion:nil];
+    NSAssert([peer2.balanceQueries.lastObject isEqual:@[@"a"]], @"Should query the lost address from another peer");
+}
+
++ (void)testTimeout
+{
+    DMCBalanceCache *cache = [DMCBalanceCache new];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    __block NSError *result = nil;
+
+    [cache refreshAddresses:@[@"a"] withPeer:peer completion:^(NSDictionary *balances, NSError *error) {
+        result = error;
+    }];
+
+    [cache expireRequests];
+    NSAssert(! result, @"Should keep waiting within requestTimeout");
+
+    cache.requestTimeout = 0; // the peer stays connected and never replies
+    [cache expireRequests];
+    NSAssert(result.code == DAEMSCOIN_TIMEOUT_CODE, @"Should fail the refresh with a timeout");
+
+    cache.requestTimeout = 30;
+    [cache refreshAddresses:@[@"a"] withPeer:peer completion:nil];
+    NSAssert(peer.balanceQueries.count == 2, @"Should query the address again after the timeout");
+}
+
+@end
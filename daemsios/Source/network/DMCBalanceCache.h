@@ -0,0 +1,74 @@
+//
+//  DMCBalanceCache.h
+
+#import <Foundation/Foundation.h>
+
+@class DMCPeer;
+
+/**
+ 地址余额缓存
+
+ Keeps the last balance a node reported for each address, and batches refreshes: one call queries any number of
+ addresses with getbalancebyaddr, skipping addresses whose cached balance is still fresh or already being queried.
+ Replies are matched to requests by address, so they can arrive in any order and split over several messages.
+
+ Not thread safe, use it from the peer delegate queue and forward peer:relayedBalances: and disconnects to it.
+ */
+@interface DMCBalanceCache : NSObject
+
+/**
+ Seconds a balance stays fresh, 60 by default.
+ */
+@property (nonatomic, assign) NSTimeInterval maxAge;
+
+/**
+ Seconds to wait for a reply before an address can be queried again and the refreshes waiting on it fail,
+ 30 by default.
+ */
+@property (nonatomic, assign) NSTimeInterval requestTimeout;
+
+/**
+ Cached balance (int64), or nil if the address was never queried.
+ */
+- (NSNumber *)balanceForAddress:(NSString *)address;
+
+/**
+ Addresses that have no cached balance or whose balance is older than maxAge.
+ */
+- (NSArray *)staleAddresses:(NSArray *)addresses;
+
+/**
+ Marks cached balances as stale, e.g. after a transaction touching these addresses was seen.
+ */
+- (void)invalidateAddresses:(NSArray *)addresses;
+
+/**
+ 查询余额
+
+ Queries the stale addresses that aren't already being queried with as few messages as possible.
+
+ @param addresses addresses to refresh
+ @param peer connected peer to query
+ @param completion called with the balances of all addresses once each one is fresh, or with an error if the peer
+ disconnects or requestTimeout passes first; called right away if nothing was stale. May be nil.
+ */
+- (void)refreshAddresses:(NSArray *)addresses withPeer:(DMCPeer *)peer
+completion:(void (^)(NSDictionary *balances, NSError *error))completion;
+
+/**
+ Fails the refreshes made more than requestTimeout ago, e.g. when a peer stays connected but never replies.
+ Called on the peer delegate queue once requestTimeout passes after each refresh.
+ */
+- (void)expireRequests;
+
+/**
+ Updates the cache from a balancebyaddr reply and completes the requests it satisfies.
+ */
+- (void)peer:(DMCPeer *)peer relayedBalances:(NSDictionary *)balances;
+
+/**
+ Fails the requests still waiting on this peer, their addresses can be queried from another peer.
+ */
+- (void)peer:(DMCPeer *)peer disconnectedWithError:(NSError *)error;
+
+@end
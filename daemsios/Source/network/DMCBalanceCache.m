@@ -0,0 +1,211 @@
+//
+//  DMCBalanceCache.m
+
+#import "DMCBalanceCache.h"
+#import "DMCPeer.h"
+#import "DMCPeerReactor.h"
+
+#define BALANCE_MAX_AGE         60.0
+#define BALANCE_REQUEST_TIMEOUT 30.0
+
+@interface DMCBalanceRequest : NSObject
+
+@property (nonatomic, strong) NSArray *addresses;
+@property (nonatomic, strong) NSMutableSet *remaining; // addresses still waiting for a reply
+@property (nonatomic, strong) NSDate *date; // when the request was made
+@property (nonatomic, copy) void (^completion)(NSDictionary *balances, NSError *error);
+
+@end
+
+@implementation DMCBalanceRequest
+
+@end
+
+
+@implementation DMCBalanceCache {
+    NSMutableDictionary *_balances; // address -> NSNumber
+    NSMutableDictionary *_updated; // address -> NSDate of the last reply
+    NSMutableDictionary *_queried; // address -> NSDate the pending query was sent
+    NSMapTable *_queriedPeers; // address -> peer the pending query was sent to
+    NSMutableArray *_requests;
+}
+
+- (instancetype)init
+{
+    if (! (self = [super init])) return nil;
+
+    _maxAge = BALANCE_MAX_AGE;
+    _requestTimeout = BALANCE_REQUEST_TIMEOUT;
+    _balances = [NSMutableDictionary dictionary];
+    _updated = [NSMutableDictionary dictionary];
+    _queried = [NSMutableDictionary dictionary];
+    _queriedPeers = [NSMapTable strongToWeakObjectsMapTable];
+    _requests = [NSMutableArray array];
+    return self;
+}
+
+- (NSNumber *)balanceForAddress:(NSString *)address
+{
+    return _balances[address];
+}
+
+- (NSArray *)staleAddresses:(NSArray *)addresses
+{
+    NSMutableArray *stale = [NSMutableArray array];
+
+    for (NSString *address in addresses) {
+        NSDate *updated = _updated[address];
+
+        if (! updated || -updated.timeIntervalSinceNow > self.maxAge) [stale addObject:address];
+    }
+
+    return stale;
+}
+
+- (void)invalidateAddresses:(NSArray *)addresses
+{
+    [_updated removeObjectsForKeys:addresses];
+}
+
+- (void)refreshAddresses:(NSArray *)addresses withPeer:(DMCPeer *)peer
+completion:(void (^)(NSDictionary *balances, NSError *error))completion
+{
+    NSArray *stale = [self staleAddresses:addresses];
+    NSMutableArray *query = [NSMutableArray array];
+
+    for (NSString *address in stale) {
+        NSDate *queried = _queried[address];
+
+        if (queried && -queried.timeIntervalSinceNow < self.requestTimeout) continue; // reply is on its way
+        _queried[address] = [NSDate date];
+        [_queriedPeers setObject:peer forKey:address];
+        [query addObject:address];
+    }
+
+    if (stale.count == 0) {
+        if (completion) completion([self balancesForAddresses:addresses], nil);
+        return;
+    }
+
+    DMCBalanceRequest *request = [DMCBalanceRequest new];
+
+    request.addresses = addresses;
+    request.remaining = [NSMutableSet setWithArray:stale];
+    request.date = [NSDate date];
+    request.completion = completion;
+    [_requests addObject:request];
+    if (query.count > 0) [peer sendGetbalancebyaddrMessageWithAddresses:query];
+    [self scheduleExpiryOnQueue:peer.delegateQueue];
+}
+
+// the cache is used from the peer delegate queue, so the timeout fires there too
+- (void)scheduleExpiryOnQueue:(dispatch_queue_t)queue
+{
+    __weak DMCBalanceCache *weakSelf = self;
+
+    if (! queue) queue = dispatch_get_main_queue();
+    // a tick (0.1s) late, timers may fire up to a tick early
+    [[DMCPeerReactor sharedReactor] scheduleTimer:self.requestTimeout + 0.1 handler:^{
+        dispatch_async(queue, ^{
+            [weakSelf expireRequests];
+        });
+    }];
+}
+
+- (void)expireRequests
+{
+    NSMutableArray *expired = [NSMutableArray array];
+
+    for (DMCBalanceRequest *request in _requests) {
+        if (-request.date.timeIntervalSinceNow >= self.requestTimeout) [expired addObject:request];
+    }
+
+    if (expired.count == 0) return;
+    [_requests removeObjectsInArray:expired];
+
+    // unanswered queries are dropped, so the addresses can be queried again
+    for (NSString *address in _queried.allKeys) {
+        if (-[_queried[address] timeIntervalSinceNow] < self.requestTimeout) continue;
+        [_queried removeObjectForKey:address];
+        [_queriedPeers removeObjectForKey:address];
+    }
+
+    NSError *error = [NSError errorWithDomain:@"Daems" code:DAEMSCOIN_TIMEOUT_CODE userInfo:@{NSLocalizedDescriptionKey:
+                      @"peer did not send all balances in time"}];
+
+    for (DMCBalanceRequest *request in expired) {
+        if (request.completion) request.completion(nil, error);
+    }
+}
+
+- (NSDictionary *)balancesForAddresses:(NSArray *)addresses
+{
+    NSMutableDictionary *balances = [NSMutableDictionary dictionaryWithCapacity:addresses.count];
+
+    for (NSString *address in addresses) {
+        if (_balances[address]) balances[address] = _balances[address];
+    }
+
+    return balances;
+}
+
+- (void)peer:(DMCPeer *)peer relayedBalances:(NSDictionary *)balances
+{
+    NSDate *now = [NSDate date];
+    NSMutableArray *completed = [NSMutableArray array];
+
+    [_balances addEntriesFromDictionary:balances];
+    [_queried removeObjectsForKeys:balances.allKeys];
+
+    for (NSString *address in balances) {
+        _updated[address] = now;
+        [_queriedPeers removeObjectForKey:address];
+    }
+
+    NSSet *received = [NSSet setWithArray:balances.allKeys];
+
+    for (DMCBalanceRequest *request in _requests) {
+        if (! [request.remaining intersectsSet:received]) continue;
+        [request.remaining minusSet:received];
+        if (request.remaining.count == 0) [completed addObject:request];
+    }
+
+    [_requests removeObjectsInArray:completed];
+
+    for (DMCBalanceRequest *request in completed) {
+        if (request.completion) request.completion([self balancesForAddresses:request.addresses], nil);
+    }
+}
+
+- (void)peer:(DMCPeer *)peer disconnectedWithError:(NSError *)error
+{
+    NSMutableSet *lost = [NSMutableSet set];
+    NSMutableArray *failed = [NSMutableArray array];
+
+    for (NSString *address in _queried) {
+        DMCPeer *queriedPeer = [_queriedPeers objectForKey:address];
+
+        if (! queriedPeer || queriedPeer == peer) [lost addObject:address];
+    }
+
+    // let another peer query them right away
+    [_queried removeObjectsForKeys:lost.allObjects];
+    for (NSString *address in lost) [_queriedPeers removeObjectForKey:address];
+
+    for (DMCBalanceRequest *request in _requests) {
+        if ([request.remaining intersectsSet:lost]) [failed addObject:request];
+    }
+
+    [_requests removeObjectsInArray:failed];
+
+    if (! error) {
+        error = [NSError errorWithDomain:@"Daems" code:500 userInfo:@{NSLocalizedDescriptionKey:
+                 @"peer disconnected before sending all balances"}];
+    }
+
+    for (DMCBalanceRequest *request in failed) {
+        if (request.completion) request.completion(nil, error);
+    }
+}
+
+@end
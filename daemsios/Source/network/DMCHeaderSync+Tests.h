@@ -0,0 +1,10 @@
+//
+//  DMCHeaderSync+Tests.h
+
+#import "DMCHeaderSync.h"
+
+@interface DMCHeaderSync (Tests)
+
++ (void)runAllTests;
+
+@end
@@ -0,0 +1,159 @@
+//
+//  DMCHeaderSync+Tests.m
+
+#import "DMCHeaderSync+Tests.h"
+#import "DMCHeaderStore.h"
+#import "DMCBlockHeader+Tests.h"
+#import "DMCBigNumber.h"
+#import "DMCData.h"
+#import "DMCStubPeer.h"
+
+// records delegate calls
+@interface DMCHeaderSyncRecorder : NSObject<DMCHeaderSyncDelegate>
+
+@property (nonatomic, assign) uint32_t syncedHeight;
+@property (nonatomic, assign) int64_t reorganizedHeight;
+@property (nonatomic, assign) NSUInteger finished;
+@property (nonatomic, strong) NSError *invalidHeadersError;
+
+@end
+
+@implementation DMCHeaderSyncRecorder
+
+- (instancetype)init
+{
+    if (! (self = [super init])) return nil;
+
+    _reorganizedHeight = -1;
+    return self;
+}
+
+- (void)headerSync:(DMCHeaderSync *)sync syncedToHeight:(uint32_t)height
+{
+    self.syncedHeight = height;
+}
+
+- (void)headerSync:(DMCHeaderSync *)sync finishedWithPeer:(DMCPeer *)peer
+{
+    self.finished++;
+}
+
+- (void)headerSync:(DMCHeaderSync *)sync reorganizedAboveHeight:(uint32_t)height
+{
+    self.reorganizedHeight = height;
+}
+
+- (void)headerSync:(DMCHeaderSync *)sync peer:(DMCPeer *)peer sentInvalidHeaders:(NSError *)error
+{
+    self.invalidHeadersError = error;
+}
+
+@end
+
+@implementation DMCHeaderSync (Tests)
+
++ (void)runAllTests
+{
+    [self testReorganization];
+    [self testWeakerFork];
+    [self testInvalidFork];
+}
+
+// headers message payload without the count: each header followed by a zero tx count
++ (NSData *)messageWithHeaders:(NSArray *)headers
+{
+    NSMutableData *data = [NSMutableData data];
+    uint8_t txCount = 0;
+
+    for (DMCBlockHeader *header in headers) {
+        [data appendData:header.data];
+        [data appendBytes:&txCount length:1];
+    }
+
+    return data;
+}
+
+// store with a mined 10-header chain, and a sync that has asked the stub for headers past it
++ (DMCHeaderSync *)syncWithChain:(NSArray *)chain path:(NSString *)path peer:(DMCStubPeer *)peer
+recorder:(DMCHeaderSyncRecorder *)recorder
+{
+    DMCHeaderStore *store = [[DMCHeaderStore alloc] initWithPath:path error:NULL];
+    NSMutableData *data = [NSMutableData data];
+
+    for (DMCBlockHeader *header in chain) {
+        [data appendData:header.data];
+    }
+
+    NSAssert([store appendHeaders:data.bytes stride:80 count:chain.count appended:NULL error:NULL], @"Should store the chain");
+
+    DMCHeaderSync *sync = [[DMCHeaderSync alloc] initWithStore:store];
+
+    sync.delegate = recorder;
+    [sync syncWithPeer:peer];
+    NSAssert(peer.headerRequests.count == 1, @"Should request headers past the tip");
+    return sync;
+}
+
++ (void)testReorganization
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    NSArray *main = [DMCBlockHeader minedChainWithCount:10 previousHash:DMCZero256() bits:0x207fffff nonce:0];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    DMCHeaderSyncRecorder *recorder = [DMCHeaderSyncRecorder new];
+    DMCHeaderSync *sync = [self syncWithChain:main path:path peer:peer recorder:recorder];
+
+    // the peer's chain replaced the stored tip at height 9 with two blocks
+    NSArray *fork = [DMCBlockHeader minedChainWithCount:2 previousHash:[main[8] blockHash] bits:0x207fffff nonce:1000];
+
+    [sync peer:peer relayedHeaders:[self messageWithHeaders:fork] count:fork.count];
+    NSAssert(! recorder.invalidHeadersError, @"Headers of a better fork are valid");
+    NSAssert(recorder.reorganizedHeight == 8, @"Should report the fork point");
+    NSAssert(sync.store.tipHeight == 10 && recorder.syncedHeight == 10, @"Should sync to the fork's tip");
+    NSAssert([[sync.store headerDataAtHeight:9] isEqual:[fork[0] data]], @"Should replace the orphaned tip");
+    NSAssert([sync.store.tipHash isEqual:[fork[1] blockHash]], @"Tip should be the fork's tip");
+    NSAssert([[sync.store headerDataAtHeight:8] isEqual:[main[8] data]], @"Should keep the chain below the fork");
+    NSAssert(recorder.finished == 1, @"A short batch finishes the sync");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
++ (void)testWeakerFork
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    NSArray *main = [DMCBlockHeader minedChainWithCount:10 previousHash:DMCZero256() bits:0x207fffff nonce:0];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    DMCHeaderSyncRecorder *recorder = [DMCHeaderSyncRecorder new];
+    DMCHeaderSync *sync = [self syncWithChain:main path:path peer:peer recorder:recorder];
+
+    // same work as the stored tip, the first seen chain stays
+    NSArray *fork = [DMCBlockHeader minedChainWithCount:1 previousHash:[main[8] blockHash] bits:0x207fffff nonce:1000];
+
+    [sync peer:peer relayedHeaders:[self messageWithHeaders:fork] count:fork.count];
+    NSAssert(! recorder.invalidHeadersError, @"A fork with equal work is not invalid");
+    NSAssert(recorder.reorganizedHeight == -1, @"Should not reorganize");
+    NSAssert([sync.store.tipHash isEqual:[main[9] blockHash]], @"Should keep the stored tip");
+    NSAssert(recorder.finished == 1, @"A short batch finishes the sync");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
++ (void)testInvalidFork
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSUUID UUID] UUIDString]];
+    NSArray *main = [DMCBlockHeader minedChainWithCount:10 previousHash:DMCZero256() bits:0x207fffff nonce:0];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    DMCHeaderSyncRecorder *recorder = [DMCHeaderSyncRecorder new];
+    DMCHeaderSync *sync = [self syncWithChain:main path:path peer:peer recorder:recorder];
+
+    // a single header claiming a huge amount of work it was never mined for
+    NSArray *fork = [DMCBlockHeader chainWithCount:1 previousHash:[main[8] blockHash] bits:0x03000001 nonce:0];
+
+    [sync peer:peer relayedHeaders:[self messageWithHeaders:fork] count:fork.count];
+    NSAssert(recorder.invalidHeadersError, @"Should report headers that fail proof of work");
+    NSAssert(recorder.reorganizedHeight == -1, @"Should not reorganize");
+    NSAssert([sync.store.tipHash isEqual:[main[9] blockHash]] && sync.store.tipHeight == 9, @"Should keep the stored chain");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:NULL];
+}
+
+@end
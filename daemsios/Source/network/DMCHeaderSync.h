@@ -0,0 +1,89 @@
+//
+//  DMCHeaderSync.h
+
+#import <Foundation/Foundation.h>
+
+@class DMCPeer, DMCHeaderStore, DMCHeaderSync, DMCNetwork, DMCKey;
+
+@protocol DMCHeaderSyncDelegate<NSObject>
+@required
+
+// a batch of headers was stored, height is the new tip
+- (void)headerSync:(DMCHeaderSync *)sync syncedToHeight:(uint32_t)height;
+
+@optional
+
+// the peer has no headers past our tip
+- (void)headerSync:(DMCHeaderSync *)sync finishedWithPeer:(DMCPeer *)peer;
+
+// the stored chain above the height was replaced by a fork with more work, blocks above it are no longer in the chain;
+// called before headerSync:syncedToHeight: reports the new tip
+- (void)headerSync:(DMCHeaderSync *)sync reorganizedAboveHeight:(uint32_t)height;
+
+// the peer sent headers that don't link to the stored chain or fail proof of work, the caller decides whether to
+// disconnect it
+- (void)headerSync:(DMCHeaderSync *)sync peer:(DMCPeer *)peer sentInvalidHeaders:(NSError *)error;
+
+@end
+
+/**
+ 区块头同步
+
+ Headers-first sync: requests headers with getheaders, hashes each batch of up to 2000 in one pass, checks that every
+ header links to the previous one, and appends them to a DMCHeaderStore. A full batch means the peer has more, so the
+ next one is requested from the last header it sent right away.
+
+ Headers that fork from the stored chain below its tip go into a DMCHeaderTree together with the stored headers above
+ the fork point. Once the fork has more work the store is truncated to the fork point and the fork is appended.
+
+ An empty store is seeded from the checkpoint bundle shipped for the network before the first request, so a fresh
+ install syncs only the headers after the last checkpoint a week before the wallet's earliest key time.
+
+ Not thread safe, use it from the peer delegate queue and forward peer:relayedHeaders:count: and disconnects to it.
+ */
+@interface DMCHeaderSync : NSObject
+
+@property (nonatomic, weak) id<DMCHeaderSyncDelegate> delegate;
+@property (nonatomic, readonly) DMCHeaderStore *store;
+
+/**
+ Network whose checkpoint bundle resource seeds an empty store, mainnet by default.
+ */
+@property (nonatomic, strong) DMCNetwork *network;
+
+/**
+ Key the checkpoint bundle must be signed with. While it is nil no bundle is trusted, so an empty store is not seeded
+ and the caller has to append the genesis header to it.
+ */
+@property (nonatomic, strong) DMCKey *checkpointPublicKey;
+
+/**
+ 以区块头存储初始化
+
+ @param store header store; if it is empty it is seeded from the checkpoint bundle when syncing starts
+ */
+- (instancetype)initWithStore:(DMCHeaderStore *)store;
+
+/**
+ 载入检查点
+
+ Starts an empty store at the last checkpoint of the network's bundle at least a week before the time. Does nothing
+ and returns YES if the store already has headers.
+
+ @param time wallet creation time (interval since reference date, like DMCPeer.earliestKeyTime)
+ @param error set if the store stays empty: the bundle isn't shipped, checkpointPublicKey is nil or doesn't match,
+ the bundle is damaged or made for another network, or no checkpoint is old enough
+ @return YES if the store has headers
+ */
+- (BOOL)loadCheckpointBeforeTime:(NSTimeInterval)time error:(NSError **)error;
+
+/**
+ Starts requesting headers past the stored tip from the peer, seeding an empty store from the checkpoint before the
+ peer's earliestKeyTime first. Headers from other peers are ignored until it finishes.
+ */
+- (void)syncWithPeer:(DMCPeer *)peer;
+
+- (void)peer:(DMCPeer *)peer relayedHeaders:(NSData *)headers count:(NSUInteger)count;
+- (void)peer:(DMCPeer *)peer disconnectedWithError:(NSError *)error;
+
+@end
@@ -0,0 +1,234 @@
+//
+//  DMCHeaderSync.m
+
+#import "DMCHeaderSync.h"
+#import "DMCHeaderStore.h"
+#import "DMCHeaderTree.h"
+#import "DMCBlockHeader.h"
+#import "DMCCheckpointBundle.h"
+#import "DMCNetwork.h"
+#import "DMCPeer.h"
+#import "NSData+DaemsCoin.h"
+
+#if ! PEER_LOGGING
+#define NSLog(...)
+#endif
+
+#define HEADER_LENGTH      80
+#define HEADER_STRIDE      81 // header followed by a zero tx count
+#define MAX_HEADERS_BATCH  2000
+
+@implementation DMCHeaderSync {
+    __weak DMCPeer *_peer;
+    DMCHeaderTree *_tree; // stored chain above a fork point and the peer's fork, while the peer is on another branch
+    NSData *_lastHash; // last header the peer sent, the next request continues from it
+}
+
+- (instancetype)initWithStore:(DMCHeaderStore *)store
+{
+    if (! (self = [super init])) return nil;
+
+    _store = store;
+    _network = [DMCNetwork mainnet];
+    return self;
+}
+
+- (BOOL)loadCheckpointBeforeTime:(NSTimeInterval)time error:(NSError **)error
+{
+    if (self.store.count > 0) return YES;
+
+    NSString *path = [DMCCheckpointBundle resourcePathForNetwork:self.network];
+
+    if (! path) {
+        if (error) *error = [NSError errorWithDomain:NSCocoaErrorDomain code:NSFileReadNoSuchFileError userInfo:nil];
+        return NO;
+    }
+
+    // a nil key fails the signature check, an untrusted bundle is never loaded
+    DMCCheckpointBundle *bundle = [[DMCCheckpointBundle alloc] initWithContentsOfFile:path network:self.network
+                                   publicKey:self.checkpointPublicKey error:error];
+
+    if (! bundle || ! [bundle loadCheckpointBeforeTime:time intoStore:self.store error:error]) return NO;
+    NSLog(@"header store starts at checkpoint height %u", self.store.baseHeight);
+    return YES;
+}
+
+- (void)syncWithPeer:(DMCPeer *)peer
+{
+    NSMutableArray *locators = [NSMutableArray array];
+    NSError *error = nil;
+
+    if (! [self loadCheckpointBeforeTime:peer.earliestKeyTime error:&error]) {
+        NSLog(@"%@:%u no checkpoint for an empty header store: %@", peer.host, peer.port, error);
+    }
+
+    for (NSData *hash in [self.store blockLocatorHashes]) {
+        [locators addObject:uint256_obj([hash hashAtOffset:0])];
+    }
+
+    if (locators.count == 0) {
+        NSLog(@"%@:%u can't sync headers, the header store is empty", peer.host, peer.port);
+        return;
+    }
+
+    _peer = peer;
+    _tree = nil;
+    _lastHash = nil;
+    [peer sendGetheadersMessageWithLocators:locators andHashStop:UINT256_ZERO];
+}
+
+- (void)peer:(DMCPeer *)peer relayedHeaders:(NSData *)headers count:(NSUInteger)count
+{
+    if (peer != _peer) return;
+
+    const uint8_t *bytes = headers.bytes;
+    NSUInteger skip = 0, appended = 0;
+    NSError *error = nil;
+
+    // the locator can be behind the tip, skip headers that are already stored
+    int64_t height = (count > 0) ? [self.store heightForBlockHash:[NSData dataWithBytes:bytes + 4 length:32]] : -1;
+
+    while (height >= 0 && skip < count && height + 1 + skip <= self.store.tipHeight &&
+           [[self.store headerDataAtHeight:(uint32_t)(height + 1 + skip)]
+            isEqual:[NSData dataWithBytesNoCopy:(void *)(bytes + skip*HEADER_STRIDE) length:HEADER_LENGTH
+                     freeWhenDone:NO]]) {
+        skip++;
+    }
+
+    if (count > 0) {
+        UInt256 lastHash = [NSData dataWithBytesNoCopy:(void *)(bytes + (count - 1)*HEADER_STRIDE) length:HEADER_LENGTH
+                            freeWhenDone:NO].SHA256_2;
+
+        _lastHash = [NSData dataWithBytes:&lastHash length:sizeof(lastHash)];
+    }
+
+    if (skip < count) {
+        NSData *previousHash = [NSData dataWithBytes:bytes + skip*HEADER_STRIDE + 4 length:32];
+        BOOL linked;
+
+        if (! _tree && (self.store.count == 0 || [previousHash isEqual:self.store.tipHash])) { // extends the tip
+            linked = [self.store appendHeaders:bytes + skip*HEADER_STRIDE stride:HEADER_STRIDE count:count - skip
+                      appended:&appended error:&error];
+        }
+        else linked = [self followFork:bytes + skip*HEADER_STRIDE count:count - skip appended:&appended error:&error];
+
+        if (! linked) {
+            NSLog(@"%@:%u sent headers that don't link to the chain: %@", peer.host, peer.port, error);
+            _peer = nil;
+            _tree = nil;
+
+            if ([self.delegate respondsToSelector:@selector(headerSync:peer:sentInvalidHeaders:)]) {
+                [self.delegate headerSync:self peer:peer sentInvalidHeaders:error];
+            }
+
+            if (appended > 0) [self.delegate headerSync:self syncedToHeight:self.store.tipHeight];
+            return;
+        }
+    }
+
+    if (appended > 0) {
+        [self.store synchronize];
+        [self.delegate headerSync:self syncedToHeight:self.store.tipHeight];
+    }
+
+    if (count >= MAX_HEADERS_BATCH) { // the peer has more, continue from the last header it sent
+        NSMutableArray *locators = [NSMutableArray array];
+
+        if (_lastHash) [locators addObject:uint256_obj([_lastHash hashAtOffset:0])];
+
+        for (NSData *hash in [self.store blockLocatorHashes]) {
+            if (! [hash isEqual:_lastHash]) [locators addObject:uint256_obj([hash hashAtOffset:0])];
+        }
+
+        [peer sendGetheadersMessageWithLocators:locators andHashStop:UINT256_ZERO];
+    }
+    else {
+        _peer = nil;
+        _tree = nil;
+
+        if ([self.delegate respondsToSelector:@selector(headerSync:finishedWithPeer:)]) {
+            [self.delegate headerSync:self finishedWithPeer:peer];
+        }
+    }
+}
+
+/**
+ 跟随分叉
+
+ Adds headers that don't extend the stored tip to a header tree holding the stored chain above their fork point, and
+ when the peer's branch gets more work than the stored one, truncates the store to the fork point and appends the
+ peer's branch. The tree is kept for the following batches from the same peer, since a fork can take several batches
+ to overtake the stored chain.
+ */
+- (BOOL)followFork:(const uint8_t *)bytes count:(NSUInteger)count appended:(NSUInteger *)appended
+error:(NSError **)error
+{
+    NSMutableArray *headers = [NSMutableArray arrayWithCapacity:count];
+    NSArray *disconnected = nil, *connected = nil;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        [headers addObject:[[DMCBlockHeader alloc] initWithData:[NSData dataWithBytes:bytes + i*HEADER_STRIDE
+                                                                  length:HEADER_LENGTH]]];
+    }
+
+    if (! [_tree nodeForBlockHash:[headers[0] previousBlockHash]]) {
+        int64_t forkHeight = [self.store heightForBlockHash:[headers[0] previousBlockHash]];
+
+        if (forkHeight < 0) {
+            if (error) {
+                *error = [NSError errorWithDomain:DMCHeaderStoreErrorDomain code:DMCHeaderStoreDisconnectedHeader
+                          userInfo:@{NSLocalizedDescriptionKey:@"Headers don't link to the stored chain"}];
+            }
+
+            return NO;
+        }
+
+        NSMutableArray *stored = [NSMutableArray array];
+
+        // the tree needs the stored branch to compare its work with the peer's
+        for (uint32_t h = (uint32_t)forkHeight + 1; h <= self.store.tipHeight; h++) {
+            [stored addObject:[self.store headerAtHeight:h]];
+        }
+
+        _tree = [[DMCHeaderTree alloc] initWithRootHeader:[self.store headerAtHeight:(uint32_t)forkHeight]
+                 height:(uint32_t)forkHeight chainWork:nil];
+        _tree.proofOfWorkLimit = self.network.proofOfWorkLimit;
+        if (! [_tree addHeaders:stored disconnected:NULL connected:NULL error:error]) return NO;
+    }
+
+    BOOL added = [_tree addHeaders:headers disconnected:&disconnected connected:&connected error:error];
+
+    if (connected.count > 0) { // the peer's branch has more work now
+        uint32_t forkHeight = [connected[0] height] - 1;
+        NSMutableData *data = [NSMutableData dataWithCapacity:connected.count*HEADER_LENGTH];
+
+        for (DMCHeaderTreeNode *node in connected) {
+            [data appendData:node.header.data];
+        }
+
+        NSLog(@"header chain reorganized above height %u, %u headers replaced by %u", forkHeight,
+              (int)disconnected.count, (int)connected.count);
+
+        if (disconnected.count > 0) {
+            [self.store truncateToHeight:forkHeight];
+
+            if ([self.delegate respondsToSelector:@selector(headerSync:reorganizedAboveHeight:)]) {
+                [self.delegate headerSync:self reorganizedAboveHeight:forkHeight];
+            }
+        }
+
+        if (! [self.store appendHeaders:data.bytes stride:HEADER_LENGTH count:connected.count appended:appended
+               error:error]) return NO;
+    }
+
+    return added;
+}
+
+- (void)peer:(DMCPeer *)peer disconnectedWithError:(NSError *)error
+{
+    if (peer != _peer) return;
+    _peer = nil;
+    _tree = nil;
+}
+
+@end
@@ -0,0 +1,10 @@
+//
+//  DMCHistorySync+Tests.h
+
+#import "DMCHistorySync.h"
+
+@interface DMCHistorySync (Tests)
+
++ (void)runAllTests;
+
+@end
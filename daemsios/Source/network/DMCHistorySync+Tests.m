@@ -0,0 +1,233 @@
+//
+//  DMCHistorySync+Tests.m
+
+#import "DMCHistorySync+Tests.h"
+#import "DMCStubPeer.h"
+#import "DMCTransaction.h"
+#import "NSData+DaemsCoin.h"
+
+// records delegate calls
+@interface DMCHistorySyncRecorder : NSObject<DMCHistorySyncDelegate>
+
+@property (nonatomic, strong) NSMutableArray *transactions;
+@property (nonatomic, assign) NSUInteger finished;
+
+@end
+
+@implementation DMCHistorySyncRecorder
+
+- (instancetype)init
+{
+    if (! (self = [super init])) return nil;
+
+    _transactions = [NSMutableArray array];
+    return self;
+}
+
+- (void)historySync:(DMCHistorySync *)sync relayedTransactions:(NSArray *)transactions
+{
+    [self.transactions addObjectsFromArray:transactions];
+}
+
+- (void)historySyncFinished:(DMCHistorySync *)sync
+{
+    self.finished++;
+}
+
+@end
+
+@implementation DMCHistorySync (Tests)
+
++ (void)runAllTests
+{
+    [self testPaging];
+    [self testRepliesByTxid];
+    [self testMissingTransactions];
+    [self testBatchSize];
+    [self testTimeout];
+    [self testCursorsSaved];
+}
+
+// transactions that differ only by lockTime, so each has its own hash
++ (NSArray *)transactionsWithCount:(NSUInteger)count
+{
+    NSMutableArray *transactions = [NSMutableArray arrayWithCapacity:count];
+
+    for (NSUInteger i = 0; i < count; i++) {
+        DMCTransaction *tx = [DMCTransaction new];
+
+        tx.lockTime = (uint32_t)i + 1;
+        [transactions addObject:tx];
+    }
+
+    return transactions;
+}
+
++ (NSValue *)hashOfTransaction:(DMCTransaction *)tx
+{
+    return uint256_obj([tx.transactionHash hashAtOffset:0]);
+}
+
++ (void)testPaging
+{
+    DMCHistorySync *sync = [[DMCHistorySync alloc] initWithPath:nil];
+    DMCHistorySyncRecorder *recorder = [DMCHistorySyncRecorder new];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    NSArray *txs = [self transactionsWithCount:2];
+    NSValue *h1 = [self hashOfTransaction:txs[0]], *h2 = [self hashOfTransaction:txs[1]];
+
+    sync.delegate = recorder;
+    sync.pageHeights = 10;
+    peer.lastblock = 15;
+    [sync addKnownTxHashes:@[h1]];
+    [sync syncAddresses:@[@"a"] withPeer:peer];
+    NSAssert([peer.historyRequests isEqual:(@[@[@"a", @0, @9]])], @"Should list the first page");
+
+    [sync peer:peer relayedTxHashes:@[h1, h2] heights:@[@1, @2] forAddress:@"a"];
+    NSAssert([peer.txRequests isEqual:(@[@[h2]])], @"Should fetch only the unknown transaction");
+    NSAssert([sync nextHeightForAddress:@"a"] == 0, @"Should not move the cursor before the page is delivered");
+
+    [sync peer:peer relayedTransactions:@[txs[1]]];
+    NSAssert([recorder.transactions isEqual:@[txs[1]]], @"Should deliver the transaction");
+    NSAssert([sync nextHeightForAddress:@"a"] == 10, @"Should move the cursor past the delivered page");
+    NSAssert([peer.historyRequests.lastObject isEqual:(@[@"a", @10, @15])], @"Should list the next page up to lastblock");
+
+    [sync peer:peer relayedTxHashes:@[] heights:@[] forAddress:@"a"];
+    NSAssert([sync nextHeightForAddress:@"a"] == 16, @"Should move the cursor past an empty page");
+    NSAssert(recorder.finished == 1, @"Should finish once the address is up to date");
+}
+
++ (void)testRepliesByTxid
+{
+    DMCHistorySync *sync = [[DMCHistorySync alloc] initWithPath:nil];
+    DMCHistorySyncRecorder *recorder = [DMCHistorySyncRecorder new];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    NSArray *txs = [self transactionsWithCount:3];
+    NSValue *h1 = [self hashOfTransaction:txs[0]], *h2 = [self hashOfTransaction:txs[1]];
+    NSValue *h3 = [self hashOfTransaction:txs[2]];
+
+    sync.delegate = recorder;
+    sync.batchSize = 1;
+    peer.lastblock = 100;
+    [sync syncAddresses:@[@"a", @"b"] withPeer:peer];
+    NSAssert(peer.historyRequests.count == 2, @"Should list both addresses at once");
+
+    // listings in reverse order, sharing a transaction
+    [sync peer:peer relayedTxHashes:@[h2, h3] heights:@[@2, @3] forAddress:@"b"];
+    [sync peer:peer relayedTxHashes:@[h1, h2] heights:@[@1, @2] forAddress:@"a"];
+    NSAssert([peer.txRequests isEqual:(@[@[h2], @[h3], @[h1]])], @"Should fetch the shared transaction once");
+
+    // the later batches are answered first
+    [sync peer:peer relayedTransactions:@[txs[0]]];
+    NSAssert(recorder.transactions.count == 1, @"Should accept a reply to a later batch");
+    [sync peer:peer relayedTransactions:@[txs[2], txs[1]]];
+    NSAssert(recorder.transactions.count == 3, @"Should accept a reply answering several batches");
+    NSAssert([sync nextHeightForAddress:@"a"] == 101 && [sync nextHeightForAddress:@"b"] == 101,
+             @"Should complete both pages");
+
+    [sync peer:peer relayedTransactions:@[txs[0]]];
+    NSAssert(recorder.transactions.count == 3, @"Should deliver each transaction once");
+}
+
++ (void)testMissingTransactions
+{
+    DMCHistorySync *sync = [[DMCHistorySync alloc] initWithPath:nil];
+    DMCHistorySyncRecorder *recorder = [DMCHistorySyncRecorder new];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    NSArray *txs = [self transactionsWithCount:2];
+    NSValue *h1 = [self hashOfTransaction:txs[0]], *h2 = [self hashOfTransaction:txs[1]];
+
+    sync.delegate = recorder;
+    peer.lastblock = 100;
+    [sync syncAddresses:@[@"a"] withPeer:peer];
+    [sync peer:peer relayedTxHashes:@[h1, h2] heights:@[@1, @2] forAddress:@"a"];
+    NSAssert(peer.txRequests.count == 1, @"Should fetch both transactions in one batch");
+
+    [sync peer:peer relayedTransactions:@[txs[0]]]; // the peer left out h2
+    NSAssert(recorder.transactions.count == 1, @"Should deliver the transaction that came");
+    NSAssert([sync nextHeightForAddress:@"a"] == 0, @"Should not move the cursor past a page missing a transaction");
+    NSAssert(recorder.finished == 1, @"Should finish, the page is synced again next time");
+
+    [sync syncAddresses:@[@"a"] withPeer:peer];
+    NSAssert([peer.historyRequests.lastObject isEqual:(@[@"a", @0, @100])], @"Should list the page again");
+}
+
++ (void)testBatchSize
+{
+    DMCHistorySync *sync = [[DMCHistorySync alloc] initWithPath:nil];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    NSMutableArray *hashes = [NSMutableArray arrayWithCapacity:MAX_GETDATA_HASHES + 1];
+    UInt256 h = UINT256_ZERO;
+
+    for (uint32_t i = 0; i <= MAX_GETDATA_HASHES; i++) {
+        h.u32[0] = i;
+        [hashes addObject:uint256_obj(h)];
+    }
+
+    sync.batchSize = NSUIntegerMax;
+    peer.lastblock = 100;
+    [sync syncAddresses:@[@"a"] withPeer:peer];
+    [sync peer:peer relayedTxHashes:hashes heights:@[] forAddress:@"a"];
+    NSAssert(peer.txRequests.count == 2, @"Should split the transactions into batches the peer accepts");
+    NSAssert([peer.txRequests[0] count] == MAX_GETDATA_HASHES, @"Should clamp the batch to MAX_GETDATA_HASHES");
+    NSAssert([peer.txRequests[1] count] == 1, @"Should fetch the rest in the next batch");
+}
+
++ (void)testTimeout
+{
+    DMCHistorySync *sync = [[DMCHistorySync alloc] initWithPath:nil];
+    DMCHistorySyncRecorder *recorder = [DMCHistorySyncRecorder new];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+    NSArray *txs = [self transactionsWithCount:1];
+
+    sync.delegate = recorder;
+    peer.lastblock = 100;
+    [sync syncAddresses:@[@"a", @"b"] withPeer:peer];
+    [sync peer:peer relayedTxHashes:@[[self hashOfTransaction:txs[0]]] heights:@[@1] forAddress:@"a"];
+
+    [sync expireRequests];
+    NSAssert(recorder.finished == 0, @"Should keep waiting within requestTimeout");
+
+    sync.requestTimeout = 0; // the peer stays connected and never replies
+    [sync expireRequests];
+    NSAssert(recorder.finished == 1, @"Should finish once the listing and the batch time out");
+    NSAssert([sync nextHeightForAddress:@"a"] == 0 && [sync nextHeightForAddress:@"b"] == 0,
+             @"Should keep the cursors of the pages that timed out");
+
+    sync.requestTimeout = 30;
+    [sync syncAddresses:@[@"a", @"b"] withPeer:peer];
+    NSAssert(peer.historyRequests.count == 4, @"Should list both addresses again");
+
+    [sync peer:peer relayedTransactions:txs];
+    NSAssert(recorder.transactions.count == 0, @"Should ignore a reply to a batch that timed out");
+}
+
++ (void)testCursorsSaved
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"DMCHistorySyncTests.plist"];
+    DMCStubPeer *peer = [DMCStubPeer stubPeerWithPort:1];
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+
+    DMCHistorySync *sync = [[DMCHistorySync alloc] initWithPath:path];
+
+    sync.pageHeights = 10;
+    peer.lastblock = 25;
+    [sync syncAddresses:@[@"a"] withPeer:peer];
+    [sync peer:peer relayedTxHashes:@[] heights:@[] forAddress:@"a"];
+    NSAssert(! [[NSFileManager defaultManager] fileExistsAtPath:path], @"Should not save after every page");
+
+    [sync peer:peer disconnectedWithError:nil];
+    NSAssert([[[DMCHistorySync alloc] initWithPath:path] nextHeightForAddress:@"a"] == 10,
+             @"Should save the cursors when the peer disconnects");
+
+    [sync syncAddresses:@[@"a"] withPeer:peer];
+    [sync peer:peer relayedTxHashes:@[] heights:@[] forAddress:@"a"];
+    [sync peer:peer relayedTxHashes:@[] heights:@[] forAddress:@"a"];
+    NSAssert([[[DMCHistorySync alloc] initWithPath:path] nextHeightForAddress:@"a"] == 26,
+             @"Should save the cursors when the sync finishes");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
+@end
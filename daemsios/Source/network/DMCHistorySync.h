@@ -0,0 +1,101 @@
+//
+//  DMCHistorySync.h
+
+#import <Foundation/Foundation.h>
+
+@class DMCPeer, DMCHistorySync;
+
+@protocol DMCHistorySyncDelegate<NSObject>
+@required
+
+// transactions (DMCTransaction) of the synced addresses, in batches as they arrive; each one is delivered once
+- (void)historySync:(DMCHistorySync *)sync relayedTransactions:(NSArray *)transactions;
+
+@optional
+
+// all addresses are synced up to the peer's last block, or have stopped on a page the peer couldn't complete
+- (void)historySyncFinished:(DMCHistorySync *)sync;
+
+@end
+
+/**
+ 地址交易历史同步
+
+ Downloads the history of a set of addresses in pages of block heights: gettxidsbyaddr lists the txids of a page,
+ txids that are already known are dropped, and the rest are fetched with gettxs in fixed size batches, keeping a fixed
+ number of batches in flight. Replies are matched to their requests by address and txid, so the peer may answer in any
+ order. Once every transaction of a page has been delivered, the address's cursor moves past it. The cursors are saved
+ every few seconds and when a sync finishes or its peer disconnects, so a restart resumes at most a few pages before
+ the first height that wasn't fully synced.
+
+ Not thread safe, use it from the peer delegate queue and forward the txidsbyaddress and tx4lightnode replies and
+ disconnects to it.
+ */
+@interface DMCHistorySync : NSObject
+
+@property (nonatomic, weak) id<DMCHistorySyncDelegate> delegate;
+
+/**
+ Block heights per gettxidsbyaddr page, 10000 by default.
+ */
+@property (nonatomic, assign) uint32_t pageHeights;
+
+/**
+ txids per gettxs batch, 500 by default, at most MAX_GETDATA_HASHES.
+ */
+@property (nonatomic, assign) NSUInteger batchSize;
+
+/**
+ gettxs batches in flight, 4 by default.
+ */
+@property (nonatomic, assign) NSUInteger maxBatchesInFlight;
+
+/**
+ Seconds to wait for a txidsbyaddress or tx4lightnode reply before giving up on the request, 30 by default.
+ */
+@property (nonatomic, assign) NSTimeInterval requestTimeout;
+
+/**
+ 以保存同步进度的文件初始化
+
+ @param path file the per address cursors are saved to, and loaded from if it exists
+ */
+- (instancetype)initWithPath:(NSString *)path;
+
+/**
+ First block height of the address that hasn't been synced yet.
+ */
+- (uint32_t)nextHeightForAddress:(NSString *)address;
+
+/**
+ Adds txHashes (uint256_obj) of transactions the wallet already has, they are never fetched.
+ */
+- (void)addKnownTxHashes:(NSArray *)txHashes;
+
+/**
+ 同步地址历史
+
+ Syncs the addresses from their saved cursors up to the peer's last block. Addresses already being synced are skipped.
+
+ @param addresses 地址
+ @param peer connected peer to sync from
+ */
+- (void)syncAddresses:(NSArray *)addresses withPeer:(DMCPeer *)peer;
+
+/**
+ Gives up on the pages and batches requested more than requestTimeout ago, e.g. when a peer stays connected but never
+ replies. Their pages keep their cursors and are synced again by the next sync. Called on the peer delegate queue once
+ requestTimeout passes after each request.
+ */
+- (void)expireRequests;
+
+- (void)peer:(DMCPeer *)peer relayedTxHashes:(NSArray *)txHashes heights:(NSArray *)heights
+forAddress:(NSString *)address;
+- (void)peer:(DMCPeer *)peer relayedTransactions:(NSArray *)transactions;
+
+/**
+ Drops the pages and batches in flight. Their addresses keep their saved cursors and can be synced again.
+ */
+- (void)peer:(DMCPeer *)peer disconnectedWithError:(NSError *)error;
+
+@end
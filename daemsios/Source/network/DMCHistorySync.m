@@ -0,0 +1,327 @@
+//
+//  DMCHistorySync.m
+
+#import "DMCHistorySync.h"
+#import "DMCPeer.h"
+#import "DMCPeerReactor.h"
+#import "DMCTransaction.h"
+#import "NSData+DaemsCoin.h"
+
+#if ! PEER_LOGGING
+#define NSLog(...)
+#endif
+
+#define HISTORY_PAGE_HEIGHTS    10000
+#define HISTORY_BATCH_SIZE      500
+#define HISTORY_BATCHES         4
+#define HISTORY_PAGES_IN_FLIGHT 16 // addresses listed at the same time
+#define HISTORY_REQUEST_TIMEOUT 30.0
+#define HISTORY_SAVE_INTERVAL   10.0 // seconds between cursor saves while syncing
+
+@interface DMCHistoryPage : NSObject
+
+@property (nonatomic, strong) NSString *address;
+@property (nonatomic, assign) uint32_t fromHeight, toHeight;
+@property (nonatomic, strong) NSDate *date; // when gettxidsbyaddr was sent
+@property (nonatomic, assign) BOOL listed; // txidsbyaddress received
+@property (nonatomic, assign) BOOL incomplete; // the peer left out a requested tx
+@property (nonatomic, strong) NSMutableSet *pending; // txHashes not delivered yet
+
+@end
+
+@implementation DMCHistoryPage
+
+@end
+
+
+@interface DMCHistoryBatch : NSObject
+
+@property (nonatomic, strong) NSMutableSet *remaining; // txHashes requested and not received yet
+@property (nonatomic, strong) NSDate *date; // when gettxs was sent
+
+@end
+
+@implementation DMCHistoryBatch
+
+@end
+
+
+@implementation DMCHistorySync {
+    NSString *_path;
+    NSMutableDictionary *_cursors; // address -> next height (NSNumber)
+    BOOL _dirty; // cursors changed since the last save
+    NSDate *_saved;
+    NSMutableSet *_known; // txHashes delivered or already in the wallet
+    __weak DMCPeer *_peer;
+    BOOL _syncing;
+    NSMutableOrderedSet *_waiting; // addresses waiting for their next page to be listed
+    NSMutableDictionary *_pages; // address -> page in flight
+    NSMutableOrderedSet *_wanted; // txHashes waiting for a gettxs batch
+    NSMutableDictionary *_requested; // txHash -> batch it was requested in, until received
+    NSMutableArray *_batches; // gettxs batches in flight
+}
+
+- (instancetype)initWithPath:(NSString *)path
+{
+    if (! (self = [super init])) return nil;
+
+    _path = path;
+    _cursors = [NSMutableDictionary dictionaryWithContentsOfFile:path] ?: [NSMutableDictionary dictionary];
+    _known = [NSMutableSet set];
+    _waiting = [NSMutableOrderedSet orderedSet];
+    _pages = [NSMutableDictionary dictionary];
+    _wanted = [NSMutableOrderedSet orderedSet];
+    _requested = [NSMutableDictionary dictionary];
+    _batches = [NSMutableArray array];
+    _saved = [NSDate date];
+    _pageHeights = HISTORY_PAGE_HEIGHTS;
+    _batchSize = HISTORY_BATCH_SIZE;
+    _maxBatchesInFlight = HISTORY_BATCHES;
+    _requestTimeout = HISTORY_REQUEST_TIMEOUT;
+    return self;
+}
+
+- (uint32_t)nextHeightForAddress:(NSString *)address
+{
+    return [_cursors[address] unsignedIntValue];
+}
+
+- (void)addKnownTxHashes:(NSArray *)txHashes
+{
+    [_known addObjectsFromArray:txHashes];
+}
+
+- (void)syncAddresses:(NSArray *)addresses withPeer:(DMCPeer *)peer
+{
+    if (_syncing && _peer && peer != _peer) {
+        NSLog(@"%@:%u can't sync history, already syncing from another peer", peer.host, peer.port);
+        return;
+    }
+
+    _peer = peer;
+    _syncing = YES;
+
+    for (NSString *address in addresses) {
+        if (! _pages[address]) [_waiting addObject:address];
+    }
+
+    [self requestPages];
+}
+
+// MARK: - pipeline
+
+- (void)requestPages
+{
+    DMCPeer *peer = _peer;
+    BOOL sent = NO;
+
+    while (peer && _pages.count < HISTORY_PAGES_IN_FLIGHT && _waiting.count > 0) {
+        NSString *address = _waiting.firstObject;
+        uint32_t fromHeight = [self nextHeightForAddress:address], lastHeight = peer.lastblock;
+
+        [_waiting removeObjectAtIndex:0];
+        if (fromHeight > lastHeight) continue; // up to date
+
+        DMCHistoryPage *page = [DMCHistoryPage new];
+
+        page.address = address;
+        page.fromHeight = fromHeight;
+        page.toHeight = (uint32_t)MIN((uint64_t)fromHeight + MAX(self.pageHeights, 1) - 1, lastHeight);
+        page.date = [NSDate date];
+        page.pending = [NSMutableSet set];
+        _pages[address] = page;
+        [peer sendGettxidsbyaddrMessageWithAddress:address fromHeight:page.fromHeight toHeight:page.toHeight];
+        sent = YES;
+    }
+
+    if (sent) [self scheduleExpiryOnQueue:peer.delegateQueue];
+
+    if (_syncing && _pages.count == 0 && _waiting.count == 0) {
+        _syncing = NO;
+        [self saveCursors];
+
+        if ([self.delegate respondsToSelector:@selector(historySyncFinished:)]) {
+            [self.delegate historySyncFinished:self];
+        }
+    }
+}
+
+- (void)requestBatches
+{
+    DMCPeer *peer = _peer;
+    NSUInteger batchSize = MIN(MAX(self.batchSize, 1), MAX_GETDATA_HASHES); // the peer won't send bigger batches
+    BOOL sent = NO;
+
+    while (peer && _batches.count < MAX(self.maxBatchesInFlight, 1) && _wanted.count > 0) {
+        NSRange range = NSMakeRange(0, MIN(batchSize, _wanted.count));
+        NSArray *txHashes = [_wanted.array subarrayWithRange:range];
+        DMCHistoryBatch *batch = [DMCHistoryBatch new];
+
+        [_wanted removeObjectsInRange:range];
+        batch.remaining = [NSMutableSet setWithArray:txHashes];
+        batch.date = [NSDate date];
+        for (NSValue *hash in txHashes) _requested[hash] = batch;
+        [_batches addObject:batch];
+        [peer sendGettxsMessageWithTxHashes:txHashes];
+        sent = YES;
+    }
+
+    if (sent) [self scheduleExpiryOnQueue:peer.delegateQueue];
+}
+
+// the sync is used from the peer delegate queue, so the timeout fires there too
+- (void)scheduleExpiryOnQueue:(dispatch_queue_t)queue
+{
+    __weak DMCHistorySync *weakSelf = self;
+
+    if (! queue) queue = dispatch_get_main_queue();
+    // a tick (0.1s) late, timers may fire up to a tick early
+    [[DMCPeerReactor sharedReactor] scheduleTimer:self.requestTimeout + 0.1 handler:^{
+        dispatch_async(queue, ^{
+            [weakSelf expireRequests];
+        });
+    }];
+}
+
+- (void)expireRequests
+{
+    NSMutableArray *expired = [NSMutableArray array];
+    NSMutableSet *missing = [NSMutableSet set];
+    BOOL expiredPages = NO;
+
+    for (DMCHistoryBatch *batch in _batches) {
+        if (-batch.date.timeIntervalSinceNow < self.requestTimeout) continue;
+        [expired addObject:batch];
+        [missing unionSet:batch.remaining];
+    }
+
+    for (DMCHistoryPage *page in _pages.allValues) {
+        if (page.listed || -page.date.timeIntervalSinceNow < self.requestTimeout) continue;
+        NSLog(@"%@:%u timed out listing the history of %@", _peer.host, _peer.port, page.address);
+        page.listed = YES; // nothing more is coming, drop it below
+        page.incomplete = YES;
+        expiredPages = YES;
+    }
+
+    if (expired.count == 0 && ! expiredPages) return;
+    [_batches removeObjectsInArray:expired];
+    [_requested removeObjectsForKeys:missing.allObjects];
+    [self receivedTxHashes:[NSSet set] missing:missing];
+    [self requestBatches];
+    [self completePages];
+}
+
+// resolves the pending txHashes of the pages in flight
+- (void)receivedTxHashes:(NSSet *)received missing:(NSSet *)missing
+{
+    for (DMCHistoryPage *page in _pages.allValues) {
+        if ([page.pending intersectsSet:missing]) page.incomplete = YES;
+        [page.pending minusSet:received];
+        [page.pending minusSet:missing];
+    }
+}
+
+// moves the cursors past pages whose transactions have all been delivered and lists the next pages
+- (void)completePages
+{
+    for (DMCHistoryPage *page in _pages.allValues) {
+        if (! page.listed || page.pending.count > 0) continue;
+        [_pages removeObjectForKey:page.address];
+
+        if (page.incomplete) { // try again on the next sync
+            NSLog(@"%@:%u history of %@ is missing transactions in heights %u-%u", _peer.host, _peer.port,
+                  page.address, page.fromHeight, page.toHeight);
+            continue;
+        }
+
+        _cursors[page.address] = @(page.toHeight + 1);
+        [_waiting addObject:page.address];
+        _dirty = YES;
+    }
+
+    // the whole file is rewritten, so it's saved every few seconds rather than after every page
+    if (_dirty && -_saved.timeIntervalSinceNow >= HISTORY_SAVE_INTERVAL) [self saveCursors];
+    [self requestPages];
+}
+
+- (void)saveCursors
+{
+    if (! _dirty) return;
+    _dirty = NO;
+    _saved = [NSDate date];
+
+    if (_path && ! [_cursors writeToFile:_path atomically:YES]) {
+        NSLog(@"failed to save history cursors to %@", _path);
+    }
+}
+
+// MARK: - replies
+
+- (void)peer:(DMCPeer *)peer relayedTxHashes:(NSArray *)txHashes heights:(NSArray *)heights
+forAddress:(NSString *)address
+{
+    DMCHistoryPage *page = _pages[address];
+
+    if (peer != _peer || ! page || page.listed) return; // not a page we asked for
+    page.listed = YES;
+
+    for (NSValue *hash in txHashes) {
+        if ([_known containsObject:hash]) continue;
+        [page.pending addObject:hash];
+        if (! _requested[hash]) [_wanted addObject:hash]; // a set, so shared txs are fetched once
+    }
+
+    [self requestBatches];
+    [self completePages];
+}
+
+// replies are matched to batches by txid: a reply answers every batch it has a transaction of, and the rest of those
+// batches is missing. A reply with none of them answers nothing, its batches time out.
+- (void)peer:(DMCPeer *)peer relayedTransactions:(NSArray *)transactions
+{
+    if (peer != _peer || _batches.count == 0) return;
+
+    NSMutableSet *received = [NSMutableSet set], *missing = [NSMutableSet set];
+    NSMutableArray *delivered = [NSMutableArray arrayWithCapacity:transactions.count], *answered = [NSMutableArray array];
+
+    for (DMCTransaction *tx in transactions) {
+        NSValue *hash = uint256_obj([tx.transactionHash hashAtOffset:0]);
+        DMCHistoryBatch *batch = _requested[hash];
+
+        if (! batch) continue; // not requested, or a duplicate
+        [_requested removeObjectForKey:hash];
+        [batch.remaining removeObject:hash];
+        if ([answered indexOfObjectIdenticalTo:batch] == NSNotFound) [answered addObject:batch];
+        [_known addObject:hash];
+        [received addObject:hash];
+        [delivered addObject:tx];
+    }
+
+    for (DMCHistoryBatch *batch in answered) {
+        [missing unionSet:batch.remaining];
+        [_batches removeObjectIdenticalTo:batch];
+    }
+
+    [_requested removeObjectsForKeys:missing.allObjects];
+    [self receivedTxHashes:received missing:missing];
+
+    if (delivered.count > 0) [self.delegate historySync:self relayedTransactions:delivered];
+    [self requestBatches];
+    [self completePages];
+}
+
+- (void)peer:(DMCPeer *)peer disconnectedWithError:(NSError *)error
+{
+    if (peer != _peer) return;
+
+    [_waiting removeAllObjects];
+    [_pages removeAllObjects];
+    [_wanted removeAllObjects];
+    [_requested removeAllObjects];
+    [_batches removeAllObjects];
+    _peer = nil;
+    _syncing = NO;
+    [self saveCursors];
+}
+
+@end
@@ -0,0 +1,64 @@
+//
+//  DMCMessageFramer.h
+
+#import <Foundation/Foundation.h>
+#import "NSData+DaemsCoin.h"
+
+#define DMC_MESSAGE_HEADER_LENGTH  24
+#define DMC_MESSAGE_COMMAND_LENGTH 12
+#define DMC_MESSAGE_MAX_LENGTH     0x02000000
+
+/**
+ P2P消息分帧器
+
+ Splits a peer byte stream into messages. Input is read straight into one reusable buffer in large chunks (one read
+ per call fills all free space), the magic number is located with memmem instead of dropping one byte at a time, and
+ payloads are returned as views into the buffer without copying. Payload bytes are hashed as they arrive, so the
+ checksum is ready as soon as the last byte of a message has been read.
+ */
+@interface DMCMessageFramer : NSObject
+
+/**
+ Bytes read but not yet returned as messages.
+ */
+@property (nonatomic, readonly) NSUInteger bufferedLength;
+
+/**
+ sha256(sha256(payload)) of the payload last returned by -nextPayloadWithCommand:error:, e.g. the hash of a tx message.
+ */
+@property (nonatomic, readonly) UInt256 payloadHash;
+
+/**
+ Reads whatever the stream has available into the buffer with a single read call.
+
+ @param inputStream 输入流
+ @return bytes read, 0 at end of stream, -1 on error (as -[NSInputStream read:maxLength:])
+ */
+- (NSInteger)readFromStream:(NSInputStream *)inputStream;
+
+/**
+ Reads whatever a non-blocking socket has available into the buffer with a single read call.
+
+ @param socket 文件描述符
+ @return bytes read, 0 at end of file, -1 on error with errno set (EAGAIN if nothing was available)
+ */
+- (NSInteger)readFromSocket:(int)socket;
+
+/**
+ Returns the payload of the next complete, checksum verified message.
+
+ The returned data points into the framer's buffer and stays valid only until the next read or -reset.
+ Callers that keep a payload past that point (or hand it to another queue) must copy it.
+
+ @param command receives the zero padded command and a terminator, DMC_MESSAGE_COMMAND_LENGTH + 1 bytes
+ @param error set when a malformed message was skipped; the framer has already resynced and can be called again
+ @return payload, or nil if no complete message is buffered yet or a malformed one was skipped
+ */
+- (NSData *)nextPayloadWithCommand:(char *)command error:(NSError **)error;
+
+/**
+ Drops all buffered input, e.g. when the connection is reset.
+ */
+- (void)reset;
+
+@end
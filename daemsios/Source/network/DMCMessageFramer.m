@@ -0,0 +1,208 @@
+//
+//  DMCMessageFramer.m
+
+#import "DMCMessageFramer.h"
+#import "NSMutableData+DaemsCoin.h"
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define FRAMER_INITIAL_CAPACITY  0x10000  // 64KB, enough for most messages plus the next read
+#define FRAMER_RETAINED_CAPACITY 0x100000 // larger buffers grown for a big message are released once drained
+#define FRAMER_MIN_READ          0x4000   // never issue a read with less free space than this
+
+// printable ascii followed by zero padding, a name that fills all 12 bytes has no terminator (longer daems commands
+// are sent as their first 12 bytes)
+static BOOL DMCCommandIsValid(const uint8_t *command)
+{
+    NSUInteger i = 0;
+
+    while (i < DMC_MESSAGE_COMMAND_LENGTH && command[i] >= ' ' && command[i] <= '~') i++;
+    while (i < DMC_MESSAGE_COMMAND_LENGTH && command[i] == 0) i++;
+    return (i == DMC_MESSAGE_COMMAND_LENGTH) ? YES : NO;
+}
+
+@implementation DMCMessageFramer {
+    uint8_t *_bytes;
+    NSUInteger _capacity, _head, _tail; // unread input is _bytes[_head.._tail)
+    NSUInteger _frameLength; // header + payload length of the message at _head once its header has been read
+    NSUInteger _hashedLength; // payload bytes of that message already added to _context
+    SHA256Context _context;
+}
+
+- (void)dealloc
+{
+    free(_bytes);
+}
+
+- (NSUInteger)bufferedLength
+{
+    return _tail - _head;
+}
+
+- (void)reset
+{
+    _head = _tail = _frameLength = 0;
+}
+
+- (NSError *)error:(NSString *)message, ... NS_FORMAT_FUNCTION(1,2)
+{
+    va_list args;
+
+    va_start(args, message);
+    NSError *error = [NSError errorWithDomain:@"Daems" code:500
+                      userInfo:@{NSLocalizedDescriptionKey:[[NSString alloc] initWithFormat:message arguments:args]}];
+    va_end(args);
+    return error;
+}
+
+// makes room after _tail for the rest of the current message, or at least FRAMER_MIN_READ bytes
+- (BOOL)reserve
+{
+    NSUInteger buffered = _tail - _head, needed = MAX(_frameLength, buffered + FRAMER_MIN_READ);
+
+    if (buffered == 0) {
+        _head = _tail = 0;
+
+        if (_capacity > FRAMER_RETAINED_CAPACITY) {
+            free(_bytes);
+            _bytes = NULL;
+            _capacity = 0;
+        }
+    }
+
+    if (_head + needed > _capacity && _head > 0) { // move the partial message to the front
+        memmove(_bytes, _bytes + _head, buffered);
+        _head = 0;
+        _tail = buffered;
+    }
+
+    if (needed > _capacity) {
+        NSUInteger capacity = MAX(needed, MAX(_capacity*2, FRAMER_INITIAL_CAPACITY));
+        uint8_t *bytes = realloc(_bytes, capacity);
+
+        if (! bytes) return NO;
+        _bytes = bytes;
+        _capacity = capacity;
+    }
+
+    return YES;
+}
+
+- (NSInteger)readFromStream:(NSInputStream *)inputStream
+{
+    if (! [self reserve]) return -1;
+
+    NSInteger l = [inputStream read:_bytes + _tail maxLength:_capacity - _tail];
+
+    if (l > 0) _tail += l;
+    [self hashReceivedPayload];
+    return l;
+}
+
+- (NSInteger)readFromSocket:(int)socket
+{
+    if (! [self reserve]) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    ssize_t l = read(socket, _bytes + _tail, _capacity - _tail);
+
+    if (l > 0) _tail += l;
+    [self hashReceivedPayload];
+    return l;
+}
+
+// adds payload bytes of the current message that arrived since the last call to the checksum
+- (void)hashReceivedPayload
+{
+    if (_frameLength == 0) return;
+
+    NSUInteger received = MIN(_tail - _head, _frameLength) - DMC_MESSAGE_HEADER_LENGTH;
+
+    if (received > _hashedLength) {
+        SHA256Update(&_context, _bytes + _head + DMC_MESSAGE_HEADER_LENGTH + _hashedLength, received - _hashedLength);
+        _hashedLength = received;
+    }
+}
+
+// advances _head to the next magic number, keeping a possible partial match at the end of the buffer
+- (BOOL)synchronize
+{
+    uint32_t magic = CFSwapInt32HostToLittle(DAEMSCOIN_MAGIC_NUMBER);
+
+    if (_tail - _head < sizeof(magic)) return NO;
+    if (memcmp(_bytes + _head, &magic, sizeof(magic)) == 0) return YES;
+
+    const uint8_t *match = memmem(_bytes + _head + 1, _tail - _head - 1, &magic, sizeof(magic));
+
+    if (match) {
+        _head = match - _bytes;
+        return YES;
+    }
+
+    _head = _tail - (sizeof(magic) - 1);
+    return NO;
+}
+
+- (NSData *)nextPayloadWithCommand:(char *)command error:(NSError **)error
+{
+    if (_frameLength == 0) {
+        if (! [self synchronize] || _tail - _head < DMC_MESSAGE_HEADER_LENGTH) return nil;
+
+        /*
+         Message Header:
+         F9 BE B4 D9                                     - magic ：main 网络
+         61 64 64 72  00 00 00 00 00 00 00 00            - "addr"
+         1F 00 00 00                                     - payload 长度31字节
+         7F 85 39 C2                                     - payload 校验和
+         */
+
+        const uint8_t *header = _bytes + _head;
+        uint32_t length = CFSwapInt32LittleToHost(*(const uint32_t *)(header + 16));
+
+        if (! DMCCommandIsValid(header + 4)) { // verify msg type field is zero padded
+            _head++; // resync past this magic number
+            if (error) *error = [self error:@"malformed message header: %@",
+                                 [NSData dataWithBytes:header length:DMC_MESSAGE_HEADER_LENGTH]];
+            return nil;
+        }
+
+        if (length > DMC_MESSAGE_MAX_LENGTH) {
+            _head++;
+            if (error) *error = [self error:@"error reading %.12s, message length %u is too long",
+                                 (const char *)header + 4, length];
+            return nil;
+        }
+
+        _frameLength = DMC_MESSAGE_HEADER_LENGTH + length;
+        _hashedLength = 0;
+        SHA256Init(&_context);
+        [self hashReceivedPayload];
+    }
+
+    if (_tail - _head < _frameLength) return nil; // wait for more stream input
+
+    const uint8_t *header = _bytes + _head;
+    uint32_t checksum = *(const uint32_t *)(header + 20);
+    NSData *payload = [NSData dataWithBytesNoCopy:(void *)(header + DMC_MESSAGE_HEADER_LENGTH)
+                       length:_frameLength - DMC_MESSAGE_HEADER_LENGTH freeWhenDone:NO];
+
+    memcpy(command, header + 4, DMC_MESSAGE_COMMAND_LENGTH);
+    command[DMC_MESSAGE_COMMAND_LENGTH] = 0;
+    _head += _frameLength;
+    _frameLength = 0;
+    SHA256Final(&_context, &_payloadHash);
+    SHA256(&_payloadHash, &_payloadHash, sizeof(_payloadHash));
+
+    if (_payloadHash.u32[0] != checksum) { // 检查payload的前4个字节：sha256(sha256(payload)) == checksum
+        if (error) *error = [self error:@"error reading %s, invalid checksum %x, expected %x, payload length:%u",
+                             command, _payloadHash.u32[0], checksum, (int)payload.length];
+        return nil;
+    }
+
+    return payload;
+}
+
+@end
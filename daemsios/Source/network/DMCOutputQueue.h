@@ -0,0 +1,41 @@
+//
+//  DMCOutputQueue.h
+
+#import <Foundation/Foundation.h>
+
+/**
+ 节点消息发送队列
+
+ Queues outgoing messages as a list of chunks, a 24 byte header followed by the caller's payload, which is retained
+ rather than copied. Chunks are written with writev, and sent chunks are dropped from the front without moving the
+ rest of the backlog.
+ */
+@interface DMCOutputQueue : NSObject
+
+/**
+ Bytes queued but not yet written, for applying backpressure.
+ */
+@property (nonatomic, readonly) NSUInteger length;
+
+/**
+ Queues a message. Immutable payloads are referenced as they are, mutable ones are copied.
+
+ @param message 消息主体payload
+ @param type 类型
+ */
+- (void)appendMessage:(NSData *)message type:(NSString *)type;
+
+/**
+ Writes as much of the backlog as a non-blocking socket accepts with a single writev call.
+
+ @param socket 文件描述符
+ @return bytes written, or -1 with errno set (EAGAIN if the socket is full)
+ */
+- (NSInteger)writeToSocket:(int)socket;
+
+/**
+ Drops the whole backlog.
+ */
+- (void)removeAllMessages;
+
+@end
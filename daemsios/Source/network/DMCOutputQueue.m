@@ -0,0 +1,68 @@
+//
+//  DMCOutputQueue.m
+
+#import "DMCOutputQueue.h"
+#import "NSMutableData+DaemsCoin.h"
+#include <sys/uio.h>
+#include <errno.h>
+
+#define MAX_IOV 64 // chunks per writev call
+
+@implementation DMCOutputQueue {
+    NSMutableArray *_chunks;
+    NSUInteger _offset; // bytes of the first chunk already written
+}
+
+- (instancetype)init
+{
+    if (! (self = [super init])) return nil;
+
+    _chunks = [NSMutableArray array];
+    return self;
+}
+
+- (void)appendMessage:(NSData *)message type:(NSString *)type
+{
+    NSMutableData *header = [NSMutableData dataWithCapacity:24];
+
+    message = [message copy]; // only copies mutable payloads
+    [header appendMessageHeaderForPayload:message type:type];
+    [_chunks addObject:header];
+    if (message.length > 0) [_chunks addObject:message];
+    _length += header.length + message.length;
+}
+
+- (NSInteger)writeToSocket:(int)socket
+{
+    struct iovec iov[MAX_IOV];
+    int count = 0;
+
+    for (NSData *chunk in _chunks) {
+        if (count == MAX_IOV) break;
+        iov[count].iov_base = (void *)((const uint8_t *)chunk.bytes + (count == 0 ? _offset : 0));
+        iov[count].iov_len = chunk.length - (count == 0 ? _offset : 0);
+        count++;
+    }
+
+    if (count == 0) return 0;
+
+    ssize_t l = writev(socket, iov, count);
+
+    if (l <= 0) return l;
+    _length -= l;
+
+    NSUInteger sent = 0, written = _offset + l;
+
+    while (sent < _chunks.count && written >= [_chunks[sent] length]) written -= [_chunks[sent++] length];
+    [_chunks removeObjectsInRange:NSMakeRange(0, sent)];
+    _offset = written;
+    return l;
+}
+
+- (void)removeAllMessages
+{
+    [_chunks removeAllObjects];
+    _offset = _length = 0;
+}
+
+@end
@@ -0,0 +1,10 @@
+//
+//  DMCPeer+Tests.h
+
+#import "DMCPeer.h"
+
+@interface DMCPeer (Tests)
+
++ (void)runAllTests;
+
+@end
@@ -0,0 +1,192 @@
+//
+//  DMCPeer+Tests.m
+
+#import "DMCPeer+Tests.h"
+#import "DMCMessageFramer.h"
+#import "DMCOutputQueue.h"
+#import "NSMutableData+DaemsCoin.h"
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+@interface DMCPeer (TestsPrivate)
+
+- (void)acceptMessage:(NSData *)message command:(const char *)command;
+
+@end
+
+// a real peer whose messages are framed into an output queue instead of the socket
+@interface DMCFramingPeer : DMCPeer
+
+@property (nonatomic, readonly) DMCOutputQueue *framedOutput;
+
+@end
+
+@implementation DMCFramingPeer
+
+- (instancetype)initWithAddress:(UInt128)address andPort:(uint16_t)port
+{
+    if (! (self = [super initWithAddress:address andPort:port])) return nil;
+
+    _framedOutput = [DMCOutputQueue new];
+    return self;
+}
+
+- (void)sendMessage:(NSData *)message type:(NSString *)type
+{
+    [_framedOutput appendMessage:message type:type];
+}
+
+@end
+
+// records the balancebyaddr callback, the other callbacks aren't used
+@interface DMCPeerRecorder : NSObject<DMCPeerDelegate>
+
+@property (nonatomic, strong) NSMutableDictionary *balances;
+
+@end
+
+@implementation DMCPeerRecorder
+
+- (instancetype)init
+{
+    if (! (self = [super init])) return nil;
+
+    _balances = [NSMutableDictionary dictionary];
+    return self;
+}
+
+- (void)peer:(DMCPeer *)peer relayedBalances:(NSDictionary *)balances
+{
+    [self.balances addEntriesFromDictionary:balances];
+}
+
+- (void)peerConnected:(DMCPeer *)peer { }
+- (void)peer:(DMCPeer *)peer disconnectedWithError:(NSError *)error { }
+- (void)peer:(DMCPeer *)peer relayedPeers:(NSArray *)peers { }
+- (void)peer:(DMCPeer *)peer relayedTransaction:(DMCTransaction *)transaction { }
+- (void)peer:(DMCPeer *)peer hasTransaction:(UInt256)txHash { }
+- (void)peer:(DMCPeer *)peer rejectedTransaction:(UInt256)txHash withCode:(uint8_t)code { }
+- (void)peer:(DMCPeer *)peer relayedBlock:(DMCMerkleBlock *)block { }
+- (void)peer:(DMCPeer *)peer notfoundTxHashes:(NSArray *)txHashes andBlockHashes:(NSArray *)blockhashes { }
+- (void)peer:(DMCPeer *)peer setFeePerKb:(uint64_t)feePerKb { }
+- (DMCTransaction *)peer:(DMCPeer *)peer requestedTransaction:(UInt256)txHash { return nil; }
+
+@end
+
+@implementation DMCPeer (Tests)
+
++ (void)runAllTests
+{
+    [self testAddressListFraming];
+    [self testBalancebyaddrFraming];
+}
+
++ (UInt128)localAddress
+{
+    return (UInt128) { .u32 = { 0, 0, CFSwapInt32HostToBig(0xffff), CFSwapInt32HostToBig(0x7f000001) } };
+}
+
+// writes the queued messages through a socket pair and reads them back with a framer, as a peer would receive them;
+// returns @[command, payload] pairs
++ (NSArray *)messagesFramedByQueue:(DMCOutputQueue *)queue
+{
+    NSMutableArray *messages = [NSMutableArray array];
+    DMCMessageFramer *framer = [DMCMessageFramer new];
+    char command[DMC_MESSAGE_COMMAND_LENGTH + 1];
+    NSError *error = nil;
+    NSData *payload = nil;
+    int fds[2];
+
+    NSAssert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0, @"Should create a socket pair");
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+
+    // both ends are non-blocking, so a full socket buffer just means reading some back before writing more
+    while (queue.length > 0 || framer.bufferedLength > 0) {
+        if (queue.length > 0) [queue writeToSocket:fds[0]];
+        if ([framer readFromSocket:fds[1]] <= 0 && queue.length == 0) break;
+
+        while ((payload = [framer nextPayloadWithCommand:command error:&error])) {
+            [messages addObject:@[@(command), [payload copy]]];
+        }
+
+        NSAssert(! error, @"Should frame every message correctly");
+    }
+
+    close(fds[0]);
+    close(fds[1]);
+    NSAssert(queue.length == 0 && framer.bufferedLength == 0, @"Should read back every byte written");
+    return messages;
+}
+
++ (void)testAddressListFraming
+{
+    DMCFramingPeer *peer = [[DMCFramingPeer alloc] initWithAddress:[self localAddress] andPort:1];
+    NSMutableArray *addresses = [NSMutableArray array];
+    NSUInteger total = 140000, perMessage = (DMC_MESSAGE_MAX_LENGTH - 9)/251, i = 0; // 9 byte count, 251 byte var_str
+
+    // long addresses, so the list passes MAX_MSG_LENGTH without a million entries
+    for (NSUInteger n = 0; n < total; n++) [addresses addObject:[NSString stringWithFormat:@"%0250lu", (unsigned long)n]];
+
+    [peer sendGetbalancebyaddrMessageWithAddresses:addresses];
+
+    NSArray *messages = [self messagesFramedByQueue:peer.framedOutput];
+
+    NSAssert(messages.count == 2, @"Should split the list into as few messages as fit");
+
+    for (NSArray *message in messages) {
+        NSData *payload = message[1];
+        NSUInteger l, off, count = (NSUInteger)[payload varIntAtOffset:0 length:&l];
+
+        NSAssert([message[0] isEqual:MSG_GETBALANCEBYADDR], @"Should send getbalancebyaddr");
+        NSAssert(payload.length <= DMC_MESSAGE_MAX_LENGTH, @"Should stay under MAX_MSG_LENGTH");
+        NSAssert(count == (message == messages.firstObject ? perMessage : total - perMessage),
+                 @"Should fill a message up to MAX_MSG_LENGTH before starting the next one");
+
+        for (off = l; off < payload.length; off += l, i++) {
+            NSAssert([[payload stringAtOffset:off length:&l] isEqual:addresses[i]], @"Should send the addresses in order");
+        }
+    }
+
+    NSAssert(i == total, @"Should send every address once");
+
+    [peer sendRegisteraddrMessageWithAddresses:@[@"a"]];
+    messages = [self messagesFramedByQueue:peer.framedOutput];
+    NSAssert(messages.count == 1 && [messages[0][0] isEqual:MSG_REGISTERADDR], @"Should send a short list at once");
+    NSAssert([messages[0][1] isEqual:[NSData dataWithBytes:"\x01\x01" "a" length:3]], @"Should frame the count and address");
+
+    [peer sendRegisteraddrMessageWithAddresses:@[]];
+    NSAssert(peer.framedOutput.length == 0, @"Should not send an empty list");
+}
+
++ (void)testBalancebyaddrFraming
+{
+    DMCPeer *peer = [[DMCPeer alloc] initWithAddress:[self localAddress] andPort:1];
+    DMCPeerRecorder *recorder = [DMCPeerRecorder new];
+    dispatch_queue_t queue = dispatch_queue_create("DMCPeerTests", DISPATCH_QUEUE_SERIAL);
+    DMCOutputQueue *output = [DMCOutputQueue new];
+    NSMutableData *payload = [NSMutableData data];
+    NSUInteger count = 100000; // a few MB, so it arrives over many reads
+
+    [peer setDelegate:recorder queue:queue];
+    [payload appendVarInt:count];
+
+    for (NSUInteger i = 0; i < count; i++) {
+        [payload appendString:[NSString stringWithFormat:@"address%lu", (unsigned long)i]];
+        [payload appendUInt64:(uint64_t)((int64_t)i - 1)];
+    }
+
+    [output appendMessage:payload type:MSG_BALANCEBYADDR];
+
+    for (NSArray *message in [self messagesFramedByQueue:output]) {
+        [peer acceptMessage:message[1] command:[message[0] UTF8String]];
+    }
+
+    dispatch_sync(queue, ^{ }); // the balances are delivered on the delegate queue
+    NSAssert(recorder.balances.count == count, @"Should relay every balance");
+    NSAssert([recorder.balances[@"address0"] isEqual:@(-1)], @"Should read balances as int64");
+    NSAssert([recorder.balances[@"address99999"] isEqual:@(99998)], @"Should read the last balance");
+}
+
+@end
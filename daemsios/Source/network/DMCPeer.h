@@ -12,6 +12,8 @@
 
 #define DAEMSCOIN_TIMEOUT_CODE  1001
 
+#define MAX_GETDATA_HASHES 50000 // hashes in one getdata or gettxs message
+
 #define SERVICES_NODE_NETWORK 0x01 // services value indicating a node carries full blocks, not just headers
 #define SERVICES_NODE_BLOOM   0x04 // BIP111: https://github.com/bitcoin/bips/blob/master/bip-0111.mediawiki
 #define USER_AGENT            [NSString stringWithFormat:@"/daems:%@/",\
@@ -69,7 +71,7 @@
 typedef union _UInt256 UInt256;
 typedef union _UInt128 UInt128;
 
-@class DMCPeer, DMCTransaction, DMCMerkleBlock;
+@class DMCPeer, DMCTransaction, DMCMerkleBlock, DMCOutpoint;
 
 @protocol DMCPeerDelegate<NSObject>
 @required
@@ -81,13 +83,37 @@ typedef union _UInt128 UInt128;
 - (void)peer:(DMCPeer *)peer hasTransaction:(UInt256)txHash;
 - (void)peer:(DMCPeer *)peer rejectedTransaction:(UInt256)txHash withCode:(uint8_t)code;
 
-// called when the peer relays either a merkleblock or a block header, headers will have 0 totalTransactions
+// called when the peer relays a merkleblock, after the tx messages for all of its matched transactions
 - (void)peer:(DMCPeer *)peer relayedBlock:(DMCMerkleBlock *)block;
 
 - (void)peer:(DMCPeer *)peer notfoundTxHashes:(NSArray *)txHashes andBlockHashes:(NSArray *)blockhashes;
 - (void)peer:(DMCPeer *)peer setFeePerKb:(uint64_t)feePerKb;
 - (DMCTransaction *)peer:(DMCPeer *)peer requestedTransaction:(UInt256)txHash;
 
+@optional
+
+// headers: count headers as in the message, 81 bytes each (80 byte header followed by a zero tx count)
+- (void)peer:(DMCPeer *)peer relayedHeaders:(NSData *)headers count:(NSUInteger)count;
+
+/***** daems协议 *****/
+
+// balancebyaddr: balances (NSNumber, int64) by address
+- (void)peer:(DMCPeer *)peer relayedBalances:(NSDictionary *)balances;
+
+// txidsbyaddress: txHashes (uint256_obj) and the block heights (NSNumber) they were confirmed at
+- (void)peer:(DMCPeer *)peer relayedTxHashes:(NSArray *)txHashes heights:(NSArray *)heights
+forAddress:(NSString *)address;
+
+// tx4lightnode
+- (void)peer:(DMCPeer *)peer relayedTransactions:(NSArray *)transactions;
+
+// availablecheques: cheque outpoints (DMCOutpoint) and their values (NSNumber, int64)
+- (void)peer:(DMCPeer *)peer relayedCheques:(NSArray *)outpoints values:(NSArray *)values
+forAddress:(NSString *)address;
+
+// registered: addresses the node has confirmed as registered
+- (void)peer:(DMCPeer *)peer registeredAddresses:(NSArray *)addresses;
+
 @end
 
 //连接状态枚举
@@ -97,7 +123,7 @@ typedef enum : NSInteger {
     DMCPeerStatusConnected
 } DMCPeerStatus;
 
-@interface DMCPeer : NSObject<NSStreamDelegate>
+@interface DMCPeer : NSObject
 
 @property (nonatomic, readonly) id<DMCPeerDelegate> delegate;
 @property (nonatomic, readonly) dispatch_queue_t delegateQueue;
@@ -117,6 +143,7 @@ typedef enum : NSInteger {
 @property (nonatomic, readonly) uint64_t feePerKb; // minimum tx fee rate peer will accept
 @property (nonatomic, readonly) NSTimeInterval pingTime;
 @property (nonatomic, readonly) NSTimeInterval relaySpeed; // headers or block->totalTx per second being relayed
+@property (nonatomic, readonly) NSUInteger outputBacklog; // bytes queued for sending, check before queuing more
 @property (nonatomic, assign) NSTimeInterval timestamp; // timestamp reported by peer (interval since refrence date)
 @property (nonatomic, assign) int16_t misbehavin;
 
@@ -177,7 +204,7 @@ typedef enum : NSInteger {
 /**
  发送消息
 
- @param message 消息主体payload
+ @param message 消息主体payload, kept by reference until sent (mutable data is copied)
  @param type 类型
  */
 - (void)sendMessage:(NSData *)message type:(NSString *)type;
@@ -190,6 +217,13 @@ typedef enum : NSInteger {
  */
 - (void)sendFilterloadMessage:(NSData *)filter;
 
+/**
+ filteradd: 向已加载的过滤器添加一个元素，不必重新发送filterload
+ Use it for newly derived addresses while DMCBloomFilter.needsReload is NO, then send a fresh filterload.
+ @param element pubkey hash or serialized outpoint, at most 520 bytes
+ */
+- (void)sendFilteraddMessage:(NSData *)element;
+
 
 - (void)sendMempoolMessage:(NSArray *)publishedTxHashes completion:(void (^)(BOOL success))completion;
 
@@ -201,4 +235,57 @@ typedef enum : NSInteger {
 - (void)sendPingMessageWithPongHandler:(void (^)(BOOL success))pongHandler;
 - (void)rerequestBlocksFrom:(UInt256)blockHash; // useful to get additional transactions after a bloom filter update
 
+/***** daems协议 *****/
+
+/**
+ 查询地址余额, replies arrive as peer:relayedBalances:
+
+ @param addresses addresses to query, split over as many getbalancebyaddr messages as needed to stay under the
+ maximum message length
+ */
+- (void)sendGetbalancebyaddrMessageWithAddresses:(NSArray *)addresses;
+
+/**
+ 向节点请求其已知的节点地址, the reply arrives as peer:relayedPeers:
+ */
+- (void)sendGetnodeaddressesMessage;
+
+/**
+ 注册地址, confirmations arrive as peer:registeredAddresses:
+
+ @param addresses addresses to register, split over as many registeraddr messages as needed
+ */
+- (void)sendRegisteraddrMessageWithAddresses:(NSArray *)addresses;
+
+/**
+ 查询地址在一段区块高度内的交易, the reply arrives as peer:relayedTxHashes:heights:forAddress:
+
+ @param address 地址
+ @param fromHeight first block height, inclusive
+ @param toHeight last block height, inclusive
+ */
+- (void)sendGettxidsbyaddrMessageWithAddress:(NSString *)address fromHeight:(uint32_t)fromHeight
+toHeight:(uint32_t)toHeight;
+
+/**
+ 按txid获取交易, the reply arrives as peer:relayedTransactions:
+
+ @param txHashes up to 50000 txHashes (uint256_obj)
+ */
+- (void)sendGettxsMessageWithTxHashes:(NSArray *)txHashes;
+
+/**
+ 查询地址的可用支票, the reply arrives as peer:relayedCheques:values:forAddress:
+
+ @param address 地址
+ */
+- (void)sendGetavailablechequesMessageWithAddress:(NSString *)address;
+
+/**
+ 作废支票. Mark them with -[DMCChequeIndex disableCheques:] as well so they leave spend selection right away.
+
+ @param outpoints cheque outpoints (DMCOutpoint)
+ */
+- (void)sendDisablechequeMessageWithOutpoints:(NSArray *)outpoints;
+
 @end
@@ -2,20 +2,31 @@
 //  DMCPeer.m
 
 #import "DMCPeer.h"
+#import "DMCMessageFramer.h"
+#import "DMCPeerReactor.h"
+#import "DMCOutputQueue.h"
 #import "DMCTransaction.h"
-//#import "DMCMerkleBlock.h"
+#import "DMCOutpoint.h"
+#import "DMCByteCursor.h"
+#import "DMCMerkleBlock.h"
+#import "DMCBlockHeader.h"
 #import "NSMutableData+DaemsCoin.h"
 #import "NSData+DaemsCoin.h"
 #import "Reachability.h"
 #import <arpa/inet.h>
+#import <netinet/tcp.h>
+#import <sys/socket.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <objc/message.h>
 
 #if ! PEER_LOGGING
 #define NSLog(...)
 #endif
 
-#define HEADER_LENGTH      24
 #define MAX_MSG_LENGTH     0x02000000
-#define MAX_GETDATA_HASHES 50000
+#define MAX_FILTERADD_LENGTH 520 // MAX_SCRIPT_ELEMENT_SIZE
+#define MAX_HEADERS        2000  // headers in one headers message
 #define ENABLED_SERVICES   0     // we don't provide full blocks to remote nodes
 #define PROTOCOL_VERSION   70013
 #define MIN_PROTO_VERSION  70002 // peers earlier than this protocol version not supported (need v0.9 txFee relay rules)
@@ -35,11 +46,14 @@ typedef enum : uint32_t {
 @property (nonatomic, assign) id<DMCPeerDelegate> delegate;
 @property (nonatomic, strong) dispatch_queue_t delegateQueue;
 
-//Socket输入输出流
-@property (nonatomic, strong) NSInputStream *inputStream;
-@property (nonatomic, strong) NSOutputStream *outputStream;
+//Socket读写事件，由所有节点共用的事件循环处理
+@property (nonatomic, strong) DMCReactorSocket *socket;
+@property (nonatomic, assign) BOOL socketOpen;
+@property (nonatomic, assign) DMCReactorTimer connectTimer, mempoolTimer;
 
-@property (nonatomic, strong) NSMutableData *msgHeader, *msgPayload, *outputBuffer;
+@property (nonatomic, strong) DMCMessageFramer *framer;
+@property (nonatomic, strong) DMCOutputQueue *outputQueue;
+@property (nonatomic, assign) NSUInteger outputBacklog;
 @property (nonatomic, assign) BOOL sentVerack, gotVerack;
 @property (nonatomic, assign) BOOL sentGetaddr, sentFilter, sentGetdata, sentMempool, sentGetblocks;
 @property (nonatomic, strong) Reachability *reachability;
@@ -47,14 +61,11 @@ typedef enum : uint32_t {
 @property (nonatomic, assign) uint64_t localNonce;
 @property (nonatomic, assign) NSTimeInterval pingStartTime, relayStartTime;
 @property (nonatomic, strong) DMCMerkleBlock *currentBlock;
-@property (nonatomic, strong) NSMutableOrderedSet *knownBlockHashes, *knownTxHashes, *currentBlockTxHashes;
+@property (nonatomic, strong) NSMutableOrderedSet *knownBlockHashes, *knownTxHashes;
 @property (nonatomic, strong) NSData *lastBlockHash;
 @property (nonatomic, strong) NSMutableArray *pongHandlers;
 @property (nonatomic, strong) void (^mempoolCompletion)(BOOL);
 
-//使用一个runloop来处理每个节点的连接
-@property (nonatomic, strong) NSRunLoop *runLoop;
-
 @end
 
 @implementation DMCPeer
@@ -89,7 +100,8 @@ services:(uint64_t)services
 {
     [self.reachability stopNotifier];
     if (self.reachabilityObserver) [[NSNotificationCenter defaultCenter] removeObserver:self.reachabilityObserver];
-    [NSObject cancelPreviousPerformRequestsWithTarget:self];
+    [[DMCPeerReactor sharedReactor] cancelTimer:self.connectTimer];
+    [[DMCPeerReactor sharedReactor] cancelTimer:self.mempoolTimer];
 }
 
 - (void)setDelegate:(id<DMCPeerDelegate>)delegate queue:(dispatch_queue_t)delegateQueue
@@ -148,50 +160,97 @@ services:(uint64_t)services
         self.reachabilityObserver = nil;
     }
 
-    self.msgHeader = [NSMutableData data];
-    self.msgPayload = [NSMutableData data];
-    self.outputBuffer = [NSMutableData data];
+    self.framer = [DMCMessageFramer new];
+    self.outputQueue = [DMCOutputQueue new];
+    self.outputBacklog = 0;
     self.gotVerack = self.sentVerack = NO;
     self.sentFilter = self.sentGetaddr = self.sentGetdata = self.sentMempool = self.sentGetblocks = NO;
     self.needsFilterUpdate = NO;
     self.knownTxHashes = [NSMutableOrderedSet orderedSet];
     self.knownBlockHashes = [NSMutableOrderedSet orderedSet];
     self.currentBlock = nil;
-    self.currentBlockTxHashes = nil;
-
-    NSString *label = [NSString stringWithFormat:@"peer.%@:%u", self.host, self.port];
 
-    // 异步线程，处理socket的runloop运行
-    dispatch_async(dispatch_queue_create(label.UTF8String, NULL), ^{
-        CFReadStreamRef readStream = NULL;
-        CFWriteStreamRef writeStream = NULL;
+    // 所有节点的socket在同一个事件循环中处理，不再为每个节点开启线程
+    dispatch_async([DMCPeerReactor sharedReactor].queue, ^{
+        if (_status != DMCPeerStatusConnecting) return; // disconnected before the reactor got to it
 
         NSLog(@"%@:%u connecting", self.host, self.port);
+
         //建立socket连接
-        CFStreamCreatePairWithSocketToHost(NULL, (__bridge CFStringRef)self.host, self.port, &readStream, &writeStream);
-        self.inputStream = CFBridgingRelease(readStream);
-        self.outputStream = CFBridgingRelease(writeStream);
-        
-        //把socket的输入输出流注册到runloop中，通过runloop的时钟监听
-        self.inputStream.delegate = self.outputStream.delegate = self;
-        self.runLoop = [NSRunLoop currentRunLoop];
-        [self.inputStream scheduleInRunLoop:self.runLoop forMode:NSRunLoopCommonModes];
-        [self.outputStream scheduleInRunLoop:self.runLoop forMode:NSRunLoopCommonModes];
-        
-        // 发送一个超时执行命令，如果超时了，就执行断开节点，如果连接了，就取消这个命令执行
-        [self performSelector:@selector(disconnectWithError:)
-         withObject:[NSError errorWithDomain:@"Daems" code:DAEMSCOIN_TIMEOUT_CODE
-                     userInfo:@{NSLocalizedDescriptionKey:NSLocalizedString(@"connect timeout", nil)}]
-         afterDelay:CONNECT_TIMEOUT];
-        
-        [self.inputStream open];        //打开socket输入
-        [self.outputStream open];       //打开socket输出
+        struct sockaddr_storage addr;
+        socklen_t addrLen = [self socketAddress:&addr];
+        int fd = socket(addr.ss_family, SOCK_STREAM, IPPROTO_TCP), on = 1;
+
+        if (fd < 0) {
+            [self disconnectWithError:[NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil]];
+            return;
+        }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+#ifdef SO_NOSIGPIPE
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+        if (connect(fd, (struct sockaddr *)&addr, addrLen) < 0 && errno != EINPROGRESS) {
+            NSError *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+
+            close(fd);
+            [self disconnectWithError:error];
+            return;
+        }
+
+        // the write handler is called once the connection is established
+        self.socketOpen = NO;
+        self.socket = [[DMCPeerReactor sharedReactor] watchSocket:fd readHandler:^{
+            [self socketReadable];
+        } writeHandler:^{
+            [self socketWritable];
+        }];
+
+        // 超时未连接则断开节点，连接后取消
+        [self startConnectTimeout];
         [self sendVersionMessage];      //向节点发送版本握手
-        [self.runLoop run];             //开启同步，如果不主动断开，runloop是死循环
-        //runLoop run后将不会执行下段代码
     });
 }
 
+// IPv4 addresses are stored as IPv4-mapped IPv6 addresses
+- (socklen_t)socketAddress:(struct sockaddr_storage *)addr
+{
+    memset(addr, 0, sizeof(*addr));
+
+    if (_address.u64[0] == 0 && _address.u32[2] == CFSwapInt32HostToBig(0xffff)) {
+        struct sockaddr_in *sin = (struct sockaddr_in *)addr;
+
+        sin->sin_family = AF_INET;
+        sin->sin_port = CFSwapInt16HostToBig(self.port);
+        sin->sin_addr.s_addr = _address.u32[3];
+        sin->sin_len = sizeof(*sin);
+        return sizeof(*sin);
+    }
+    else {
+        struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)addr;
+
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = CFSwapInt16HostToBig(self.port);
+        memcpy(&sin6->sin6_addr, &_address, sizeof(_address));
+        sin6->sin6_len = sizeof(*sin6);
+        return sizeof(*sin6);
+    }
+}
+
+- (void)startConnectTimeout
+{
+    DMCPeerReactor *reactor = [DMCPeerReactor sharedReactor];
+
+    [reactor cancelTimer:self.connectTimer];
+    self.connectTimer = [reactor scheduleTimer:CONNECT_TIMEOUT handler:^{
+        self.connectTimer = 0;
+        [self disconnectWithError:[NSError errorWithDomain:@"Daems" code:DAEMSCOIN_TIMEOUT_CODE
+                                   userInfo:@{NSLocalizedDescriptionKey:NSLocalizedString(@"connect timeout", nil)}]];
+    }];
+}
+
 - (void)disconnect
 {
     [self disconnectWithError:nil];
@@ -205,8 +264,6 @@ services:(uint64_t)services
  */
 - (void)disconnectWithError:(NSError *)error
 {
-    [NSObject cancelPreviousPerformRequestsWithTarget:self]; // cancel connect timeout
-    
     if (_status == DMCPeerStatusDisconnected) return;
     _status = DMCPeerStatusDisconnected;
 
@@ -217,17 +274,21 @@ services:(uint64_t)services
         self.reachabilityObserver = nil;
     }
 
-    if (! self.runLoop) return;
-    [self.inputStream close];
-    [self.outputStream close];
-    [self.inputStream removeFromRunLoop:self.runLoop forMode:NSRunLoopCommonModes];
-    [self.outputStream removeFromRunLoop:self.runLoop forMode:NSRunLoopCommonModes];
-    CFRunLoopStop([self.runLoop getCFRunLoop]);
-        
-    _status = DMCPeerStatusDisconnected;
+    if (! self.framer) return; // never got as far as connecting
+
+    DMCPeerReactor *reactor = [DMCPeerReactor sharedReactor];
+
+    dispatch_async(reactor.queue, ^{
+        [reactor cancelTimer:self.connectTimer]; // cancel connect timeout
+        [reactor cancelTimer:self.mempoolTimer];
+        self.connectTimer = self.mempoolTimer = 0;
+        [self.socket close];
+        self.socket = nil;
+        [self.outputQueue removeAllMessages];
+        self.outputBacklog = 0;
+    });
+
     dispatch_async(self.delegateQueue, ^{
-        [NSObject cancelPreviousPerformRequestsWithTarget:self];
-        
         while (self.pongHandlers.count) {
             ((void (^)(BOOL))self.pongHandlers[0])(NO);
             [self.pongHandlers removeObjectAtIndex:0];
@@ -258,7 +319,8 @@ services:(uint64_t)services
     if (self.status != DMCPeerStatusConnecting || ! self.sentVerack || ! self.gotVerack) return;
 
     NSLog(@"%@:%u handshake completed", self.host, self.port);
-    [NSObject cancelPreviousPerformRequestsWithTarget:self]; // 取消超时处理的延迟执行命令
+    [[DMCPeerReactor sharedReactor] cancelTimer:self.connectTimer]; // 取消超时处理
+    self.connectTimer = 0;
     _status = DMCPeerStatusConnected;
 
     dispatch_async(self.delegateQueue, ^{
@@ -278,23 +340,16 @@ services:(uint64_t)services
         return;
     }
 
-    if (! self.runLoop) return;
-    
-    //把写入到输出流过程放在到runloop周期中执行
-    CFRunLoopPerformBlock([self.runLoop getCFRunLoop], kCFRunLoopCommonModes, ^{
+    //把写入socket的过程放在事件循环中执行
+    dispatch_async([DMCPeerReactor sharedReactor].queue, ^{
+        if (! self.socket) return;
         NSLog(@"%@:%u sending %@", self.host, self.port, type);
 
-        //把消息主题放在协议体中
-        [self.outputBuffer appendMessage:message type:type];
-        
-        while (self.outputBuffer.length > 0 && self.outputStream.hasSpaceAvailable) {
-            NSInteger l = [self.outputStream write:self.outputBuffer.bytes maxLength:self.outputBuffer.length];
-
-            if (l > 0) [self.outputBuffer replaceBytesInRange:NSMakeRange(0, l) withBytes:NULL length:0];
-            //if (self.outputBuffer.length == 0) NSLog(@"%@:%u output buffer cleared", self.host, self.port);
-        }
+        //把消息头和消息主体放入发送队列，消息主体不复制
+        [self.outputQueue appendMessage:message type:type];
+        self.outputBacklog = self.outputQueue.length;
+        if (self.socketOpen) [self writeOutput];
     });
-    CFRunLoopWakeUp([self.runLoop getCFRunLoop]);
 }
 
 - (void)sendVersionMessage
@@ -333,12 +388,24 @@ services:(uint64_t)services
     [self sendMessage:filter type:MSG_FILTERLOAD];
 }
 
+- (void)sendFilteraddMessage:(NSData *)element
+{
+    if (element.length > MAX_FILTERADD_LENGTH) {
+        NSLog(@"%@:%u filteradd element too long (%u bytes)", self.host, self.port, (int)element.length);
+        return;
+    }
+
+    NSMutableData *msg = [NSMutableData data];
+
+    [msg appendVarInt:element.length];
+    [msg appendData:element];
+    [self sendMessage:msg type:MSG_FILTERADD];
+}
+
 - (void)mempoolTimeout
 {
-    dispatch_async(self.delegateQueue, ^{
-        [NSObject cancelPreviousPerformRequestsWithTarget:self];
-    });
-    
+    [[DMCPeerReactor sharedReactor] cancelTimer:self.mempoolTimer];
+    self.mempoolTimer = 0;
     [self sendPingMessageWithPongHandler:self.mempoolCompletion];
     self.mempoolCompletion = nil;
 }
@@ -356,9 +423,11 @@ services:(uint64_t)services
         }
         else {
             self.mempoolCompletion = completion;
-            dispatch_async(self.delegateQueue, ^{
-                [self performSelector:@selector(mempoolTimeout) withObject:nil afterDelay:MEMPOOL_TIMEOUT];
-            });
+            self.mempoolTimer = [[DMCPeerReactor sharedReactor] scheduleTimer:MEMPOOL_TIMEOUT handler:^{
+                dispatch_async(self.delegateQueue, ^{
+                    if (self.mempoolCompletion) [self mempoolTimeout];
+                });
+            }];
         }
     }
         
@@ -496,6 +565,117 @@ services:(uint64_t)services
     [self sendMessage:[NSData data] type:MSG_GETADDR];
 }
 
+- (void)sendGetnodeaddressesMessage
+{
+    [self sendMessage:[NSData data] type:MSG_GETNODEADDRESSES];
+}
+
+// getbalancebyaddr: count (var_int), then the addresses (var_str)
+- (void)sendGetbalancebyaddrMessageWithAddresses:(NSArray *)addresses
+{
+    [self sendAddressListMessage:addresses type:MSG_GETBALANCEBYADDR];
+}
+
+// registeraddr: count (var_int), then the addresses (var_str)
+- (void)sendRegisteraddrMessageWithAddresses:(NSArray *)addresses
+{
+    [self sendAddressListMessage:addresses type:MSG_REGISTERADDR];
+}
+
+// sends an address list in as many messages as needed to stay under MAX_MSG_LENGTH
+- (void)sendAddressListMessage:(NSArray *)addresses type:(NSString *)type
+{
+    NSMutableData *list = [NSMutableData data];
+    NSUInteger count = 0;
+
+    for (NSString *address in addresses) {
+        NSUInteger l = list.length;
+
+        [list appendString:address];
+
+        if (count > 0 && list.length + 9 > MAX_MSG_LENGTH) { // 9 bytes is the longest possible var_int count
+            NSMutableData *msg = [NSMutableData dataWithCapacity:l + 9];
+
+            [msg appendVarInt:count];
+            [msg appendBytes:list.bytes length:l];
+            [self sendMessage:msg type:type];
+            [list replaceBytesInRange:NSMakeRange(0, l) withBytes:NULL length:0];
+            count = 0;
+        }
+
+        count++;
+    }
+
+    if (count == 0) return;
+
+    NSMutableData *msg = [NSMutableData dataWithCapacity:list.length + 9];
+
+    [msg appendVarInt:count];
+    [msg appendData:list];
+    [self sendMessage:msg type:type];
+}
+
+// gettxidsbyaddr: address (var_str), from height (uint32), to height (uint32)
+- (void)sendGettxidsbyaddrMessageWithAddress:(NSString *)address fromHeight:(uint32_t)fromHeight
+toHeight:(uint32_t)toHeight
+{
+    NSMutableData *msg = [NSMutableData data];
+
+    [msg appendString:address];
+    [msg appendUInt32:fromHeight];
+    [msg appendUInt32:toHeight];
+    [self sendMessage:msg type:MSG_GETTXIDSBYADDR];
+}
+
+// gettxs: count (var_int), then the txids (uint256)
+- (void)sendGettxsMessageWithTxHashes:(NSArray *)txHashes
+{
+    if (txHashes.count > MAX_GETDATA_HASHES) {
+        NSLog(@"%@:%u couldn't send gettxs, %u is too many items, max is %u", self.host, self.port,
+              (int)txHashes.count, MAX_GETDATA_HASHES);
+        return;
+    }
+    else if (txHashes.count == 0) return;
+
+    NSMutableData *msg = [NSMutableData dataWithCapacity:9 + txHashes.count*sizeof(UInt256)];
+    UInt256 h;
+
+    [msg appendVarInt:txHashes.count];
+
+    for (NSValue *hash in txHashes) {
+        [hash getValue:&h];
+        [msg appendBytes:&h length:sizeof(h)];
+    }
+
+    [self sendMessage:msg type:MSG_GETTXS];
+}
+
+// getavailablecheques: address (var_str)
+- (void)sendGetavailablechequesMessageWithAddress:(NSString *)address
+{
+    NSMutableData *msg = [NSMutableData data];
+
+    [msg appendString:address];
+    [self sendMessage:msg type:MSG_GETAVAILABLECHEQUES];
+}
+
+// disablecheque: count (var_int), then for each cheque: txid (uint256), index (uint32)
+- (void)sendDisablechequeMessageWithOutpoints:(NSArray *)outpoints
+{
+    if (outpoints.count == 0) return;
+
+    NSMutableData *msg = [NSMutableData dataWithCapacity:9 + outpoints.count*(sizeof(UInt256) + sizeof(uint32_t))];
+
+    [msg appendVarInt:outpoints.count];
+
+    for (DMCOutpoint *outpoint in outpoints) {
+        [msg appendData:outpoint.txHash];
+        [msg appendUInt32:outpoint.index];
+    }
+
+    [self sendMessage:msg type:MSG_DISABLECHEQUE];
+}
+
 - (void)sendPingMessageWithPongHandler:(void (^)(BOOL success))pongHandler;
 {
     NSMutableData *msg = [NSMutableData data];
@@ -523,36 +703,97 @@ services:(uint64_t)services
 
 // MARK: - accept
 
-- (void)acceptMessage:(NSData *)message type:(NSString *)type
+#define COMMAND_TABLE_SIZE 64 // power of two, more than twice the number of handled commands
+
+// the 12 byte zero padded command field is compared as two integers, so no string is created per message
+typedef struct {
+    uint64_t command0; // command bytes 0-7
+    uint32_t command1; // command bytes 8-11
+    SEL selector;
+} DMCCommandHandler;
+
+static DMCCommandHandler commandTable[COMMAND_TABLE_SIZE];
+
+static NSUInteger DMCCommandSlot(uint64_t command0, uint32_t command1)
 {
+    return (NSUInteger)((command0*0x9e3779b97f4a7c15ull ^ command1*0xc2b2ae3d27d4eb4full) >> 58); // top 6 bits
+}
+
+static SEL DMCCommandSelector(const char *command)
+{
+    uint64_t command0;
+    uint32_t command1;
+
+    memcpy(&command0, command, sizeof(command0));
+    memcpy(&command1, command + sizeof(command0), sizeof(command1));
+
+    for (NSUInteger i = DMCCommandSlot(command0, command1); commandTable[i].selector;
+         i = (i + 1) % COMMAND_TABLE_SIZE) {
+        if (commandTable[i].command0 == command0 && commandTable[i].command1 == command1) {
+            return commandTable[i].selector;
+        }
+    }
+
+    return NULL;
+}
+
+static void DMCRegisterCommand(NSString *type, SEL selector)
+{
+    char command[DMC_MESSAGE_COMMAND_LENGTH] = { 0 };
+    uint64_t command0;
+    uint32_t command1;
+
+    strncpy(command, type.UTF8String, sizeof(command)); // longer daems commands are sent as their first 12 bytes
+    memcpy(&command0, command, sizeof(command0));
+    memcpy(&command1, command + sizeof(command0), sizeof(command1));
+
+    NSUInteger i = DMCCommandSlot(command0, command1);
+
+    while (commandTable[i].selector) i = (i + 1) % COMMAND_TABLE_SIZE;
+    commandTable[i] = (DMCCommandHandler){ command0, command1, selector };
+}
+
++ (void)initialize
+{
+    if (self != [DMCPeer class]) return;
+
+    DMCRegisterCommand(MSG_VERSION, @selector(acceptVersionMessage:));
+    DMCRegisterCommand(MSG_VERACK, @selector(acceptVerackMessage:));
+    DMCRegisterCommand(MSG_ADDR, @selector(acceptAddrMessage:));
+    DMCRegisterCommand(MSG_INV, @selector(acceptInvMessage:));
+    DMCRegisterCommand(MSG_TX, @selector(acceptTxMessage:));
+    DMCRegisterCommand(MSG_HEADERS, @selector(acceptHeadersMessage:));
+    DMCRegisterCommand(MSG_GETADDR, @selector(acceptGetaddrMessage:));
+    DMCRegisterCommand(MSG_GETDATA, @selector(acceptGetdataMessage:));
+    DMCRegisterCommand(MSG_NOTFOUND, @selector(acceptNotfoundMessage:));
+    DMCRegisterCommand(MSG_PING, @selector(acceptPingMessage:));
+    DMCRegisterCommand(MSG_PONG, @selector(acceptPongMessage:));
+    DMCRegisterCommand(MSG_MERKLEBLOCK, @selector(acceptMerkleblockMessage:));
+    DMCRegisterCommand(MSG_REJECT, @selector(acceptRejectMessage:));
+    DMCRegisterCommand(MSG_FEEFILTER, @selector(acceptFeeFilterMessage:));
+    /***** daems协议 *****/
+    DMCRegisterCommand(MSG_BALANCEBYADDR, @selector(acceptBalancebyaddrMessage:));
+    DMCRegisterCommand(MSG_TXIDSBYADDRESS, @selector(acceptTxidsbyaddressMessage:));
+    DMCRegisterCommand(MSG_TX4LIGHTNODE, @selector(acceptTx4lightnodeMessage:));
+    DMCRegisterCommand(MSG_AVAILABLECHEQUES, @selector(acceptAvailablechequesMessage:));
+    DMCRegisterCommand(MSG_NODEADDRESSES, @selector(acceptNodeaddressesMessage:));
+    DMCRegisterCommand(MSG_REGISTERED, @selector(acceptRegisteredMessage:));
+}
+
+- (void)acceptMessage:(NSData *)message command:(const char *)command
+{
+    SEL selector = DMCCommandSelector(command);
     
-    if (self.currentBlock && ! [MSG_TX isEqual:type]) { // if we receive a non-tx message, merkleblock is done
-        //当所有交易单接收完
-        /*
-        UInt256 hash = self.currentBlock.blockHash;
-        
+    // if we receive a non-tx message, merkleblock is done
+    if (self.currentBlock && selector != @selector(acceptTxMessage:)) {
+        DMCMerkleBlock *block = self.currentBlock;
+
         self.currentBlock = nil;
-        self.currentBlockTxHashes = nil;
-        [self error:@"incomplete merkleblock %@, expected %u more tx, got %@",
-         uint256_obj(hash), (int)self.currentBlockTxHashes.count, type];
-         */
-    }
-    else if ([MSG_VERSION isEqual:type]) [self acceptVersionMessage:message];
-    else if ([MSG_VERACK isEqual:type]) [self acceptVerackMessage:message];
-    else if ([MSG_ADDR isEqual:type]) [self acceptAddrMessage:message];
-    else if ([MSG_INV isEqual:type]) [self acceptInvMessage:message];
-    else if ([MSG_TX isEqual:type]) [self acceptTxMessage:message];
-    else if ([MSG_HEADERS isEqual:type]) [self acceptHeadersMessage:message];
-    else if ([MSG_GETADDR isEqual:type]) [self acceptGetaddrMessage:message];
-    else if ([MSG_GETDATA isEqual:type]) [self acceptGetdataMessage:message];
-    else if ([MSG_NOTFOUND isEqual:type]) [self acceptNotfoundMessage:message];
-    else if ([MSG_PING isEqual:type]) [self acceptPingMessage:message];
-    else if ([MSG_PONG isEqual:type]) [self acceptPongMessage:message];
-    else if ([MSG_MERKLEBLOCK isEqual:type]) [self acceptMerkleblockMessage:message];
-    else if ([MSG_REJECT isEqual:type]) [self acceptRejectMessage:message];
-    else if ([MSG_FEEFILTER isEqual:type]) [self acceptFeeFilterMessage:message];
-    else NSLog(@"%@:%u dropping %@, len:%u, not implemented", self.host, self.port, type, (int)message.length);
-    
+        [self error:@"incomplete merkleblock %@, expected %u more tx, got %s", block.header.blockID,
+         (int)block.missingTransactionCount, command];
+    }
+    else if (selector) ((void (*)(id, SEL, NSData *))objc_msgSend)(self, selector, message);
+    else NSLog(@"%@:%u dropping %s, len:%u, not implemented", self.host, self.port, command, (int)message.length);
 }
 
 - (void)acceptVersionMessage:(NSData *)message
@@ -601,6 +842,11 @@ services:(uint64_t)services
 
 // TODO: relay addresses
 - (void)acceptAddrMessage:(NSData *)message
+{
+    [self acceptAddrMessage:message solicited:self.sentGetaddr];
+}
+
+- (void)acceptAddrMessage:(NSData *)message solicited:(BOOL)solicited
 {
     if (message.length > 0 && [message UInt8AtOffset:0] == 0) {
         NSLog(@"%@:%u got addr with 0 addresses", self.host, self.port);
@@ -610,7 +856,7 @@ services:(uint64_t)services
         [self error:@"malformed addr message, length %u is too short", (int)message.length];
         return;
     }
-    else if (! self.sentGetaddr) return; // simple anti-tarpitting tactic, don't accept unsolicited addresses
+    else if (! solicited) return; // simple anti-tarpitting tactic, don't accept unsolicited addresses
 
     NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
     NSUInteger l, count = (NSUInteger)[message varIntAtOffset:0 length:&l];
@@ -740,10 +986,8 @@ services:(uint64_t)services
     }
     
     if (self.mempoolCompletion && (txHashes.count > 0 || blockHashes.count == 0)) {
-        dispatch_async(self.delegateQueue, ^{
-            [NSObject cancelPreviousPerformRequestsWithTarget:self];
-        });
-
+        [[DMCPeerReactor sharedReactor] cancelTimer:self.mempoolTimer];
+        self.mempoolTimer = 0;
         [self sendPingMessageWithPongHandler:self.mempoolCompletion];
         self.mempoolCompletion = nil;
     }
@@ -751,8 +995,11 @@ services:(uint64_t)services
 
 - (void)acceptTxMessage:(NSData *)message
 {
-    /*
-    DMCTransaction *tx = [DMCTransaction transactionWithMessage:message];
+    // the framer hashed the payload while receiving it, which for a tx message is the txid
+    // (DMCTransaction ignores it if the payload has bytes after the tx)
+    UInt256 txHash = self.framer.payloadHash;
+    DMCTransaction *tx = [[DMCTransaction alloc] initWithData:[NSData dataWithBytes:message.bytes length:message.length]
+                          transactionHash:[NSData dataWithBytes:&txHash length:sizeof(txHash)]];
     
     if (! tx) {
         [self error:@"malformed tx message: %@", message];
@@ -763,39 +1010,42 @@ services:(uint64_t)services
         return;
     }
     
-    NSLog(@"%@:%u got tx %@", self.host, self.port, uint256_obj(tx.txHash));
+    NSLog(@"%@:%u got tx %@", self.host, self.port, uint256_obj(txHash));
 
     dispatch_async(self.delegateQueue, ^{
         [self.delegate peer:self relayedTransaction:tx];
     });
 
-    if (self.currentBlock) { // we're collecting tx messages for a merkleblock
-        [self.currentBlockTxHashes removeObject:uint256_obj(tx.txHash)];
-
-        if (self.currentBlockTxHashes.count == 0) { // we received the entire block including all matched tx
-            DMCMerkleBlock *block = self.currentBlock;
+    // we're collecting tx messages for a merkleblock, the block goes out once it has all matched tx
+    if (self.currentBlock && [self.currentBlock addTransaction:tx] && self.currentBlock.missingTransactionCount == 0) {
+        DMCMerkleBlock *block = self.currentBlock;
 
-            self.currentBlock = nil;
-            self.currentBlockTxHashes = nil;
+        self.currentBlock = nil;
 
-            dispatch_sync(self.delegateQueue, ^{ // syncronous dispatch so we don't get too many queued up tx
-                [self.delegate peer:self relayedBlock:block];
-            });
-        }
+        dispatch_async(self.delegateQueue, ^{ // same queue as the tx, so the block follows its transactions
+            [self.delegate peer:self relayedBlock:block];
+        });
     }
-     */
 }
 
+// headers: count (var_int), then for each header: block header (80 bytes), tx count (var_int, always 0)
 - (void)acceptHeadersMessage:(NSData *)message
 {
-    /*
-    NSUInteger l, count = (NSUInteger)[message varIntAtOffset:0 length:&l], off;
+    NSUInteger l, count = (NSUInteger)[message varIntAtOffset:0 length:&l];
     
-    if (message.length < l + 81*count) {
-        [self error:@"malformed headers message, length is %u, should be %u for %u items", (int)message.length,
-         (int)(((l == 0) ? 1 : l) + count*81), (int)count];
+    // count comes from the peer, so bound it before multiplying
+    if (l == 0 || count > MAX_HEADERS || count > (message.length - l)/81) {
+        [self error:@"malformed headers message, length is %u for %llu items", (int)message.length,
+         (unsigned long long)count];
         return;
     }
+    
+    for (NSUInteger off = l + 80; off < l + count*81; off += 81) {
+        if ([message UInt8AtOffset:off] != 0) {
+            [self error:@"malformed headers message, header %u has a transaction count", (int)((off - l)/81)];
+            return;
+        }
+    }
 
     NSLog(@"%@:%u got %u headers", self.host, self.port, (int)count);
 
@@ -806,47 +1056,15 @@ services:(uint64_t)services
         _relaySpeed = _relaySpeed*0.9 + speed*0.1;
         _relayStartTime = 0;
     }
-    
-    // To improve chain download performance, if this message contains 2000 headers then request the next 2000 headers
-    // immediately, and switch to requesting blocks when we receive a header newer than earliestKeyTime
-    NSTimeInterval t = [message UInt32AtOffset:l + 81*(count - 1) + 68] - NSTimeIntervalSince1970;
 
-    if (count >= 2000 || t + 7*24*60*60 >= self.earliestKeyTime - 2*60*60) {
-        NSValue *firstHash = uint256_obj([message subdataWithRange:NSMakeRange(l, 80)].SHA256_2),
-                *lastHash = uint256_obj([message subdataWithRange:NSMakeRange(l + 81*(count - 1), 80)].SHA256_2);
+    // copied out of the framer's buffer as one block, so the headers can be hashed and stored in bulk
+    NSData *headers = [NSData dataWithBytes:(const uint8_t *)message.bytes + l length:81*count];
 
-        if (t + 7*24*60*60 >= self.earliestKeyTime - 2*60*60) { // request blocks for the remainder of the chain
-            t = [message UInt32AtOffset:l + 81 + 68] - NSTimeIntervalSince1970;
-
-            for (off = l; t > 0 && t + 7*24*60*60 < self.earliestKeyTime - 2*60*60;) {
-                off += 81;
-                t = [message UInt32AtOffset:off + 81 + 68] - NSTimeIntervalSince1970;
-            }
-
-            lastHash = uint256_obj([message subdataWithRange:NSMakeRange(off, 80)].SHA256_2);
-            NSLog(@"%@:%u calling getblocks with locators: %@", self.host, self.port, @[lastHash, firstHash]);
-            [self sendGetblocksMessageWithLocators:@[lastHash, firstHash] andHashStop:UINT256_ZERO];
-        }
-        else [self sendGetheadersMessageWithLocators:@[lastHash, firstHash] andHashStop:UINT256_ZERO];
-    }
-    else {
-        [self error:@"non-standard headers message, %u is fewer headers than expected", (int)count];
-        return;
-    }
-    
-    for (NSUInteger off = l; off < l + 81*count; off += 81) {
-        DMCMerkleBlock *block = [DMCMerkleBlock blockWithMessage:[message subdataWithRange:NSMakeRange(off, 81)]];
-    
-        if (! block.valid) {
-            [self error:@"invalid block header %@", uint256_obj(block.blockHash)];
-            return;
+    dispatch_async(self.delegateQueue, ^{
+        if ([self.delegate respondsToSelector:@selector(peer:relayedHeaders:count:)]) {
+            [self.delegate peer:self relayedHeaders:headers count:count];
         }
-
-        dispatch_async(self.delegateQueue, ^{
-            [self.delegate peer:self relayedBlock:block];
-        });
-    }
-     */
+    });
 }
 
 - (void)acceptGetaddrMessage:(NSData *)message
@@ -872,12 +1090,15 @@ services:(uint64_t)services
     
     NSLog(@"%@:%u got getdata with %u items", self.host, self.port, (int)count);
 
+    // the message points into the framer's buffer, which is reused by the next read, so copy the items out first
+    NSData *items = [NSData dataWithBytes:(const uint8_t *)message.bytes + l length:count*36];
+
     dispatch_async(self.delegateQueue, ^{
         NSMutableData *notfound = [NSMutableData data];
     
-        for (NSUInteger off = l; off < l + count*36; off += 36) {
-            inv_type type = [message UInt32AtOffset:off];
-            UInt256 hash = [message hashAtOffset:off + sizeof(uint32_t)];
+        for (NSUInteger off = 0; off < items.length; off += 36) {
+            inv_type type = [items UInt32AtOffset:off];
+            UInt256 hash = [items hashAtOffset:off + sizeof(uint32_t)];
             DMCTransaction *transaction = nil;
         
             if (uint256_is_zero(hash)) continue;
@@ -944,7 +1165,7 @@ services:(uint64_t)services
     }
     
     NSLog(@"%@:%u got ping", self.host, self.port);
-    [self sendMessage:message type:MSG_PONG];
+    [self sendMessage:[NSData dataWithBytes:message.bytes length:message.length] type:MSG_PONG]; // message is a view
 }
 
 - (void)acceptPongMessage:(NSData *)message
@@ -983,36 +1204,37 @@ services:(uint64_t)services
 
 - (void)acceptMerkleblockMessage:(NSData *)message
 {
-    /*
     // DaemsCoin nodes don't support querying arbitrary transactions, only transactions not yet accepted in a block. After
     // a merkleblock message, the remote node is expected to send tx messages for the tx referenced in the block. When a
     // non-tx message is received we should have all the tx in the merkleblock.
-    DMCMerkleBlock *block = [DMCMerkleBlock blockWithMessage:message];
+    // the message is a view into the framer's buffer, the block keeps slices of it
+    DMCMerkleBlock *block = [[DMCMerkleBlock alloc] initWithData:[NSData dataWithBytes:message.bytes
+                                                                               length:message.length]];
     
-    if (! block.valid) {
-        [self error:@"invalid merkleblock: %@", uint256_obj(block.blockHash)];
+    if (! block.isValid) {
+        [self error:@"invalid merkleblock: %@%@", block.header.blockID,
+         (block.hasTailDuplicates) ? @" (duplicate merkle branches, CVE-2012-2459)" : @""];
         return;
     }
     else if (! self.sentFilter && ! self.sentGetdata) {
         [self error:@"got merkleblock message before loading a filter"];
         return;
     }
-    //else NSLog(@"%@:%u got merkleblock %@", self.host, self.port, block.blockHash);
-
-    NSMutableOrderedSet *txHashes = [NSMutableOrderedSet orderedSetWithArray:block.txHashes];
+    //else NSLog(@"%@:%u got merkleblock %@", self.host, self.port, block.header.blockID);
 
-    [txHashes minusOrderedSet:self.knownTxHashes];
+    // the remote node doesn't send tx we already have again
+    for (NSData *txHash in block.matchedTransactionHashes) {
+        if ([self.knownTxHashes containsObject:uint256_obj([txHash hashAtOffset:0])]) [block skipTransactionHash:txHash];
+    }
 
-    if (txHashes.count > 0) { // wait til we get all the tx messages before processing the block
+    if (block.missingTransactionCount > 0) { // wait til we get all the tx messages before processing the block
         self.currentBlock = block;
-        self.currentBlockTxHashes = txHashes;
     }
     else {
         dispatch_async(self.delegateQueue, ^{
             [self.delegate peer:self relayedBlock:block];
         });
     }
-     */
 }
 
 // BIP61: https://github.com/bitcoin/bips/blob/master/bip-0061.mediawiki
@@ -1051,6 +1273,188 @@ services:(uint64_t)services
     });
 }
 
+// MARK: - daems协议
+
+// balancebyaddr: count (var_int), then for each address: address (var_str), balance (int64)
+- (void)acceptBalancebyaddrMessage:(NSData *)message
+{
+    NSUInteger l, off, count = (NSUInteger)[message varIntAtOffset:0 length:&l];
+    NSMutableDictionary *balances = [NSMutableDictionary dictionary];
+
+    // count can be any var_int, so it is bounded by division before anything is multiplied or allocated
+    if (l == 0 || message.length < l || count > (message.length - l)/(1 + sizeof(int64_t))) {
+        [self error:@"malformed balancebyaddr message, length is %u, too short for %u addresses",
+         (int)message.length, (int)count];
+        return;
+    }
+
+    off = l;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        NSString *address = [message stringAtOffset:off length:&l];
+
+        if (! address || message.length < off + l + sizeof(int64_t)) {
+            [self error:@"malformed balancebyaddr message, length is %u", (int)message.length];
+            return;
+        }
+
+        balances[address] = @((int64_t)[message UInt64AtOffset:off + l]);
+        off += l + sizeof(int64_t);
+    }
+
+    NSLog(@"%@:%u got balancebyaddr with %u addresses", self.host, self.port, (int)count);
+
+    dispatch_async(self.delegateQueue, ^{
+        if ([self.delegate respondsToSelector:@selector(peer:relayedBalances:)]) {
+            [self.delegate peer:self relayedBalances:balances];
+        }
+    });
+}
+
+// txidsbyaddress: address (var_str), count (var_int), then for each tx: txid (uint256), height (uint32)
+- (void)acceptTxidsbyaddressMessage:(NSData *)message
+{
+    NSUInteger l, ll, count;
+    NSString *address = [message stringAtOffset:0 length:&l];
+
+    count = (NSUInteger)[message varIntAtOffset:l length:&ll];
+
+    if (! address || ll == 0 || message.length < l + ll ||
+        count > (message.length - l - ll)/(sizeof(UInt256) + sizeof(uint32_t))) {
+        [self error:@"malformed txidsbyaddress message, length is %u", (int)message.length];
+        return;
+    }
+
+    NSMutableArray *txHashes = [NSMutableArray arrayWithCapacity:count],
+                   *heights = [NSMutableArray arrayWithCapacity:count];
+
+    for (NSUInteger off = l + ll; off < l + ll + count*(sizeof(UInt256) + sizeof(uint32_t));
+         off += sizeof(UInt256) + sizeof(uint32_t)) {
+        [txHashes addObject:uint256_obj([message hashAtOffset:off])];
+        [heights addObject:@([message UInt32AtOffset:off + sizeof(UInt256)])];
+    }
+
+    NSLog(@"%@:%u got txidsbyaddress with %u txids", self.host, self.port, (int)count);
+
+    dispatch_async(self.delegateQueue, ^{
+        if ([self.delegate respondsToSelector:@selector(peer:relayedTxHashes:heights:forAddress:)]) {
+            [self.delegate peer:self relayedTxHashes:txHashes heights:heights forAddress:address];
+        }
+    });
+}
+
+// tx4lightnode: count (var_int), then the serialized transactions
+- (void)acceptTx4lightnodeMessage:(NSData *)message
+{
+    // transactions keep slices of the cursor's data, so they need their own copy of the payload
+    DMCByteCursor *cursor = [[DMCByteCursor alloc] initWithData:[NSData dataWithBytes:message.bytes
+                                                                 length:message.length]];
+    NSMutableArray *transactions = [NSMutableArray array];
+    uint64_t count = 0;
+
+    if (! [cursor readVarInt:&count] || count > cursor.remainingLength/10) { // a tx is at least 10 bytes
+        [self error:@"malformed tx4lightnode message, length is %u", (int)message.length];
+        return;
+    }
+
+    for (uint64_t i = 0; i < count; i++) {
+        DMCTransaction *tx = [[DMCTransaction alloc] initWithCursor:cursor];
+
+        if (! tx) {
+            [self error:@"malformed tx4lightnode message, transaction %u of %u", (int)i, (int)count];
+            return;
+        }
+
+        [transactions addObject:tx];
+    }
+
+    NSLog(@"%@:%u got tx4lightnode with %u transactions", self.host, self.port, (int)count);
+
+    dispatch_async(self.delegateQueue, ^{
+        if ([self.delegate respondsToSelector:@selector(peer:relayedTransactions:)]) {
+            [self.delegate peer:self relayedTransactions:transactions];
+        }
+    });
+}
+
+// availablecheques: address (var_str), count (var_int), then for each cheque: txid (uint256), index (uint32),
+// value (int64)
+- (void)acceptAvailablechequesMessage:(NSData *)message
+{
+    NSUInteger l, ll, count;
+    NSString *address = [message stringAtOffset:0 length:&l];
+
+    count = (NSUInteger)[message varIntAtOffset:l length:&ll];
+
+    if (! address || ll == 0 || message.length < l + ll ||
+        count > (message.length - l - ll)/(sizeof(UInt256) + sizeof(uint32_t) + sizeof(int64_t))) {
+        [self error:@"malformed availablecheques message, length is %u", (int)message.length];
+        return;
+    }
+
+    NSMutableArray *outpoints = [NSMutableArray arrayWithCapacity:count],
+                   *values = [NSMutableArray arrayWithCapacity:count];
+
+    for (NSUInteger off = l + ll; off < l + ll + count*(sizeof(UInt256) + sizeof(uint32_t) + sizeof(int64_t));
+         off += sizeof(UInt256) + sizeof(uint32_t) + sizeof(int64_t)) {
+        NSData *hash = [NSData dataWithBytes:(const uint8_t *)message.bytes + off length:sizeof(UInt256)];
+
+        uint32_t index = [message UInt32AtOffset:off + sizeof(UInt256)];
+
+        [outpoints addObject:[[DMCOutpoint alloc] initWithHash:hash index:index]];
+        [values addObject:@((int64_t)[message UInt64AtOffset:off + sizeof(UInt256) + sizeof(uint32_t)])];
+    }
+
+    NSLog(@"%@:%u got availablecheques with %u cheques", self.host, self.port, (int)count);
+
+    dispatch_async(self.delegateQueue, ^{
+        if ([self.delegate respondsToSelector:@selector(peer:relayedCheques:values:forAddress:)]) {
+            [self.delegate peer:self relayedCheques:outpoints values:values forAddress:address];
+        }
+    });
+}
+
+// nodeaddresses: same layout as addr, only sent in reply to getnodeaddresses
+- (void)acceptNodeaddressesMessage:(NSData *)message
+{
+    [self acceptAddrMessage:message solicited:YES];
+}
+
+// registered: count (var_int), then the registered addresses (var_str)
+- (void)acceptRegisteredMessage:(NSData *)message
+{
+    NSUInteger l, off, count = (NSUInteger)[message varIntAtOffset:0 length:&l];
+    NSMutableArray *addresses = [NSMutableArray array];
+
+    if (l == 0 || message.length < l || count > message.length - l) {
+        [self error:@"malformed registered message, length is %u, too short for %u addresses", (int)message.length,
+         (int)count];
+        return;
+    }
+
+    off = l;
+
+    for (NSUInteger i = 0; i < count; i++) {
+        NSString *address = [message stringAtOffset:off length:&l];
+
+        if (! address) {
+            [self error:@"malformed registered message, length is %u", (int)message.length];
+            return;
+        }
+
+        [addresses addObject:address];
+        off += l;
+    }
+
+    NSLog(@"%@:%u got registered with %u addresses", self.host, self.port, (int)count);
+
+    dispatch_async(self.delegateQueue, ^{
+        if ([self.delegate respondsToSelector:@selector(peer:registeredAddresses:)]) {
+            [self.delegate peer:self registeredAddresses:addresses];
+        }
+    });
+}
+
 // MARK: - hash
 
 #define FNV32_PRIME  0x01000193u
@@ -1077,164 +1481,79 @@ services:(uint64_t)services
                                uint128_eq(_address, [(DMCPeer *)object address]))) ? YES : NO;
 }
 
-// MARK: - NSStreamDelegate 实现方法
+// MARK: - socket events, called on the reactor queue
 
-- (void)stream:(NSStream *)aStream handleEvent:(NSStreamEvent)eventCode
+- (void)socketWritable
 {
-    switch (eventCode) {
-        case NSStreamEventOpenCompleted:    //连接成功
-            NSLog(@"%@:%u %@ stream connected in %fs", self.host, self.port,
-                  (aStream == self.inputStream) ? @"input" : (aStream == self.outputStream ? @"output" : @"unknown"),
-                  [NSDate timeIntervalSinceReferenceDate] - self.pingStartTime);
+    if (! self.socketOpen) { //连接成功
+        int error = 0;
+        socklen_t len = sizeof(error);
 
-            if (aStream == self.outputStream) {
-                self.pingStartTime = [NSDate timeIntervalSinceReferenceDate]; // don't count connect time in ping time
-                [NSObject cancelPreviousPerformRequestsWithTarget:self]; // cancel pending socket connect timeout
-                [self performSelector:@selector(disconnectWithError:)
-                 withObject:[NSError errorWithDomain:@"Daems" code:DAEMSCOIN_TIMEOUT_CODE
-                             userInfo:@{NSLocalizedDescriptionKey:NSLocalizedString(@"connect timeout", nil)}]
-                             afterDelay:CONNECT_TIMEOUT];
-            }
+        getsockopt(self.socket.fileDescriptor, SOL_SOCKET, SO_ERROR, &error, &len);
 
-            // fall through to send any queued output
-        case NSStreamEventHasSpaceAvailable:    //有数据可输出
-            if (aStream != self.outputStream) return;
-        
-            while (self.outputBuffer.length > 0 && self.outputStream.hasSpaceAvailable) {
-                
-                //把缓存输入到输出流
-                NSInteger l = [self.outputStream write:self.outputBuffer.bytes maxLength:self.outputBuffer.length];
-                
-                //删除已输出的字节，并重新计算字节空间
-                if (l > 0) [self.outputBuffer replaceBytesInRange:NSMakeRange(0, l) withBytes:NULL length:0];
-            }
+        if (error) {
+            NSLog(@"%@:%u error connecting, %s", self.host, self.port, strerror(error));
+            [self disconnectWithError:[NSError errorWithDomain:NSPOSIXErrorDomain code:error userInfo:nil]];
+            return;
+        }
 
-            break;
-            
-        case NSStreamEventHasBytesAvailable:    //有数据可输入
-            if (aStream != self.inputStream) return;
-
-            //这里的消息解析过于臃肿，需要优化
-            while (self.inputStream.hasBytesAvailable) {
-                @autoreleasepool {
-                    
-                    //以下程序控制在对每一个消息包的处理
-                    
-                    NSData *message = nil;
-                    NSString *type = nil;
-                    
-                    //开始时，self.msgHeader.length = 0， self.msgPayload = 0
-                    //headerLen偏移长度
-                    NSInteger headerLen = self.msgHeader.length, payloadLen = self.msgPayload.length, l = 0;
-                    uint32_t length = 0, checksum = 0;
-                    
-                    /************** 【一】消息头处理 **************/
-                    
-                    if (headerLen < HEADER_LENGTH) { // 读取头部，协议中Message的头部不会超过24字节
-                        self.msgHeader.length = HEADER_LENGTH;  //把前24字节以0填充，增加部分以0填充
-                        //输入流中的写入数据到头部缓存，开始位以headerLen偏移
-                        l = [self.inputStream read:(uint8_t *)self.msgHeader.mutableBytes + headerLen
-                             maxLength:self.msgHeader.length - headerLen];
-                        
-                        //l为实际读取的长度
-                        if (l < 0) {    //如果没有数据读取了，则处理下一个消息
-                            NSLog(@"%@:%u error reading message", self.host, self.port);
-                            goto reset;
-                        }
-                        
-                        //消息头长度与实际读取的长度累加
-                        self.msgHeader.length = headerLen + l;
-                        
-                        //读取头4字节的内容，判断是否为聊天币网络识别，一条消息必须以这个内容作为头部开始
-                        while (self.msgHeader.length >= sizeof(uint32_t) &&
-                               [self.msgHeader UInt32AtOffset:0] != DAEMSCOIN_MAGIC_NUMBER) {
-#if DEBUG
-                            //d9 b4 be f9
-                            printf("%c", *(const char *)self.msgHeader.bytes);
-#endif
-                            //如果不是，移除这些内容，直至找到头4字节能识别为聊天币网络位置
-                            [self.msgHeader replaceBytesInRange:NSMakeRange(0, 1) withBytes:NULL length:0];
-                        }
-                        
-                        //头部长度未读取够，继续while读取
-                        if (self.msgHeader.length < HEADER_LENGTH) continue; // wait for more stream input
-                    }
-                    
-                    //检查command是否用NULL填充结束，使用非NULL字符填充会被拒绝
-                    if ([self.msgHeader UInt8AtOffset:15] != 0) { // verify msg type field is null terminated
-                        [self error:@"malformed message header: %@", self.msgHeader];
-                        goto reset;
-                    }
-                    
-                    /*
-                    Message Header:
-                    F9 BE B4 D9                                     - magic ：main 网络
-                    61 64 64 72  00 00 00 00 00 00 00 00            - "addr"
-                    1F 00 00 00                                     - payload 长度31字节
-                    7F 85 39 C2                                     - payload 校验和
-                    */
-                    
-                    type = @((const char *)self.msgHeader.bytes + 4);   //类型
-                    length = [self.msgHeader UInt32AtOffset:16];        //长度
-                    checksum = [self.msgHeader UInt32AtOffset:20];      //校验
-                    
-                    /************** 【二】消息主体处理 **************/
-                    
-                    if (length > MAX_MSG_LENGTH) { // 检查消息长度是否超限制
-                        [self error:@"error reading %@, message length %u is too long", type, length];
-                        goto reset;
-                    }
-                    
-                    if (payloadLen < length) { // read message payload
-                        self.msgPayload.length = length;        //设置payload长度，增加部分以0填充
-                        
-                        //从输入流写入数据到payload缓存
-                        l = [self.inputStream read:(uint8_t *)self.msgPayload.mutableBytes + payloadLen
-                             maxLength:self.msgPayload.length - payloadLen];
-                        
-                        //self.msgPayload.length - payloadLen = 剩余需要写入的数量
-                        
-                        if (l < 0) {    //读取失败
-                            NSLog(@"%@:%u error reading %@", self.host, self.port, type);
-                            goto reset;
-                        }
-                        //重新记录消息主体实际长度已写入
-                        self.msgPayload.length = payloadLen + l;
-                        if (self.msgPayload.length < length) continue; //长度未到尽头，继续写
-                    }
-                    
-                    if (CFSwapInt32LittleToHost(self.msgPayload.SHA256_2.u32[0]) != checksum) { // 检查payload的前4个字节：sha256(sha256(payload)) == checksum
-                        [self error:@"error reading %@, invalid checksum %x, expected %x, payload length:%u, expected "
-                         "length:%u, SHA256_2:%@", type, self.msgPayload.SHA256_2.u32[0], checksum,
-                         (int)self.msgPayload.length, length, uint256_obj(self.msgPayload.SHA256_2)];
-                        goto reset;
-                    }
-                    
-                    message = self.msgPayload;      //取得消息主体
-                    self.msgPayload = [NSMutableData data];     //重置消息主体
-                    [self acceptMessage:message type:type]; // 处理消息业务
-                    
-reset:
-                    // 完整消息提取成功后 或 数据解析异常
-                    //把消息头和消息主体重置，继续读取符合协议处理的内容
-                    self.msgHeader.length = self.msgPayload.length = 0;
-                }
-            }
+        NSLog(@"%@:%u socket connected in %fs", self.host, self.port,
+              [NSDate timeIntervalSinceReferenceDate] - self.pingStartTime);
+        self.socketOpen = YES;
+        self.pingStartTime = [NSDate timeIntervalSinceReferenceDate]; // don't count connect time in ping time
+        [self startConnectTimeout]; // restart the timeout for the handshake
+    }
 
-            break;
-            
-        case NSStreamEventErrorOccurred:    //出错
-            NSLog(@"%@:%u error connecting, %@", self.host, self.port, aStream.streamError);
-            [self disconnectWithError:aStream.streamError];
-            break;
-            
-        case NSStreamEventEndEncountered:
-            NSLog(@"%@:%u connection closed", self.host, self.port);
-            [self disconnectWithError:nil];
-            break;
-            
-        default:
-            NSLog(@"%@:%u unknown network stream eventCode:%u", self.host, self.port, (int)eventCode);
+    [self writeOutput]; //有数据可输出
+}
+
+- (void)writeOutput
+{
+    while (self.outputQueue.length > 0) {
+        //把发送队列写入socket
+        NSInteger l = [self.outputQueue writeToSocket:self.socket.fileDescriptor];
+
+        if (l < 0 && errno != EAGAIN && errno != EINTR) {
+            NSLog(@"%@:%u error writing, %s", self.host, self.port, strerror(errno));
+            [self disconnectWithError:[NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil]];
+            return;
+        }
+
+        if (l <= 0) break;
+    }
+
+    self.outputBacklog = self.outputQueue.length;
+    self.socket.wantsWrite = (self.outputQueue.length > 0); // only watch for space while output is queued
+}
+
+- (void)socketReadable
+{
+    NSInteger l = [self.framer readFromSocket:self.socket.fileDescriptor]; //有数据可输入
+
+    if (l == 0) {
+        NSLog(@"%@:%u connection closed", self.host, self.port);
+        [self disconnectWithError:nil];
+        return;
+    }
+    else if (l < 0) {
+        if (errno == EAGAIN || errno == EINTR) return;
+        NSLog(@"%@:%u error reading message, %s", self.host, self.port, strerror(errno));
+        [self disconnectWithError:[NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil]];
+        return;
+    }
+
+    @autoreleasepool {
+        char command[DMC_MESSAGE_COMMAND_LENGTH + 1];
+        NSError *error = nil;
+        NSData *message = nil;
+
+        // payloads point into the framer's buffer and are only valid until the next read
+        while (_status != DMCPeerStatusDisconnected &&
+               (message = [self.framer nextPayloadWithCommand:command error:&error])) {
+            [self acceptMessage:message command:command]; // 处理消息业务
+        }
+
+        if (error) [self disconnectWithError:error];
     }
 }
 
@@ -0,0 +1,10 @@
+//
+//  DMCPeerAddressBook+Tests.h
+
+#import "DMCPeerAddressBook.h"
+
+@interface DMCPeerAddressBook (Tests)
+
++ (void)runAllTests;
+
+@end
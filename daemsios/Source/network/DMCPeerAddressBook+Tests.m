@@ -0,0 +1,176 @@
+//
+//  DMCPeerAddressBook+Tests.m
+
+#import "DMCPeerAddressBook+Tests.h"
+#import "DMCPeer.h"
+
+#define TEST_BUCKET_SIZE  64 // BUCKET_SIZE
+#define TEST_BOOK_HEADER  44 // magic, version, bucket key, count
+#define TEST_BOOK_RECORD  52
+
+@implementation DMCPeerAddressBook (Tests)
+
++ (void)runAllTests
+{
+    [self testSaveLoad];
+    [self testCorruptBucket];
+    [self testEviction];
+    [self testDemotion];
+    [self testBackoff];
+    [self testServices];
+}
+
++ (NSTimeInterval)hourAgo
+{
+    return [NSDate timeIntervalSinceReferenceDate] - 60*60;
+}
+
++ (DMCPeer *)peerWithIPv4:(uint32_t)ipv4 port:(uint16_t)port
+{
+    UInt128 address = { .u32 = { 0, 0, CFSwapInt32HostToBig(0xffff), CFSwapInt32HostToBig(ipv4) } };
+
+    return [[DMCPeer alloc] initWithAddress:address port:port timestamp:[self hourAgo] services:SERVICES_NODE_NETWORK];
+}
+
+// the file keeps timestamps in whole seconds
++ (NSSet *)descriptionsOfPeers:(NSArray *)peers
+{
+    NSMutableSet *descriptions = [NSMutableSet set];
+
+    for (DMCPeer *peer in peers) {
+        [descriptions addObject:[NSString stringWithFormat:@"%@:%u services:%llu timestamp:%.0f misbehavin:%d", peer.host,
+                                 peer.port, peer.services, floor(peer.timestamp), peer.misbehavin]];
+    }
+
+    return descriptions;
+}
+
++ (NSString *)temporaryPath
+{
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"DMCPeerAddressBookTests.dat"];
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    return path;
+}
+
++ (void)testSaveLoad
+{
+    NSString *path = [self temporaryPath];
+    DMCPeerAddressBook *book = [[DMCPeerAddressBook alloc] initWithPath:path];
+    DMCPeer *tried = [self peerWithIPv4:0x0a010001 port:1], *misbehaving = [self peerWithIPv4:0x0a020001 port:2];
+
+    [book addPeers:@[tried, misbehaving, [self peerWithIPv4:0x0a030001 port:3]] fromPeer:nil];
+    [book peerConnected:tried];
+    misbehaving.misbehavin = 7;
+    [book updatePeer:misbehaving];
+    NSAssert([book save], @"Should save the book");
+
+    DMCPeerAddressBook *loaded = [[DMCPeerAddressBook alloc] initWithPath:path];
+
+    NSAssert(loaded.count == 3 && loaded.triedCount == 1, @"Should load every record into the same tables");
+    NSAssert([[self descriptionsOfPeers:[loaded bestPeers:10]] isEqual:[self descriptionsOfPeers:[book bestPeers:10]]],
+             @"Should load the addresses, ports, services, timestamps and misbehavin scores that were saved");
+    NSAssert([[loaded bestPeers:1][0] port] == 1, @"Should keep the tried peer first");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
++ (void)testCorruptBucket
+{
+    NSString *path = [self temporaryPath];
+    DMCPeerAddressBook *book = [[DMCPeerAddressBook alloc] initWithPath:path];
+
+    [book addPeers:@[[self peerWithIPv4:0x0a010001 port:1], [self peerWithIPv4:0x0a020001 port:2]] fromPeer:nil];
+    [book save];
+
+    NSMutableData *d = [NSMutableData dataWithContentsOfFile:path];
+    uint8_t bucket = 0xff;
+
+    // the last byte of a record is its bucket
+    [d replaceBytesInRange:NSMakeRange(TEST_BOOK_HEADER + TEST_BOOK_RECORD - 1, 1) withBytes:&bucket];
+    [d writeToFile:path atomically:YES];
+    NSAssert([[DMCPeerAddressBook alloc] initWithPath:path].count == 1, @"Should skip a record with a bad bucket index");
+
+    [d setLength:TEST_BOOK_HEADER + TEST_BOOK_RECORD]; // shorter than its count says
+    [d writeToFile:path atomically:YES];
+    NSAssert([[DMCPeerAddressBook alloc] initWithPath:path].count == 0, @"Should ignore a truncated file");
+
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+}
+
++ (void)testEviction
+{
+    DMCPeerAddressBook *book = [[DMCPeerAddressBook alloc] initWithPath:nil];
+    DMCPeer *source = [self peerWithIPv4:0x0b010001 port:1], *worst = [self peerWithIPv4:0x0a010000 port:1],
+            *added = [self peerWithIPv4:0x0a01ffff port:1];
+    NSMutableArray *peers = [NSMutableArray arrayWithObject:worst];
+
+    // same group from the same source, so they all land in one new bucket
+    for (uint16_t i = 1; i < TEST_BUCKET_SIZE; i++) [peers addObject:[self peerWithIPv4:0x0a010000 + i port:1]];
+    [book addPeers:peers fromPeer:source];
+    NSAssert(book.count == TEST_BUCKET_SIZE, @"Should fill the bucket");
+
+    worst.misbehavin = 50;
+    [book updatePeer:worst];
+    [book addPeers:@[added] fromPeer:source];
+    NSAssert(book.count == TEST_BUCKET_SIZE, @"Should not grow a full bucket");
+
+    NSArray *hosts = [[book bestPeers:100] valueForKey:@"host"];
+
+    NSAssert(! [hosts containsObject:worst.host], @"Should evict the lowest scoring entry");
+    NSAssert([hosts containsObject:added.host], @"Should keep the new entry");
+}
+
++ (void)testDemotion
+{
+    DMCPeerAddressBook *book = [[DMCPeerAddressBook alloc] initWithPath:nil];
+    NSUInteger connected = 4*TEST_BUCKET_SIZE + 1;
+
+    // a group spreads over 4 tried buckets at most, so connecting to one more peer than they hold overflows one
+    for (uint32_t i = 0; i < connected; i++) [book peerConnected:[self peerWithIPv4:0x0a010000 + i port:1]];
+
+    NSAssert(book.triedCount <= 4*TEST_BUCKET_SIZE, @"Should keep a group within its tried buckets");
+    NSAssert(book.count > book.triedCount, @"Should demote overflowing tried peers to new rather than forgetting them");
+}
+
++ (void)testBackoff
+{
+    DMCPeerAddressBook *book = [[DMCPeerAddressBook alloc] initWithPath:nil];
+    DMCPeer *failing = [self peerWithIPv4:0x0a010001 port:1], *other = [self peerWithIPv4:0x0a020001 port:2];
+
+    [book addPeers:@[failing, other] fromPeer:nil];
+    [book peerFailed:failing];
+    NSAssert([[book bestPeers:10] count] == 1 && [[book bestPeers:10][0] port] == 2,
+             @"Should not return a peer that just failed");
+
+    [book peerConnected:failing];
+    NSAssert([[book bestPeers:10] count] == 2 && [[book bestPeers:10][0] port] == 1,
+             @"Should return a peer again once it connects, tried peers first");
+}
+
++ (void)testServices
+{
+    DMCPeerAddressBook *book = [[DMCPeerAddressBook alloc] initWithPath:nil];
+    DMCPeer *peer = [self peerWithIPv4:0x0a010001 port:1];
+    UInt128 address = peer.address;
+
+    peer.misbehavin = 3;
+    [book addPeers:@[peer] fromPeer:nil];
+    [book updatePeer:peer];
+
+    [book addPeers:@[[[DMCPeer alloc] initWithAddress:address port:1 timestamp:peer.timestamp - 10 services:0]]
+          fromPeer:nil];
+    NSAssert([[book bestPeers:1][0] services] == SERVICES_NODE_NETWORK, @"Should ignore an older announcement");
+
+    [book addPeers:@[[[DMCPeer alloc] initWithAddress:address port:1 timestamp:peer.timestamp + 10
+                      services:SERVICES_NODE_BLOOM]] fromPeer:nil];
+
+    DMCPeer *updated = [book bestPeers:1][0];
+
+    NSAssert(book.count == 1, @"Should not add a known address twice");
+    NSAssert(updated.services == SERVICES_NODE_BLOOM && updated.timestamp == peer.timestamp + 10,
+             @"Should take the services and timestamp of a newer announcement");
+    NSAssert(updated.misbehavin == 3, @"Should keep the misbehavin score");
+}
+
+@end
@@ -0,0 +1,82 @@
+//
+//  DMCPeerAddressBook.h
+
+#import <Foundation/Foundation.h>
+
+@class DMCPeer;
+
+/**
+ 节点地址簿
+
+ Keeps the peer addresses learned from addr and nodeaddresses messages. Addresses start in new buckets chosen by their
+ network group and the group of the peer that relayed them, so one source can't fill the book, and move to tried
+ buckets once a connection succeeds. Full buckets evict their lowest scoring entry. Scores favour tried peers with a
+ low ping and fast relaying, and penalise misbehaviour and failed connections.
+
+ The book is saved as a compact binary file, so a cold start can connect to the best known peers right away.
+ Not thread safe, use it from the peer manager's queue.
+ */
+@interface DMCPeerAddressBook : NSObject
+
+/**
+ Number of known addresses.
+ */
+@property (nonatomic, readonly) NSUInteger count;
+
+/**
+ Number of addresses that have been connected to successfully.
+ */
+@property (nonatomic, readonly) NSUInteger triedCount;
+
+/**
+ 以地址簿文件初始化
+
+ @param path file the book is saved to, and loaded from if it exists
+ */
+- (instancetype)initWithPath:(NSString *)path;
+
+/**
+ Adds relayed addresses, e.g. from peer:relayedPeers:. Known addresses only have their timestamp and services updated,
+ and only by an announcement newer than the one they have.
+
+ @param peers 节点
+ @param source peer that relayed them
+ */
+- (void)addPeers:(NSArray *)peers fromPeer:(DMCPeer *)source;
+
+/**
+ Moves the peer to a tried bucket and records its ping time, call after the handshake.
+ */
+- (void)peerConnected:(DMCPeer *)peer;
+
+/**
+ Counts a failed connection attempt against the peer.
+ */
+- (void)peerFailed:(DMCPeer *)peer;
+
+/**
+ Records the peer's current ping time, relay speed and misbehaviour score, e.g. when it disconnects.
+ */
+- (void)updatePeer:(DMCPeer *)peer;
+
+/**
+ Forgets the peer, e.g. after banning it.
+ */
+- (void)removePeer:(DMCPeer *)peer;
+
+/**
+ Best scoring peers, best first.
+
+ @param count maximum number of peers to return
+ @return new DMCPeer objects with their saved misbehavin score, ready to connect
+ */
+- (NSArray *)bestPeers:(NSUInteger)count;
+
+/**
+ Writes the book to its file.
+
+ @return NO if the file couldn't be written
+ */
+- (BOOL)save;
+
+@end
@@ -0,0 +1,358 @@
+//
+//  DMCPeerAddressBook.m
+
+#import "DMCPeerAddressBook.h"
+#import "DMCPeer.h"
+#import "NSData+DaemsCoin.h"
+#import "NSMutableData+DaemsCoin.h"
+
+#if ! PEER_LOGGING
+#define NSLog(...)
+#endif
+
+#define NEW_BUCKETS    64
+#define TRIED_BUCKETS  16
+#define BUCKET_SIZE    64
+#define BOOK_MAGIC     0x41434d44 // "DMCA"
+#define BOOK_VERSION   1
+#define BOOK_HEADER    (4 + 4 + sizeof(UInt256) + 4) // magic, version, bucket key, count
+#define BOOK_RECORD    52
+
+@interface DMCAddressBookEntry : NSObject
+
+@property (nonatomic, strong) DMCPeer *peer;
+@property (nonatomic, assign) BOOL tried;
+@property (nonatomic, assign) uint8_t bucket;
+@property (nonatomic, assign) NSTimeInterval lastSuccess, lastAttempt; // interval since refrence date
+@property (nonatomic, assign) uint16_t failures;
+@property (nonatomic, assign) NSTimeInterval pingTime, relaySpeed;
+@property (nonatomic, readonly) double score;
+
+@end
+
+@implementation DMCAddressBookEntry
+
+- (double)score
+{
+    double score = (self.tried) ? 100.0 : 0.0, days;
+
+    score -= MIN(self.failures, 5)*20.0;
+    score -= self.peer.misbehavin;
+    if (self.pingTime > 0) score -= MIN(self.pingTime, 2.0)*50.0; // 0.2s costs 10 points
+    score += MIN(self.relaySpeed, 1000.0)/50.0;
+    days = ([NSDate timeIntervalSinceReferenceDate] - MAX(self.peer.timestamp, self.lastSuccess))/(24*60*60);
+    score -= MIN(MAX(days, 0), 30.0); // one point per day not seen
+    return score;
+}
+
+@end
+
+
+@implementation DMCPeerAddressBook {
+    NSString *_path;
+    UInt256 _key; // random, so bucket placement can't be predicted by other nodes
+    NSMutableDictionary *_entries; // address and port (18 bytes) -> DMCAddressBookEntry
+    NSArray *_newBuckets, *_triedBuckets; // NSMutableArrays of DMCAddressBookEntry
+}
+
+- (instancetype)initWithPath:(NSString *)path
+{
+    if (! (self = [super init])) return nil;
+
+    NSMutableArray *newBuckets = [NSMutableArray arrayWithCapacity:NEW_BUCKETS],
+                   *triedBuckets = [NSMutableArray arrayWithCapacity:TRIED_BUCKETS];
+
+    for (NSUInteger i = 0; i < NEW_BUCKETS; i++) [newBuckets addObject:[NSMutableArray array]];
+    for (NSUInteger i = 0; i < TRIED_BUCKETS; i++) [triedBuckets addObject:[NSMutableArray array]];
+    _newBuckets = newBuckets;
+    _triedBuckets = triedBuckets;
+    _entries = [NSMutableDictionary dictionary];
+    _path = path;
+    if (! [self load]) arc4random_buf(&_key, sizeof(_key));
+    return self;
+}
+
+- (NSUInteger)count
+{
+    return _entries.count;
+}
+
+- (NSUInteger)triedCount
+{
+    NSUInteger count = 0;
+
+    for (NSArray *bucket in _triedBuckets) count += bucket.count;
+    return count;
+}
+
+// MARK: - buckets
+
+static NSData *DMCPeerKey(DMCPeer *peer)
+{
+    NSMutableData *key = [NSMutableData dataWithCapacity:sizeof(UInt128) + sizeof(uint16_t)];
+    UInt128 address = peer.address;
+
+    [key appendBytes:&address length:sizeof(address)];
+    [key appendUInt16:peer.port];
+    return key;
+}
+
+// network group: /16 for IPv4, /32 for IPv6
+static NSData *DMCPeerGroup(DMCPeer *peer)
+{
+    UInt128 address = peer.address;
+    BOOL ipv4 = (address.u64[0] == 0 && address.u32[2] == CFSwapInt32HostToBig(0xffff));
+
+    return (ipv4) ? [NSData dataWithBytes:&address.u8[12] length:2] : [NSData dataWithBytes:&address.u8[0] length:4];
+}
+
+- (uint32_t)hashWithData:(NSData *)data
+{
+    NSMutableData *d = [NSMutableData dataWithBytes:&_key length:sizeof(_key)];
+
+    [d appendData:data];
+    return d.SHA256.u32[0];
+}
+
+- (uint8_t)newBucketForPeer:(DMCPeer *)peer source:(DMCPeer *)source
+{
+    NSMutableData *d = [NSMutableData dataWithData:DMCPeerGroup(peer)];
+
+    if (source) [d appendData:DMCPeerGroup(source)];
+    return [self hashWithData:d] % NEW_BUCKETS;
+}
+
+// a group spreads over a few tried buckets at most, so one network can't take over the tried table
+- (uint8_t)triedBucketForPeer:(DMCPeer *)peer
+{
+    NSMutableData *d = [NSMutableData dataWithData:DMCPeerGroup(peer)];
+
+    [d appendUInt8:[self hashWithData:DMCPeerKey(peer)] % 4];
+    return [self hashWithData:d] % TRIED_BUCKETS;
+}
+
+- (NSMutableArray *)bucketForEntry:(DMCAddressBookEntry *)entry
+{
+    return (entry.tried) ? _triedBuckets[entry.bucket] : _newBuckets[entry.bucket];
+}
+
+// adds the entry to its bucket, evicting the lowest scoring entry if the bucket is full
+- (void)insertEntry:(DMCAddressBookEntry *)entry
+{
+    NSMutableArray *bucket = [self bucketForEntry:entry];
+
+    if (bucket.count >= BUCKET_SIZE) {
+        DMCAddressBookEntry *worst = nil;
+
+        for (DMCAddressBookEntry *e in bucket) {
+            if (! worst || e.score < worst.score) worst = e;
+        }
+
+        if (worst.score > entry.score && ! entry.tried) return; // not worth keeping
+        [self removeEntry:worst];
+
+        if (worst.tried) { // demote to new rather than forgetting a peer we've connected to
+            worst.tried = NO;
+            worst.bucket = [self newBucketForPeer:worst.peer source:nil];
+            [self insertEntry:worst];
+        }
+    }
+
+    [bucket addObject:entry];
+    _entries[DMCPeerKey(entry.peer)] = entry;
+}
+
+- (void)removeEntry:(DMCAddressBookEntry *)entry
+{
+    [[self bucketForEntry:entry] removeObjectIdenticalTo:entry];
+    [_entries removeObjectForKey:DMCPeerKey(entry.peer)];
+}
+
+// MARK: - updates
+
+- (void)addPeers:(NSArray *)peers fromPeer:(DMCPeer *)source
+{
+    for (DMCPeer *peer in peers) {
+        DMCAddressBookEntry *entry = _entries[DMCPeerKey(peer)];
+
+        if (entry) { // a newer announcement has the peer's current services
+            if (peer.timestamp <= entry.peer.timestamp) continue;
+            DMCPeer *updated = [[DMCPeer alloc] initWithAddress:peer.address port:peer.port timestamp:peer.timestamp
+                                services:peer.services];
+
+            updated.misbehavin = entry.peer.misbehavin;
+            entry.peer = updated;
+            continue;
+        }
+
+        entry = [DMCAddressBookEntry new];
+        entry.peer = [[DMCPeer alloc] initWithAddress:peer.address port:peer.port timestamp:peer.timestamp
+                      services:peer.services];
+        entry.bucket = [self newBucketForPeer:peer source:source];
+        [self insertEntry:entry];
+    }
+}
+
+- (DMCAddressBookEntry *)entryForPeer:(DMCPeer *)peer
+{
+    DMCAddressBookEntry *entry = _entries[DMCPeerKey(peer)];
+
+    if (! entry) { // e.g. a seed node
+        entry = [DMCAddressBookEntry new];
+        entry.peer = [[DMCPeer alloc] initWithAddress:peer.address port:peer.port timestamp:peer.timestamp
+                      services:peer.services];
+        entry.bucket = [self newBucketForPeer:peer source:nil];
+        [self insertEntry:entry];
+    }
+
+    return entry;
+}
+
+- (void)peerConnected:(DMCPeer *)peer
+{
+    DMCAddressBookEntry *entry = [self entryForPeer:peer];
+
+    entry.lastSuccess = entry.lastAttempt = [NSDate timeIntervalSinceReferenceDate];
+    entry.peer.timestamp = entry.lastSuccess;
+    entry.failures = 0;
+    [self updatePeer:peer];
+
+    if (! entry.tried) {
+        [self removeEntry:entry];
+        entry.tried = YES;
+        entry.bucket = [self triedBucketForPeer:peer];
+        [self insertEntry:entry];
+    }
+}
+
+- (void)peerFailed:(DMCPeer *)peer
+{
+    DMCAddressBookEntry *entry = _entries[DMCPeerKey(peer)];
+
+    entry.lastAttempt = [NSDate timeIntervalSinceReferenceDate];
+    if (entry.failures < UINT16_MAX) entry.failures++;
+}
+
+- (void)updatePeer:(DMCPeer *)peer
+{
+    DMCAddressBookEntry *entry = _entries[DMCPeerKey(peer)];
+
+    if (peer.pingTime > 0) entry.pingTime = peer.pingTime;
+    if (peer.relaySpeed > 0) entry.relaySpeed = peer.relaySpeed;
+    entry.peer.misbehavin = peer.misbehavin;
+}
+
+- (void)removePeer:(DMCPeer *)peer
+{
+    DMCAddressBookEntry *entry = _entries[DMCPeerKey(peer)];
+
+    if (entry) [self removeEntry:entry];
+}
+
+- (NSArray *)bestPeers:(NSUInteger)count
+{
+    NSMutableArray *entries = [NSMutableArray arrayWithCapacity:_entries.count], *peers;
+    NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+
+    for (DMCAddressBookEntry *entry in _entries.allValues) {
+        if (entry.failures > 0 && now - entry.lastAttempt < 60*entry.failures) continue; // back off after failures
+        [entries addObject:entry];
+    }
+
+    [entries sortUsingComparator:^NSComparisonResult(DMCAddressBookEntry *a, DMCAddressBookEntry *b) {
+        double sa = a.score, sb = b.score;
+
+        return (sa > sb) ? NSOrderedAscending : (sa < sb) ? NSOrderedDescending : NSOrderedSame;
+    }];
+
+    peers = [NSMutableArray arrayWithCapacity:MIN(count, entries.count)];
+
+    for (DMCAddressBookEntry *entry in entries) {
+        if (peers.count >= count) break;
+
+        DMCPeer *peer = [[DMCPeer alloc] initWithAddress:entry.peer.address port:entry.peer.port
+                         timestamp:entry.peer.timestamp services:entry.peer.services];
+
+        peer.misbehavin = entry.peer.misbehavin;
+        [peers addObject:peer];
+    }
+
+    return peers;
+}
+
+// MARK: - file
+
+// record: address (16), port (uint16), services (uint64), timestamp, last success, last attempt (uint32 unix time),
+// failures (uint16), misbehavin (int16), ping time (uint32 ms), relay speed (uint32), tried (uint8), bucket (uint8)
+- (BOOL)save
+{
+    NSMutableData *d = [NSMutableData dataWithCapacity:BOOK_HEADER + _entries.count*BOOK_RECORD];
+
+    [d appendUInt32:BOOK_MAGIC];
+    [d appendUInt32:BOOK_VERSION];
+    [d appendBytes:&_key length:sizeof(_key)];
+    [d appendUInt32:(uint32_t)_entries.count];
+
+    for (DMCAddressBookEntry *entry in _entries.allValues) {
+        UInt128 address = entry.peer.address;
+
+        [d appendBytes:&address length:sizeof(address)];
+        [d appendUInt16:entry.peer.port];
+        [d appendUInt64:entry.peer.services];
+        [d appendUInt32:(uint32_t)MAX(entry.peer.timestamp + NSTimeIntervalSince1970, 0)];
+        [d appendUInt32:(uint32_t)MAX(entry.lastSuccess + NSTimeIntervalSince1970, 0)];
+        [d appendUInt32:(uint32_t)MAX(entry.lastAttempt + NSTimeIntervalSince1970, 0)];
+        [d appendUInt16:entry.failures];
+        [d appendUInt16:(uint16_t)entry.peer.misbehavin];
+        [d appendUInt32:(uint32_t)MIN(entry.pingTime*1000, UINT32_MAX)];
+        [d appendUInt32:(uint32_t)MIN(entry.relaySpeed, UINT32_MAX)];
+        [d appendUInt8:entry.tried];
+        [d appendUInt8:entry.bucket];
+    }
+
+    if (! _path || ! [d writeToFile:_path atomically:YES]) {
+        NSLog(@"failed to save peer address book to %@", _path);
+        return NO;
+    }
+
+    return YES;
+}
+
+- (BOOL)load
+{
+    NSData *d = (_path) ? [NSData dataWithContentsOfFile:_path options:NSDataReadingMappedIfSafe error:nil] : nil;
+
+    if (d.length < BOOK_HEADER || [d UInt32AtOffset:0] != BOOK_MAGIC || [d UInt32AtOffset:4] != BOOK_VERSION) {
+        return NO;
+    }
+
+    NSUInteger count = [d UInt32AtOffset:BOOK_HEADER - 4];
+
+    if (d.length < BOOK_HEADER + count*BOOK_RECORD) return NO;
+    [d getBytes:&_key range:NSMakeRange(8, sizeof(_key))];
+
+    for (NSUInteger off = BOOK_HEADER; off < BOOK_HEADER + count*BOOK_RECORD; off += BOOK_RECORD) {
+        DMCAddressBookEntry *entry = [DMCAddressBookEntry new];
+        UInt128 address;
+
+        [d getBytes:&address range:NSMakeRange(off, sizeof(address))];
+        entry.peer = [[DMCPeer alloc] initWithAddress:address port:[d UInt16AtOffset:off + 16]
+                      timestamp:(NSTimeInterval)[d UInt32AtOffset:off + 26] - NSTimeIntervalSince1970
+                      services:[d UInt64AtOffset:off + 18]];
+        entry.lastSuccess = (NSTimeInterval)[d UInt32AtOffset:off + 30] - NSTimeIntervalSince1970;
+        entry.lastAttempt = (NSTimeInterval)[d UInt32AtOffset:off + 34] - NSTimeIntervalSince1970;
+        entry.failures = [d UInt16AtOffset:off + 38];
+        entry.peer.misbehavin = (int16_t)[d UInt16AtOffset:off + 40];
+        entry.pingTime = [d UInt32AtOffset:off + 42]/1000.0;
+        entry.relaySpeed = [d UInt32AtOffset:off + 46];
+        entry.tried = [d UInt8AtOffset:off + 50];
+        entry.bucket = [d UInt8AtOffset:off + 51];
+        if (entry.bucket >= ((entry.tried) ? TRIED_BUCKETS : NEW_BUCKETS)) continue; // corrupt record
+        [self insertEntry:entry];
+    }
+
+    NSLog(@"loaded %u peer addresses", (int)_entries.count);
+    return YES;
+}
+
+@end
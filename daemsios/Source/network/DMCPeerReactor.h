@@ -0,0 +1,74 @@
+//
+//  DMCPeerReactor.h
+
+#import <Foundation/Foundation.h>
+
+typedef uint64_t DMCReactorTimer; // 0 is never a valid timer
+
+/**
+ 节点连接的读写事件
+
+ A watched socket. Both event sources are serviced on the reactor queue; these methods must be called there as well.
+ */
+@interface DMCReactorSocket : NSObject
+
+@property (nonatomic, readonly) int fileDescriptor;
+
+/**
+ Enables the write handler while there is output to send, and disables it afterwards so an idle socket costs nothing.
+ */
+@property (nonatomic, assign) BOOL wantsWrite;
+
+/**
+ Stops both handlers. The socket is closed once the event sources have shut down.
+ */
+- (void)close;
+
+@end
+
+
+/**
+ 节点I/O事件循环
+
+ Services every peer socket from a single serial queue using kqueue backed dispatch sources, so the number of threads
+ stays the same however many peers are connected. Timeouts are kept in a hashed timer wheel driven by one timer
+ source that only runs while timers are pending.
+ */
+@interface DMCPeerReactor : NSObject
+
+/**
+ 所有节点共用的事件循环
+ */
++ (instancetype)sharedReactor;
+
+/**
+ Serial queue all socket and timer handlers run on.
+ */
+@property (nonatomic, readonly) dispatch_queue_t queue;
+
+/**
+ Starts watching a connected or connecting non-blocking socket. The reactor takes ownership of the file descriptor.
+ Write events start enabled so the handler is called when a pending connect completes.
+
+ @param socket 文件描述符
+ @param readHandler called on the reactor queue when the socket is readable or has reached end of file
+ @param writeHandler called on the reactor queue when the socket is writable while wantsWrite is set
+ @return watched socket, call -close to stop
+ */
+- (DMCReactorSocket *)watchSocket:(int)socket readHandler:(dispatch_block_t)readHandler
+writeHandler:(dispatch_block_t)writeHandler;
+
+/**
+ Calls handler on the reactor queue after delay seconds, with tick (0.1s) resolution. Can be called from any queue.
+
+ @return timer to pass to -cancelTimer:
+ */
+- (DMCReactorTimer)scheduleTimer:(NSTimeInterval)delay handler:(dispatch_block_t)handler;
+
+/**
+ Cancels a timer that hasn't fired yet. Cancelling 0 or a timer that already fired does nothing. Can be called from
+ any queue; when called on the reactor queue the timer is guaranteed not to fire afterwards.
+ */
+- (void)cancelTimer:(DMCReactorTimer)timer;
+
+@end
@@ -0,0 +1,206 @@
+//
+//  DMCPeerReactor.m
+
+#import "DMCPeerReactor.h"
+#include <stdatomic.h>
+#include <unistd.h>
+
+#define WHEEL_SLOTS 256 // one revolution covers 25.6s, longer timers stay in their slot for more revolutions
+#define WHEEL_TICK  0.1 // seconds
+
+static char DMCPeerReactorQueueKey;
+
+@interface DMCReactorSocket ()
+
+- (instancetype)initWithSocket:(int)socket queue:(dispatch_queue_t)queue readHandler:(dispatch_block_t)readHandler
+writeHandler:(dispatch_block_t)writeHandler;
+
+@end
+
+@implementation DMCReactorSocket {
+    dispatch_source_t _readSource, _writeSource;
+}
+
+- (instancetype)initWithSocket:(int)socket queue:(dispatch_queue_t)queue readHandler:(dispatch_block_t)readHandler
+writeHandler:(dispatch_block_t)writeHandler
+{
+    if (! (self = [super init])) return nil;
+
+    __block int sources = 2;
+    dispatch_block_t cancelHandler = ^{
+        if (--sources == 0) close(socket); // only close once neither source can touch the descriptor
+    };
+
+    _fileDescriptor = socket;
+    _readSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, socket, 0, queue);
+    _writeSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_WRITE, socket, 0, queue);
+    dispatch_source_set_event_handler(_readSource, readHandler);
+    dispatch_source_set_event_handler(_writeSource, writeHandler);
+    dispatch_source_set_cancel_handler(_readSource, cancelHandler);
+    dispatch_source_set_cancel_handler(_writeSource, cancelHandler);
+    dispatch_resume(_readSource);
+    dispatch_resume(_writeSource);
+    _wantsWrite = YES;
+    return self;
+}
+
+- (void)dealloc
+{
+    [self close];
+}
+
+- (void)setWantsWrite:(BOOL)wantsWrite
+{
+    if (! _writeSource || wantsWrite == _wantsWrite) return;
+    _wantsWrite = wantsWrite;
+
+    if (wantsWrite) dispatch_resume(_writeSource);
+    else dispatch_suspend(_writeSource);
+}
+
+- (void)close
+{
+    if (! _readSource) return;
+    dispatch_source_cancel(_readSource);
+    dispatch_source_cancel(_writeSource);
+    if (! _wantsWrite) dispatch_resume(_writeSource); // a suspended source never runs its cancel handler
+    _readSource = _writeSource = nil;
+}
+
+@end
+
+
+@interface DMCReactorTimerEntry : NSObject
+
+@property (nonatomic, assign) DMCReactorTimer timer;
+@property (nonatomic, assign) uint64_t tick; // wheel tick the timer fires on
+@property (nonatomic, strong) dispatch_block_t handler;
+
+@end
+
+@implementation DMCReactorTimerEntry
+
+@end
+
+
+@implementation DMCPeerReactor {
+    NSArray *_slots; // WHEEL_SLOTS arrays of DMCReactorTimerEntry, a timer lives in slot tick % WHEEL_SLOTS
+    NSMutableDictionary *_timers; // pending entries by timer number
+    dispatch_source_t _ticker;
+    NSTimeInterval _wheelStart; // system uptime of tick 0
+    uint64_t _tick; // last tick processed
+    _Atomic uint64_t _lastTimer;
+}
+
++ (instancetype)sharedReactor
+{
+    static DMCPeerReactor *reactor = nil;
+    static dispatch_once_t onceToken = 0;
+
+    dispatch_once(&onceToken, ^{
+        reactor = [self new];
+    });
+
+    return reactor;
+}
+
+- (instancetype)init
+{
+    if (! (self = [super init])) return nil;
+
+    NSMutableArray *slots = [NSMutableArray arrayWithCapacity:WHEEL_SLOTS];
+
+    for (NSUInteger i = 0; i < WHEEL_SLOTS; i++) [slots addObject:[NSMutableArray array]];
+    _slots = slots;
+    _timers = [NSMutableDictionary dictionary];
+    _queue = dispatch_queue_create("peer.reactor", DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(_queue, &DMCPeerReactorQueueKey, &DMCPeerReactorQueueKey, NULL);
+
+    __weak typeof(self) weakSelf = self;
+
+    _ticker = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, _queue);
+    dispatch_source_set_timer(_ticker, dispatch_time(DISPATCH_TIME_NOW, WHEEL_TICK*NSEC_PER_SEC),
+                              WHEEL_TICK*NSEC_PER_SEC, WHEEL_TICK*NSEC_PER_SEC/10);
+    dispatch_source_set_event_handler(_ticker, ^{
+        [weakSelf advance];
+    }); // created suspended, resumed while timers are pending
+    return self;
+}
+
+- (void)onQueue:(dispatch_block_t)block
+{
+    if (dispatch_get_specific(&DMCPeerReactorQueueKey)) block();
+    else dispatch_async(self.queue, block);
+}
+
+- (DMCReactorSocket *)watchSocket:(int)socket readHandler:(dispatch_block_t)readHandler
+writeHandler:(dispatch_block_t)writeHandler
+{
+    return [[DMCReactorSocket alloc] initWithSocket:socket queue:self.queue readHandler:readHandler
+            writeHandler:writeHandler];
+}
+
+// MARK: - timer wheel
+
+- (uint64_t)currentTick
+{
+    return (uint64_t)(([NSProcessInfo processInfo].systemUptime - _wheelStart)/WHEEL_TICK);
+}
+
+- (DMCReactorTimer)scheduleTimer:(NSTimeInterval)delay handler:(dispatch_block_t)handler
+{
+    DMCReactorTimer timer = atomic_fetch_add(&_lastTimer, 1) + 1;
+
+    [self onQueue:^{
+        if (_timers.count == 0) { // restart the wheel, no need to catch up on ticks while it was stopped
+            _wheelStart = [NSProcessInfo processInfo].systemUptime;
+            _tick = 0;
+            dispatch_resume(_ticker);
+        }
+
+        DMCReactorTimerEntry *entry = [DMCReactorTimerEntry new];
+
+        entry.timer = timer;
+        entry.tick = MAX(_tick, [self currentTick]) + MAX(1, (uint64_t)ceil(delay/WHEEL_TICK));
+        entry.handler = handler;
+        [_slots[entry.tick % WHEEL_SLOTS] addObject:entry];
+        _timers[@(timer)] = entry;
+    }];
+
+    return timer;
+}
+
+- (void)cancelTimer:(DMCReactorTimer)timer
+{
+    if (timer == 0) return;
+
+    [self onQueue:^{
+        DMCReactorTimerEntry *entry = _timers[@(timer)];
+
+        if (! entry) return;
+        [self removeEntry:entry];
+    }];
+}
+
+- (void)removeEntry:(DMCReactorTimerEntry *)entry
+{
+    [_slots[entry.tick % WHEEL_SLOTS] removeObjectIdenticalTo:entry];
+    [_timers removeObjectForKey:@(entry.timer)];
+    if (_timers.count == 0) dispatch_suspend(_ticker);
+}
+
+// fires due timers in every slot passed since the last tick, ticks can be late or coalesced
+- (void)advance
+{
+    while (_timers.count > 0 && _tick < [self currentTick]) { // a handler can restart the wheel from tick 0
+        _tick++;
+
+        for (DMCReactorTimerEntry *entry in [_slots[_tick % WHEEL_SLOTS] copy]) {
+            if (entry.tick > _tick || ! _timers[@(entry.timer)]) continue; // due in a later revolution, or cancelled
+            [self removeEntry:entry];
+            entry.handler();
+        }
+    }
+}
+
+@end
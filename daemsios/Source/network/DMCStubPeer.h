@@ -0,0 +1,49 @@
+//
+//  DMCStubPeer.h
+
+#import "DMCPeer.h"
+
+/**
+ 本地节点替身
+
+ Peer stand-in for tests: it never connects, and records the address lists, header and history requests it is asked to send
+ instead of sending them. Replies are simulated by calling the receiver's peer:... methods directly.
+ */
+@interface DMCStubPeer : DMCPeer
+
+/**
+ Address lists passed to sendGetbalancebyaddrMessageWithAddresses:, one per call.
+ */
+@property (nonatomic, readonly) NSMutableArray *balanceQueries;
+
+/**
+ Address lists passed to sendRegisteraddrMessageWithAddresses:, one per call.
+ */
+@property (nonatomic, readonly) NSMutableArray *registrations;
+
+/**
+ Locator arrays passed to sendGetheadersMessageWithLocators:andHashStop:, one per call.
+ */
+@property (nonatomic, readonly) NSMutableArray *headerRequests;
+
+/**
+ @[address, fromHeight, toHeight] passed to sendGettxidsbyaddrMessageWithAddress:fromHeight:toHeight:, one per call.
+ */
+@property (nonatomic, readonly) NSMutableArray *historyRequests;
+
+/**
+ txHash arrays passed to sendGettxsMessageWithTxHashes:, one per call.
+ */
+@property (nonatomic, readonly) NSMutableArray *txRequests;
+
+/**
+ Settable, so tests don't need a version message.
+ */
+@property (nonatomic, assign) uint32_t lastblock;
+
+/**
+ Stub at 127.0.0.1 on the port, so stubs for different nodes differ only by port.
+ */
++ (instancetype)stubPeerWithPort:(uint16_t)port;
+
+@end
@@ -0,0 +1,55 @@
+//
+//  DMCStubPeer.m
+
+#import "DMCStubPeer.h"
+
+@implementation DMCStubPeer
+
+@synthesize lastblock = _stubLastblock; // the inherited property is readonly, so it isn't synthesized on its own
+
++ (instancetype)stubPeerWithPort:(uint16_t)port
+{
+    UInt128 address = { .u32 = { 0, 0, CFSwapInt32HostToBig(0xffff), CFSwapInt32HostToBig(0x7f000001) } };
+
+    return [[self alloc] initWithAddress:address andPort:port];
+}
+
+- (instancetype)initWithAddress:(UInt128)address andPort:(uint16_t)port
+{
+    if (! (self = [super initWithAddress:address andPort:port])) return nil;
+
+    _balanceQueries = [NSMutableArray array];
+    _registrations = [NSMutableArray array];
+    _headerRequests = [NSMutableArray array];
+    _historyRequests = [NSMutableArray array];
+    _txRequests = [NSMutableArray array];
+    return self;
+}
+
+- (void)sendGetbalancebyaddrMessageWithAddresses:(NSArray *)addresses
+{
+    [_balanceQueries addObject:[addresses copy]];
+}
+
+- (void)sendRegisteraddrMessageWithAddresses:(NSArray *)addresses
+{
+    [_registrations addObject:[addresses copy]];
+}
+
+- (void)sendGetheadersMessageWithLocators:(NSArray *)locators andHashStop:(UInt256)hashStop
+{
+    [_headerRequests addObject:[locators copy]];
+}
+
+- (void)sendGettxidsbyaddrMessageWithAddress:(NSString *)address fromHeight:(uint32_t)fromHeight
+toHeight:(uint32_t)toHeight
+{
+    [_historyRequests addObject:@[address, @(fromHeight), @(toHeight)]];
+}
+
+- (void)sendGettxsMessageWithTxHashes:(NSArray *)txHashes
+{
+    [_txRequests addObject:[txHashes copy]];
+}
+
+@end
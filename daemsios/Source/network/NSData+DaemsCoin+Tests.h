@@ -0,0 +1,12 @@
+//
+//  NSData+DaemsCoin+Tests.h
+
+#import <Foundation/Foundation.h>
+
+// +[NSData runAllTests] is the core NSData (DMC_Tests) category, so the tests of the hashes in NSData+DaemsCoin run
+// with +[NSMutableData runAllTests]
+@interface NSMutableData (DaemsCoin_Tests)
+
++ (void)runAllTests;
+
+@end
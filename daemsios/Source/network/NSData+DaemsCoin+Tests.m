@@ -0,0 +1,221 @@
+//
+//  NSData+DaemsCoin+Tests.m
+
+#import "NSData+DaemsCoin+Tests.h"
+#import "NSData+DaemsCoin.h"
+#import "NSString+DaemsCoin.h"
+
+// chunk sizes that end updates before, on and after the 64 and 128 byte block boundaries
+static const size_t chunkSizes[] = { 1, 3, 55, 56, 63, 64, 65, 111, 112, 127, 128, 129 };
+
+// hashes data through the incremental context of the hash, chunk bytes per update
+static void incrementalDigest(void (*hash)(void *, const void *, size_t), void *md, const uint8_t *data, size_t len,
+                              size_t chunk)
+{
+    union {
+        SHA1Context sha1;
+        SHA256Context sha256;
+        SHA512Context sha512;
+        RMD160Context rmd160;
+    } ctx;
+
+    if (hash == SHA1) SHA1Init(&ctx.sha1);
+    else if (hash == SHA256) SHA256Init(&ctx.sha256);
+    else if (hash == SHA512) SHA512Init(&ctx.sha512);
+    else RMD160Init(&ctx.rmd160);
+
+    for (size_t i = 0; i < len; i += chunk) {
+        size_t n = MIN(chunk, len - i);
+
+        if (hash == SHA1) SHA1Update(&ctx.sha1, data + i, n);
+        else if (hash == SHA256) SHA256Update(&ctx.sha256, data + i, n);
+        else if (hash == SHA512) SHA512Update(&ctx.sha512, data + i, n);
+        else RMD160Update(&ctx.rmd160, data + i, n);
+    }
+
+    if (hash == SHA1) SHA1Final(&ctx.sha1, md);
+    else if (hash == SHA256) SHA256Final(&ctx.sha256, md);
+    else if (hash == SHA512) SHA512Final(&ctx.sha512, md);
+    else RMD160Final(&ctx.rmd160, md);
+}
+
+@implementation NSMutableData (DaemsCoin_Tests)
+
++ (void)runAllTests
+{
+    [self testHashVectors];
+    [self testIncrementalHashes];
+    [self testHMACVectors];
+    [self testIncrementalHMAC];
+    [self testPBKDF2Vectors];
+}
+
++ (NSData *)testMessage
+{
+    NSMutableData *message = [NSMutableData dataWithLength:300];
+
+    for (NSUInteger i = 0; i < message.length; i++) {
+        ((uint8_t *)message.mutableBytes)[i] = (uint8_t)(i*13 + 5);
+    }
+
+    return message;
+}
+
+// NIST FIPS 180 examples, RIPEMD-160 reference vectors
++ (void)testHashVectors
+{
+    NSData *abc = [@"abc" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *abc448 = [@"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *abc896 = [@"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrs"
+                      "mnopqrstnopqrstu" dataUsingEncoding:NSUTF8StringEncoding];
+    uint8_t md[64];
+
+    SHA1(md, abc.bytes, abc.length);
+    NSAssert([[NSData dataWithBytes:md length:20] isEqual:@"a9993e364706816aba3e25717850c26c9cd0d89d".hexToData], @"SHA1(abc)");
+    SHA1(md, abc448.bytes, abc448.length);
+    NSAssert([[NSData dataWithBytes:md length:20] isEqual:@"84983e441c3bd26ebaae4aa1f95129e5e54670f1".hexToData], @"SHA1(448 bits)");
+
+    SHA256(md, abc.bytes, abc.length);
+    NSAssert([[NSData dataWithBytes:md length:32]
+              isEqual:@"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad".hexToData], @"SHA256(abc)");
+    SHA256(md, abc448.bytes, abc448.length);
+    NSAssert([[NSData dataWithBytes:md length:32]
+              isEqual:@"248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1".hexToData], @"SHA256(448 bits)");
+
+    SHA512(md, abc.bytes, abc.length);
+    NSAssert([[NSData dataWithBytes:md length:64]
+              isEqual:@"ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd"
+              "454d4423643ce80e2a9ac94fa54ca49f".hexToData], @"SHA512(abc)");
+    SHA512(md, abc896.bytes, abc896.length);
+    NSAssert([[NSData dataWithBytes:md length:64]
+              isEqual:@"8e959b75dae313da8cf4f72814fc143f8f7779c6eb9f7fa17299aeadb6889018501d289e4900f7e4331b99dec4b5433a"
+              "c7d329eeb6dd26545e96e55b874be909".hexToData], @"SHA512(896 bits)");
+
+    RMD160(md, abc.bytes, abc.length);
+    NSAssert([[NSData dataWithBytes:md length:20] isEqual:@"8eb208f7e05d987a9b044a8e98c6b087f15a0bfc".hexToData], @"RMD160(abc)");
+    RMD160(md, abc448.bytes, abc448.length);
+    NSAssert([[NSData dataWithBytes:md length:20] isEqual:@"12a053384a9c0c88e405a06c27dcf49ada62eb2b".hexToData], @"RMD160(448 bits)");
+}
+
++ (void)testIncrementalHashes
+{
+    NSData *message = [self testMessage];
+    void (*hashes[])(void *, const void *, size_t) = { SHA1, SHA256, SHA512, RMD160 };
+    size_t lengths[] = { 20, 32, 64, 20 };
+
+    for (size_t h = 0; h < sizeof(hashes)/sizeof(*hashes); h++) {
+        for (size_t len = 0; len <= message.length; len++) {
+            uint8_t expected[64], actual[64];
+
+            hashes[h](expected, message.bytes, len);
+
+            for (size_t c = 0; c < sizeof(chunkSizes)/sizeof(*chunkSizes); c++) {
+                incrementalDigest(hashes[h], actual, message.bytes, len, chunkSizes[c]);
+                NSAssert(memcmp(expected, actual, lengths[h]) == 0, @"Incremental hash should match one-shot hash");
+            }
+        }
+    }
+}
+
+// RFC 4231 test cases 1, 2 and 6 (key longer than the block), RFC 2202 test case 1 for SHA1 and MD5
++ (void)testHMACVectors
+{
+    NSMutableData *key1 = [NSMutableData dataWithLength:20], *key6 = [NSMutableData dataWithLength:131];
+    NSData *key2 = [@"Jefe" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *data1 = [@"Hi There" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *data2 = [@"what do ya want for nothing?" dataUsingEncoding:NSUTF8StringEncoding];
+    NSData *data6 = [@"Test Using Larger Than Block-Size Key - Hash Key First" dataUsingEncoding:NSUTF8StringEncoding];
+    uint8_t md[64];
+
+    memset(key1.mutableBytes, 0x0b, key1.length);
+    memset(key6.mutableBytes, 0xaa, key6.length);
+
+    NSArray *vectors = @[
+        @[key1, data1, @"b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7",
+          @"87aa7cdea5ef619d4ff0b4241a1d6cb02379f4e2ce4ec2787ad0b30545e17cdedaa833b7d6b8a702038b274eaea3f4e4"
+          "be9d914eeb61f1702e696c203a126854"],
+        @[key2, data2, @"5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843",
+          @"164b7a7bfcf819e2e395fbe73b56e0a387bd64222e831fd610270cd7ea2505549758bf75c05a994a6d034f65f8f0e6fd"
+          "caeab1a34d4a6b4b636e070a38bce737"],
+        @[key6, data6, @"60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54",
+          @"80b24263c7c1a3ebb71493c1dd7be8b49b46d1f41b4aeec1121b013783f8f3526b56d037e05f2598bd0fd2215d6a1e52"
+          "95e64f73f63f0aec8b915a985d786598"]
+    ];
+
+    for (NSArray *v in vectors) {
+        NSData *key = v[0], *data = v[1];
+        HMACContext pads, ctx;
+
+        HMAC(md, SHA256, 32, key.bytes, key.length, data.bytes, data.length);
+        NSAssert([[NSData dataWithBytes:md length:32] isEqual:[v[2] hexToData]], @"HMAC-SHA256 should match RFC 4231");
+        HMAC(md, SHA512, 64, key.bytes, key.length, data.bytes, data.length);
+        NSAssert([[NSData dataWithBytes:md length:64] isEqual:[v[3] hexToData]], @"HMAC-SHA512 should match RFC 4231");
+
+        // key pads are hashed once and reused from copies of the context
+        HMACInit(&pads, SHA512, 64, key.bytes, key.length);
+
+        for (int i = 0; i < 2; i++) {
+            ctx = pads;
+            HMACUpdate(&ctx, data.bytes, 3);
+            HMACUpdate(&ctx, (const uint8_t *)data.bytes + 3, data.length - 3);
+            HMACFinal(&ctx, md);
+            NSAssert([[NSData dataWithBytes:md length:64] isEqual:[v[3] hexToData]], @"Copied HMAC context should reuse the key");
+        }
+    }
+
+    HMAC(md, SHA1, 20, key1.bytes, key1.length, data1.bytes, data1.length);
+    NSAssert([[NSData dataWithBytes:md length:20] isEqual:@"b617318655057264e28bc0b6fb378c8ef146be00".hexToData], @"HMAC-SHA1");
+    HMAC(md, MD5, 16, key1.bytes, 16, data1.bytes, data1.length); // one-shot path of hashes without a context
+    NSAssert([[NSData dataWithBytes:md length:16] isEqual:@"9294727a3638bb1c13f48ef8158bfc9d".hexToData], @"HMAC-MD5");
+}
+
++ (void)testIncrementalHMAC
+{
+    NSData *message = [self testMessage];
+    void (*hashes[])(void *, const void *, size_t) = { SHA1, SHA256, SHA512, RMD160 };
+    size_t lengths[] = { 20, 32, 64, 20 };
+    size_t keyLengths[] = { 0, 20, 64, 128, 200 };
+
+    for (size_t h = 0; h < sizeof(hashes)/sizeof(*hashes); h++) {
+        for (size_t k = 0; k < sizeof(keyLengths)/sizeof(*keyLengths); k++) {
+            for (size_t len = 0; len <= message.length; len += 7) {
+                uint8_t expected[64], actual[64];
+
+                HMAC(expected, hashes[h], lengths[h], message.bytes, keyLengths[k], message.bytes, len);
+
+                for (size_t c = 0; c < sizeof(chunkSizes)/sizeof(*chunkSizes); c++) {
+                    HMACContext ctx;
+
+                    HMACInit(&ctx, hashes[h], lengths[h], message.bytes, keyLengths[k]);
+
+                    for (size_t i = 0; i < len; i += chunkSizes[c]) {
+                        HMACUpdate(&ctx, (const uint8_t *)message.bytes + i, MIN(chunkSizes[c], len - i));
+                    }
+
+                    HMACFinal(&ctx, actual);
+                    NSAssert(memcmp(expected, actual, lengths[h]) == 0, @"Incremental HMAC should match one-shot HMAC");
+                }
+            }
+        }
+    }
+}
+
+// RFC 6070 for SHA1, the same inputs for SHA256 and SHA512
++ (void)testPBKDF2Vectors
+{
+    uint8_t dk[64];
+
+    PBKDF2(dk, 20, SHA1, 20, "password", 8, "salt", 4, 2);
+    NSAssert([[NSData dataWithBytes:dk length:20] isEqual:@"ea6c014dc72d6f8ccd1ed92ace1d41f0d8de8957".hexToData], @"PBKDF2-SHA1 2 rounds");
+    PBKDF2(dk, 20, SHA1, 20, "password", 8, "salt", 4, 4096);
+    NSAssert([[NSData dataWithBytes:dk length:20] isEqual:@"4b007901b765489abead49d926f721d065a429c1".hexToData], @"PBKDF2-SHA1 4096 rounds");
+    PBKDF2(dk, 32, SHA256, 32, "password", 8, "salt", 4, 4096);
+    NSAssert([[NSData dataWithBytes:dk length:32]
+              isEqual:@"c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a".hexToData], @"PBKDF2-SHA256");
+    PBKDF2(dk, 64, SHA512, 64, "password", 8, "salt", 4, 4096);
+    NSAssert([[NSData dataWithBytes:dk length:64]
+              isEqual:@"d197b1b33db0143e018b12f3d1d1479e6cdebdcc97c5c0f87f6902e072f457b5143f30602641b3d55cd335988cb36b84"
+              "376060ecd532e039b742a239434af2d5".hexToData], @"PBKDF2-SHA512");
+}
+
+@end
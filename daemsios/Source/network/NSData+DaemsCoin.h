@@ -2,6 +2,7 @@
 //  NSData+DaemsCoin.h
 
 #import <Foundation/Foundation.h>
+#import "DMCHashBackend.h"
 
 typedef union _UInt512 {
     uint8_t u8[512/8];
@@ -78,12 +79,61 @@ void SHA256(void *_Nonnull md, const void *_Nonnull data, size_t len);
 void SHA512(void *_Nonnull md, const void *_Nonnull data, size_t len);
 void RMD160(void *_Nonnull md, const void *_Nonnull data, size_t len);
 void MD5(void *_Nonnull md, const void *_Nonnull data, size_t len);
+// hashes without an incremental context (MD5) need a buffer of the key pad and data; if it can't be allocated the
+// output of HMAC and PBKDF2 is zeroed
 void HMAC(void *_Nonnull md, void (*_Nonnull hash)(void *_Nonnull , const void *_Nonnull , size_t), size_t hlen,
           const void *_Nonnull key, size_t klen, const void *_Nonnull data, size_t dlen);
 void PBKDF2(void *_Nonnull dk, size_t dklen, void (*_Nonnull hash)(void *_Nonnull , const void *_Nonnull , size_t),
             size_t hlen, const void *_Nonnull pw, size_t pwlen, const void *_Nonnull salt, size_t slen,
             unsigned rounds);
 
+// incremental hashing: init, update with any number of buffers, then final writes md and clears the context
+typedef DMCSHA1Context SHA1Context;
+typedef DMCSHA256Context SHA256Context;
+
+typedef struct {
+    uint64_t buf[8];
+    uint64_t len;
+    uint64_t x[16];
+} SHA512Context;
+
+typedef struct {
+    uint32_t buf[5];
+    uint64_t len;
+    uint32_t x[16];
+} RMD160Context;
+
+void SHA1Init(SHA1Context *_Nonnull ctx);
+void SHA1Update(SHA1Context *_Nonnull ctx, const void *_Nonnull data, size_t len);
+void SHA1Final(SHA1Context *_Nonnull ctx, void *_Nonnull md);
+void SHA256Init(SHA256Context *_Nonnull ctx);
+void SHA256Update(SHA256Context *_Nonnull ctx, const void *_Nonnull data, size_t len);
+void SHA256Final(SHA256Context *_Nonnull ctx, void *_Nonnull md);
+void SHA512Init(SHA512Context *_Nonnull ctx);
+void SHA512Update(SHA512Context *_Nonnull ctx, const void *_Nonnull data, size_t len);
+void SHA512Final(SHA512Context *_Nonnull ctx, void *_Nonnull md);
+void RMD160Init(RMD160Context *_Nonnull ctx);
+void RMD160Update(RMD160Context *_Nonnull ctx, const void *_Nonnull data, size_t len);
+void RMD160Final(RMD160Context *_Nonnull ctx, void *_Nonnull md);
+
+// incremental HMAC, hash must be SHA1, SHA256, SHA512 or RMD160
+// a context right after HMACInit holds the hashed key pads and can be copied to reuse the same key
+typedef struct {
+    void (*_Nonnull hash)(void *_Nonnull, const void *_Nonnull, size_t);
+    size_t hlen;
+    union {
+        SHA1Context sha1;
+        SHA256Context sha256;
+        SHA512Context sha512;
+        RMD160Context rmd160;
+    } inner, outer;
+} HMACContext;
+
+void HMACInit(HMACContext *_Nonnull ctx, void (*_Nonnull hash)(void *_Nonnull, const void *_Nonnull, size_t), size_t hlen,
+              const void *_Nonnull key, size_t klen);
+void HMACUpdate(HMACContext *_Nonnull ctx, const void *_Nonnull data, size_t len);
+void HMACFinal(HMACContext *_Nonnull ctx, void *_Nonnull md);
+
 // poly1305 authenticator: https://tools.ietf.org/html/rfc7539
 // must use constant time mem comparison when verifying mac to defend against timing attacks
 void poly1305(void *_Nonnull mac16, const void *_Nonnull key32, const void *_Nonnull data, size_t len);
@@ -3,175 +3,111 @@
 
 #import "NSData+DaemsCoin.h"
 #import "NSString+DaemsCoin.h"
+#import "DMCHashBackend.h"
+#import "DMCPBKDF2.h"
+#import "DMCSHA512.h"
 
 // bitwise left rotation
 #define rol32(a, b) (((a) << (b)) | ((a) >> (32 - (b))))
 
-// basic sha1 functions
-#define f1(x, y, z) (((x) & (y)) | (~(x) & (z)))
-#define f2(x, y, z) ((x) ^ (y) ^ (z))
-#define f3(x, y, z) (((x) & (y)) | ((x) & (z)) | ((y) & (z)))
-
-// basic sha1 operation
-#define sha1(x, y, z) (t = rol32(a, 5) + (x) + e + (y) + (z), e = d, d = c, c = rol32(b, 30), b = a, a = t)
-
-static void SHA1Compress(uint32_t *r, uint32_t *x)
+// sha1 and sha256 use the hardware accelerated backend when the cpu supports it
+void SHA1(void *md, const void *data, size_t len)
 {
-    size_t i = 0;
-    uint32_t a = r[0], b = r[1], c = r[2], d = r[3], e = r[4], t;
-    
-    for (; i < 16; i++) sha1(f1(b, c, d), 0x5a827999, (x[i] = CFSwapInt32BigToHost(x[i])));
-    for (; i < 20; i++) sha1(f1(b, c, d), 0x5a827999, (x[i] = rol32(x[i - 3] ^ x[i - 8] ^ x[i - 14] ^ x[i - 16], 1)));
-    for (; i < 40; i++) sha1(f2(b, c, d), 0x6ed9eba1, (x[i] = rol32(x[i - 3] ^ x[i - 8] ^ x[i - 14] ^ x[i - 16], 1)));
-    for (; i < 60; i++) sha1(f3(b, c, d), 0x8f1bbcdc, (x[i] = rol32(x[i - 3] ^ x[i - 8] ^ x[i - 14] ^ x[i - 16], 1)));
-    for (; i < 80; i++) sha1(f2(b, c, d), 0xca62c1d6, (x[i] = rol32(x[i - 3] ^ x[i - 8] ^ x[i - 14] ^ x[i - 16], 1)));
-
-    r[0] += a, r[1] += b, r[2] += c, r[3] += d, r[4] += e;
+    DMCSHA1Digest(md, data, len);
 }
 
-void SHA1(void *md, const void *data, size_t len)
+void SHA1Init(SHA1Context *ctx)
 {
-    size_t i;
-    uint32_t x[80], buf[] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 }; // initial buffer values
-    
-    for (i = 0; i < len; i += 64) { // process data in 64 byte blocks
-        memcpy(x, (const uint8_t *)data + i, (i + 64 < len) ? 64 : len - i);
-        if (i + 64 > len) break;
-        SHA1Compress(buf, x);
-    }
-    
-    memset((uint8_t *)x + (len - i), 0, 64 - (len - i)); // clear remainder of x
-    ((uint8_t *)x)[len - i] = 0x80; // append padding
-    if (len - i >= 56) SHA1Compress(buf, x), memset(x, 0, 64); // length goes to next block
-    *(uint64_t *)&x[14] = CFSwapInt64HostToBig((uint64_t)len*8); // append length in bits
-    SHA1Compress(buf, x); // finalize
-    for (i = 0; i < 5; i++) ((uint32_t *)md)[i] = CFSwapInt32HostToBig(buf[i]); // write to md
+    DMCSHA1Init(ctx);
 }
 
-// bitwise right rotation
-#define ror32(a, b) (((a) >> (b)) | ((a) << (32 - (b))))
-
-// basic sha2 functions
-#define ch(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
-#define maj(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
-
-// basic sha256 functions
-#define s0(x) (ror32((x), 2) ^ ror32((x), 13) ^ ror32((x), 22))
-#define s1(x) (ror32((x), 6) ^ ror32((x), 11) ^ ror32((x), 25))
-#define s2(x) (ror32((x), 7) ^ ror32((x), 18) ^ ((x) >> 3))
-#define s3(x) (ror32((x), 17) ^ ror32((x), 19) ^ ((x) >> 10))
+void SHA1Update(SHA1Context *ctx, const void *data, size_t len)
+{
+    DMCSHA1Update(ctx, data, len);
+}
 
-static void SHA256Compress(uint32_t *r, uint32_t *x)
+void SHA1Final(SHA1Context *ctx, void *md)
 {
-    static const uint32_t k[] = {
-        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
-        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
-        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
-        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
-        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
-        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
-        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
-        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
-    };
-    
-    size_t i;
-    uint32_t a = r[0], b = r[1], c = r[2], d = r[3], e = r[4], f = r[5], g = r[6], h = r[7], t1, t2, w[64];
-    
-    for (i = 0; i < 16; i++) w[i] = CFSwapInt32BigToHost(x[i]);
-    for (; i < 64; i++) w[i] = s3(w[i - 2]) + w[i - 7] + s2(w[i - 15]) + w[i - 16];
-    
-    for (i = 0; i < 64; i++) {
-        t1 = h + s1(e) + ch(e, f, g) + k[i] + w[i];
-        t2 = s0(a) + maj(a, b, c);
-        h = g, g = f, f = e, e = d + t1, d = c, c = b, b = a, a = t1 + t2;
-    }
-    
-    r[0] += a, r[1] += b, r[2] += c, r[3] += d, r[4] += e, r[5] += f, r[6] += g, r[7] += h;
+    DMCSHA1Final(ctx, md);
 }
 
 void SHA256(void *md, const void *data, size_t len)
 {
-    size_t i;
-    uint32_t x[16], buf[] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
-                              0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 }; // initial buffer values
-    
-    for (i = 0; i < len; i += 64) { // process data in 64 byte blocks
-        memcpy(x, (const uint8_t *)data + i, (i + 64 < len) ? 64 : len - i);
-        if (i + 64 > len) break;
-        SHA256Compress(buf, x);
-    }
+    DMCSHA256Digest(md, data, len);
+}
 
-    memset((uint8_t *)x + (len - i), 0, 64 - (len - i)); // clear remainder of x
-    ((uint8_t *)x)[len - i] = 0x80; // append padding
-    if (len - i >= 56) SHA256Compress(buf, x), memset(x, 0, 64); // length goes to next block
-    *(uint64_t *)&x[14] = CFSwapInt64HostToBig((uint64_t)len*8); // append length in bits
-    SHA256Compress(buf, x); // finalize
-    for (i = 0; i < 8; i++) ((uint32_t *)md)[i] = CFSwapInt32HostToBig(buf[i]); // write to md
+void SHA256Init(SHA256Context *ctx)
+{
+    DMCSHA256Init(ctx);
 }
 
-// bitwise right rotation
-#define ror64(a, b) (((a) >> (b)) | ((a) << (64 - (b))))
+void SHA256Update(SHA256Context *ctx, const void *data, size_t len)
+{
+    DMCSHA256Update(ctx, data, len);
+}
 
-// basic sha512 opeartions
-#define S0(x) (ror64((x), 28) ^ ror64((x), 34) ^ ror64((x), 39))
-#define S1(x) (ror64((x), 14) ^ ror64((x), 18) ^ ror64((x), 41))
-#define S2(x) (ror64((x), 1) ^ ror64((x), 8) ^ ((x) >> 7))
-#define S3(x) (ror64((x), 19) ^ ror64((x), 61) ^ ((x) >> 6))
+void SHA256Final(SHA256Context *ctx, void *md)
+{
+    DMCSHA256Final(ctx, md);
+}
 
 static void SHA512Compress(uint64_t *r, uint64_t *x)
 {
-    static const uint64_t k[] = {
-        0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc, 0x3956c25bf348b538,
-        0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118, 0xd807aa98a3030242, 0x12835b0145706fbe,
-        0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2, 0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235,
-        0xc19bf174cf692694, 0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
-        0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5, 0x983e5152ee66dfab,
-        0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4, 0xc6e00bf33da88fc2, 0xd5a79147930aa725,
-        0x06ca6351e003826f, 0x142929670a0e6e70, 0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed,
-        0x53380d139d95b3df, 0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
-        0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30, 0xd192e819d6ef5218,
-        0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8, 0x19a4c116b8d2d0c8, 0x1e376c085141ab53,
-        0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8, 0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373,
-        0x682e6ff3d6b2b8a3, 0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
-        0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b, 0xca273eceea26619c,
-        0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178, 0x06f067aa72176fba, 0x0a637dc5a2c898a6,
-        0x113f9804bef90dae, 0x1b710b35131c471b, 0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc,
-        0x431d67c49c100d4c, 0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817
-    };
-    
     size_t i;
     uint64_t a = r[0], b = r[1], c = r[2], d = r[3], e = r[4], f = r[5], g = r[6], h = r[7], t1, t2, w[80];
     
     for (i = 0; i < 16; i++) w[i] = CFSwapInt64BigToHost(x[i]);
-    for (; i < 80; i++) w[i] = S3(w[i - 2]) + w[i - 7] + S2(w[i - 15]) + w[i - 16];
+    for (; i < 80; i++) w[i] = DMCSHA512S3(w[i - 2]) + w[i - 7] + DMCSHA512S2(w[i - 15]) + w[i - 16];
     
     for (i = 0; i < 80; i++) {
-        t1 = h + S1(e) + ch(e, f, g) + k[i] + w[i];
-        t2 = S0(a) + maj(a, b, c);
+        t1 = h + DMCSHA512S1(e) + DMCSHA512Ch(e, f, g) + DMCSHA512K[i] + w[i];
+        t2 = DMCSHA512S0(a) + DMCSHA512Maj(a, b, c);
         h = g, g = f, f = e, e = d + t1, d = c, c = b, b = a, a = t1 + t2;
     }
     
     r[0] += a, r[1] += b, r[2] += c, r[3] += d, r[4] += e, r[5] += f, r[6] += g, r[7] += h;
 }
 
-void SHA512(void *md, const void *data, size_t len)
+void SHA512Init(SHA512Context *ctx)
 {
-    size_t i;
-    uint64_t x[16], buf[] = { 0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
-                              0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179 };
+    memcpy(ctx->buf, DMCSHA512IV, sizeof(DMCSHA512IV)); // initial buffer values
+    ctx->len = 0;
+}
+
+void SHA512Update(SHA512Context *ctx, const void *data, size_t len)
+{
+    size_t i = ctx->len % 128, n;
+    
+    ctx->len += len;
     
-    for (i = 0; i < len; i += 128) { // process data in 128 byte blocks
-        memcpy(x, (const uint8_t *)data + i, (i + 128 < len) ? 128 : len - i);
-        if (i + 128 > len) break;
-        SHA512Compress(buf, x);
+    while (len > 0) { // fill x and process it in 128 byte blocks
+        n = (i + len < 128) ? len : 128 - i;
+        memcpy((uint8_t *)ctx->x + i, data, n);
+        data = (const uint8_t *)data + n, len -= n, i += n;
+        if (i == 128) SHA512Compress(ctx->buf, ctx->x), i = 0;
     }
+}
+
+void SHA512Final(SHA512Context *ctx, void *md)
+{
+    size_t i = ctx->len % 128;
     
-    memset((uint8_t *)x + (len - i), 0, 128 - (len - i)); // clear remainder of x
-    ((uint8_t *)x)[len - i] = 0x80; // append padding
-    if (len - i >= 112) SHA512Compress(buf, x), memset(x, 0, 128); // length goes to next block
-    x[14] = 0, x[15] = CFSwapInt64HostToBig((uint64_t)len*8); // append length in bits
-    SHA512Compress(buf, x); // finalize
-    for (i = 0; i < 8; i++) ((uint64_t *)md)[i] = CFSwapInt64HostToBig(buf[i]); // write to md
+    ((uint8_t *)ctx->x)[i++] = 0x80; // append padding
+    memset((uint8_t *)ctx->x + i, 0, 128 - i); // clear remainder of x
+    if (i > 112) SHA512Compress(ctx->buf, ctx->x), memset(ctx->x, 0, 128); // length goes to next block
+    ctx->x[14] = 0, ctx->x[15] = CFSwapInt64HostToBig(ctx->len*8); // append length in bits
+    SHA512Compress(ctx->buf, ctx->x); // finalize
+    for (i = 0; i < 8; i++) ((uint64_t *)md)[i] = CFSwapInt64HostToBig(ctx->buf[i]); // write to md
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void SHA512(void *md, const void *data, size_t len)
+{
+    SHA512Context ctx;
+    
+    SHA512Init(&ctx);
+    SHA512Update(&ctx, data, len);
+    SHA512Final(&ctx, md);
 }
 
 // basic ripemd functions
@@ -231,23 +167,49 @@ static void RMDCompress(uint32_t *r, uint32_t *x)
 }
 
 // ripemd-160 hash function: http://homes.esat.kuleuven.be/~bosselae/ripemd160.html
-void RMD160(void *md, const void *data, size_t len)
+void RMD160Init(RMD160Context *ctx)
 {
-    size_t i;
-    uint32_t x[16], buf[] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 }; // initial buffer values
+    static const uint32_t iv[] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
     
-    for (i = 0; i <= len; i += 64) { // process data in 64 byte blocks
-        memcpy(x, (const uint8_t *)data + i, (i + 64 < len) ? 64 : len - i);
-        if (i + 64 > len) break;
-        RMDCompress(buf, x);
+    memcpy(ctx->buf, iv, sizeof(iv)); // initial buffer values
+    ctx->len = 0;
+}
+
+void RMD160Update(RMD160Context *ctx, const void *data, size_t len)
+{
+    size_t i = ctx->len % 64, n;
+    
+    ctx->len += len;
+    
+    while (len > 0) { // fill x and process it in 64 byte blocks
+        n = (i + len < 64) ? len : 64 - i;
+        memcpy((uint8_t *)ctx->x + i, data, n);
+        data = (const uint8_t *)data + n, len -= n, i += n;
+        if (i == 64) RMDCompress(ctx->buf, ctx->x), i = 0;
     }
+}
+
+void RMD160Final(RMD160Context *ctx, void *md)
+{
+    size_t i = ctx->len % 64;
     
-    memset((uint8_t *)x + (len - i), 0, 64 - (len - i)); // clear remainder of x
-    ((uint8_t *)x)[len - i] = 0x80; // append padding
-    if (len - i >= 56) RMDCompress(buf, x), memset(x, 0, 64); // length goes to next block
-    *(uint64_t *)&x[14] = CFSwapInt64HostToLittle((uint64_t)len*8); // append length in bits
-    RMDCompress(buf, x); // finalize
-    for (i = 0; i < 5; i++) ((uint32_t *)md)[i] = CFSwapInt32HostToLittle(buf[i]); // write to md
+    ((uint8_t *)ctx->x)[i++] = 0x80; // append padding
+    memset((uint8_t *)ctx->x + i, 0, 64 - i); // clear remainder of x
+    if (i > 56) RMDCompress(ctx->buf, ctx->x), memset(ctx->x, 0, 64); // length goes to next block
+    ctx->x[14] = CFSwapInt32HostToLittle((uint32_t)(ctx->len*8)); // append length in bits
+    ctx->x[15] = CFSwapInt32HostToLittle((uint32_t)(ctx->len >> 29));
+    RMDCompress(ctx->buf, ctx->x); // finalize
+    for (i = 0; i < 5; i++) ((uint32_t *)md)[i] = CFSwapInt32HostToLittle(ctx->buf[i]); // write to md
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+void RMD160(void *md, const void *data, size_t len)
+{
+    RMD160Context ctx;
+    
+    RMD160Init(&ctx);
+    RMD160Update(&ctx, data, len);
+    RMD160Final(&ctx, md);
 }
 
 // basic md5 functions
@@ -312,11 +274,93 @@ void MD5(void *md, const void *data, size_t len)
 // HMAC(key, data) = hash((key xor opad) || hash((key xor ipad) || data))
 // opad = 0x5c5c5c...5c5c
 // ipad = 0x363636...3636
+static int _HMACHashIsIncremental(void (*hash)(void *, const void *, size_t))
+{
+    return (hash == SHA1 || hash == SHA256 || hash == SHA512 || hash == RMD160);
+}
+
+static void _HMACHashInit(void (*hash)(void *, const void *, size_t), void *ctx)
+{
+    if (hash == SHA1) SHA1Init(ctx);
+    else if (hash == SHA256) SHA256Init(ctx);
+    else if (hash == SHA512) SHA512Init(ctx);
+    else RMD160Init(ctx);
+}
+
+static void _HMACHashUpdate(void (*hash)(void *, const void *, size_t), void *ctx, const void *data, size_t len)
+{
+    if (hash == SHA1) SHA1Update(ctx, data, len);
+    else if (hash == SHA256) SHA256Update(ctx, data, len);
+    else if (hash == SHA512) SHA512Update(ctx, data, len);
+    else RMD160Update(ctx, data, len);
+}
+
+static void _HMACHashFinal(void (*hash)(void *, const void *, size_t), void *ctx, void *md)
+{
+    if (hash == SHA1) SHA1Final(ctx, md);
+    else if (hash == SHA256) SHA256Final(ctx, md);
+    else if (hash == SHA512) SHA512Final(ctx, md);
+    else RMD160Final(ctx, md);
+}
+
+void HMACInit(HMACContext *ctx, void (*hash)(void *, const void *, size_t), size_t hlen, const void *key, size_t klen)
+{
+    size_t blen = (hlen > 32) ? 128 : 64;
+    uint64_t k[128/8], pad[128/8];
+    
+    memset(k, 0, sizeof(k));
+    if (klen > blen) hash(k, key, klen);
+    else memcpy(k, key, klen);
+    
+    ctx->hash = hash;
+    ctx->hlen = hlen;
+    for (size_t i = 0; i < blen/8; i++) pad[i] = k[i] ^ 0x3636363636363636;
+    _HMACHashInit(hash, &ctx->inner);
+    _HMACHashUpdate(hash, &ctx->inner, pad, blen);
+    for (size_t i = 0; i < blen/8; i++) pad[i] = k[i] ^ 0x5c5c5c5c5c5c5c5c;
+    _HMACHashInit(hash, &ctx->outer);
+    _HMACHashUpdate(hash, &ctx->outer, pad, blen);
+    
+    memset(k, 0, sizeof(k));
+    memset(pad, 0, sizeof(pad));
+}
+
+void HMACUpdate(HMACContext *ctx, const void *data, size_t len)
+{
+    _HMACHashUpdate(ctx->hash, &ctx->inner, data, len);
+}
+
+void HMACFinal(HMACContext *ctx, void *md)
+{
+    uint8_t ihash[64];
+    
+    _HMACHashFinal(ctx->hash, &ctx->inner, ihash);
+    _HMACHashUpdate(ctx->hash, &ctx->outer, ihash, ctx->hlen);
+    _HMACHashFinal(ctx->hash, &ctx->outer, md);
+    memset(ihash, 0, sizeof(ihash));
+    memset(ctx, 0, sizeof(*ctx));
+}
+
 void HMAC(void *md, void (*hash)(void *, const void *, size_t), size_t hlen, const void *key, size_t klen,
           const void *data, size_t dlen)
 {
+    if (_HMACHashIsIncremental(hash)) {
+        HMACContext ctx;
+        
+        HMACInit(&ctx, hash, hlen, key, klen);
+        HMACUpdate(&ctx, data, dlen);
+        HMACFinal(&ctx, md);
+        return;
+    }
+    
+    // one-shot hash functions need key pads and data in one buffer, keep it off the stack
     size_t blen = (hlen > 32) ? 128 : 64;
-    uint8_t k[hlen], kipad[blen + dlen], kopad[blen + hlen];
+    uint8_t k[hlen], *kipad = malloc(blen + dlen), kopad[blen + hlen];
+    
+    if (! kipad) { // no partial result to hand back
+        memset(md, 0, hlen);
+        return;
+    }
     
     if (klen > blen) hash(k, key, klen), key = k, klen = sizeof(k);
     memset(kipad, 0, blen);
@@ -326,12 +370,13 @@ void HMAC(void *md, void (*hash)(void *, const void *, size_t), size_t hlen, con
     memcpy(kopad, key, klen);
     for (size_t i = 0; i < blen/8; i++) ((uint64_t *)kopad)[i] ^= 0x5c5c5c5c5c5c5c5c;
     memcpy(kipad + blen, data, dlen);
-    hash(kopad + blen, kipad, sizeof(kipad));
+    hash(kopad + blen, kipad, blen + dlen);
     hash(md, kopad, sizeof(kopad));
     
     memset(k, 0, sizeof(k));
     memset(kipad, 0, blen);
     memset(kopad, 0, blen);
+    free(kipad);
 }
 
 // dk = T1 || T2 || ... || Tdklen/hlen
@@ -343,18 +388,54 @@ void HMAC(void *md, void (*hash)(void *, const void *, size_t), size_t hlen, con
 void PBKDF2(void *dk, size_t dklen, void (*hash)(void *, const void *, size_t), size_t hlen,
             const void *pw, size_t pwlen, const void *salt, size_t slen, unsigned rounds)
 {
-    uint8_t s[slen + sizeof(unsigned)], U[hlen], T[hlen];
-    uint32_t i, j;
+    uint8_t U[hlen], T[hlen];
+    uint32_t i, j, be;
+    int incremental = _HMACHashIsIncremental(hash);
+    HMACContext pads, ctx;
+    
+    if (hash == SHA512 && hlen == 64) { // word-level rounds with SIMD lanes in core
+        DMCPBKDF2HMACSHA512(dk, dklen, pw, pwlen, salt, slen, rounds);
+        return;
+    }
     
-    memcpy(s, salt, slen);
+    // hash key pads once, every hmac below resumes from a copy of these states
+    if (incremental) HMACInit(&pads, hash, hlen, pw, pwlen);
     
     for (i = 0; i < (dklen + hlen - 1)/hlen; i++) {
-        *(uint32_t *)(s + slen) = CFSwapInt32HostToBig(i + 1);
-        HMAC(U, hash, hlen, pw, pwlen, s, sizeof(s)); // U1 = hmac_hash(pw, salt || INT32_BE(i))
+        be = CFSwapInt32HostToBig(i + 1);
+        
+        if (incremental) { // U1 = hmac_hash(pw, salt || INT32_BE(i))
+            ctx = pads;
+            HMACUpdate(&ctx, salt, slen);
+            HMACUpdate(&ctx, &be, sizeof(be));
+            HMACFinal(&ctx, U);
+        }
+        else {
+            uint8_t *s = malloc(slen + sizeof(be));
+            
+            if (! s) {
+                memset(dk, 0, dklen);
+                memset(T, 0, sizeof(T));
+                return;
+            }
+            
+            memcpy(s, salt, slen);
+            memcpy(s + slen, &be, sizeof(be));
+            HMAC(U, hash, hlen, pw, pwlen, s, slen + sizeof(be));
+            memset(s, 0, slen + sizeof(be));
+            free(s);
+        }
+        
         memcpy(T, U, sizeof(U));
 
-        for (unsigned r = 1; r < rounds; r++) {
-            HMAC(U, hash, hlen, pw, pwlen, U, sizeof(U)); // Urounds = hmac_hash(pw, Urounds-1)
+        for (unsigned r = 1; r < rounds; r++) { // Urounds = hmac_hash(pw, Urounds-1)
+            if (incremental) {
+                ctx = pads;
+                HMACUpdate(&ctx, U, sizeof(U));
+                HMACFinal(&ctx, U);
+            }
+            else HMAC(U, hash, hlen, pw, pwlen, U, sizeof(U));
+            
             for (j = 0; j < hlen/4; j++) ((uint32_t *)T)[j] ^= ((uint32_t *)U)[j]; // Ti = U1 xor U2 xor ... xor Urounds
         }
 
@@ -362,7 +443,7 @@ void PBKDF2(void *dk, size_t dklen, void (*hash)(void *, const void *, size_t),
         memcpy((uint8_t *)dk + i*hlen, T, (i*hlen + hlen <= dklen) ? hlen : dklen % hlen);
     }
     
-    memset(s, 0, sizeof(s));
+    if (incremental) memset(&pads, 0, sizeof(pads));
     memset(U, 0, sizeof(U));
     memset(T, 0, sizeof(T));
 }
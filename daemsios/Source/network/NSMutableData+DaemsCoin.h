@@ -39,6 +39,7 @@ CF_IMPLICIT_BRIDGING_DISABLED
 - (void)appendScriptPushData:(NSData *)d;
 
 - (void)appendMessage:(NSData *)message type:(NSString *)type;
+- (void)appendMessageHeaderForPayload:(NSData *)message type:(NSString *)type; // header only, without the payload
 - (void)appendNullPaddedString:(NSString *)s length:(NSUInteger)length;
 - (void)appendNetAddress:(uint32_t)address port:(uint16_t)port services:(uint64_t)services;
 
@@ -227,12 +227,19 @@ CFAllocatorRef SecureAllocator()
  */
 - (void)appendMessage:(NSData *)message type:(NSString *)type;
 {
+    [self appendMessageHeaderForPayload:message type:type];
+    [self appendBytes:message.bytes length:message.length];
+}
 
+- (void)appendMessageHeaderForPayload:(NSData *)message type:(NSString *)type
+{
+    char command[12] = { 0 };
+
+    strncpy(command, type.UTF8String, sizeof(command)); // longer daems commands are sent as their first 12 bytes
     [self appendUInt32:DAEMSCOIN_MAGIC_NUMBER];
-    [self appendNullPaddedString:type length:12];
+    [self appendBytes:command length:sizeof(command)];
     [self appendUInt32:(uint32_t)message.length];
     [self appendBytes:message.SHA256_2.u32 length:4];
-    [self appendBytes:message.bytes length:message.length];
 }
 
 - (void)appendNullPaddedString:(NSString *)s length:(NSUInteger)length
@@ -4,12 +4,8 @@
 #import "NSString+DaemsCoin.h"
 #import "NSData+DaemsCoin.h"
 #import "NSMutableData+DaemsCoin.h"
-
-static const UniChar base58chars[] = {
-    '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'J', 'K', 'L', 'M', 'N', 'P',
-    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'm', 'n',
-    'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z'
-};
+#import "DMCBase58.h"
+#import "DMCHex.h"
 
 @implementation NSString (DaemsCoin)
 
@@ -17,33 +13,13 @@ static const UniChar base58chars[] = {
 {
     if (! d) return nil;
     
-    size_t i, z = 0;
+    size_t len = DMCBase58MaxEncodedLength(d.length);
+    char buf[len];
     
-    while (z < d.length && ((const uint8_t *)d.bytes)[z] == 0) z++; // count leading zeroes
+    DMCBase58Encode(buf, &len, d.bytes, d.length);
     
-    uint8_t buf[(d.length - z)*138/100 + 1]; // log(256)/log(58), rounded up
-
-    memset(buf, 0, sizeof(buf));
-
-    for (i = z; i < d.length; i++) {
-        uint32_t carry = ((const uint8_t *)d.bytes)[i];
-
-        for (size_t j = sizeof(buf); j > 0; j--) {
-            carry += (uint32_t)buf[j - 1] << 8;
-            buf[j - 1] = carry % 58;
-            carry /= 58;
-        }
-        
-        memset(&carry, 0, sizeof(carry));
-    }
-
-    i = 0;
-    while (i < sizeof(buf) && buf[i] == 0) i++; // skip leading zeroes
-
-    CFMutableStringRef s = CFStringCreateMutable(SecureAllocator(), z + sizeof(buf) - i);
+    CFStringRef s = CFStringCreateWithBytes(SecureAllocator(), (const UInt8 *)buf, len, kCFStringEncodingASCII, false);
     
-    while (z-- > 0) CFStringAppendCharacters(s, &base58chars[0], 1);
-    while (i < sizeof(buf)) CFStringAppendCharacters(s, &base58chars[buf[i++]], 1);
     memset(buf, 0, sizeof(buf));
     return CFBridgingRelease(s);
 }
@@ -62,14 +38,15 @@ static const UniChar base58chars[] = {
 {
     if (! d) return nil;
     
-    const uint8_t *bytes = d.bytes;
-    NSMutableString *hex = CFBridgingRelease(CFStringCreateMutable(SecureAllocator(), d.length*2));
+    char *buf = malloc(d.length*2 + 1);
     
-    for (NSUInteger i = 0; i < d.length; i++) {
-        [hex appendFormat:@"%02x", bytes[i]];
-    }
+    DMCHexEncode(buf, d.bytes, d.length, DMCHexLowercase);
+    
+    CFStringRef s = CFStringCreateWithBytes(SecureAllocator(), (const UInt8 *)buf, d.length*2, kCFStringEncodingASCII, false);
     
-    return hex;
+    memset(buf, 0, d.length*2);
+    free(buf);
+    return CFBridgingRelease(s);
 }
 
 // NOTE: It's important here to be permissive with scriptSig (spends) and strict with scriptPubKey (receives). If we
@@ -152,68 +129,27 @@ static const UniChar base58chars[] = {
 
 - (NSData *)base58ToData
 {
-    size_t i, z = 0;
+    NSUInteger n = self.length, i = 0;
+    UniChar chars[n + 1];
+    char str[n + 1];
     
-    while (z < self.length && [self characterAtIndex:z] == base58chars[0]) z++; // count leading zeroes
+    [self getCharacters:chars range:NSMakeRange(0, n)];
     
-    uint8_t buf[(self.length - z)*733/1000 + 1]; // log(58)/log(256), rounded up
+    for (; i < n && chars[i] < 0x80; i++) str[i] = (char)chars[i];
     
-    memset(buf, 0, sizeof(buf));
+    size_t len = DMCBase58ValidLength(str, i); // decoding stops at the first invalid digit
     
-    for (i = z; i < self.length; i++) {
-        uint32_t carry = [self characterAtIndex:i];
-
-        switch (carry) {
-            case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
-                carry -= '1';
-                break;
-
-            case 'A': case 'B': case 'C': case 'D': case 'E': case 'F': case 'G': case 'H':
-                carry += 9 - 'A';
-                break;
-
-            case 'J': case 'K': case 'L': case 'M': case 'N':
-                carry += 17 - 'J';
-                break;
-
-            case 'P': case 'Q': case 'R': case 'S': case 'T': case 'U': case 'V': case 'W': case 'X': case 'Y':
-            case 'Z':
-                carry += 22 - 'P';
-                break;
-
-            case 'a': case 'b': case 'c': case 'd': case 'e': case 'f': case 'g': case 'h': case 'i': case 'j':
-            case 'k':
-                carry += 33 - 'a';
-                break;
-
-            case 'm': case 'n': case 'o': case 'p': case 'q': case 'r': case 's': case 't': case 'u': case 'v':
-            case 'w': case 'x': case 'y': case 'z':
-                carry += 44 - 'm';
-                break;
-
-            default:
-                carry = UINT32_MAX;
-        }
-        
-        if (carry >= 58) break; // invalid base58 digit
-        
-        for (size_t j = sizeof(buf); j > 0; j--) {
-            carry += (uint32_t)buf[j - 1]*58;
-            buf[j - 1] = carry & 0xff;
-            carry >>= 8;
-        }
-        
-        memset(&carry, 0, sizeof(carry));
-    }
+    uint8_t buf[DMCBase58MaxDecodedLength(len) + 1];
+    size_t dlen = sizeof(buf);
     
-    i = 0;
-    while (i < sizeof(buf) && buf[i] == 0) i++; // skip leading zeroes
-
-    NSMutableData *d = [NSMutableData secureDataWithCapacity:z + sizeof(buf) - i];
+    DMCBase58Decode(buf, &dlen, str, len);
+    
+    NSMutableData *d = [NSMutableData secureDataWithCapacity:dlen];
 
-    d.length = z;
-    [d appendBytes:&buf[i] length:sizeof(buf) - i];
+    [d appendBytes:buf length:dlen];
     memset(buf, 0, sizeof(buf));
+    memset(str, 0, sizeof(str));
+    memset(chars, 0, sizeof(chars));
     return d;
 }
 
@@ -234,38 +170,20 @@ static const UniChar base58chars[] = {
 {
     if (self.length % 2) return nil;
     
-    NSMutableData *d = [NSMutableData secureDataWithCapacity:self.length/2];
-    uint8_t b = 0;
+    NSUInteger n = self.length;
+    UniChar *chars = malloc(n*sizeof(UniChar) + 1);
+    char *str = malloc(n + 1);
     
-    for (NSUInteger i = 0; i < self.length; i++) {
-        unichar c = [self characterAtIndex:i];
-        
-        switch (c) {
-            case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
-                b += c - '0';
-                break;
-
-            case 'A': case 'B': case 'C': case 'D': case 'E': case 'F':
-                b += c + 10 - 'A';
-                break;
-
-            case 'a': case 'b': case 'c': case 'd': case 'e': case 'f':
-                b += c + 10 - 'a';
-                break;
-
-            default:
-                return d;
-        }
-        
-        memset(&c, 0, sizeof(c));
-        
-        if (i % 2) {
-            [d appendBytes:&b length:1];
-            memset(&b, 0, sizeof(b));
-        }
-        else b *= 16;
-    }
+    [self getCharacters:chars range:NSMakeRange(0, n)];
+    for (NSUInteger i = 0; i < n; i++) str[i] = (chars[i] < 0x80) ? (char)chars[i] : '\0'; // non-ascii is not a hex digit
+    
+    NSMutableData *d = [NSMutableData secureDataWithLength:n/2];
     
+    d.length = DMCHexDecode(d.mutableBytes, str, n/2, DMCHexLowercase); // decoding stops at the first invalid digit
+    memset(chars, 0, n*sizeof(UniChar));
+    memset(str, 0, n);
+    free(chars);
+    free(str);
     return d;
 }
 